@@ -0,0 +1,166 @@
+//
+// Read a big generated ida file into a plain Attribute tree and into one that uses
+// an AttributeArena, and compare allocations, read, lookup, and free times. Does the same
+// for the binary format. Exits with 1 if the trees written back out differ.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ attarenabench.cc `pkg-config laxkit --cflags --libs` -o attarenabench
+//
+// Usage: attarenabench [number of entries] [directory]
+//  Each entry has 8 subattributes. Files are written to directory, default /tmp.
+
+
+#include <lax/attributes.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+static long num_allocs = 0;
+
+void *operator new(size_t size)
+{
+	num_allocs++;
+	void *p = malloc(size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+
+//! Something like a big shortcut or resource file.
+static void MakeFile(const char *file, int n)
+{
+	FILE *f = fopen(file, "w");
+	if (!f) return;
+	for (int c=0; c<n; c++) {
+		fprintf(f, "shortcut Action%d\n", c);
+		fprintf(f, "  area \"window %d\"\n", c%37);
+		fprintf(f, "  key %d\n", 'a' + c%26);
+		fprintf(f, "  state control+shift\n");
+		fprintf(f, "  mode %d\n", c%3);
+		fprintf(f, "  description \"Does thing number %d, which is quite useful\"\n", c);
+		fprintf(f, "  icon icons/action%d.png  #with a comment\n", c%100);
+		fprintf(f, "  weight %.6f\n", c * .001);
+		fprintf(f, "  options\n    repeat yes\n");
+	}
+	fclose(f);
+}
+
+//! Return sum of lookups through find() and findLong(), to compare trees and time lookups.
+static long Lookups(Attribute *att)
+{
+	long sum = 0;
+	for (int c=0; c<att->attributes.n; c++) {
+		Attribute *sub = att->attributes.e[c];
+		sum += sub->findLong("key");
+		sum += sub->findLong("mode");
+		const char *desc = sub->findValue("description");
+		if (desc) sum += strlen(desc);
+		if (sub->find("options")) sum++;
+		if (sub->find("not_there")) sum += 1000;
+	}
+	return sum;
+}
+
+static char *ToText(Attribute *att)
+{
+	char *buf = nullptr;
+	size_t size = 0;
+	FILE *f = open_memstream(&buf, &size);
+	att->dump_out(f, 0);
+	fclose(f);
+	return buf;
+}
+
+struct Result {
+	long allocs;
+	double read, lookup, destroy;
+	long sum;
+	char *text;
+};
+
+static Result Run(const char *file, bool arena, bool binary)
+{
+	Result r;
+	Attribute *att = new Attribute();
+	if (arena) att->UseArena();
+
+	long allocs = num_allocs;
+	double start = Now();
+	if (binary) BinaryFileToAttribute(file, att, nullptr);
+	else att->dump_in(file);
+	r.read = Now() - start;
+	r.allocs = num_allocs - allocs;
+
+	start = Now();
+	r.sum = 0;
+	for (int c=0; c<10; c++) r.sum += Lookups(att);
+	r.lookup = Now() - start;
+
+	r.text = ToText(att);
+
+	start = Now();
+	delete att;
+	r.destroy = Now() - start;
+	return r;
+}
+
+static void Print(const char *what, Result &r)
+{
+	cout << "  " << what << r.allocs << " allocations, read " << r.read*1000 << " ms, 10x lookups "
+		 << r.lookup*1000 << " ms, free " << r.destroy*1000 << " ms" << endl;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = (argc>1 ? strtol(argv[1], NULL, 10) : 100000);
+	if (n <= 0) n = 100000;
+	const char *dir = (argc>2 ? argv[2] : "/tmp");
+
+	char textfile[strlen(dir) + 30], binfile[strlen(dir) + 30];
+	sprintf(textfile, "%s/attarenabench.txt", dir);
+	sprintf(binfile,  "%s/attarenabench.bin", dir);
+
+	MakeFile(textfile, n);
+	Attribute att;
+	att.dump_in(textfile);
+	AttributeToBinaryFile(binfile, &att);
+	att.clear();
+
+	cout << n << " entries, " << n*10 << " attributes" << endl;
+
+	int bad = 0;
+	for (int binary=0; binary<2; binary++) {
+		const char *file = (binary ? binfile : textfile);
+		Result plain  = Run(file, false, binary);
+		Result arena  = Run(file, true,  binary);
+
+		cout << (binary ? "binary:" : "text:") << endl;
+		Print("plain: ", plain);
+		Print("arena: ", arena);
+
+		if (plain.sum != arena.sum || strcmp(plain.text, arena.text)) {
+			cout << "Warning! Arena tree differs from plain tree!" << endl;
+			bad = 1;
+		}
+		free(plain.text);
+		free(arena.text);
+	}
+
+	return bad;
+}
@@ -0,0 +1,122 @@
+//
+// Save and load a large engraving as text and as a binary Attribute file, and
+// report times and file sizes. Checks that both loads give back the same line points.
+// Exits with 1 if they differ. No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ attbinbench.cc `pkg-config laxkit --cflags --libs` -llaxinterfaces -o attbinbench
+//
+// Usage: attbinbench [spacing] [directory]
+//  The fill is 100x100 units, so spacing .2 gives about 140k points, and .07 about 1.1M.
+//  Files are written to directory, default /tmp.
+
+
+#include <lax/interfaces/engraverfilldata.h>
+#include <lax/fileutils.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+using namespace LaxInterfaces;
+
+
+//! Return the number of points in group that differ from group in other, or -1 for different line counts.
+static long Differences(EngraverPointGroup *a, EngraverPointGroup *b)
+{
+	if (a->lines.n != b->lines.n) return -1;
+	long bad = 0;
+	for (int c=0; c<a->lines.n; c++) {
+		LinePoint *p = a->lines.e[c], *p2 = b->lines.e[c];
+		for ( ; p && p2; p=p->next, p2=p2->next) {
+			if (fabs(p->s - p2->s) > 1e-9 || fabs(p->t - p2->t) > 1e-9
+					|| fabs(p->weight - p2->weight) > 1e-9 || p->on != p2->on) bad++;
+		}
+		if (p || p2) bad++;
+	}
+	return bad;
+}
+
+//! Load file into a new EngraverFillData.
+static EngraverFillData *Load(const char *file, double *time_ret)
+{
+	double start = Now();
+	Attribute att;
+	att.dump_in(file);
+	EngraverFillData *data = new EngraverFillData();
+	DumpContext context;
+	data->dump_in_atts(&att, 0, &context);
+	*time_ret = Now() - start;
+	return data;
+}
+
+
+int main(int argc,char **argv)
+{
+	double spacing = (argc>1 ? strtod(argv[1], NULL) : .2);
+	if (spacing <= 0) spacing = .2;
+	const char *dir = (argc>2 ? argv[2] : "/tmp");
+
+	 //debug output from the engraver code would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	EngraverFillData *data = new EngraverFillData();
+	data->Set(0,0,100,100,1,1,0);
+	data->FillRegularLines(-1, spacing);
+	EngraverPointGroup *group = data->groups.e[0];
+	for (int c=0; c<group->lines.n; c++) {
+		int i = 0;
+		for (LinePoint *p = group->lines.e[c]; p; p = p->next, i++) {
+			p->weight = spacing * (.1 + .8 * ((i + c) % 17) / 16.);
+			if (i % 23 == 0) p->on = ENGRAVE_Off;
+		}
+	}
+
+	long n = 0;
+	for (int c=0; c<group->lines.n; c++) for (LinePoint *p = group->lines.e[c]; p; p = p->next) n++;
+	cout << group->lines.n << " lines, " << n << " points" << endl;
+
+	char textfile[strlen(dir) + 30], binfile[strlen(dir) + 30];
+	sprintf(textfile, "%s/attbinbench.txt", dir);
+	sprintf(binfile,  "%s/attbinbench.bin", dir);
+
+	 //---- save
+	DumpContext context;
+	double start = Now();
+	Attribute *att = data->dump_out_atts(NULL, 0, &context);
+	FILE *f = fopen(textfile, "w");
+	if (f) { att->dump_out(f, 0); fclose(f); }
+	double text_save = Now() - start;
+	delete att;
+
+	context.format = ATT_Binary;
+	start = Now();
+	att = data->dump_out_atts(NULL, 0, &context);
+	AttributeToBinaryFile(binfile, att);
+	double bin_save = Now() - start;
+	delete att;
+
+	 //---- load
+	double text_load, bin_load;
+	EngraverFillData *from_text = Load(textfile, &text_load);
+	EngraverFillData *from_bin  = Load(binfile,  &bin_load);
+
+	cout << "  text:   save " << text_save*1000 << " ms, load " << text_load*1000 << " ms, "
+		 << file_size(textfile, 1, NULL)/1024 << " kb" << endl;
+	cout << "  binary: save " << bin_save*1000  << " ms, load " << bin_load*1000  << " ms, "
+		 << file_size(binfile,  1, NULL)/1024 << " kb" << endl;
+
+	long bad_text = Differences(group, from_text->groups.e[0]);
+	long bad_bin  = Differences(group, from_bin ->groups.e[0]);
+	if (bad_text) cout << "Warning! Text load differs at " << bad_text << " points!" << endl;
+	if (bad_bin)  cout << "Warning! Binary load differs at " << bad_bin << " points!" << endl;
+
+	from_text->dec_count();
+	from_bin->dec_count();
+	data->dec_count();
+	return (bad_text || bad_bin) ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+//
+// Read a big generated csv file into a PointSet with the streaming PointSet::LoadCSV(), and
+// into a whole Attribute tree with CSVFileToAttribute(). Then count the elements of a big
+// generated svg with ParseXMLEvents(), and read it with XMLFileToAttribute().
+// Reports times, and memory: how much peak memory grows for the streaming readers, which
+// run first since peak memory only ever goes up, and how much memory each whole tree holds.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ attstreambench.cc `pkg-config laxkit --cflags --libs` -o attstreambench
+//
+// Usage: attstreambench [number of rows] [directory]
+//  The svg gets one path per csv row. Files are written to directory, default /tmp.
+
+
+#include <lax/attributes.h>
+#include <lax/pointset.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+//! Peak resident memory so far, in kb.
+static long PeakKb()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static void MakeCSV(const char *file, long n)
+{
+	FILE *f = fopen(file, "w");
+	if (!f) return;
+	fprintf(f, "id, x, y, weight, label\n");
+	for (long c=0; c<n; c++) {
+		fprintf(f, "%ld, %.6f, %.6f, %.3f, \"point %ld\"\n", c, (c%1000) * .1, (c/1000) * .1, 1 + (c%7)*.25, c);
+	}
+	fclose(f);
+}
+
+static void MakeSVG(const char *file, long n)
+{
+	FILE *f = fopen(file, "w");
+	if (!f) return;
+	fprintf(f, "<?xml version=\"1.0\"?>\n<svg width=\"1000\" height=\"1000\">\n  <title>Big drawing</title>\n");
+	for (long c=0; c<n; c++) {
+		if (c%100 == 0) fprintf(f, "%s  <g id=\"group%ld\">\n", c ? "  </g>\n" : "", c/100);
+		fprintf(f, "    <path id=\"path%ld\" style=\"fill:#%06lx\" d=\"M %ld %ld L %ld %ld L %ld 0 z\"/>\n",
+				c, (c*2654435761L) & 0xffffff, c%1000, c/1000, c%1000 + 10, c/1000 + 5, c%1000);
+	}
+	if (n) fprintf(f, "  </g>\n");
+	fprintf(f, "</svg>\n");
+	fclose(f);
+}
+
+static long CountAtts(Attribute *att)
+{
+	long n = att->attributes.n;
+	for (int c=0; c<att->attributes.n; c++) n += CountAtts(att->attributes.e[c]);
+	return n;
+}
+
+//! Just count nodes, and the elements that are paths.
+class Counter : public AttributeEvents
+{
+  public:
+	long nodes, paths;
+	Counter() { nodes = paths = 0; }
+	virtual bool BeginNode() { nodes++; return true; }
+	virtual bool Name(const char *str, int len) { if (len == 4 && !strncmp(str, "path", 4)) paths++; return true; }
+	virtual bool Value(const char *str, int len) { return true; }
+	virtual bool EndNode() { return true; }
+};
+
+
+int main(int argc,char **argv)
+{
+	long n = (argc>1 ? strtol(argv[1], NULL, 10) : 1000000);
+	if (n <= 0) n = 1000000;
+	const char *dir = (argc>2 ? argv[2] : "/tmp");
+
+	char csvfile[strlen(dir) + 30], svgfile[strlen(dir) + 30];
+	sprintf(csvfile, "%s/attstreambench.csv", dir);
+	sprintf(svgfile, "%s/attstreambench.svg", dir);
+	MakeCSV(csvfile, n);
+	MakeSVG(svgfile, n);
+
+	 //debug output would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	int bad = 0;
+	long peak = PeakKb(), peak2, mem;
+	cout << n << " rows" << endl;
+
+	 //---- streaming
+	PointSet *points = new PointSet();
+	double start = Now();
+	int status = points->LoadCSV(csvfile, true, "x", "y");
+	double csv_stream = Now() - start;
+	peak2 = PeakKb();
+	long numpoints = points->NumPoints();
+	points->dec_count();
+	cout << "csv:" << endl;
+	cout << "  PointSet::LoadCSV():  " << csv_stream*1000 << " ms, " << numpoints << " points, peak memory +"
+		 << (peak2 - peak)/1024 << " mb" << endl;
+	if (status != 0 || numpoints != n) { cout << "Warning! LoadCSV() failed!" << endl; bad = 1; }
+
+	Counter counter;
+	IOBuffer f;
+	peak = PeakKb();
+	start = Now();
+	if (f.OpenFile(svgfile, "r") == 0) status = ParseXMLEvents(f, NULL, &counter);
+	else status = -1;
+	f.Close();
+	double xml_stream = Now() - start;
+	peak2 = PeakKb();
+	if (status != 0 || counter.paths != n) { cout << "Warning! ParseXMLEvents() failed!" << endl; bad = 1; }
+
+	 //---- whole trees
+	mem = CurrentKb();
+	start = Now();
+	Attribute *att = CSVFileToAttribute(NULL, csvfile, ",", true, NULL);
+	double tree_time = Now() - start;
+	cout << "  CSVFileToAttribute(): " << tree_time*1000 << " ms, " << (att ? att->attributes.n-1 : 0)
+		 << " rows, tree holds " << (CurrentKb() - mem)/1024 << " mb" << endl;
+	if (!att || att->attributes.n != n+1) { cout << "Warning! CSVFileToAttribute() failed!" << endl; bad = 1; }
+	delete att;
+
+	cout << "svg:" << endl;
+	cout << "  ParseXMLEvents():     " << xml_stream*1000 << " ms, " << counter.paths << " paths, "
+		 << counter.nodes << " nodes, peak memory +" << (peak2 - peak)/1024 << " mb" << endl;
+
+	mem = CurrentKb();
+	start = Now();
+	att = XMLFileToAttribute(NULL, svgfile, NULL);
+	tree_time = Now() - start;
+	long numatts = (att ? CountAtts(att) : 0);
+	cout << "  XMLFileToAttribute(): " << tree_time*1000 << " ms, " << numatts
+		 << " nodes, tree holds " << (CurrentKb() - mem)/1024 << " mb" << endl;
+	if (numatts != counter.nodes) { cout << "Warning! XMLFileToAttribute() and ParseXMLEvents() differ!" << endl; bad = 1; }
+	delete att;
+
+	return bad;
+}
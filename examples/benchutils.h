@@ -0,0 +1,58 @@
+//
+// Helpers shared by the *bench.cc programs in this directory.
+//
+#ifndef _LAX_EXAMPLES_BENCHUTILS_H
+#define _LAX_EXAMPLES_BENCHUTILS_H
+
+
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <unistd.h>
+
+#include <iostream>
+
+
+//! Seconds on the monotonic clock, for timing.
+static inline double Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+//! Random number in [0, max].
+static inline double Random(double max)
+{
+	return max * rand() / RAND_MAX;
+}
+
+//! Resident memory right now, in kb.
+static inline long CurrentKb()
+{
+	long size = 0, resident = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (!f) return 0;
+	if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = 0;
+	fclose(f);
+	return resident * (getpagesize() / 1024);
+}
+
+//! Running mean, standard deviation, and max of samples in microseconds.
+class Stats
+{
+  public:
+	double sum, sumsq, max;
+	int n;
+	Stats() { sum=sumsq=max=0; n=0; }
+	void Add(double v) { sum+=v; sumsq+=v*v; if (v>max) max=v; n++; }
+	double Mean() { return n ? sum/n : 0; }
+	double StdDev() { if (!n) return 0; double m=Mean(); return sqrt(sumsq/n - m*m); }
+	void Print(const char *what) {
+		std::cout << what << ": n=" << n << "  mean=" << Mean() << " us  stddev=" << StdDev() << " us  max=" << max << " us" << std::endl;
+	}
+};
+
+
+#endif
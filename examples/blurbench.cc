@@ -0,0 +1,105 @@
+//
+// Time Laxkit::GaussianBlur() on a 4000x4000 one channel image for radius 2, 20, and 200,
+// with the gaussian kernel and with the 3 box approximation, against a copy of the
+// older column major version, which is only run for the smaller radii since it is so slow.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ blurbench.cc `pkg-config laxkit --cflags --libs` -lpthread -o blurbench
+
+
+#include <lax/bitmaputils.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+#define SIZE 4000
+
+
+/*! The older GaussianBlur(), 8 bit, !expand only, with the kernel indexing fixed.
+ */
+static void OldBlur(int radius, char which, unsigned char *img, int width, int height, unsigned char *blurred)
+{
+	int n=radius*2+1;
+	double kernel[n];
+	double sigma=radius/3.;
+	for (int c=0; c<=radius; c++) kernel[radius-c] = kernel[radius+c] = exp(-c*c/2/sigma/sigma);
+	double summ=0;
+	for (int c=0; c<n; c++) summ+=kernel[c];
+	for (int c=0; c<n; c++) kernel[c]/=summ;
+
+	int ii;
+	double sum,tsum;
+	for (int x=0; x<width; x++) {
+		for (int y=0; y<height; y++) {
+			sum=tsum=0;
+			for (int c=-radius; c<=radius; c++) {
+				ii=(which=='x' ? x : y) + c;
+				if (ii<0 || ii>=(which=='x' ? width : height)) continue;
+				sum  += kernel[c+radius] * (which=='x' ? img[y*width + ii] : img[ii*width + x]);
+				tsum += kernel[c+radius];
+			}
+			blurred[y*width + x] = sum/tsum;
+		}
+	}
+}
+
+/*! Return largest difference between a and b.
+ */
+static int MaxDiff(unsigned char *a, unsigned char *b, int n)
+{
+	int d=0;
+	for (int c=0; c<n; c++) if (abs(a[c]-b[c]) > d) d=abs(a[c]-b[c]);
+	return d;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = SIZE*SIZE;
+	unsigned char *img  = new unsigned char[n];
+	unsigned char *tmp  = new unsigned char[n];
+	unsigned char *out1 = new unsigned char[n];
+	unsigned char *out2 = new unsigned char[n];
+
+	srandom(1);
+	for (int c=0; c<n; c++) img[c] = random()%256;
+
+	int radii[] = { 2, 20, 200 };
+	for (int r=0; r<3; r++) {
+		int radius = radii[r];
+		cout << "radius "<<radius<<":"<<endl;
+
+		double start = Now();
+		GaussianBlur(radius,'x', img,SIZE,SIZE, tmp,  false, 8,1,0, BLUR_Gaussian);
+		GaussianBlur(radius,'y', tmp,SIZE,SIZE, out1, false, 8,1,0, BLUR_Gaussian);
+		cout << "  gaussian: "<<Now()-start<<" s"<<endl;
+
+		start = Now();
+		GaussianBlur(radius,'x', img,SIZE,SIZE, tmp,  false, 8,1,0, BLUR_Box);
+		GaussianBlur(radius,'y', tmp,SIZE,SIZE, out2, false, 8,1,0, BLUR_Box);
+		cout << "  box:      "<<Now()-start<<" s, max difference from gaussian: "<<MaxDiff(out1,out2,n)<<endl;
+
+		if (radius <= 20) {
+			start = Now();
+			OldBlur(radius,'x', img,SIZE,SIZE, tmp);
+			OldBlur(radius,'y', tmp,SIZE,SIZE, out2);
+			cout << "  old:      "<<Now()-start<<" s, max difference from gaussian: "<<MaxDiff(out1,out2,n)<<endl;
+		}
+	}
+
+	delete[] img;
+	delete[] tmp;
+	delete[] out1;
+	delete[] out2;
+	return 0;
+}
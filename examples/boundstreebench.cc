@@ -0,0 +1,83 @@
+//
+// Hit test random points against many random rectangles, comparing a linear scan
+// like ViewportWithStack used to do with Laxkit::BoundsTree.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ boundstreebench.cc `pkg-config laxkit --cflags --libs` -o boundstreebench
+
+
+#include <lax/boundstree.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+#define NUM_RECTS   100000
+#define NUM_QUERIES 100000
+#define AREA        10000.
+#define MAX_SIZE    50.
+
+
+int main(int argc,char **argv)
+{
+	srand(1);
+
+	DoubleBBox *rects = new DoubleBBox[NUM_RECTS];
+	for (int c=0; c<NUM_RECTS; c++) {
+		double x = Random(AREA), y = Random(AREA);
+		rects[c].setboundsXYWH(x,y, Random(MAX_SIZE), Random(MAX_SIZE));
+	}
+
+	flatpoint *points = new flatpoint[NUM_QUERIES];
+	for (int c=0; c<NUM_QUERIES; c++) points[c].set(Random(AREA), Random(AREA));
+
+
+	 //build
+	double start = Now();
+	BoundsTree tree;
+	for (int c=0; c<NUM_RECTS; c++) tree.Insert(c, rects[c]);
+	double build = Now() - start;
+
+
+	 //linear scan for topmost hit, like the old FindObject()
+	long linear_hits = 0;
+	start = Now();
+	for (int q=0; q<NUM_QUERIES; q++) {
+		flatpoint p = points[q];
+		for (int c=NUM_RECTS-1; c>=0; c--) {
+			if (p.x>=rects[c].minx && p.x<=rects[c].maxx && p.y>=rects[c].miny && p.y<=rects[c].maxy) {
+				linear_hits += c;
+				break;
+			}
+		}
+	}
+	double linear = Now() - start;
+
+
+	 //tree search for topmost hit
+	long tree_hits = 0;
+	NumStack<int> found;
+	start = Now();
+	for (int q=0; q<NUM_QUERIES; q++) {
+		if (tree.FindPoint(points[q], found)) tree_hits += found.e[found.n-1];
+	}
+	double treetime = Now() - start;
+
+
+	cout << NUM_RECTS << " rectangles, " << NUM_QUERIES << " point queries" << endl;
+	cout << "tree build:  " << build*1000 << " ms, height " << tree.Height() << endl;
+	cout << "linear scan: " << linear/NUM_QUERIES*1e6 << " us per query" << endl;
+	cout << "bounds tree: " << treetime/NUM_QUERIES*1e6 << " us per query" << endl;
+	if (linear_hits != tree_hits) cout << "Warning! results differ!" << endl;
+
+	delete[] rects;
+	delete[] points;
+	return 0;
+}
@@ -0,0 +1,53 @@
+//
+// Time VoronoiData triangulation and voronoi region building for 1k, 100k and 1M random points.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ delaunaybench.cc `pkg-config laxkit --cflags --libs` -llaxinterfaces -o delaunaybench
+
+
+#include <lax/interfaces/delaunayinterface.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+using namespace LaxInterfaces;
+
+
+#define AREA 10000.
+
+
+int main(int argc,char **argv)
+{
+	srand(1);
+
+	int sizes[] = { 1000, 100000, 1000000 };
+
+	for (int s=0; s<3; s++) {
+		int n = sizes[s];
+
+		VoronoiData *data = new VoronoiData;
+		for (int c=0; c<n; c++) data->AddPoint(flatpoint(Random(AREA), Random(AREA)));
+
+		double start = Now();
+		data->Triangulate();
+		double tri = Now() - start;
+
+		start = Now();
+		data->RebuildVoronoi(false);
+		double regions = Now() - start;
+
+		cout << n << " points: "<< data->triangles.n << " triangles" << endl;
+		cout << "  Triangulate():    " << tri*1000 << " ms" << endl;
+		cout << "  RebuildVoronoi(): " << regions*1000 << " ms" << endl;
+
+		data->dec_count();
+	}
+
+	return 0;
+}
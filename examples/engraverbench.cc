@@ -0,0 +1,111 @@
+//
+// Time the per point passes of EngraverPointGroup on a large regular line fill:
+// Sync(), UpdateBezCache(), Trace(), UpdateDashCache(), UpdatePositionCache() and MakePathsData(),
+// and report how much heap each sample point costs.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ engraverbench.cc `pkg-config laxkit --cflags --libs` -llaxinterfaces -o engraverbench
+//
+// Usage: engraverbench [spacing]
+//  The fill is 100x100 units, so spacing .2 gives about 140k points, and .07 about 1.1M.
+
+
+#include <lax/interfaces/engraverfilldata.h>
+#include "benchutils.h"
+
+#include <malloc.h>
+#include <ctime>
+#include <cmath>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+using namespace LaxInterfaces;
+
+
+#define NUM_RUNS 5
+
+
+static size_t HeapInUse()
+{
+	struct mallinfo2 info = mallinfo2();
+	return info.uordblks + info.hblkhd;
+}
+
+
+int main(int argc,char **argv)
+{
+	double spacing = (argc>1 ? strtod(argv[1], NULL) : .2);
+	if (spacing <= 0) spacing = .2;
+
+	 //debug output from the engraver code would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	EngraverFillData *data = new EngraverFillData();
+	data->Set(0,0,100,100,1,1,0);
+
+	size_t heap = HeapInUse();
+	double start = Now();
+	data->FillRegularLines(-1, spacing);
+	double fill_time = Now() - start;
+
+	EngraverPointGroup *group = data->groups.e[0];
+
+	 //give the lines a weight pattern that crosses the dash thresholds
+	long n = 0;
+	for (int c=0; c<group->lines.n; c++) {
+		for (LinePoint *l=group->lines.e[c]; l; l=l->next) {
+			l->weight_orig = l->weight = spacing * (.5 + .45*sin(l->p.x*.3)*cos(l->p.y*.2));
+			n++;
+		}
+	}
+	group->dashes->zero_threshhold   = spacing * .2;
+	group->dashes->broken_threshhold = spacing * .6;
+	group->trace->traceobject = new TraceObject();
+
+	cout << group->lines.n << " lines, " << n << " points" << endl;
+	cout << "  fill:                  " << fill_time*1000 << " ms" << endl;
+
+	 //each pass is run a few times, as when editing interactively, and the average is shown
+	double sync_time=0, bez_time=0, trace_time=0, dash_time=0, position_time=0;
+	for (int c=0; c<NUM_RUNS; c++) {
+		start = Now();
+		data->Sync(false);
+		sync_time += Now()-start;
+
+		start = Now();
+		group->UpdateBezCache();
+		bez_time += Now()-start;
+
+		start = Now();
+		group->Trace(NULL);
+		trace_time += Now()-start;
+
+		start = Now();
+		group->UpdateDashCache();
+		dash_time += Now()-start;
+
+		start = Now();
+		group->UpdatePositionCache();
+		position_time += Now()-start;
+	}
+
+	cout << "  Sync():                " << sync_time    /NUM_RUNS*1000 << " ms" << endl;
+	cout << "  UpdateBezCache():      " << bez_time     /NUM_RUNS*1000 << " ms" << endl;
+	cout << "  Trace() with dashes:   " << trace_time   /NUM_RUNS*1000 << " ms" << endl;
+	cout << "  UpdateDashCache():     " << dash_time    /NUM_RUNS*1000 << " ms" << endl;
+	cout << "  UpdatePositionCache(): " << position_time/NUM_RUNS*1000 << " ms" << endl;
+
+	cout << "  heap per point:        " << (double)(HeapInUse() - heap) / n << " bytes" << endl;
+
+	start = Now();
+	PathsData *paths = data->MakePathsData(0);
+	cout << "  MakePathsData():       " << (Now()-start)*1000 << " ms, " << paths->paths.n << " outlines" << endl;
+
+	paths->dec_count();
+	data->dec_count();
+	return 0;
+}
@@ -0,0 +1,148 @@
+//
+// Measure throughput of anXApp::SendMessage() with several producer threads.
+//
+// This compares the lock free event queue with a copy of the older mutex protected
+// linked list, and reports how many EventData blocks had to come from the heap.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ eventqueuebench.cc `pkg-config laxkit --cflags --libs` -lpthread -o eventqueuebench
+
+
+#include <lax/anxapp.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <pthread.h>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+#define NUM_THREADS 4
+#define PER_THREAD  500000
+
+
+//--------------------------- apps -------------------------------
+
+/*! Exposes processdataevents() for the benchmark.
+ */
+class BenchApp : public anXApp
+{
+  public:
+	virtual int Process() { return processdataevents(); }
+};
+
+/*! Uses the old mutex locked list for SendMessage().
+ */
+class MutexBenchApp : public BenchApp
+{
+  public:
+	pthread_mutex_t mutex;
+	MutexBenchApp() { pthread_mutex_init(&mutex,NULL); }
+	virtual ~MutexBenchApp() { pthread_mutex_destroy(&mutex); }
+	virtual int SendMessage(EventData *data, unsigned long toobj=0, const char *mes=0, unsigned long fromobj=0);
+	virtual int Process();
+};
+
+int MutexBenchApp::SendMessage(EventData *data, unsigned long toobj, const char *mes, unsigned long fromobj)
+{
+	if (toobj) data->to = toobj;
+	pthread_mutex_lock(&mutex);
+	if (dataevente) {
+		dataevente->next=data;
+		dataevente=data;
+	} else {
+		dataevents=dataevente=data;
+	}
+	pthread_mutex_unlock(&mutex);
+	return 0;
+}
+
+int MutexBenchApp::Process()
+{
+	EventData *data;
+	while (1) {
+		pthread_mutex_lock(&mutex);
+		if (!dataevents) {
+			pthread_mutex_unlock(&mutex);
+			break;
+		}
+		data=dataevents;
+		dataevents=dataevents->next;
+		if (!dataevents) dataevente=NULL;
+		data->next=NULL;
+		pthread_mutex_unlock(&mutex);
+
+		processSingleDataEvent(NULL,data);
+		delete data;
+	}
+	return 0;
+}
+
+
+//--------------------------- Counter -------------------------------
+
+class Counter : public EventReceiver
+{
+  public:
+	long count;
+	Counter() { count=0; }
+	virtual int Event(const EventData *data,const char *mes) { count++; return 0; }
+};
+
+static Counter *counter = NULL;
+
+static void *Produce(void *)
+{
+	for (int c=0; c<PER_THREAD; c++) {
+		MouseEventData *m = new MouseEventData(LAX_onMouseMove);
+		m->x = c;
+		anXApp::app->SendMessage(m, counter->object_id);
+	}
+	return NULL;
+}
+
+static void Run(BenchApp *app, const char *name)
+{
+	counter = new Counter;
+	long total = (long)NUM_THREADS * PER_THREAD;
+
+	 //one warm up round to fill the pools, then a measured round
+	for (int round=0; round<2; round++) {
+		counter->count = 0;
+		long allocs = EventDataPoolAllocations();
+		double start = Now();
+
+		pthread_t threads[NUM_THREADS];
+		for (int c=0; c<NUM_THREADS; c++) pthread_create(&threads[c], NULL, Produce, NULL);
+		while (counter->count < total) app->Process();
+		for (int c=0; c<NUM_THREADS; c++) pthread_join(threads[c], NULL);
+
+		double secs = Now() - start;
+		if (round == 0) continue;
+		cout << name << ": " << total/secs/1e6 << " million events/sec, "
+			 << EventDataPoolAllocations() - allocs << " heap allocations" << endl;
+	}
+
+	delete counter;
+}
+
+
+int main(int argc,char **argv)
+{
+	cout << NUM_THREADS << " threads sending " << PER_THREAD << " MouseEventData each" << endl;
+
+	{
+		MutexBenchApp app;
+		Run(&app, "mutex list");
+	}
+	{
+		BenchApp app;
+		Run(&app, "lock free ");
+	}
+
+	return 0;
+}
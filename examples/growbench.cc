@@ -0,0 +1,104 @@
+//
+// Grow engraver lines with the old all at once EngraverPointGroup::GrowLines_OLD() and with the
+// time sliced GrowLines_Init()/GrowLines_Iterate()/GrowLines_Finish(), and compare total time,
+// the longest single Iterate() call, and how evenly the result covers the fill.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ growbench.cc `pkg-config laxkit --cflags --libs` -llaxinterfaces -o growbench
+//
+// Usage: growbench [spacing]
+//  The fill is 100x100 units.
+
+
+#include <lax/interfaces/engraverfilldata.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+using namespace LaxInterfaces;
+
+
+#define PROBES 40
+
+
+static int CountPoints(EngraverPointGroup *group)
+{
+	int n = 0;
+	for (int c=0; c<group->lines.n; c++) {
+		for (LinePoint *l=group->lines.e[c]; l; l=l->next) n++;
+	}
+	return n;
+}
+
+//! Return the largest distance from a grid of probe points inside the fill to the nearest line point.
+static double LargestGap(EngraverFillData *data, EngraverPointGroup *group)
+{
+	double gap = 0;
+	for (int y=1; y<PROBES; y++) {
+		for (int x=1; x<PROBES; x++) {
+			flatpoint p = data->getPoint(double(x)/PROBES, double(y)/PROBES, false);
+			double d = 1e+10;
+			for (int c=0; c<group->lines.n; c++) {
+				for (LinePoint *l=group->lines.e[c]; l; l=l->next) {
+					double d2 = norm2(l->p - p);
+					if (d2 < d) d = d2;
+				}
+			}
+			if (d > gap) gap = d;
+		}
+	}
+	return sqrt(gap);
+}
+
+
+int main(int argc,char **argv)
+{
+	double spacing = (argc>1 ? strtod(argv[1], NULL) : 2);
+	if (spacing <= 0) spacing = 2;
+
+	 //debug output from the engraver code would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	EngraverFillData *data = new EngraverFillData();
+	data->Set(0,0,100,100,1,1,0);
+	EngraverPointGroup *group = data->groups.e[0];
+	group->spacing->spacing = spacing;
+	group->directionv = flatpoint(1,.3);
+
+	double start = Now();
+	group->GrowLines_OLD(data, spacing/3, spacing, NULL, .01, NULL, group->directionv, group, NULL, 1000);
+	double old_time = Now() - start;
+
+	cout << "GrowLines_OLD():" << endl;
+	cout << "  " << old_time*1000 << " ms, " << group->lines.n << " lines, " << CountPoints(group) << " points" << endl;
+	cout << "  largest gap: " << LargestGap(data, group)/spacing << " spacings" << endl;
+
+	int calls = 0;
+	double longest = 0, t;
+	start = Now();
+	group->GrowLines_Init(data, spacing/3, spacing, NULL, .01, NULL, group->directionv, group, group->direction->grow_iteration_limit, NULL);
+	bool more;
+	do {
+		calls++;
+		t = Now();
+		more = group->GrowLines_Iterate();
+		t = Now() - t;
+		if (t > longest) longest = t;
+	} while (more);
+	group->GrowLines_Finish();
+	double new_time = Now() - start;
+
+	cout << "GrowLines_Iterate(), " << GROW_TIME_SLICE*1000 << " ms slices:" << endl;
+	cout << "  " << new_time*1000 << " ms, " << group->lines.n << " lines, " << CountPoints(group) << " points" << endl;
+	cout << "  " << calls << " calls, longest " << longest*1000 << " ms" << endl;
+	cout << "  largest gap: " << LargestGap(data, group)/spacing << " spacings" << endl;
+
+	data->dec_count();
+	return 0;
+}
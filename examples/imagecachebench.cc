@@ -0,0 +1,332 @@
+//
+// Scroll through many big file backed images, like a page of thumbnails or a photo viewer,
+// with no cache limit, with a CacheManager budget, and with a budget plus loading on a
+// TaskQueue with small proxies drawn meanwhile, like LaxCairoImage::DisplayImage().
+// Frames are paced at 60 per second. Reports memory, how many loads were needed, the slowest
+// frame, and how many frames were missing images or had proxies instead, for each.
+// Also checks TaskQueue priority order and Cancel(), and that reloaded images have the
+// same pixels. Exits with 1 on any problem. No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ imagecachebench.cc `pkg-config laxkit --cflags --libs` -lpthread -o imagecachebench
+//
+// Usage: imagecachebench [number of images] [image size] [budget in mb] [directory]
+//  Images are written to directory, default /tmp.
+
+
+#include <lax/laximages.h>
+#include <lax/workerpool.h>
+#include <lax/strmanip.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+//! Pixels of image number which, some noise over a gradient so it does not compress to nothing.
+static void Pixels(unsigned char *data, int size, int which)
+{
+	unsigned int r = which * 2654435761u + 1;
+	for (int y=0; y<size; y++) {
+		for (int x=0; x<size; x++) {
+			r = r * 1103515245 + 12345;
+			unsigned char *p = data + 4*(y*size + x);
+			p[0] = x + which;
+			p[1] = y;
+			p[2] = (x^y) + ((r >> 16) & 15);
+			p[3] = 255;
+		}
+	}
+}
+
+static unsigned long Checksum(const unsigned char *data, long n)
+{
+	unsigned long sum = 0;
+	for (long c=0; c<n; c+=61) sum = sum*31 + data[c];
+	return sum;
+}
+
+//! Write a zlib compressed image file, standing in for a png.
+static void MakeFile(const char *file, int size, int which)
+{
+	uLong len = 4L*size*size;
+	unsigned char *data = new unsigned char[len];
+	Pixels(data, size, which);
+	uLongf clen = compressBound(len);
+	unsigned char *cdata = new unsigned char[clen];
+	compress2(cdata, &clen, data, len, Z_BEST_SPEED);
+
+	FILE *f = fopen(file, "w");
+	if (f) {
+		fwrite(cdata, 1, clen, f);
+		fclose(f);
+	}
+	delete[] data;
+	delete[] cdata;
+}
+
+//! Read and decompress a file from MakeFile(). Safe to call from any thread.
+static unsigned char *Decode(const char *file, int size)
+{
+	FILE *f = fopen(file, "r");
+	if (!f) return NULL;
+	fseek(f, 0, SEEK_END);
+	long clen = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	unsigned char *cdata = new unsigned char[clen];
+	long got = fread(cdata, 1, clen, f);
+	fclose(f);
+
+	uLongf len = 4L*size*size;
+	unsigned char *data = new unsigned char[len];
+	if (got != clen || uncompress(data, &len, cdata, clen) != Z_OK) {
+		delete[] data;
+		data = NULL;
+	}
+	delete[] cdata;
+	return data;
+}
+
+
+//! Like a LaxCairoImage, but with plain buffers so no cairo is needed.
+class FileImage : public MemCachedObject
+{
+  public:
+	static int num_loads;
+	static int proxy_div;
+
+	char *file;
+	int size;
+	unsigned char *data;  //full image, or NULL
+	unsigned char *proxy; //every proxy_div'th pixel, kept when data is freed
+	unsigned long checksum;
+
+	std::atomic<unsigned char*> loaded; //finished background load, not yet taken
+	bool loading;
+	unsigned long task; //id in the TaskQueue
+	double wanted; //when DisplayImage() last asked for it
+
+	FileImage(const char *nfile, int nsize) {
+		file = newstr(nfile);
+		size = nsize;
+		data = proxy = NULL;
+		checksum = 0;
+		loaded = NULL;
+		loading = false;
+		task = 0;
+		wanted = 0;
+	}
+	virtual ~FileImage() {
+		delete[] file;
+		delete[] data;
+		delete[] proxy;
+		delete[] loaded.load();
+	}
+
+	void Adopt(unsigned char *d) {
+		if (!d) return;
+		num_loads++;
+		data = d;
+		unsigned long sum = Checksum(data, 4L*size*size);
+		if (checksum && sum != checksum) cout << "Warning! Reloaded image has different pixels!" << endl;
+		checksum = sum;
+	}
+
+	 //like LaxCairoImage::Image()
+	unsigned char *Image() {
+		if (!data && loading) {
+			while (!loaded) usleep(100);
+			Adopt(loaded.exchange(NULL));
+			loading = false;
+		}
+		if (!data) Adopt(Decode(file, size));
+		if (!data) return NULL;
+		inc_cache();
+		CacheManager::GetDefault()->Touch(this);
+		return data;
+	}
+
+	 //like LaxCairoImage::CheckLoads(): take finished loads into the cache, and cancel stale ones
+	void CheckLoad(TaskQueue *queue, double stale) {
+		if (!loading) return;
+		if (loaded) {
+			Adopt(loaded.exchange(NULL));
+			loading = false;
+			CacheManager::GetDefault()->Touch(this);
+		} else if (Now() - wanted > stale && queue->Cancel(task)) loading = false;
+	}
+
+	 //like LaxCairoImage::DisplayImage(): full image if there, else start a load and return the proxy
+	unsigned char *DisplayImage(TaskQueue *queue) {
+		static int priority = 0;
+		if (data) return Image();
+		if (!loading) {
+			loading = true;
+			task = queue->Add([this]() { loaded = Decode(file, size); }, ++priority);
+		}
+		wanted = Now();
+		if (!proxy) return NULL;
+		inc_cache();
+		return proxy;
+	}
+
+	void doneForNow() {
+		if (dec_cache() == 0 && InCache()) InCache()->Trim();
+	}
+
+	virtual long CacheMemoryNeeded() { return data ? 4L*size*size : 0; }
+	virtual int AbleToRegenerate() { return 1; }
+	virtual int CacheRegenerate() { if (!Image()) return 1; dec_cache(); return 0; }
+	virtual int CacheState() { return (data ? LAX_IMAGE_WHOLE : 0) | (proxy ? LAX_IMAGE_PREVIEW : 0); }
+	virtual int CacheFree() {
+		if (!data || CacheCount() > 0) return 1;
+		if (!proxy) {
+			int psize = size / proxy_div;
+			proxy = new unsigned char[4*psize*psize];
+			for (int y=0; y<psize; y++)
+				for (int x=0; x<psize; x++)
+					memcpy(proxy + 4*(y*psize + x), data + 4*(y*proxy_div*size + x*proxy_div), 4);
+		}
+		delete[] data;
+		data = NULL;
+		return 0;
+	}
+};
+
+int FileImage::num_loads = 0;
+int FileImage::proxy_div = 8;
+
+
+//! Scroll down through all the images and back up again, drawing visible ones each frame.
+static int Run(const char *what, FileImage **images, int n, long budget, bool async)
+{
+	CacheManager *cache = new CacheManager(budget);
+	CacheManager::SetDefault(cache);
+	cache->dec_count();
+	TaskQueue *queue = (async ? new TaskQueue(-1) : NULL);
+
+	const int visible = 8;
+	const double frame_time = 1/60.;
+	FileImage::num_loads = 0;
+	long mem = CurrentKb(), peak = 0;
+	double worst = 0, start = Now();
+	int bad = 0, frames = 0, partial = 0, proxies = 0;
+
+	 //two frames per step, so background loads have a moment to finish
+	for (int pass=0; pass<2; pass++) {
+		for (int step=0; step<=n-visible; step++) {
+			int top = (pass == 0 ? step : n-visible-step);
+			for (int f=0; f<2; f++) {
+				double fstart = Now();
+				bool all = true;
+				if (async) for (int c=0; c<n; c++) images[c]->CheckLoad(queue, .5);
+				for (int c=top; c<top+visible; c++) {
+					unsigned char *p = (async ? images[c]->DisplayImage(queue) : images[c]->Image());
+					if (!p || p != images[c]->data) { all = false; if (p) proxies++; }
+					if (p) images[c]->doneForNow();
+				}
+				double t = Now() - fstart;
+				if (t > worst) worst = t;
+				if (t < frame_time) usleep((frame_time - t) * 1e6); //as if waiting for the next screen refresh
+				if (!all) partial++;
+				frames++;
+
+				long m = CurrentKb() - mem;
+				if (m > peak) peak = m;
+				if (budget > 0 && cache->Bytes() > budget) bad = 1;
+			}
+			if (async && pass == 1 && step == n-visible) {
+				queue->Wait();
+				for (int c=0; c<n; c++) images[c]->CheckLoad(queue, .5);
+			}
+		}
+	}
+	double total = Now() - start;
+
+	cout << what << endl;
+	cout << "  " << FileImage::num_loads << " loads, " << cache->NumFreed() << " freed, holding "
+		 << cache->Bytes()/1024/1024 << " mb by CacheMemoryNeeded(), process grew up to " << peak/1024 << " mb" << endl;
+	cout << "  " << frames << " frames in " << total*1000 << " ms, slowest frame " << worst*1000 << " ms, "
+		 << partial << " frames incomplete";
+	if (async) cout << ", drew " << proxies << " proxies";
+	cout << endl;
+	if (bad) cout << "Warning! Cache went over budget!" << endl;
+
+	delete queue;
+	for (int c=0; c<n; c++) {
+		delete[] images[c]->loaded.exchange(NULL);
+		images[c]->loading = false;
+		if (images[c]->data && images[c]->CacheCount() == 0) images[c]->CacheFree();
+		delete[] images[c]->proxy;
+		images[c]->proxy = NULL;
+		cache->Remove(images[c]);
+	}
+	CacheManager::SetDefault(NULL);
+	return bad;
+}
+
+//! Higher priority first, same priority in order added, and canceled ones never run.
+static int CheckQueue()
+{
+	TaskQueue queue(1);
+	int order[6], n = 0;
+	std::atomic<bool> go(false);
+	queue.Add([&go]() { while (!go) usleep(100); }); //hold the only thread while the rest are added
+	queue.Add([&]() { order[n++] = 1; }, 0);
+	queue.Add([&]() { order[n++] = 2; }, 0);
+	unsigned long id = queue.Add([&]() { order[n++] = -1; }, 5);
+	queue.Add([&]() { order[n++] = 3; }, 10);
+	queue.Add([&]() { order[n++] = 4; }, 5);
+	bool canceled = queue.Cancel(id);
+	go = true;
+	queue.Wait();
+
+	int bad = (!canceled || n != 4 || order[0] != 3 || order[1] != 4 || order[2] != 1 || order[3] != 2);
+	if (bad) cout << "Warning! TaskQueue ran tasks in the wrong order!" << endl;
+	return bad;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = (argc>1 ? strtol(argv[1], NULL, 10) : 100);
+	if (n < 8) n = 100;
+	int size = (argc>2 ? strtol(argv[2], NULL, 10) : 1024);
+	if (size < 64) size = 1024;
+	long budget = (argc>3 ? strtol(argv[3], NULL, 10) : 64) * 1024*1024;
+	if (budget <= 0) budget = 64*1024*1024;
+	const char *dir = (argc>4 ? argv[4] : "/tmp");
+
+	FileImage **images = new FileImage*[n];
+	char file[strlen(dir) + 40];
+	for (int c=0; c<n; c++) {
+		sprintf(file, "%s/imagecachebench%d.z", dir, c);
+		MakeFile(file, size, c);
+		images[c] = new FileImage(file, size);
+	}
+
+	cout << n << " images of " << size << "x" << size << ", " << 4L*size*size*n/1024/1024 << " mb in all, budget "
+		 << budget/1024/1024 << " mb" << endl;
+
+	int bad = CheckQueue();
+	 //freed memory is not always given back to the system, so biggest last
+	bad |= Run("budget, background loads:", images, n, budget, true);
+	bad |= Run("budget:", images, n, budget, false);
+	bad |= Run("no limit:", images, n, 0, false);
+
+	for (int c=0; c<n; c++) {
+		unlink(images[c]->file);
+		delete images[c];
+	}
+	delete[] images;
+	return bad;
+}
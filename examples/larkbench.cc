@@ -0,0 +1,174 @@
+//
+// Intern many strings as larks, then time lookups from one thread and from several threads at once,
+// and compare an Event() style chain of strcmp() against lark id comparisons with LARK().
+// Also checks that every thread gets the same ids, and that ids map back to the same strings.
+// Exits with 1 on any mismatch. No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ larkbench.cc `pkg-config laxkit --cflags --libs` -lpthread -o larkbench
+//
+// Usage: larkbench [number of strings] [number of threads]
+
+
+#include <lax/lark.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+static const char *event_names[] = {
+	"menuevent", "traceobjectmenu", "PathInterface", "dashlength", "dashseed", "defaultspacing",
+	"newcolor", "renameobject", "renamegroup", "renametraceobject", "renametrace", "renamedash",
+	"renamespacing", "renamedirection", "exportsvg", "exportsnapshot", "savetraceimage", "loadimage",
+	"loadnormal", "sharedirection", "quickadjust", "orientspacing", "orientdirection", "directiontype",
+	"lineprofilemenu", "directionseed", "spacingmenu", "FreehandInterface",
+	NULL
+};
+
+//! Like the top of a big Event(), return which message it was.
+static int StrcmpChain(const char *mes)
+{
+	for (int c=0; event_names[c]; c++) if (!strcmp(mes, event_names[c])) return c;
+	return -1;
+}
+
+static int LarkChain(int id)
+{
+	if (id == LARK("menuevent")) return 0;
+	else if (id == LARK("traceobjectmenu")) return 1;
+	else if (id == LARK("PathInterface")) return 2;
+	else if (id == LARK("dashlength")) return 3;
+	else if (id == LARK("dashseed")) return 4;
+	else if (id == LARK("defaultspacing")) return 5;
+	else if (id == LARK("newcolor")) return 6;
+	else if (id == LARK("renameobject")) return 7;
+	else if (id == LARK("renamegroup")) return 8;
+	else if (id == LARK("renametraceobject")) return 9;
+	else if (id == LARK("renametrace")) return 10;
+	else if (id == LARK("renamedash")) return 11;
+	else if (id == LARK("renamespacing")) return 12;
+	else if (id == LARK("renamedirection")) return 13;
+	else if (id == LARK("exportsvg")) return 14;
+	else if (id == LARK("exportsnapshot")) return 15;
+	else if (id == LARK("savetraceimage")) return 16;
+	else if (id == LARK("loadimage")) return 17;
+	else if (id == LARK("loadnormal")) return 18;
+	else if (id == LARK("sharedirection")) return 19;
+	else if (id == LARK("quickadjust")) return 20;
+	else if (id == LARK("orientspacing")) return 21;
+	else if (id == LARK("orientdirection")) return 22;
+	else if (id == LARK("directiontype")) return 23;
+	else if (id == LARK("lineprofilemenu")) return 24;
+	else if (id == LARK("directionseed")) return 25;
+	else if (id == LARK("spacingmenu")) return 26;
+	else if (id == LARK("FreehandInterface")) return 27;
+	return -1;
+}
+
+static void Lookups(char **strs, int n, int rounds, int *ids, long *sum)
+{
+	long s = 0;
+	for (int r=0; r<rounds; r++) {
+		for (int c=0; c<n; c++) {
+			int id = lark_id_from_str(strs[c], 1);
+			if (r == 0) ids[c] = id;
+			s += id;
+		}
+	}
+	*sum = s;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = (argc>1 ? strtol(argv[1], NULL, 10) : 20000);
+	if (n <= 0) n = 20000;
+	int numthreads = (argc>2 ? strtol(argv[2], NULL, 10) : 4);
+	if (numthreads <= 0) numthreads = 4;
+
+	char **strs = new char*[n];
+	for (int c=0; c<n; c++) {
+		char buf[64];
+		sprintf(buf, "resource/type%d/name_%x", c%97, c*2654435761u);
+		strs[c] = strdup(buf);
+	}
+
+	int bad = 0;
+	int *ids = new int[n];
+	long sum = 0;
+
+	 //---- create from several threads at once
+	double start = Now();
+	vector<thread> threads;
+	vector<int*> thread_ids;
+	vector<long> sums(numthreads);
+	for (int t=0; t<numthreads; t++) {
+		thread_ids.push_back(new int[n]);
+		threads.push_back(thread(Lookups, strs, n, 1, thread_ids[t], &sums[t]));
+	}
+	for (auto &t : threads) t.join();
+	threads.clear();
+	double create_time = Now() - start;
+
+	for (int t=1; t<numthreads; t++) {
+		if (memcmp(thread_ids[0], thread_ids[t], n*sizeof(int))) bad = 1;
+	}
+	for (int c=0; c<n; c++) {
+		const char *s = lark_str_from_id(thread_ids[0][c]);
+		if (!s || strcmp(s, strs[c])) bad = 1;
+	}
+	if (bad) cout << "Warning! Threads got different ids, or ids map to wrong strings!" << endl;
+
+	 //---- lookups of known strings
+	int rounds = 20;
+	start = Now();
+	Lookups(strs, n, rounds, ids, &sum);
+	double one_time = Now() - start;
+
+	start = Now();
+	for (int t=0; t<numthreads; t++) threads.push_back(thread(Lookups, strs, n, rounds, thread_ids[t], &sums[t]));
+	for (auto &t : threads) t.join();
+	double many_time = Now() - start;
+	for (int t=0; t<numthreads; t++) if (sums[t] != sum) bad = 1;
+
+	cout << n << " strings, " << numthreads << " threads" << endl;
+	cout << "  create in " << numthreads << " threads at once: " << create_time*1000 << " ms" << endl;
+	cout << "  lookup, 1 thread:  " << one_time*1e9/(n*rounds) << " ns each" << endl;
+	cout << "  lookup, " << numthreads << " threads: " << many_time*1e9/(n*rounds*numthreads) << " ns each, "
+		 << many_time*1000 << " ms total" << endl;
+
+	 //---- event name chain
+	int nummes = 0;
+	while (event_names[nummes]) nummes++;
+	int mesids[nummes];
+	for (int c=0; c<nummes; c++) mesids[c] = lark_id_from_str(event_names[c], 1);
+
+	long found = 0, found2 = 0;
+	int reps = 200000;
+	start = Now();
+	for (int r=0; r<reps; r++) found += StrcmpChain(event_names[r % nummes]);
+	double strcmp_time = Now() - start;
+	start = Now();
+	for (int r=0; r<reps; r++) found2 += LarkChain(mesids[r % nummes]);
+	double lark_time = Now() - start;
+	if (found != found2) { cout << "Warning! Lark chain differs from strcmp chain!" << endl; bad = 1; }
+
+	cout << "  " << nummes << " message Event() chain: strcmp " << strcmp_time*1e9/reps << " ns, lark ids "
+		 << lark_time*1e9/reps << " ns per event" << endl;
+
+	for (int c=0; c<n; c++) free(strs[c]);
+	delete[] strs;
+	delete[] ids;
+	for (int t=0; t<numthreads; t++) delete[] thread_ids[t];
+	return bad;
+}
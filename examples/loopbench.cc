@@ -0,0 +1,122 @@
+//
+// Measure event loop wakeup latency and timer jitter.
+//
+// A worker thread sends messages to a window with SendMessage(), and the window records
+// how long each took to arrive. Meanwhile, a timer ticks every few milliseconds, and we record
+// how far each tick is from where it should be.
+//
+// Run with --select to use the older select() loop with bump() through X, for comparison.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ loopbench.cc `pkg-config laxkit --cflags --libs` -lpthread -o loopbench
+
+
+#include <lax/anxapp.h>
+#include <lax/laxutils.h>
+#include "benchutils.h"
+
+#include <unistd.h>
+#include <cmath>
+#include <cstring>
+#include <pthread.h>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+#define NUM_MESSAGES   2000
+#define MESSAGE_GAP_US 1000
+#define NUM_TICKS      1000
+#define TICK_MS        5
+
+
+//--------------------------- BenchWindow -------------------------------
+
+class BenchWindow : public anXWindow
+{
+  public:
+	Stats latency;
+	Stats jitter;
+	long long lasttick;
+	int numticks;
+	int timerid;
+
+	BenchWindow() : anXWindow(NULL,"loopbench","loopbench",0, 0,0,100,100,0, NULL,0,NULL)
+	  { lasttick=0; numticks=0; timerid=0; }
+	virtual int Event(const EventData *data,const char *mes);
+	virtual int Idle(int tid, double delta);
+	virtual void CheckDone();
+};
+
+int BenchWindow::Event(const EventData *data,const char *mes)
+{
+	if (!strcmp(mes,"bench")) {
+		const SimpleMessage *s = dynamic_cast<const SimpleMessage*>(data);
+		long long sent = ((long long)s->info1 << 32) | (unsigned int)s->info2;
+		latency.Add(MonotonicMicroseconds() - sent);
+		CheckDone();
+		return 0;
+	}
+	return anXWindow::Event(data,mes);
+}
+
+int BenchWindow::Idle(int tid, double delta)
+{
+	long long now = MonotonicMicroseconds();
+	if (lasttick) jitter.Add(fabs((now - lasttick) - TICK_MS*1000.));
+	lasttick = now;
+	numticks++;
+	if (numticks >= NUM_TICKS) {
+		CheckDone();
+		return 1;
+	}
+	return 0;
+}
+
+void BenchWindow::CheckDone()
+{
+	if (latency.n >= NUM_MESSAGES && numticks >= NUM_TICKS) app->quit();
+}
+
+
+//--------------------------- sender thread -------------------------------
+
+static void *SendMessages(void *data)
+{
+	BenchWindow *win = (BenchWindow*)data;
+
+	for (int c=0; c<NUM_MESSAGES; c++) {
+		usleep(MESSAGE_GAP_US);
+		long long now = MonotonicMicroseconds();
+		SimpleMessage *s = new SimpleMessage(NULL, (int)(now>>32), (int)(now&0xffffffff), 0,0, "bench", 0, win->object_id);
+		anXApp::app->SendMessage(s, win->object_id, "bench", 0);
+	}
+	return NULL;
+}
+
+
+int main(int argc,char **argv)
+{
+	anXApp app;
+	for (int c=1; c<argc; c++) if (!strcmp(argv[c],"--select")) app.use_epoll = false;
+	app.init(argc,argv);
+
+	BenchWindow *win = new BenchWindow;
+	app.addwindow(win,0,1);
+	win->timerid = app.addtimer(win, TICK_MS, TICK_MS, -1);
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, SendMessages, win);
+
+	app.run();
+	pthread_join(thread, NULL);
+
+	cout << (app.use_epoll ? "epoll" : "select") << " loop" << endl;
+	win->latency.Print("SendMessage wakeup latency");
+	win->jitter .Print("Timer jitter");
+
+	app.close();
+	return 0;
+}
@@ -0,0 +1,231 @@
+//
+// Drag objects around for a few seconds at 60 frames per second, redrawing their previews each frame,
+// first with Previewable::GetPreview(), which renders old previews right away, then with
+// Previewable::GetPreviewAsync(), which renders them on a TaskQueue and draws the old preview meanwhile.
+// Reports the slowest frame, how many renders were done, and how many frames drew an old preview.
+// Also checks that the last async preview matches the final state of each object, and that objects
+// deleted with renders still going are cleaned up. Exits with 1 on any problem. No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ previewbench.cc `pkg-config laxkit --cflags --libs` -lpthread -o previewbench
+//
+// Usage: previewbench [number of objects] [preview size] [seconds]
+
+
+#include <lax/previewable.h>
+#include <lax/laximages.h>
+#include <lax/workerpool.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <unistd.h>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+static unsigned long Checksum(const unsigned char *data, long n)
+{
+	unsigned long sum = 0;
+	for (long c=0; c<n; c++) sum = sum*31 + data[c];
+	return sum;
+}
+
+
+//! Plain memory image, so no cairo or imlib is needed.
+class BufferImage : public LaxImage
+{
+  public:
+	int width, height;
+	unsigned char *data;
+	BufferImage(int w, int h) : LaxImage(NULL) { width = w; height = h; data = new unsigned char[4*w*h]; memset(data, 0, 4*w*h); }
+	virtual ~BufferImage() { delete[] data; }
+	virtual int imagetype() { return LAX_IMAGE_BUFFER; }
+	virtual unsigned int imagestate() { return LAX_IMAGE_WHOLE; }
+	virtual int w() { return width; }
+	virtual int h() { return height; }
+	virtual void clear() {}
+	virtual unsigned char *getImageBuffer() { return data; }
+	virtual int doneWithBuffer(unsigned char *buffer) { return 0; }
+	virtual LaxImage *Crop(int x, int y, int width, int height, bool return_new) { return NULL; }
+	virtual void Set(double r, double g, double b, double a) {}
+	virtual int Save(const char *tofile, const char *format) { return 1; }
+};
+
+
+//! Where the blobs of a Drawing are. Drawings render from a copy of this.
+struct Blobs
+{
+	int n;
+	double x[40], y[40], r[40];
+};
+
+//! Slow on purpose, something like rendering a complicated path or mesh.
+static int RenderBlobs(const Blobs &blobs, LaxImage *image)
+{
+	unsigned char *data = image->getImageBuffer();
+	int w = image->w(), h = image->h();
+	for (int y=0; y<h; y++) {
+		for (int x=0; x<w; x++) {
+			double v = 0;
+			for (int c=0; c<blobs.n; c++) {
+				double dx = x - blobs.x[c]*w, dy = y - blobs.y[c]*h;
+				v += blobs.r[c] * exp(-(dx*dx + dy*dy) / (w*w*blobs.r[c]*blobs.r[c]));
+			}
+			unsigned char *p = data + 4*(y*w + x);
+			p[0] = p[1] = p[2] = (v > 1 ? 255 : 255*v);
+			p[3] = 255;
+		}
+	}
+	image->doneWithBuffer(data);
+	return 0;
+}
+
+static std::atomic<int> num_renders(0);
+
+class BlobRender : public PreviewRender
+{
+  public:
+	Blobs blobs;
+	BlobRender(LaxImage *img, const Blobs &b) : PreviewRender(img) { blobs = b; }
+	virtual int Render() { num_renders++; return RenderBlobs(blobs, image); }
+};
+
+class Drawing : public Previewable
+{
+  public:
+	Blobs blobs;
+	int size;
+
+	Drawing(int which, int nsize) {
+		size = nsize;
+		setbounds(0,1, 0,1);
+		blobs.n = 40;
+		for (int c=0; c<blobs.n; c++) {
+			blobs.x[c] = .5 + .4*cos(c + which);
+			blobs.y[c] = .5 + .4*sin(c*1.3 + which);
+			blobs.r[c] = .05 + .01*(c%5);
+		}
+	}
+
+	 //like dragging a control point
+	void Nudge(int frame) {
+		blobs.x[frame % blobs.n] += .001*((frame/blobs.n)%2 ? -1 : 1);
+		touchContents();
+	}
+
+	virtual bool CanRenderPreview() { return true; }
+	virtual int GeneratePreview(int w, int h) {
+		if (!preview) preview = new BufferImage(size, size);
+		num_renders++;
+		RenderBlobs(blobs, preview);
+		tms tms_;
+		previewtime = times(&tms_);
+		return 0;
+	}
+	virtual int renderToBufferImage(LaxImage *image) { return RenderBlobs(blobs, image); }
+	virtual PreviewRender *NewPreviewRender() { return new BlobRender(new BufferImage(size, size), blobs); }
+};
+
+
+static int Run(const char *what, int n, int size, double seconds, bool async)
+{
+	Drawing **drawings = new Drawing*[n];
+	for (int c=0; c<n; c++) drawings[c] = new Drawing(c, size);
+
+	const double frame_time = 1/60.;
+	num_renders = 0;
+	double worst = 0, start = Now();
+	int frames = 0, edits = 0, old = 0;
+
+	while (Now() - start < seconds) {
+		double fstart = Now();
+
+		 //drag around in one object, while the others sit still
+		drawings[0]->Nudge(frames);
+		edits++;
+
+		for (int c=0; c<n; c++) {
+			LaxImage *preview = (async ? drawings[c]->GetPreviewAsync() : drawings[c]->GetPreview());
+			if (!preview || drawings[c]->HasOldPreview() || drawings[c]->PreviewPending()) old++;
+		}
+
+		double t = Now() - fstart;
+		if (t > worst) worst = t;
+		if (t < frame_time) usleep((frame_time - t) * 1e6); //as if waiting for the next screen refresh
+		frames++;
+	}
+	double total = Now() - start;
+
+	 //after editing stops, the async preview must catch up with the final state
+	int bad = 0;
+	if (async) {
+		for (int tries=0; tries<1000; tries++) {
+			bool pending = false;
+			for (int c=0; c<n; c++) {
+				drawings[c]->GetPreviewAsync();
+				if (drawings[c]->PreviewPending() || drawings[c]->HasOldPreview()) pending = true;
+			}
+			if (!pending) break;
+			usleep(10000);
+		}
+		for (int c=0; c<n; c++) {
+			LaxImage *preview = drawings[c]->GetPreviewAsync();
+			BufferImage check(size, size);
+			RenderBlobs(drawings[c]->blobs, &check);
+			if (!preview || Checksum(check.data, 4*size*size) != Checksum(((BufferImage*)preview)->data, 4*size*size)) bad = 1;
+		}
+		if (bad) cout << "Warning! Async preview does not match the final state!" << endl;
+	}
+
+	cout << what << endl;
+	cout << "  " << frames << " frames in " << total*1000 << " ms, slowest frame " << worst*1000 << " ms, "
+		 << num_renders << " renders for " << edits << " edits, " << old << " of " << frames*n << " previews drawn were old" << endl;
+
+	for (int c=0; c<n; c++) drawings[c]->dec_count();
+	delete[] drawings;
+	return bad;
+}
+
+//! Delete objects with renders queued and running, then make sure they are all cleaned up.
+static int CheckCancel(int size)
+{
+	const int n = 20;
+	Drawing *drawings[n];
+	for (int c=0; c<n; c++) {
+		drawings[c] = new Drawing(c, size);
+		drawings[c]->GetPreviewAsync();
+	}
+	usleep(1000); //so one is probably running
+	for (int c=0; c<n; c++) drawings[c]->dec_count();
+
+	TaskQueue::Default()->Wait();
+	int left = Previewable::CheckPreviews();
+	if (left) cout << "Warning! " << left << " previews not cleaned up!" << endl;
+	return left != 0;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = (argc>1 ? strtol(argv[1], NULL, 10) : 4);
+	if (n <= 0) n = 4;
+	int size = (argc>2 ? strtol(argv[2], NULL, 10) : 200);
+	if (size < 16) size = 200;
+	double seconds = (argc>3 ? strtod(argv[3], NULL) : 3);
+	if (seconds <= 0) seconds = 3;
+
+	cout << n << " objects, " << size << "x" << size << " previews, one being edited each frame" << endl;
+
+	int bad = 0;
+	bad |= Run("GetPreview():", n, size, seconds, false);
+	bad |= Run("GetPreviewAsync():", n, size, seconds, true);
+	bad |= CheckCancel(size);
+	return bad;
+}
@@ -0,0 +1,144 @@
+//
+// Time Path::UpdateCache() for single vertex drags on long weighted paths, and check that
+// each incremental recache matches a full rebuild of a duplicate path exactly.
+// No X connection is needed. Exits with 1 if any cache differs.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ recachebench.cc `pkg-config laxkit --cflags --libs` -llaxinterfaces -o recachebench
+
+
+#include <lax/interfaces/pathinterface.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+using namespace LaxInterfaces;
+
+
+#define NUM_DRAGS 50
+
+
+static bool SameCache(NumStack<flatpoint> &a, NumStack<flatpoint> &b)
+{
+	if (a.n != b.n) return false;
+	for (int c=0; c<a.n; c++) {
+		if (a.e[c].x != b.e[c].x || a.e[c].y != b.e[c].y || a.e[c].info != b.e[c].info) return false;
+	}
+	return true;
+}
+
+//! Return 0 if path's current caches match a fresh full rebuild, else 1.
+static int CheckAgainstFull(Path *path, const char *what)
+{
+	Path *full = path->duplicate();
+	full->cache_types = path->cache_types;
+	full->UpdateCache();
+
+	int bad = 0;
+	if (!SameCache(path->outlinecache, full->outlinecache)) { cout << what << ": outlinecache differs!" << endl; bad = 1; }
+	if (!SameCache(path->centercache,  full->centercache))  { cout << what << ": centercache differs!"  << endl; bad = 1; }
+	if (!SameCache(path->cache_top,    full->cache_top))    { cout << what << ": cache_top differs!"    << endl; bad = 1; }
+	if (!SameCache(path->cache_bottom, full->cache_bottom)) { cout << what << ": cache_bottom differs!" << endl; bad = 1; }
+
+	full->dec_count();
+	return bad;
+}
+
+//! Make a wavy bezier path with n vertices, and a weight node every few segments.
+static Path *MakePath(int n, bool closed)
+{
+	Path *path = new Path();
+	path->cache_types = 1;
+
+	double x = 0;
+	path->append(flatpoint(0,0));
+	for (int c=1; c<n; c++) {
+		double y = (c%2 ? 1 : -1) * (1 + Random(.5));
+		path->append(flatpoint(x + .3, 0), POINT_TOPREV);
+		path->append(flatpoint(x + .7, y), POINT_TONEXT);
+		x += 1;
+		path->append(flatpoint(x, y));
+	}
+	if (closed) path->close();
+
+	for (int c=0; c<n-1; c+=7) path->AddWeightNode(c + .5, Random(.1), .2 + Random(.3), 0);
+	return path;
+}
+
+//! Move the vertex at index along with its control handles.
+static void Drag(Path *path, int index, flatpoint d)
+{
+	Coordinate *v = path->path;
+	for (int c=0; c<index; c++) v = v->nextVertex(0);
+
+	v->fp += d;
+	if (v->prev && (v->prev->flags & POINT_TONEXT)) v->prev->fp += d;
+	if (v->next && (v->next->flags & POINT_TOPREV)) v->next->fp += d;
+	path->needtorecache = 1;
+}
+
+
+int main(int argc,char **argv)
+{
+	int sizes[] = { 500, 5000 };
+	int bad = 0;
+
+	 //debug output from the outline code would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	for (int s=0; s<2; s++) {
+		for (int closed=0; closed<2; closed++) {
+			int n = sizes[s];
+			srand(1);
+			Path *path = MakePath(n, closed);
+
+			double start = Now();
+			path->UpdateCache();
+			double full_time = Now() - start;
+
+			 //drag one vertex around, like a mouse move
+			double drag_time = 0;
+			int index = n/2;
+			for (int c=0; c<NUM_DRAGS; c++) {
+				Drag(path, index, flatpoint(Random(.2) - .1, Random(.2) - .1));
+				start = Now();
+				path->UpdateCache();
+				drag_time += Now() - start;
+			}
+			bad |= CheckAgainstFull(path, "drag");
+
+			 //ends, which touch the caps or the closing join
+			Drag(path, 0, flatpoint(.1, .1));
+			path->UpdateCache();
+			bad |= CheckAgainstFull(path, "drag first");
+			Drag(path, n-1, flatpoint(-.1, .1));
+			path->UpdateCache();
+			bad |= CheckAgainstFull(path, "drag last");
+
+			 //structural edits, which must invalidate more than one segment
+			path->AddAt(index + .5);
+			path->needtorecache = 1;
+			path->UpdateCache();
+			bad |= CheckAgainstFull(path, "add point");
+
+			path->MoveWeight(1, path->pathweights.e[1]->t + .3);
+			path->needtorecache = 1;
+			path->UpdateCache();
+			bad |= CheckAgainstFull(path, "move weight");
+
+			cout << n << " vertices, " << (closed ? "closed" : "open") << endl;
+			cout << "  full UpdateCache(): " << full_time*1000 << " ms" << endl;
+			cout << "  single vertex drag: " << drag_time/NUM_DRAGS*1000 << " ms per recache" << endl;
+
+			path->dec_count();
+		}
+	}
+
+	if (bad) cout << "Warning! Incremental caches differ from a full rebuild!" << endl;
+	return bad;
+}
@@ -0,0 +1,79 @@
+//
+// Time PointSet::Relax(), PointSet::RelaxWeighted() and PointSet::Closest() on 1k, 10k and 100k random points.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ relaxbench.cc `pkg-config laxkit --cflags --libs` -o relaxbench
+
+
+#include <lax/pointset.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+#define ITERATIONS  10
+#define NUM_QUERIES 10000
+
+
+int main(int argc,char **argv)
+{
+	int sizes[] = { 1000, 10000, 100000 };
+
+	for (int s=0; s<3; s++) {
+		int n = sizes[s];
+		double side = sqrt((double)n); //about 1 unit between points
+
+		PointSet set;
+		srand(1);
+		for (int c=0; c<n; c++) set.AddPoint(flatpoint(Random(side), Random(side)), nullptr, false, .5 + Random(1));
+
+		DoubleBBox box;
+		set.GetBBox(box);
+
+		double start = Now();
+		set.Relax(ITERATIONS, 1, .1, box);
+		double relax = Now() - start;
+
+		start = Now();
+		set.RelaxWeighted(ITERATIONS, 1, .5, nullptr, 0);
+		double weighted = Now() - start;
+
+		 //Closest with the grid, checked against a linear scan
+		int mismatches = 0;
+		double grid_time = 0, linear_time = 0;
+		for (int q=0; q<NUM_QUERIES; q++) {
+			flatpoint p(Random(side*1.2) - side*.1, Random(side*1.2) - side*.1);
+
+			start = Now();
+			int i = set.Closest(p);
+			grid_time += Now() - start;
+
+			start = Now();
+			int best = -1;
+			double bestd = 1e+100;
+			for (int c=0; c<n; c++) {
+				double d = norm2(set.points.e[c]->p - p);
+				if (d < bestd) { bestd = d; best = c; }
+			}
+			linear_time += Now() - start;
+
+			if (i != best && norm2(set.points.e[i]->p - p) != bestd) mismatches++;
+		}
+
+		cout << n << " points, " << ITERATIONS << " iterations" << endl;
+		cout << "  Relax():         " << relax*1000 << " ms" << endl;
+		cout << "  RelaxWeighted(): " << weighted*1000 << " ms" << endl;
+		cout << "  Closest():       " << grid_time/NUM_QUERIES*1e6 << " us per query, linear scan "
+			 << linear_time/NUM_QUERIES*1e6 << " us" << endl;
+		if (mismatches) cout << "Warning! " << mismatches << " Closest() results differ!" << endl;
+	}
+
+	return 0;
+}
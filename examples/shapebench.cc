@@ -0,0 +1,300 @@
+//
+// Shape a long caption line by line and turn its glyphs into paths, the way CaptionData::RecacheLine()
+// and ConvertToPaths() used to, opening the font and creating harfbuzz buffers every time and
+// decomposing every glyph again on each conversion, then with TextShaper, cold and warm.
+// Also checks that shaped runs and outlines from TextShaper are the same as freshly made ones.
+// Exits with 1 on any mismatch. No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ shapebench.cc `pkg-config laxkit --cflags --libs` -llaxinterfaces -lharfbuzz -o shapebench
+//
+// Usage: shapebench [font file] [number of characters] [rounds]
+
+
+#include <lax/interfaces/texttopath.h>
+#include <lax/interfaces/pathinterface.h>
+#include <lax/strmanip.h>
+#include <lax/laxdefs.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+using namespace LaxInterfaces;
+
+
+static const char *words[] = {
+	"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "Typography", "kerning",
+	"office", "affine", "waffle", "AVATAR", "Tokyo", "1234567890", "quartz", "sphinx", "of", "black",
+	NULL
+};
+
+//! Like the old RecacheLine(): new face, new hb font, new buffer, for every line.
+static int OldShape(FT_Library library, const char *file, double size, const char *line, ShapedGlyph *glyphs)
+{
+	FT_Face ft_face;
+	if (FT_New_Face(library, file, 0, &ft_face)) return -1;
+	FT_Set_Char_Size(ft_face, size*64, size*64, 0, 0);
+	hb_font_t *hb_font = hb_ft_font_create(ft_face, NULL);
+
+	hb_buffer_t *hb_buffer = hb_buffer_create();
+	hb_buffer_add_utf8(hb_buffer, line, -1, 0, -1);
+	hb_buffer_guess_segment_properties(hb_buffer);
+	hb_shape(hb_font, hb_buffer, NULL, 0);
+
+	unsigned int n           = hb_buffer_get_length(hb_buffer);
+	hb_glyph_info_t *info    = hb_buffer_get_glyph_infos(hb_buffer, NULL);
+	hb_glyph_position_t *pos = hb_buffer_get_glyph_positions(hb_buffer, NULL);
+	for (unsigned int i=0; i<n; i++) {
+		glyphs[i].index     = info[i].codepoint;
+		glyphs[i].cluster   = info[i].cluster;
+		glyphs[i].x_advance = pos[i].x_advance / 64.;
+		glyphs[i].y_advance = pos[i].y_advance / 64.;
+		glyphs[i].x_offset  = pos[i].x_offset  / 64.;
+		glyphs[i].y_offset  = pos[i].y_offset  / 64.;
+	}
+
+	hb_buffer_destroy(hb_buffer);
+	hb_font_destroy(hb_font);
+	FT_Done_Face(ft_face);
+	return n;
+}
+
+static int NumPoints(PathsData *paths)
+{
+	int n = 0;
+	for (int p=0; p<paths->paths.n; p++) {
+		Coordinate *start = paths->paths.e[p]->path, *coord = start;
+		while (coord) {
+			n++;
+			coord = coord->next;
+			if (coord == start) break;
+		}
+	}
+	return n;
+}
+
+//! Like the old ConvertToPaths(): open the face, then load and decompose each glyph the first time it is seen.
+static int OldConvert(FT_Library library, const char *file, double size, ShapedGlyph **lines, int *numglyphs, int numlines,
+					  int *points)
+{
+	FT_Face ft_face;
+	if (FT_New_Face(library, file, 0, &ft_face)) return -1;
+	FT_Set_Char_Size(ft_face, size*64, size*64, 0, 0);
+
+	FT_Outline_Funcs outline_funcs;
+	outline_funcs.move_to  = pathsdata_ft_move_to;
+	outline_funcs.line_to  = pathsdata_ft_line_to;
+	outline_funcs.conic_to = pathsdata_ft_conic_to;
+	outline_funcs.cubic_to = pathsdata_ft_cubic_to;
+	outline_funcs.shift    = 0;
+	outline_funcs.delta    = 0;
+
+	int total = 0;
+	char seen[ft_face->num_glyphs];
+	memset(seen, 0, ft_face->num_glyphs);
+	for (int l=0; l<numlines; l++) {
+		for (int g=0; g<numglyphs[l]; g++) {
+			unsigned int index = lines[l][g].index;
+			if (seen[index]) continue;
+			seen[index] = 1;
+
+			if (FT_Load_Glyph(ft_face, index, FT_LOAD_NO_BITMAP) != 0) continue;
+			if (ft_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE) continue;
+			PathsData *outline = new PathsData();
+			FT_Outline_Decompose(&ft_face->glyph->outline, &outline_funcs, outline);
+			outline->close();
+			if (points) points[index] = NumPoints(outline);
+			total++;
+			outline->dec_count();
+		}
+	}
+
+	FT_Done_Face(ft_face);
+	return total;
+}
+
+//! The new ConvertToPaths(): the same, but the shaper only decomposes once ever.
+static int NewConvert(TextShaper *shaper, const char *file, double size, ShapedGlyph **lines, int *numglyphs, int numlines,
+					  int numfaceglyphs, int *points)
+{
+	int total = 0;
+	char seen[numfaceglyphs];
+	memset(seen, 0, numfaceglyphs);
+	for (int l=0; l<numlines; l++) {
+		for (int g=0; g<numglyphs[l]; g++) {
+			unsigned int index = lines[l][g].index;
+			if (seen[index]) continue;
+			seen[index] = 1;
+
+			PathsData *outline = new PathsData();
+			if (shaper->AppendOutline(file, size, index, outline) == 0) {
+				outline->close();
+				if (points) points[index] = NumPoints(outline);
+				total++;
+			}
+			outline->dec_count();
+		}
+	}
+	return total;
+}
+
+static bool SameGlyphs(const ShapedGlyph *a, const ShapedGlyph *b, int n)
+{
+	for (int c=0; c<n; c++) {
+		if (a[c].index != b[c].index || a[c].cluster != b[c].cluster
+				|| a[c].x_advance != b[c].x_advance || a[c].y_advance != b[c].y_advance
+				|| a[c].x_offset != b[c].x_offset || a[c].y_offset != b[c].y_offset)
+			return false;
+	}
+	return true;
+}
+
+
+int main(int argc,char **argv)
+{
+	const char *file = (argc>1 ? argv[1] : "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf");
+	int n = (argc>2 ? strtol(argv[2], NULL, 10) : 10000);
+	if (n <= 0) n = 10000;
+	int rounds = (argc>3 ? strtol(argv[3], NULL, 10) : 10);
+	if (rounds <= 0) rounds = 10;
+	double size = 24;
+
+	 //debug output would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	FT_Library library;
+	FT_Face face;
+	if (FT_Init_FreeType(&library) || FT_New_Face(library, file, 0, &face)) {
+		cout << "Could not load font " << file << endl;
+		return 1;
+	}
+	int numfaceglyphs = face->num_glyphs;
+	FT_Done_Face(face);
+
+	 //about 60 characters per line, like a long caption
+	int numlines = 0, maxlines = n/20 + 1;
+	char **lines = new char*[maxlines];
+	int total = 0, w = 0;
+	while (total < n && numlines < maxlines) {
+		char *line = NULL;
+		while (!line || (int)strlen(line) < 60) {
+			if (line) appendstr(line, " ");
+			appendstr(line, words[w % 20]);
+			w = w*7 + 3;
+			if (w > 1000000) w = w % 997;
+		}
+		total += strlen(line);
+		lines[numlines++] = line;
+	}
+
+	ShapedGlyph **oldglyphs = new ShapedGlyph*[numlines];
+	ShapedGlyph **newglyphs = new ShapedGlyph*[numlines];
+	int *numold = new int[numlines];
+	int *numnew = new int[numlines];
+	int *numalloc = new int[numlines];
+	for (int l=0; l<numlines; l++) {
+		oldglyphs[l] = new ShapedGlyph[strlen(lines[l]) * 4];
+		newglyphs[l] = NULL;
+		numalloc[l] = 0;
+	}
+
+	TextShaper *shaper = TextShaper::Default();
+	int bad = 0;
+	cout << numlines << " lines, " << total << " characters, " << rounds << " rounds, " << file << endl;
+
+	 //---- shaping every line, like recaching the whole caption
+	double start = Now();
+	for (int r=0; r<rounds; r++)
+		for (int l=0; l<numlines; l++) numold[l] = OldShape(library, file, size, lines[l], oldglyphs[l]);
+	double old_time = Now() - start;
+
+	start = Now();
+	for (int r=0; r<rounds; r++) {
+		shaper->Clear();
+		for (int l=0; l<numlines; l++)
+			numnew[l] = shaper->Shape(file, size, lines[l], -1, 0, NULL, NULL, NULL, newglyphs[l], numalloc[l]);
+	}
+	double cold_time = Now() - start;
+
+	start = Now();
+	for (int r=0; r<rounds; r++)
+		for (int l=0; l<numlines; l++)
+			numnew[l] = shaper->Shape(file, size, lines[l], -1, 0, NULL, NULL, NULL, newglyphs[l], numalloc[l]);
+	double warm_time = Now() - start;
+
+	int numglyphs = 0;
+	for (int l=0; l<numlines; l++) {
+		numglyphs += numold[l];
+		if (numold[l] != numnew[l] || !SameGlyphs(oldglyphs[l], newglyphs[l], numold[l])) bad = 1;
+	}
+	if (bad) cout << "Warning! Shaped runs differ from freshly shaped ones!" << endl;
+
+	cout << "  shape all lines: " << old_time*1000/rounds << " ms old way, " << cold_time*1000/rounds << " ms cold, "
+		 << warm_time*1000/rounds << " ms warm, " << numglyphs << " glyphs" << endl;
+
+	 //---- converting to paths again and again
+	int *oldpoints = new int[numfaceglyphs];
+	int *newpoints = new int[numfaceglyphs];
+	memset(oldpoints, 0, numfaceglyphs*sizeof(int));
+	memset(newpoints, 0, numfaceglyphs*sizeof(int));
+	int numold_outlines = 0, numnew_outlines = 0;
+
+	start = Now();
+	for (int r=0; r<rounds; r++) numold_outlines = OldConvert(library, file, size, oldglyphs, numold, numlines, r==0 ? oldpoints : NULL);
+	old_time = Now() - start;
+
+	long misses_before = 0, misses_after = 0;
+	shaper->Stats(NULL, NULL, NULL, &misses_before);
+	start = Now();
+	for (int r=0; r<rounds; r++)
+		numnew_outlines = NewConvert(shaper, file, size, newglyphs, numnew, numlines, numfaceglyphs, r==0 ? newpoints : NULL);
+	double new_time = Now() - start;
+	shaper->Stats(NULL, NULL, NULL, &misses_after);
+
+	if (numold_outlines != numnew_outlines || memcmp(oldpoints, newpoints, numfaceglyphs*sizeof(int))) {
+		cout << "Warning! Cached outlines differ from freshly decomposed ones!" << endl;
+		bad = 1;
+	}
+	int numdistinct = 0;
+	char seen[numfaceglyphs];
+	memset(seen, 0, numfaceglyphs);
+	for (int l=0; l<numlines; l++)
+		for (int g=0; g<numnew[l]; g++)
+			if (!seen[newglyphs[l][g].index]) { seen[newglyphs[l][g].index] = 1; numdistinct++; }
+	if (misses_after - misses_before > numdistinct) {
+		cout << "Warning! Glyphs were decomposed more than once!" << endl;
+		bad = 1;
+	}
+
+	cout << "  convert to paths: " << old_time*1000/rounds << " ms old way, " << new_time*1000/rounds << " ms with TextShaper, "
+		 << numnew_outlines << " distinct glyphs, " << misses_after - misses_before << " decomposed in " << rounds << " conversions" << endl;
+
+	long run_hits, run_misses, outline_hits, outline_misses;
+	shaper->Stats(&run_hits, &run_misses, &outline_hits, &outline_misses);
+	cout << "  shaper holds " << shaper->NumRuns() << " runs and " << shaper->NumOutlines() << " outlines, "
+		 << run_hits << " run hits, " << run_misses << " run misses, "
+		 << outline_hits << " outline hits, " << outline_misses << " outline misses" << endl;
+
+	for (int l=0; l<numlines; l++) {
+		delete[] lines[l];
+		delete[] oldglyphs[l];
+		delete[] newglyphs[l];
+	}
+	delete[] lines;
+	delete[] oldglyphs;
+	delete[] newglyphs;
+	delete[] numold;
+	delete[] numnew;
+	delete[] numalloc;
+	delete[] oldpoints;
+	delete[] newpoints;
+	FT_Done_FreeType(library);
+	return bad;
+}
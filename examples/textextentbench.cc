@@ -0,0 +1,140 @@
+//
+// Time DisplayerCairo::textextent() on many short strings, like the items of a TreeSelector or
+// PopupMenu being laid out, with CairoTextCache cold, which is what every call used to cost, and warm.
+// Times it in the current font with and without a current cairo_t, and in a font other than the current
+// one, which used to switch fonts twice per call. Also times drawing the strings with textout().
+// Checks that cached extents are the same as freshly measured ones. Exits with 1 on any mismatch.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ textextentbench.cc `pkg-config laxkit --cflags --libs` -o textextentbench
+//
+// Usage: textextentbench [number of strings] [rounds]
+
+
+#include <lax/anxapp.h>
+#include <lax/displayer-cairo.h>
+#include <lax/laximages.h>
+#include <lax/strmanip.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+//! Measure all strs rounds times, clearing the cache before each round if cold. Returns calls per second.
+static double Measure(Displayer *dp, LaxFont *font, char **strs, int n, int rounds, bool cold, double *widths)
+{
+	CairoTextCache *cache = CairoTextCache::Default();
+	double w, h, a, d;
+	double start = Now();
+	for (int r=0; r<rounds; r++) {
+		if (cold) cache->Clear();
+		for (int c=0; c<n; c++) {
+			dp->textextent(font, strs[c], -1, &w, &h, &a, &d, 0);
+			if (r == 0) widths[c] = w;
+		}
+	}
+	return n*rounds / (Now() - start);
+}
+
+//! Draw all strs rounds times, like redrawing a list. Returns strings drawn per second.
+static double Draw(Displayer *dp, char **strs, int n, int rounds, bool cold)
+{
+	CairoTextCache *cache = CairoTextCache::Default();
+	double start = Now();
+	for (int r=0; r<rounds; r++) {
+		if (cold) cache->Clear();
+		dp->ClearWindow();
+		for (int c=0; c<n; c++) dp->textout(5, 5 + (c%40)*15, strs[c], -1, LAX_LEFT|LAX_TOP);
+	}
+	return n*rounds / (Now() - start);
+}
+
+static int Report(const char *what, double cold, double warm, double *cold_widths, double *warm_widths, int n)
+{
+	int bad = 0;
+	for (int c=0; c<n; c++) if (cold_widths[c] != warm_widths[c]) bad++;
+	cout << "  " << what << cold << " calls/s cold, " << warm << " calls/s warm, " << warm/cold << "x" << endl;
+	if (bad) cout << "Warning! " << bad << " cached extents differ from measured ones!" << endl;
+	return bad ? 1 : 0;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = (argc>1 ? strtol(argv[1], NULL, 10) : 2000);
+	if (n <= 0) n = 2000;
+	int rounds = (argc>2 ? strtol(argv[2], NULL, 10) : 20);
+	if (rounds <= 0) rounds = 20;
+
+	anXApp app;
+	app.Backend("cairo");
+	app.initNoX(argc, argv);
+
+	 //debug output would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	char **strs = new char*[n];
+	char scratch[100];
+	for (int c=0; c<n; c++) {
+		if (c%3 == 0) sprintf(scratch, "Menu item %d", c);
+		else if (c%3 == 1) sprintf(scratch, "/home/someone/images/photo_%04d.jpg", c);
+		else sprintf(scratch, "Ünïcödé → %d ✓", c);
+		strs[c] = newstr(scratch);
+	}
+	double *cold_widths = new double[n];
+	double *warm_widths = new double[n];
+
+	Displayer *dp = newDisplayer(NULL);
+	LaxFont *font = app.defaultlaxfont;
+	LaxFont *other = GetDefaultFontManager()->MakeFont("serif", "normal", 20, -1);
+	dp->font(font, font->textheight());
+
+	cout << n << " strings, " << rounds << " rounds" << endl;
+	int bad = 0;
+	double cold, warm;
+
+	 //like widgets measuring before they draw, with no cairo_t
+	cold = Measure(dp, font, strs, n, rounds, true, cold_widths);
+	warm = Measure(dp, font, strs, n, rounds, false, warm_widths);
+	bad |= Report("textextent(), no cairo_t:  ", cold, warm, cold_widths, warm_widths, n);
+
+	cold = Measure(dp, other, strs, n, rounds, true, cold_widths);
+	warm = Measure(dp, other, strs, n, rounds, false, warm_widths);
+	bad |= Report("textextent(), other font:  ", cold, warm, cold_widths, warm_widths, n);
+
+	LaxImage *image = ImageLoader::NewImage(400, 600);
+	dp->MakeCurrent(image);
+	dp->font(font, font->textheight());
+	cold = Measure(dp, font, strs, n, rounds, true, cold_widths);
+	warm = Measure(dp, font, strs, n, rounds, false, warm_widths);
+	bad |= Report("textextent(), on an image: ", cold, warm, cold_widths, warm_widths, n);
+
+	cold = Draw(dp, strs, n, rounds, true);
+	warm = Draw(dp, strs, n, rounds, false);
+	cout << "  textout(), on an image:    " << cold << " strings/s cold, " << warm << " strings/s warm, "
+		 << warm/cold << "x" << endl;
+
+	long hits = 0, misses = 0;
+	CairoTextCache::Default()->Stats(&hits, &misses);
+	cout << "  cache holds " << CairoTextCache::Default()->NumRuns() << " runs, " << hits << " hits, "
+		 << misses << " misses in all" << endl;
+
+	dp->EndDrawing();
+	image->dec_count();
+	other->dec_count();
+	dp->dec_count();
+	for (int c=0; c<n; c++) delete[] strs[c];
+	delete[] strs;
+	delete[] cold_widths;
+	delete[] warm_widths;
+	return bad;
+}
@@ -0,0 +1,208 @@
+//
+// Open, expand and collapse, and scroll through a TreeSelector holding a big tree, like a file browser
+// or a resource list, first as usual, then with TREESEL_VIRTUAL, which only measures rows near the
+// viewport and splices rows in and out on expand and collapse. Reports times and how many items were
+// measured with getitemextent() for each. Also checks that the spliced rows match a full rebuild, and
+// that findItem() and lazy measuring give the right rows. Exits with 1 on any mismatch.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ treeselectorbench.cc `pkg-config laxkit --cflags --libs` -o treeselectorbench
+//
+// Usage: treeselectorbench [number of folders] [items per folder]
+
+
+#include <lax/anxapp.h>
+#include <lax/treeselector.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+//! Does what init(), Refresh() and the mouse would, without needing a window on screen.
+class BenchTree : public TreeSelector
+{
+  public:
+	long num_extents;
+
+	BenchTree(MenuInfo *menu, unsigned long long style)
+	  : TreeSelector(NULL, "tree", "tree", 0, 0,0,400,800, 0, NULL, 0, NULL, style, menu)
+	{
+		num_extents = 0;
+	}
+
+	virtual double getitemextent(MenuItem *mitem, double *w, double *h, double *gx, double *tx)
+	{
+		num_extents++;
+		return TreeSelector::getitemextent(mitem, w, h, gx, tx);
+	}
+
+	 //like init() and syncWindows()
+	void Open()
+	{
+		inrect.x = inrect.y = 0;
+		inrect.width  = win_w;
+		inrect.height = win_h;
+		textheight = UIScale() * win_themestyle->normal->textheight();
+		iwidth = textheight;
+		padg   = textheight / 2;
+		pad    = textheight * .3;
+		needtobuildcache = 1;
+		arrangeItems();
+	}
+
+	 //like clicking on the arrow of a row in LBUp()
+	void Toggle(int row)
+	{
+		if (visibleitems.e(row)->isOpen()) Collapse(row);
+		else Expand(row);
+		arrangeItems();
+	}
+
+	 //like WheelDown(), then the rows Refresh() lays out
+	void Scroll(int dy)
+	{
+		movescreen(0, dy);
+		int first, last;
+		if ((menustyle & TREESEL_VIRTUAL) && visibleRange(&first, &last)) {
+			for (int c = first; c <= last; c++) item(c);
+		}
+	}
+
+	int NumRows() { return visibleitems.menuitems.n; }
+	MenuItem **Rows() { return visibleitems.menuitems.e; }
+	void Rebuild() { needtobuildcache = 1; RebuildCache(); }
+	int Step() { return rowstep; }
+	int Row(int y) { int onsub; return findItem(inrect.x + 1, y + offsety + inrect.y, &onsub); }
+};
+
+
+static void SetOpen(MenuInfo *menu)
+{
+	for (int c=0; c<menu->n(); c++) {
+		if (c%3 == 0) menu->e(c)->state |= MENU_OPEN;
+		else menu->e(c)->state &= ~MENU_OPEN;
+	}
+}
+
+static int Run(const char *what, MenuInfo *menu, unsigned long long style)
+{
+	SetOpen(menu);
+	BenchTree *tree = new BenchTree(menu, style);
+	srand(1);
+
+	double start = Now();
+	tree->Open();
+	double open_time = Now() - start;
+	long open_extents = tree->num_extents;
+
+	 //expand and collapse random folders
+	tree->num_extents = 0;
+	int toggles = 0;
+	start = Now();
+	while (toggles < 50) {
+		int row = rand() % tree->NumRows();
+		if (!tree->Rows()[row]->hasSub()) continue;
+		tree->Toggle(row);
+		toggles++;
+	}
+	double toggle_time = Now() - start;
+	long toggle_extents = tree->num_extents;
+
+	 //scroll a page at a time down and back up
+	tree->num_extents = 0;
+	int pages = 500;
+	start = Now();
+	for (int c=0; c<pages; c++) tree->Scroll(800);
+	for (int c=0; c<pages; c++) tree->Scroll(-800);
+	double scroll_time = Now() - start;
+	long scroll_extents = tree->num_extents;
+
+	cout << what << " " << tree->NumRows() << " rows" << endl;
+	cout << "  open " << open_time*1000 << " ms, " << open_extents << " measured" << endl;
+	cout << "  " << toggles << " expand or collapse " << toggle_time*1000 << " ms, " << toggle_extents << " measured" << endl;
+	cout << "  " << 2*pages << " pages scrolled " << scroll_time*1000 << " ms, " << scroll_extents << " measured" << endl;
+
+	int bad = 0;
+	if (style & TREESEL_VIRTUAL) {
+		 //spliced rows must be the same as rebuilding from scratch
+		int n = tree->NumRows();
+		MenuItem **rows = new MenuItem*[n];
+		memcpy(rows, tree->Rows(), n*sizeof(MenuItem*));
+		tree->Rebuild();
+		if (n != tree->NumRows() || memcmp(rows, tree->Rows(), n*sizeof(MenuItem*))) {
+			cout << "Warning! Expand and collapse gave different rows than a rebuild!" << endl;
+			bad = 1;
+		}
+		delete[] rows;
+
+		 //findItem() and lazy measuring
+		double w, h;
+		for (int c=0; c<1000 && !bad; c++) {
+			int row = rand() % tree->NumRows();
+			MenuItem *mitem = const_cast<MenuItem*>(tree->Item(row));
+			tree->getitemextent(mitem, &w, &h, NULL, NULL);
+			if (tree->Row(row * tree->Step() + 1) != row || mitem->y != row * tree->Step() || mitem->w != (int)w) {
+				cout << "Warning! Row " << row << " is in the wrong place!" << endl;
+				bad = 1;
+			}
+		}
+	}
+
+	tree->dec_count();
+	return bad;
+}
+
+
+int main(int argc,char **argv)
+{
+	int numfolders = (argc>1 ? strtol(argv[1], NULL, 10) : 300);
+	if (numfolders <= 0) numfolders = 300;
+	int numitems = (argc>2 ? strtol(argv[2], NULL, 10) : 300);
+	if (numitems <= 0) numitems = 300;
+
+	anXApp app;
+	app.Backend("cairo");
+	app.initNoX(argc, argv);
+
+	 //debug output would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	 //folders of files, with every tenth file having a few more inside
+	MenuInfo *menu = new MenuInfo;
+	char scratch[100];
+	for (int f=0; f<numfolders; f++) {
+		sprintf(scratch, "Folder %d", f);
+		menu->AddItem(scratch);
+		menu->SubMenu();
+		for (int c=0; c<numitems; c++) {
+			sprintf(scratch, "/home/someone/images/photo_%04d_%04d.jpg", f, c);
+			menu->AddItem(scratch);
+			if (c%10 == 0) {
+				menu->SubMenu();
+				for (int c2=0; c2<5; c2++) {
+					sprintf(scratch, "Layer %d", c2);
+					menu->AddItem(scratch);
+				}
+				menu->EndSubMenu();
+			}
+		}
+		menu->EndSubMenu();
+	}
+
+	cout << numfolders << " folders of " << numitems << " items, every third folder open" << endl;
+	int bad = 0;
+	bad |= Run("normal:", menu, 0);
+	bad |= Run("TREESEL_VIRTUAL:", menu, TREESEL_VIRTUAL);
+
+	menu->dec_count();
+	return bad;
+}
@@ -0,0 +1,187 @@
+//
+// Fill an UndoManager with big MetaUndoData entries, like edits to a large path or engraving,
+// with a size budget and compression of older undos, then with just the budget, then with no limits.
+// Reports memory use from UndoManager::Stats() and the process, and times for adding,
+// and for undoing and redoing everything. Also checks that coalescing merges a series of
+// nudges into one undo. Exits with 1 if undo or redo gives back wrong data.
+// No X connection is needed.
+//
+// After installing the Laxkit, compile this program like this:
+//
+// g++ undobench.cc `pkg-config laxkit --cflags --libs` -o undobench
+//
+// Usage: undobench [number of undos] [points per undo]
+
+
+#include <lax/undo.h>
+#include <lax/strmanip.h>
+#include "benchutils.h"
+
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include <iostream>
+using namespace std;
+using namespace Laxkit;
+
+
+//! Keeps a running sum of what has been undone and redone, to check against.
+class Counter : public anObject, public Undoable
+{
+  public:
+	long state;
+	int bad;
+	Counter() { state = 0; bad = 0; }
+
+	int Check(UndoData *data, int dir)
+	{
+		MetaUndoData *undo = dynamic_cast<MetaUndoData*>(data);
+		if (!undo) return 1;
+		 //each undo holds the state before and after, plus a lot of point data
+		long before = undo->meta.findLong("before");
+		long after  = undo->meta.findLong("after");
+		Attribute *points = undo->meta.find("points");
+		if (!points || points->attributes.n == 0) bad++;
+		if (dir < 0) {
+			if (state != after) bad++;
+			state = before;
+		} else {
+			if (state != before) bad++;
+			state = after;
+		}
+		return 0;
+	}
+	virtual int Undo(UndoData *data) { return Check(data, -1); }
+	virtual int Redo(UndoData *data) { return Check(data, 1); }
+};
+
+//! Something like a move of many path points.
+static MetaUndoData *NewUndo(Counter *counter, long step, int numpoints)
+{
+	MetaUndoData *undo = new MetaUndoData(counter, 0, 0, "Move points");
+	char scratch[100];
+	sprintf(scratch, "%ld", step);
+	undo->meta.push("before", scratch);
+	sprintf(scratch, "%ld", step+1);
+	undo->meta.push("after", scratch);
+	Attribute *points = undo->meta.pushSubAtt("points");
+	for (int c=0; c<numpoints; c++) {
+		sprintf(scratch, "%.6f, %.6f", (c % 100) * .25 + step * .01, (c / 100) * .25);
+		points->push("p", scratch);
+	}
+	return undo;
+}
+
+static int Run(const char *what, int n, int numpoints, long max_bytes, int compress_after)
+{
+	Counter *counter = new Counter();
+	UndoManager *manager = new UndoManager();
+	manager->SetLimits(0, max_bytes);
+	manager->SetCompression(compress_after);
+
+	long mem = CurrentKb();
+	double start = Now();
+	for (int c=0; c<n; c++) {
+		manager->AddUndo(NewUndo(counter, c, numpoints));
+		counter->state = c+1;
+	}
+	double add_time = Now() - start;
+	long used = CurrentKb() - mem;
+
+	UndoStats stats = manager->Stats();
+	int kept = stats.num_undoable;
+
+	start = Now();
+	int undone = 0;
+	while (manager->Undo() == 0) undone++;
+	double undo_time = Now() - start;
+	start = Now();
+	int redone = 0;
+	while (manager->Redo() == 0) redone++;
+	double redo_time = Now() - start;
+
+	cout << what << endl;
+	cout << "  kept " << kept << " of " << n << ", " << stats.bytes/1024 << " kb by Size(), "
+		 << stats.num_compressed << " compressed saving " << stats.bytes_saved/1024 << " kb, "
+		 << stats.num_evicted << " evicted" << endl;
+	cout << "  process grew " << used/1024 << " mb, add " << add_time*1000 << " ms, undo all "
+		 << undo_time*1000 << " ms, redo all " << redo_time*1000 << " ms" << endl;
+
+	int bad = counter->bad;
+	if (undone != kept || redone != kept || counter->state != n) bad++;
+	if (max_bytes && manager->Stats().bytes > max_bytes) bad++;
+	if (bad) cout << "Warning! Undo or redo gave wrong data!" << endl;
+
+	manager->dec_count();
+	counter->dec_count();
+	return bad ? 1 : 0;
+}
+
+//! A small undo that can merge with the next one.
+class Nudge : public MetaUndoData
+{
+  public:
+	Nudge(Counter *c, long step) : MetaUndoData(c, 0, 0, "Nudge") {
+		coalesce_key = 1;
+		char scratch[30];
+		sprintf(scratch, "%ld", step);
+		meta.push("before", scratch);
+		sprintf(scratch, "%ld", step+1);
+		meta.push("after", scratch);
+		meta.pushSubAtt("points")->push("p", "0, 0");
+	}
+	virtual int Coalesce(UndoData *newer) {
+		Nudge *n = dynamic_cast<Nudge*>(newer);
+		if (!n) return 0;
+		makestr(meta.find("after")->value, n->meta.findValue("after"));
+		return 1;
+	}
+};
+
+//! Quick nudges with the same coalesce_key should become one undo.
+static int Coalescing()
+{
+	Counter *counter = new Counter();
+	UndoManager *manager = new UndoManager();
+	manager->SetCoalesceTime(1000);
+
+	int merged = 0;
+	for (int c=0; c<50; c++) {
+		merged += manager->AddUndo(new Nudge(counter, c));
+		counter->state = c+1;
+	}
+	int undone = 0;
+	while (manager->Undo() == 0) undone++;
+
+	cout << "coalescing: 50 nudges became " << manager->Stats().num_redoable << " undo, "
+		 << manager->Stats().num_coalesced << " merged" << endl;
+	int bad = (merged != 49 || undone != 1 || counter->state != 0 || counter->bad);
+	if (bad) cout << "Warning! Nudges did not coalesce properly!" << endl;
+
+	manager->dec_count();
+	counter->dec_count();
+	return bad;
+}
+
+
+int main(int argc,char **argv)
+{
+	int n = (argc>1 ? strtol(argv[1], NULL, 10) : 1000);
+	if (n <= 0) n = 1000;
+	int numpoints = (argc>2 ? strtol(argv[2], NULL, 10) : 5000);
+	if (numpoints <= 0) numpoints = 5000;
+
+	 //undo messages would swamp the timings
+	cerr.setstate(ios::badbit);
+
+	cout << n << " undos of " << numpoints << " points each" << endl;
+	int bad = 0;
+	 //freed memory is not given back to the system, so biggest last
+	bad |= Run("64 mb budget, compress after 10:", n, numpoints, 64*1024*1024, 10);
+	bad |= Run("64 mb budget:", n, numpoints, 64*1024*1024, 0);
+	bad |= Run("no limits:", n, numpoints, 0, 0);
+	bad |= Coalescing();
+	return bad;
+}
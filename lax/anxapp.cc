@@ -26,6 +26,14 @@
 #include <sys/select.h>
 #include <fcntl.h>
 #include <cerrno>
+#include <ctime>
+
+#ifdef __linux__
+#define LAX_USES_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif
 
 
 #include <lax/configured.h>
@@ -177,9 +185,18 @@ anXWindow *TopWindow(anXWindow *win)
  */
 
 
+/*! Return the current time of CLOCK_MONOTONIC in microseconds.
+ * This is what TimerInfo and the anXApp event loop use to schedule timers.
+ */
+long long MonotonicMicroseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
 /*! All the time values are passed in as milliseconds, but internally, they are
- * converted to clock ticks. If duration==-1, then duration is taken to be 1 million,
- * which is 1000 hours.
+ * converted to microseconds of MonotonicMicroseconds(). If duration==-1, then the timer never expires.
  *
  * For the span of the timer, win->Idle(timer->id,timer->delta) is called every tickt milliseconds (the first
  * tick is sent after firstt milliseconds), until the time is after the current time plus duration.
@@ -192,19 +209,19 @@ TimerInfo::TimerInfo(EventReceiver *nwin,int duration,int firstt,int tickt,int n
 	win=nwin;
 	id=nid;
 	info=ninfo;
+	delta=0;
+	heap_index=-1;
 	if (tickt<=0) tickt=100;
-	tms tms_;
-	clock_t curtime = times(&tms_);
+	long long curtime = MonotonicMicroseconds();
 	lastactualtime  = curtime;
 	starttime       = curtime;
 
-	firsttick = firstt  *sysconf(_SC_CLK_TCK)/1000; // convert firstt to clock ticks
-	ticktime  = tickt*sysconf(_SC_CLK_TCK)/1000; // convert ticktime to clock ticks
+	firsttick = firstt*1000LL; // convert firstt to microseconds
+	ticktime  = tickt *1000LL; // convert ticktime to microseconds
 
 	if (duration != -1) {
-		duration = duration*sysconf(_SC_CLK_TCK)/1000; // convert duration to clock ticks
-		endtime  = curtime+duration;
-	} else endtime =- 1;
+		endtime = curtime + duration*1000LL;
+	} else endtime = -1;
 
 	nexttime = curtime+firsttick;
 }
@@ -215,11 +232,10 @@ TimerInfo::TimerInfo(EventReceiver *nwin,int duration,int firstt,int tickt,int n
 void TimerInfo::Update(int next, int duration)
 {
 	if (duration > 0) {
-		duration = duration * sysconf(_SC_CLK_TCK)/1000; // convert duration to clock ticks
-		endtime  = duration + lastactualtime;
+		endtime  = duration*1000LL + lastactualtime;
 	}
 	if (next > 0) {
-		ticktime = next * sysconf(_SC_CLK_TCK)/1000; // convert ticktime to clock ticks
+		ticktime = next*1000LL;
 	}
 }
 
@@ -228,18 +244,21 @@ void TimerInfo::Update(int next, int duration)
  * Returns -1 if the timer has expired, else return the number of ticks that have happened.
  * Thus, 0 means a tick has not occured. If a window.Idle(id) returns nonzero, then
  * anXApp removes the timer.
+ *
+ * tm is the current time from MonotonicMicroseconds().
  */
-int TimerInfo::checktime(clock_t tm)
+int TimerInfo::checktime(long long tm)
 {
 	int t=0;
-	while (nexttime <= tm) { t++; nexttime += ticktime; } //skips ticks potentially
+	if (nexttime <= tm) {
+		 //skips ticks potentially, but keeps the phase of the original schedule
+		t = (tm - nexttime)/ticktime + 1;
+		nexttime += t*ticktime;
+	}
 
 	if (t && win) {
-		tms tms_;
-		clock_t curtime = times(&tms_);
-		delta   = (curtime - lastactualtime)/(double)sysconf(_SC_CLK_TCK);
-		//double elapsed = (curtime - starttime     )/(double)sysconf(_SC_CLK_TCK);
-		lastactualtime = curtime;
+		delta = (tm - lastactualtime)/1000000.;
+		lastactualtime = tm;
 
 		if (win->Idle(id, delta)) {
 			return -1; //nonzero win->Idle means remove timer
@@ -254,6 +273,17 @@ int TimerInfo::checktime(clock_t tm)
 }
 
 
+//-------------------------- FdWatchInfo ----------------------------------------
+/*! \struct FdWatchInfo
+ * \brief Extra file descriptors that anXApp::run() listens to, see anXApp::AddFdWatch().
+ */
+/*! \typedef int (*FdCallbackFunc)(int fd, unsigned int events, void *data)
+ * \brief Called from the event loop when a watched fd is ready.
+ *
+ * events is a mask of FdWatchEvents. Return 0 to keep watching, or nonzero to remove the watch.
+ */
+
+
 //-------------------------- aDrawable ----------------------------------------
 /*! \class aDrawable
  * \brief Class to facilitate various double buffer and in-memory pixmap rendering.
@@ -328,7 +358,38 @@ anXApp *anXApp::app=NULL;
  * from destroyqueued().
  */
 /*! \var PtrStack<TimerInfo> anXApp::timers
- * \brief Stack of timers.
+ * \brief Stack of timers, kept as a binary min-heap on TimerInfo::nexttime.
+ *
+ * timers.e[0] is always the next timer due. Each TimerInfo knows its own heap_index.
+ * Use timerHeapUp(), timerHeapDown() and timerHeapRemove() to keep it in order.
+ */
+/*! \var TimerInfo *anXApp::firing_timer
+ * \brief The timer whose Idle() is currently being called from settimeout().
+ *
+ * If that timer is removed during its own Idle(), removetimer() sets this to NULL
+ * instead of deleting it, and settimeout() deletes it once Idle() returns.
+ */
+/*! \var long long anXApp::next_deadline
+ * \brief Absolute MonotonicMicroseconds() time of the next timer or tooltip, or 0 for none.
+ *
+ * This is set in settimeout(), and used by waitForEvents() to arm timer_fd.
+ */
+/*! \var bool anXApp::use_epoll
+ * \brief Whether run() should wait in an epoll set, or fall back to select().
+ *
+ * The epoll backend (Linux only) waits on the X connection, wake_fd for bump(), timer_fd for
+ * microsecond timer deadlines, and anything added with AddFdWatch(). If false, or if
+ * setupEventLoop() fails, then run() uses select() on the same fds, and bump() sends an X
+ * ClientMessage to bump_xid.
+ */
+/*! \var int anXApp::wake_fd
+ * \brief An eventfd written to by bump() to break out of waitForEvents() from any thread.
+ */
+/*! \var int anXApp::timer_fd
+ * \brief A CLOCK_MONOTONIC timerfd armed to next_deadline.
+ */
+/*! \var PtrStack<FdWatchInfo> anXApp::fdwatches
+ * \brief Extra file descriptors to listen to in run(). See AddFdWatch().
  */
 
 /*! \var int anXApp::tooltips
@@ -480,6 +541,15 @@ anXApp::anXApp()
 	donotusex     = false;
 	devicemanager = nullptr;
 	maxtimeout    = 0;  // override timeout when bump() doesn't work. microseconds
+	firing_timer  = nullptr;
+	next_deadline = 0;
+
+	use_epoll     = true;
+	epoll_fd      = -1;
+	wake_fd       = -1;
+	timer_fd      = -1;
+	loop_running  = false;
+	loop_thread   = pthread_self();
 
 	default_language = newstr("");
 
@@ -504,6 +574,7 @@ anXApp::anXApp()
 	default_icon      = nullptr;
 
 	dataevents = dataevente = nullptr;
+	incoming_events = nullptr;
 
 	// base default styling
 	app_profile = nullptr;
@@ -523,10 +594,6 @@ anXApp::anXApp()
 	controlfontstr = newstr("sans-12");
 
 	max_window_size = 10000;
-
-
-	 //set up standard mutexes
-	pthread_mutex_init(&event_mutex,nullptr);
 }
 
 
@@ -555,8 +622,6 @@ anXApp::~anXApp()
 
 	if (screeninfo) delete screeninfo;
 
-	pthread_mutex_destroy(&event_mutex);
-
 	if (anXApp::app == this) anXApp::app = nullptr;
 }
 
@@ -1133,6 +1198,8 @@ int anXApp::close()
 	DBG cerr <<"removing remaining topwindows..."<<endl;
 	topwindows.flush(); // not really necessary, done here just to remind
 
+	closeEventLoop();
+
 #ifdef _LAX_PLATFORM_XLIB
 	if (bump_xid) {
 		XDestroyWindow(dpy,bump_xid);
@@ -1461,10 +1528,16 @@ int anXApp::destroywindow(anXWindow *w)
 	int c=dialogs.findindex(w);
 	if (c>=0) dialogs.pop(c); // dialog is always a toplevel window
 
-	 //remove all timers associated with w and its children
-	for (int c=0; c<timers.n; c++) {
-		if (dynamic_cast<anXWindow*>(timers.e[c]->win)==w || IsWindowChild(w,dynamic_cast<anXWindow*>(timers.e[c]->win)))
-			{ timers.remove(c); c--; }
+	 //remove all timers associated with w and its children, keeping the heap in order like removetimer()
+	c = 0;
+	while (c < timers.n) {
+		anXWindow *tw = dynamic_cast<anXWindow*>(timers.e[c]->win);
+		if (!IsWindowChild(w,tw)) { c++; continue; }
+
+		TimerInfo *timer = timerHeapRemove(c);
+		if (timer == firing_timer) firing_timer = nullptr; //settimeout() deletes it after Idle()
+		else delete timer;
+		c = 0;
 	}
 
 
@@ -1778,10 +1851,23 @@ EventReceiver *anXApp::findEventObj(unsigned long id)
 
 //! Force dealing with any pending messages.
 /*! Sometimes messages sent via SendMessage() do not also make the application actually deal
- * with those messages.
+ * with those messages. This is safe to call from any thread.
+ *
+ * With the epoll backend, this just writes to wake_fd. Otherwise an X ClientMessage is sent
+ * to bump_xid to break run() out of select().
  */
 void anXApp::bump()
 {
+#ifdef LAX_USES_EPOLL
+	if (wake_fd >= 0) {
+		uint64_t one = 1;
+		if (write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+			DBG cerr << "bump write failed: "<<strerror(errno)<<endl;
+		}
+		return;
+	}
+#endif //LAX_USES_EPOLL
+
 #ifdef _LAX_PLATFORM_XLIB
 	if (!bump_xid || !dpy) return;
 
@@ -1795,20 +1881,6 @@ void anXApp::bump()
 	XSendEvent(dpy,bump_xid,False,0,&e);
 	XUnlockDisplay(dpy);
 #endif //_LAX_PLATFORM_XLIB
-
-
-// **** This below doesn't work, I don't know how to make a file descriptor that breaks select():
-//	if (bump_fd<=0) {
-//		char path[200];
-//		sprintf(path,"/tmp/.lax-%d",getpid());
-//		bump_fd=open(path,O_RDWR|O_CREAT, S_IRUSR|S_IWUSR);
-//		//unlink(path);
-//	}
-//
-//	 //bump_fd is added to the fds that select() monitors, thus this will break it out of just waiting around
-//	DBG cerr <<"bumping..."<<endl;
-//	write(bump_fd,"0",1);
-//	lseek(bump_fd,0,SEEK_SET);
 }
 
 
@@ -1828,6 +1900,12 @@ void anXApp::ThemeReconfigure(Theme *theme)
         topwindows.e[c]->ThemeChanged();
 }
 
+//! Whether this is called from the thread the event loop runs in, or would run in if not running yet.
+bool anXApp::IsMainThread()
+{
+	return pthread_equal(pthread_self(), loop_thread);
+}
+
 
 //! Send arbitrary data to a window.
 /*! Applications can derive classes from EventData to easily pass arbitrary chunks of data
@@ -1845,55 +1923,77 @@ void anXApp::ThemeReconfigure(Theme *theme)
  * processdataevents(). If the target window does not exist at that time, the data is
  * deleted.
  *
- * Messages are recorded in a thread safe way with event_mutex.
+ * mes, if given, replaces data->send_message. Messages are interned with EventData::SetMessage(), so data->message_id
+ * is the lark id of data->send_message, for EventMessageId(), and no strings are copied.
+ *
+ * Messages are pushed onto incoming_events, a lock free stack, so any number of threads
+ * can send at once without blocking each other or the event loop. If this is called from a thread
+ * other than the one in run(), then bump() is called so the event loop wakes up for it.
  */
 int anXApp::SendMessage(EventData *data, unsigned long toobj, const char *mes, unsigned long fromobj)//mes=0, sendwindow=0
 {
 	if (!data) return 1;
 
-	if (mes) makestr(data->send_message,mes);
+	data->SetMessage(mes ? mes : data->send_message);
 	if (fromobj) data->from=fromobj;
 	if (toobj)   data->to  =toobj;
 	data->send_time=times(&tmsstruct); //*** is the tmsstruct necessary? pass in NULL?
 
+	EventData *head = incoming_events.load(std::memory_order_relaxed);
+	do {
+		data->next = head;
+	} while (!incoming_events.compare_exchange_weak(head, data, std::memory_order_release, std::memory_order_relaxed));
 
-	pthread_mutex_lock(&event_mutex);
-
-	if (dataevente) {
-		dataevente->next=data;
-		dataevente=data;
-	} else {
-		dataevents=dataevente=data;
-	}
-
-	pthread_mutex_unlock(&event_mutex);
+	if (loop_running && !pthread_equal(pthread_self(), loop_thread)) bump();
 
 	//DBG cerr <<" ***** anXApp queued message: "<<(data->send_message?data->send_message:lax_event_name(data->type))<<endl;
 
 	return 0;
 }
 
+//! Move everything sent with SendMessage() so far onto the end of the dataevents list.
+/*! incoming_events is newest first, so it is reversed here to keep events in the order they were sent.
+ * This should only be called from the event loop thread.
+ *
+ * Returns the number of events taken.
+ */
+int anXApp::takeincomingevents()
+{
+	EventData *batch = incoming_events.exchange(nullptr, std::memory_order_acquire);
+	if (!batch) return 0;
+
+	EventData *first = nullptr, *last = batch;
+	int n = 0;
+	while (batch) {
+		EventData *next = batch->next;
+		batch->next = first;
+		first = batch;
+		batch = next;
+		n++;
+	}
+
+	if (dataevente) dataevente->next = first;
+	else dataevents = first;
+	dataevente = last;
+	return n;
+}
+
 //! Process the queue of EventData objects.
 /*! Accumulated messages, whether from SendMessage() or through other means, are dispatched to the target windows.
+ * Pending messages are taken in batches with takeincomingevents(), so there is no locking per event.
+ * Events sent while processing are handled in the same call.
  *
  * \todo if event propagation ever really becomes an issue, it should probably be fleshed out here!
  */
 int anXApp::processdataevents()
 {
 	EventData *data;
-	while (1) {
-		pthread_mutex_lock(&event_mutex);
-		if (!dataevents) {
-			pthread_mutex_unlock(&event_mutex);
-			break;
-		}
-
+	while (dataevents || takeincomingevents()) {
 		 //detach the oldest event data from pending events
 		data=dataevents;
 		dataevents=dataevents->next;
 		if (!dataevents) dataevente=NULL;
 		data->next=NULL;
-		pthread_mutex_unlock(&event_mutex);
 
 		processSingleDataEvent(NULL,data);
 		delete data;
@@ -1938,37 +2038,86 @@ int anXApp::processSingleDataEvent(EventReceiver *obj,EventData *ee)
 	} else if (ww && ee->type==LAX_onFocusOff) {
 		ww->FocusOff(dynamic_cast<const FocusChangeData*>(ee));
 
-	} else if (obj->Event(ee,ee->send_message?ee->send_message:"")!=0 && ee->propagate) {
-		 //If event rejected, then possibly propagate to parent
-		 // Only mouse and key events are so passed on.
-		if (ww && ww->win_parent) {
-			bool propagate = 0;
-
-			if (ee->type==LAX_onMouseMove || ee->type==LAX_onButtonDown || ee->type==LAX_onButtonUp) {
-				 // Mouse event, musttranslate x,y to new window, ***assume win_x and win_y are accurate?
-				 //****must make sure they are!! Check through all the configure notify stuff
-				 //what about window manager decorations?
-				MouseEventData *me = dynamic_cast<MouseEventData*>(ee);
-				me->x += ww->win_x+ww->win_border;
-				me->y += ww->win_y+ww->win_border;
-				propagate = true;
-
-			} else if (ee->type==LAX_onKeyDown || ee->type==LAX_onKeyUp) propagate = true;
-
-			if (propagate) {
-				anXWindow *w = ww->win_parent;
-				while (w) {
-					if (w->Event(ee,ee->send_message?ee->send_message:"") == 0) break;
-					w = w->win_parent;
+	} else {
+		 //let the window get at any coalesced samples through LaxMouse::MotionHistory()
+		MouseEventData *motion = (ee->type==LAX_onMouseMove ? dynamic_cast<MouseEventData*>(ee) : NULL);
+		if (motion && motion->device) motion->device->current_motion = motion;
+
+		if (obj->Event(ee,ee->send_message?ee->send_message:"")!=0 && ee->propagate) {
+			 //If event rejected, then possibly propagate to parent
+			 // Only mouse and key events are so passed on.
+			if (ww && ww->win_parent) {
+				bool propagate = 0;
+
+				if (ee->type==LAX_onMouseMove || ee->type==LAX_onButtonDown || ee->type==LAX_onButtonUp) {
+					 // Mouse event, musttranslate x,y to new window, ***assume win_x and win_y are accurate?
+					 //****must make sure they are!! Check through all the configure notify stuff
+					 //what about window manager decorations?
+					MouseEventData *me = dynamic_cast<MouseEventData*>(ee);
+					me->x += ww->win_x+ww->win_border;
+					me->y += ww->win_y+ww->win_border;
+					propagate = true;
+
+				} else if (ee->type==LAX_onKeyDown || ee->type==LAX_onKeyUp) propagate = true;
+
+				if (propagate) {
+					anXWindow *w = ww->win_parent;
+					while (w) {
+						if (w->Event(ee,ee->send_message?ee->send_message:"") == 0) break;
+						w = w->win_parent;
+					}
+					//if (!w) eventCatchAll(ee);
 				}
-				//if (!w) eventCatchAll(ee);
 			}
 		}
+
+		if (motion && motion->device) motion->device->current_motion = NULL;
 	}
 
 	return 0;
 }
 
+//! Hold a motion event to be merged with any later motion for the same mouse and window.
+/*! Returns 1 if ee has been taken, or 0 if it should be delivered right away, such as
+ * when the target window has ANXWIN_FULL_MOTION.
+ *
+ * If there is already a held event for the same device and target, ee absorbs it
+ * with MouseEventData::Absorb(), so the older position, pressure, tilt and time end up in
+ * ee->history, and the older event is deleted.
+ *
+ * Held events are delivered with flushMotion(), which run() calls after each batch of X
+ * events, and which is called before delivering any other kind of event.
+ */
+int anXApp::coalesceMotion(EventReceiver *obj, MouseEventData *ee)
+{
+	if (!obj || !ee || !ee->device) return 0;
+	anXWindow *ww = dynamic_cast<anXWindow*>(obj);
+	if (!ww || (ww->win_style & ANXWIN_FULL_MOTION)) return 0;
+
+	for (int c=0; c<pending_motion.n; c++) {
+		MouseEventData *old = pending_motion.e[c];
+		if (old->device != ee->device || old->to != ee->to) continue;
+
+		ee->Absorb(old);
+		delete old;
+		pending_motion.e[c] = ee;
+		return 1;
+	}
+
+	pending_motion.push(ee);
+	return 1;
+}
+
+//! Deliver any motion events held by coalesceMotion().
+void anXApp::flushMotion()
+{
+	while (pending_motion.n) {
+		MouseEventData *ee = pending_motion.pop(0);
+		processSingleDataEvent(NULL, ee);
+		delete ee;
+	}
+}
+
 //! See if a mouse down event is down outside of any top windows in outclickwatch or any controls connected to them.
 /*! destroywindow() if the mouse is down outside of any of them.
  *
@@ -2542,64 +2691,51 @@ anXWindow *anXApp::findwindow_xlib(Window win)
 #endif //_LAX_PLATFORM_XLIB
 
 
-//! Examine timers and set time to wait in preparation for a call to select().
+//! Examine timers and set time to wait in preparation for waiting on events.
 /*! If a timer is due, then that window's anXWindow::Idle() function is called from here.
+ * Only timers at the top of the timers heap are looked at, so this is O(log n) per timer that fires,
+ * rather than a scan over all timers.
+ *
+ * timeout is set to the time until the next timer or tooltip is due, and next_deadline is
+ * set to the absolute MonotonicMicroseconds() time of that, or 0 if nothing is due.
  *
  * This is called from anXApp::run().
  */
 void anXApp::settimeout(struct timeval *timeout)
 {
-	//DBG cerr <<" --- settimeout"<<endl;
-
-	//timeout->tv_sec=0;
-	//timeout->tv_usec=100000;
-	//return;
-
-	if (maxtimeout>0) {
-		timeout->tv_sec =maxtimeout/1000000;
-		timeout->tv_usec=maxtimeout%1000000;
-	} else {
-		timeout->tv_sec=2000000000;
-		timeout->tv_usec=0;
-	}
-	if (timers.n==0 && tooltipmaybe.n==0) return;
-
-	clock_t currenttime;
-	clock_t earliest=0;
-	currenttime=times(&tmsstruct); // get current time
-    int tid;
-
-	for (int c=0; c<timers.n; c++) {
-        tid = timers.e[c]->id;
-		if (timers.e[c]->checktime(currenttime) < 0) {  //this calls Idle if necessary
-            if (c >= timers.n || tid != timers.e[c]->id) {
-                //likely a window removetimer()'d during Idle, we catch here to be nice to sloppy devs
-                c--;
-                continue;
-            }
-			DBG cerr <<"remove timer (expired) "<<c<<", id: "<<timers.e[c]->id<<endl;
-			timers.remove(c);
-            c--;
-            continue;
+	long long currenttime = MonotonicMicroseconds();
+	long long earliest = 0;
+
+	 //fire any due timers. Each fired timer has its nexttime advanced past currenttime,
+	 //so each timer fires at most once here.
+	while (timers.n && timers.e[0]->nexttime <= currenttime) {
+		TimerInfo *timer = timers.e[0];
+		firing_timer = timer;
+		int status = timer->checktime(currenttime); //this calls Idle if necessary
+
+		if (firing_timer == nullptr) {
+			 //a window removetimer()'d during Idle, we catch here to be nice to sloppy devs
+			delete timer;
+			continue;
 		}
-        if (c >= timers.n || tid != timers.e[c]->id) {
-            //likely a window removetimer()'d during Idle, we catch here to be nice to sloppy devs
-            c--;
-            continue;
-        }
-
-		if (c==0) earliest=timers.e[0]->nexttime;
-		if (timers.e[c]->nexttime<earliest) earliest=timers.e[c]->nexttime;
+		firing_timer = nullptr;
+
+		if (status < 0) {
+			DBG cerr <<"remove timer (expired), id: "<<timer->id<<endl;
+			delete timerHeapRemove(timer->heap_index);
+		} else timerHeapDown(timer->heap_index);
 	}
+	if (timers.n) earliest = timers.e[0]->nexttime;
 
 
 	 // tooltip timer, update earliest against possibly many tooltips to pop up...
 	if (tooltips && ttcount==0 && tooltipmaybe.n) {
 		LaxMouse *ttmouse;
+		clock_t curticks = times(&tmsstruct);
 		for (int c=0; c<tooltipmaybe.n; c++) {
 			ttmouse=dynamic_cast<LaxMouse*>(tooltipmaybe.e[c]); //tooltipmaybe should ONLY have mice
 
-			if (currenttime>=ttmouse->ttendlimit) { // is time, so pop up
+			if (curticks>=ttmouse->ttendlimit) { // is time, so pop up
 				ttmouse->ttendlimit=0;
 				newToolTip(ttmouse->ttwindow->tooltip(ttmouse->id),ttmouse->id, ttmouse->ttwindow);
 				ttmouse->last_tt=ttmouse->ttwindow->object_id;
@@ -2608,28 +2744,21 @@ void anXApp::settimeout(struct timeval *timeout)
 				c--;
 
 			} else { // if not time, just check against earliest
-				if (earliest==0 || ttmouse->ttendlimit<earliest) earliest=ttmouse->ttendlimit;
+				 //tooltip limits are in clock ticks, so convert to microseconds
+				long long ttime = currenttime + (ttmouse->ttendlimit - curticks)*1000000LL/sysconf(_SC_CLK_TCK);
+				if (earliest==0 || ttime<earliest) earliest=ttime;
 			}
 		}
-
-	} else {
-		//DBG cerr <<"not checking tooltips in settimeout"<<endl;
 	}
 
+	next_deadline = earliest;
 
-	//DBG cerr <<"earliest time:"<<earliest<<"  currenttime:"<<currenttime<<endl;
-	if (earliest) {
-		 //convert earliest, which at the moment is clock ticks, to microseconds
-		earliest-=currenttime;
-		earliest=earliest*1000000/sysconf(_SC_CLK_TCK);
-	}
-	if (maxtimeout>0 && earliest>maxtimeout) earliest=maxtimeout;
-	if (earliest==0) earliest=2000000000;
-
-	//DBG cerr <<"earliest secs:"<<earliest<<endl;
+	long long wait = (earliest ? earliest - currenttime : 2000000000LL*1000000);
+	if (wait < 0) wait = 0;
+	if (maxtimeout>0 && wait>maxtimeout) wait=maxtimeout;
 
-	timeout->tv_sec=earliest/1000000;
-	timeout->tv_usec=earliest%1000000;
+	timeout->tv_sec  = wait/1000000;
+	timeout->tv_usec = wait%1000000;
 }
 
 //! Create and add a new tooltip, ensuring there is only one per mouse up at any one time.
@@ -2651,8 +2780,9 @@ void anXApp::newToolTip(const char *text,int mouseid, anXWindow *ttwindow)
  *
  * Return 0 for successful run. Return nonzero for unsuccessful, such as when dpy==NULL.
  *
- * \todo must implement other file descriptor input for the call to select. This will allow listening for
- *   unusual input sources like wiimotes or socket communication..
+ * Each pass dispatches queued EventData, then X events, then due timers, then refreshes windows.
+ * When there is nothing left to do, waitForEvents() blocks until the X connection, bump(),
+ * the next timer deadline, or any fd from AddFdWatch() needs attention.
  */
 int anXApp::run()
 {
@@ -2661,41 +2791,30 @@ int anXApp::run()
 	DBG cerr <<"Entering run()....."<<endl;
 
 	XEvent event;
-	//clock_t tm;
 	int c;
 	int anytodraw;
 
-
 	 //--- event loop
 	struct timeval timeout;
-	fd_set fdset[3];
 	int xlibfd=ConnectionNumber(dpy);
-	int maxfd=xlibfd;
+
+	if (use_epoll && epoll_fd < 0) setupEventLoop();
+	loop_thread  = pthread_self();
+	loop_running = true;
 
 	while (dontstop) {
 		anytodraw=1;
 
 		 //--- Dispatch any EventData events
-		//DBG cerr <<"-dispatch data events"<<endl;
-		if (dataevents) processdataevents();
-
-		 //--- do any idling
-		 // idle is recursive loop on the specified window
-		//DBG cerr <<"-idling"<<endl;
-		// *** this is do nothing as idle is controlled by timers now...
-		//for (c=0; c<topwindows.n; c++) idle(topwindows.e[c]);
+		if (dataevents || incoming_events.load(std::memory_order_relaxed)) processdataevents();
 
 		 // Do X events
-		//DBG cerr <<"-x events"<<endl;
-		//while (XEventsQueued(dpy,QueuedAfterFlush)) {
 		while (XPending(dpy)) {
-			//DBG cerr <<"--events pending: "<<XPending(dpy)<<endl;
 			XNextEvent(dpy,&event);
-			//DBG cerr <<"----xevent: "<<xlib_event_name(event.type)<<endl;
 			processXevent(&event);
 		}
+		if (pending_motion.n) flushMotion();
 
-		//DBG cerr <<"-destroy queued"<<endl;
 		 //--- destroy any requested destruction (before idling and refreshing)
 		if (todelete.how_many()) destroyqueued();
 
@@ -2711,56 +2830,220 @@ int anXApp::run()
 		if (anytodraw) {
 			anytodraw=0;
 			for (c=0; c<topwindows.n; c++) anytodraw+=refresh(topwindows.e[c]);
-			//DBG cerr <<"anytodraw:"<<anytodraw<<endl;
 		}
 		XSync(dpy,False);
-		//DBG cerr <<"-just refreshed "<<anytodraw<<endl;
 
 
 		if (dontstop==0 || topwindows.n==0) { dontstop=0; break; }
 
 		 //---- Wait for events or timers
-		 // man select and select_tut for what this does..
-		 // Currently, just monitors the X channel, later add support for arbitrary fds?
-		 // like an object event pipe?
-		 //
 		 //It is necessary to check for pending here, because anything above might have triggered
 		 //a send event, for instance, and the event will already be pending, but it will not cause
 		 //the X file descriptor to change state..
-		if (!dataevents && !XPending(dpy) && !anytodraw && !todelete.how_many()) {
-			FD_ZERO(&fdset[0]);
-			FD_ZERO(&fdset[1]);
-			FD_ZERO(&fdset[2]);
-			FD_SET(xlibfd,&fdset[0]);
-//			if (bump_fd>0) {
-//				FD_SET(bump_fd,&fdset[0]);
-//				if (bump_fd>maxfd) maxfd=bump_fd;
-//			}
-			//if (devicemanager && devicemanager->hasFD()) devicemanager->Setfd(&fdset[0],&maxfd);
-
-			//DBG timeout.tv_sec=1;
-			//DBG cerr <<"entering select...."<<endl;
-			//settimeout(&timeout);//****this is done above now
-			//int select(int n, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout);
-			c=select(maxfd+1, &fdset[0], &fdset[1], &fdset[2], &timeout);
-
-//			if (FD_ISSET(bump_fd,&fdset[0])) {
-//				 //clear the bump file
-//				DBG cerr <<"*** clearing bump"<<endl;
-//				//char buffer[100];
-//				//while (read(bump_fd,buffer,100)>0) ;
-//				ftruncate(bump_fd,0);
-//			}
+		if (!dataevents && !incoming_events.load(std::memory_order_relaxed)
+				&& !XPending(dpy) && !anytodraw && !todelete.how_many()) {
+			waitForEvents(xlibfd, &timeout);
+		}
+	}
+
+	loop_running = false;
+	return 0;
+}
+
+//! Block until there is something for run() to do.
+/*! Waits for input on the X connection, a bump(), any fd added with AddFdWatch(), or
+ * for timeout to elapse. Ready fds from AddFdWatch() have their callbacks called from here.
+ *
+ * With the epoll backend, timer_fd is armed to the absolute next_deadline so timers wake
+ * up with microsecond precision, and timeout is only used when maxtimeout is set.
+ *
+ * Returns the number of ready fds, or -1 for error.
+ */
+int anXApp::waitForEvents(int xlibfd, struct timeval *timeout)
+{
+#ifdef LAX_USES_EPOLL
+	if (epoll_fd >= 0) {
+		struct itimerspec spec;
+		memset(&spec, 0, sizeof(spec));
+		if (next_deadline > 0) {
+			spec.it_value.tv_sec  = next_deadline/1000000;
+			spec.it_value.tv_nsec = (next_deadline%1000000)*1000;
+			if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) spec.it_value.tv_nsec = 1; //0 would disarm
+		}
+		timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+		struct epoll_event events[16];
+		int ms = -1;
+		if (maxtimeout > 0) ms = timeout->tv_sec*1000 + (timeout->tv_usec+999)/1000;
+		int n = epoll_wait(epoll_fd, events, 16, ms);
+
+		for (int c=0; c<n; c++) {
+			int fd = events[c].data.fd;
+
+			if (fd == wake_fd || fd == timer_fd) {
+				uint64_t count;
+				while (read(fd, &count, sizeof(count)) > 0) ;
+				continue;
+			}
+			if (fd == xlibfd) continue; //handled by XPending() in run()
+
+			unsigned int mask = 0;
+			if (events[c].events & EPOLLIN)  mask |= LAX_FD_Read;
+			if (events[c].events & EPOLLOUT) mask |= LAX_FD_Write;
+			if (events[c].events & (EPOLLERR|EPOLLHUP)) mask |= LAX_FD_Error;
+			dispatchFdWatch(fd, mask);
+		}
+
+		return n;
+	}
+#endif //LAX_USES_EPOLL
+
+	 //fallback: select() on X and any fd watches. bump() goes through X in this case.
+	fd_set fdset[3];
+	FD_ZERO(&fdset[0]);
+	FD_ZERO(&fdset[1]);
+	FD_ZERO(&fdset[2]);
+	FD_SET(xlibfd,&fdset[0]);
+	int maxfd = xlibfd;
+
+	for (int c=0; c<fdwatches.n; c++) {
+		FdWatchInfo *w = fdwatches.e[c];
+		if (w->events & LAX_FD_Read)  FD_SET(w->fd, &fdset[0]);
+		if (w->events & LAX_FD_Write) FD_SET(w->fd, &fdset[1]);
+		FD_SET(w->fd, &fdset[2]);
+		if (w->fd > maxfd) maxfd = w->fd;
+	}
 
-			//if (c<0) perror("select returned error: ");
+	int n = select(maxfd+1, &fdset[0], &fdset[1], &fdset[2], timeout);
+
+	if (n > 0) {
+		for (int c=fdwatches.n-1; c>=0; c--) {
+			if (c >= fdwatches.n) continue; //a callback removed more than itself
+			int fd = fdwatches.e[c]->fd;
+			unsigned int mask = 0;
+			if (FD_ISSET(fd, &fdset[0])) mask |= LAX_FD_Read;
+			if (FD_ISSET(fd, &fdset[1])) mask |= LAX_FD_Write;
+			if (FD_ISSET(fd, &fdset[2])) mask |= LAX_FD_Error;
+			if (mask) dispatchFdWatch(fd, mask);
 		}
+	}
+
+	return n;
+}
+
+//! Create the epoll set, wake_fd and timer_fd used by waitForEvents().
+/*! Called from run() if use_epoll. Returns 0 for success, or nonzero if the epoll backend
+ * is not available, in which case waitForEvents() falls back to select().
+ */
+int anXApp::setupEventLoop()
+{
+#ifdef LAX_USES_EPOLL
+	if (epoll_fd >= 0) return 0;
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+	if (epoll_fd < 0 || wake_fd < 0 || timer_fd < 0) {
+		DBG cerr << "Could not set up epoll event loop, falling back to select(): "<<strerror(errno)<<endl;
+		closeEventLoop();
+		return 1;
+	}
+
+	int fds[3] = { wake_fd, timer_fd, -1 };
+#ifdef _LAX_PLATFORM_XLIB
+	if (dpy) fds[2] = ConnectionNumber(dpy);
+#endif
+	for (int c=0; c<3; c++) {
+		if (fds[c] < 0) continue;
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events  = EPOLLIN;
+		ev.data.fd = fds[c];
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[c], &ev);
+	}
+
+	 //add any watches made before the loop started
+	for (int c=0; c<fdwatches.n; c++) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		if (fdwatches.e[c]->events & LAX_FD_Read)  ev.events |= EPOLLIN;
+		if (fdwatches.e[c]->events & LAX_FD_Write) ev.events |= EPOLLOUT;
+		ev.data.fd = fdwatches.e[c]->fd;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fdwatches.e[c]->fd, &ev);
+	}
+
+	return 0;
+#else
+	return 1;
+#endif //LAX_USES_EPOLL
+}
+
+//! Close the fds made in setupEventLoop(). Called from close().
+void anXApp::closeEventLoop()
+{
+	if (epoll_fd >= 0) { ::close(epoll_fd); epoll_fd = -1; }
+	if (wake_fd  >= 0) { ::close(wake_fd);  wake_fd  = -1; }
+	if (timer_fd >= 0) { ::close(timer_fd); timer_fd = -1; }
+}
 
-		//if (c==0) processTimers(); //c==0 means time expired, rather than event ready
-		//--- timer handling is done in settimeout()
+//! Call the callback for fd. If it returns nonzero, the watch is removed.
+void anXApp::dispatchFdWatch(int fd, unsigned int events)
+{
+	for (int c=0; c<fdwatches.n; c++) {
+		if (fdwatches.e[c]->fd != fd) continue;
+
+		FdWatchInfo *w = fdwatches.e[c];
+		if (!w->callback || w->callback(fd, events, w->data) != 0) RemoveFdWatch(fd);
+		return;
 	}
+}
+
+//! Have run() listen to fd, and call callback(fd, events, data) when it is ready.
+/*! events is a mask of FdWatchEvents, LAX_FD_Read and/or LAX_FD_Write. Errors and hangups
+ * are always reported with LAX_FD_Error. The callback is called from the event loop thread,
+ * and should return 0 to keep watching, or nonzero to remove the watch.
+ *
+ * This is how to hook up unusual input sources like wiimotes, tuio, or socket communication.
+ * The caller still owns fd, and must RemoveFdWatch() before closing it.
+ *
+ * Returns 0 for success, 1 for bad arguments or fd already watched, or -1 for epoll error.
+ */
+int anXApp::AddFdWatch(int fd, unsigned int events, FdCallbackFunc callback, void *data)
+{
+	if (fd < 0 || !callback) return 1;
+	for (int c=0; c<fdwatches.n; c++) if (fdwatches.e[c]->fd == fd) return 1;
+
+#ifdef LAX_USES_EPOLL
+	if (epoll_fd >= 0) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		if (events & LAX_FD_Read)  ev.events |= EPOLLIN;
+		if (events & LAX_FD_Write) ev.events |= EPOLLOUT;
+		ev.data.fd = fd;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) return -1;
+	}
+#endif //LAX_USES_EPOLL
+
+	fdwatches.push(new FdWatchInfo(fd, events, callback, data));
 	return 0;
 }
 
+//! Stop listening to fd. Return 0 for success, or 1 for fd not found.
+int anXApp::RemoveFdWatch(int fd)
+{
+	for (int c=0; c<fdwatches.n; c++) {
+		if (fdwatches.e[c]->fd != fd) continue;
+
+#ifdef LAX_USES_EPOLL
+		if (epoll_fd >= 0) epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+		fdwatches.remove(c);
+		return 0;
+	}
+	return 1;
+}
+
 //void anXApp::processTimers()
 //{}
 
@@ -3073,15 +3356,20 @@ void anXApp::processXevent(XEvent *xevent)
 	}
 
 	 // Finally dispatch event to window
-	//DBG cerr <<"  call ww->event ifww..."<<endl;
+	 // Motion events might be held back to be merged with later ones in coalesceMotion().
+	 // Anything else flushes held motion first, so that events arrive in order.
 	if (events) {
 		EventData *ee=NULL;
 		while (events) {
-			if (rr->object_id!=events->to) rr=findEventObj(events->to);
-			processSingleDataEvent(rr,events);
 			ee=events;
 			events=events->next;
 			ee->next=NULL;
+			if (rr && rr->object_id!=ee->to) rr=findEventObj(ee->to);
+
+			if (ee->type==LAX_onMouseMove && coalesceMotion(rr, dynamic_cast<MouseEventData*>(ee))) continue;
+			if (pending_motion.n) flushMotion();
+
+			processSingleDataEvent(rr,ee);
 			delete ee;
 		}
 	}
@@ -3149,12 +3437,12 @@ int anXApp::SetMaxTimeout(int timeoutmax)
 }
 
 //! Add a timer. Return the timer id.
-/*! strt,next are in milliseconds, they get converted to clock ticks in TimerInfo.
+/*! strt,next are in milliseconds, they get converted to microseconds in TimerInfo.
  *
  * Once a timer is established, after the specified time, then a windows anXWindow::Idle()
  * function will be called, with the associated timer id.
  *
- * A duration of -1 means about 1000 hours, so basically forever.
+ * A duration of -1 means the timer never expires.
  */
 int anXApp::addtimer(EventReceiver *win, //!< The window to create the timer for
 					int strt, //!< Time to wait for the first timer event (milliseconds)
@@ -3165,7 +3453,10 @@ int anXApp::addtimer(EventReceiver *win, //!< The window to create the timer for
 	if (!win) return 0;
 	//TimerInfo(anXWindow *nwin,int duration,int firstt,int tickt,int nid,long ninfo);
 	int nid=getUniqueNumber();
-	timers.push(new TimerInfo(win,duration,strt,next,nid,0));
+	TimerInfo *timer = new TimerInfo(win,duration,strt,next,nid,0);
+	timer->heap_index = timers.n;
+	timers.push(timer);
+	timerHeapUp(timer->heap_index);
 
 	DBG cerr <<"addtimer: "<<win->object_id<<"  id:"<<nid<<"  duration:"<<duration<<"  next:"<<next<< " ms"<<"   numtimers="<<timers.n<<endl;
 	return nid;
@@ -3195,22 +3486,77 @@ int anXApp::modifytimer(EventReceiver *win, int timerid,int next,int duration)
  *  timers here.
  *
  * If timerid==0, then remove any timer of w.
+ *
+ * Return 0 for a timer removed, or 1 for not found.
  */
 int anXApp::removetimer(EventReceiver *w,int timerid)
 {
-	int c;
-	for (c=0; c<timers.n; c++) {
-		if (w==timers.e[c]->win) {
-			if (timerid>0 && timerid==timers.e[c]->id) break;
-			if (!timerid) { timers.remove(c); c--; }
-		}
+	int found = 0;
+	int c = 0;
+	while (c < timers.n) {
+		if (w != timers.e[c]->win || (timerid>0 && timerid != timers.e[c]->id)) { c++; continue; }
+
+		DBG cerr <<"remove timer:"<<timers.e[c]->id<<endl;
+		TimerInfo *timer = timerHeapRemove(c);
+		if (timer == firing_timer) firing_timer = nullptr; //settimeout() deletes it after Idle()
+		else delete timer;
+		found = 1;
+		if (timerid>0) break;
+
+		 //removing sifts other timers up or down the heap, possibly past c, so start over
+		c = 0;
 	}
 
-	if (c>=timers.n) return 1;
-	DBG cerr <<"remove timer:"<<timerid<<endl;
-	timers.remove(c);
+	return found ? 0 : 1;
+}
 
-	return 0;
+//! Move timers.e[index] toward the top of the timer heap as necessary.
+void anXApp::timerHeapUp(int index)
+{
+	while (index > 0) {
+		int parent = (index-1)/2;
+		if (timers.e[parent]->nexttime <= timers.e[index]->nexttime) break;
+		timers.swap(parent, index);
+		timers.e[index]->heap_index = index;
+		timers.e[parent]->heap_index = parent;
+		index = parent;
+	}
+}
+
+//! Move timers.e[index] toward the bottom of the timer heap as necessary.
+void anXApp::timerHeapDown(int index)
+{
+	while (1) {
+		int smallest = index;
+		int l = 2*index+1, r = l+1;
+		if (l < timers.n && timers.e[l]->nexttime < timers.e[smallest]->nexttime) smallest = l;
+		if (r < timers.n && timers.e[r]->nexttime < timers.e[smallest]->nexttime) smallest = r;
+		if (smallest == index) break;
+		timers.swap(smallest, index);
+		timers.e[index]->heap_index = index;
+		timers.e[smallest]->heap_index = smallest;
+		index = smallest;
+	}
+}
+
+//! Detach timers.e[index] from the heap and return it. The caller must delete it.
+TimerInfo *anXApp::timerHeapRemove(int index)
+{
+	if (index < 0 || index >= timers.n) return nullptr;
+
+	int last = timers.n-1;
+	if (index != last) {
+		timers.swap(index, last);
+		timers.e[index]->heap_index = index;
+	}
+	TimerInfo *timer = timers.pop(last);
+	timer->heap_index = -1;
+
+	if (index < timers.n) {
+		timerHeapUp(index);
+		timerHeapDown(timers.e[index]->heap_index);
+	}
+	return timer;
 }
 
 //! Add a timer with the default mouse button delays. Returns timer id.
@@ -3241,7 +3587,9 @@ void anXApp::idle(anXWindow *w)
 
 //! Handles refreshing for window w and its children.
 /*! Called from a loop over topwindows in run. Calls w->Refresh() only
- * if (w->Needtodraw() && w->win_on). The window must clear needtodraw itself.
+ * if (w->Needtodraw() && w->win_on), or if the window has only partial damage from
+ * anXWindow::Invalidate(). The window must clear needtodraw itself. Damage is cleared here
+ * after Refresh().
  *
  * Returns the number of windows saying they still need to be refreshed.
  */
@@ -3249,8 +3597,9 @@ int anXApp::refresh(anXWindow *w)
 {
 	if (!w) return 0;
 	int n=0;
-	if (w->Needtodraw() && w->win_on) {
+	if ((w->Needtodraw() || w->DamageRect(nullptr)) && w->win_on) {
 		w->Refresh();
+		w->ClearDamage();
 		if (w->Needtodraw()) {
 			DBG cerr <<"Needs to draw: "<<w->WindowTitle()<<" child of "<<(w->win_parent?w->win_parent->WindowTitle():"null")
 			DBG      <<" index: "<<(w->win_parent?w->win_parent->_kids.findindex(w):-1)<<"  "<<w->whattype()<<endl;
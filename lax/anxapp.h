@@ -33,6 +33,7 @@
 
 #include <sys/times.h>
 #include <pthread.h>
+#include <atomic>
 
 #include <lax/anobject.h>
 #include <lax/dump.h>
@@ -121,6 +122,10 @@ class aDrawable
 #define ANXWIN_DOUBLEBUFFER   (1<<11)
 #define ANXWIN_DOOMED         (1<<12)
 #define ANXWIN_OUT_CLICK_DESTROYS (1<<13)
+//do not coalesce motion events for this window
+#define ANXWIN_FULL_MOTION    (1<<14)
+//Refresh() honors Invalidate() damage with needtodraw==0
+#define ANXWIN_DAMAGE_REFRESH (1<<15)
 //-------------------
 
  // note that care must be taken here, are these defines constant across Xlibs?
@@ -151,6 +156,9 @@ class anXWindow : virtual public EventReceiver,
 	XSizeHints    *xlib_win_sizehints;
 	XSetWindowAttributes xlib_win_xatts;
 	unsigned long  xlib_win_xattsmask;
+	GC             xlib_damage_gc; //made on first use by CopyDamage()
+
+	virtual int CopyDamage();
 
 	static Atom XdndAware;
     static Atom XdndEnter;
@@ -200,6 +208,7 @@ class anXWindow : virtual public EventReceiver,
  protected:
 	char        *win_tooltip;
 	int          needtodraw;
+	IntRectangle win_damage; //union of Invalidate() rects since the last refresh
 
 	RefPtrStack<anXWindow> _kids; 
 	virtual int deletekid(anXWindow *w);
@@ -258,6 +267,9 @@ class anXWindow : virtual public EventReceiver,
 	virtual Displayer *GetDisplayer();
 	virtual int  Needtodraw() { return needtodraw; }
 	virtual void Needtodraw(int nntd) { needtodraw=nntd; }
+	virtual void Invalidate(int x,int y,int w,int h);
+	virtual int  DamageRect(IntRectangle *rect_ret);
+	virtual void ClearDamage() { win_damage.set(0,0,0,0); }
 	virtual int  deletenow() { return 1; }
 
 	 //style functions
@@ -339,23 +351,49 @@ class anXWindow : virtual public EventReceiver,
 
 
 //-------------------------- TimerInfo ----------------------------------------
+
+long long MonotonicMicroseconds();
+
 struct TimerInfo
 {
 	int id;
 	long info;
-	clock_t endtime,firsttick,ticktime;
-	clock_t nexttime;
-	clock_t starttime, lastactualtime;
+	long long endtime,firsttick,ticktime; //microseconds on CLOCK_MONOTONIC
+	long long nexttime;
+	long long starttime, lastactualtime;
 	double delta;
 	EventReceiver *win;
+	int heap_index; //position in anXApp::timers, which is kept as a min-heap on nexttime
 	
-	TimerInfo() { info=0; id=0; endtime=firsttick=ticktime=nexttime=0; win=NULL; }
+	TimerInfo() { info=0; id=0; endtime=firsttick=ticktime=nexttime=0; starttime=lastactualtime=0; delta=0; win=NULL; heap_index=-1; }
 	TimerInfo(EventReceiver *nwin,int duration,int firstt,int tickt,int nid,long ninfo);
-	int checktime(clock_t tm);
+	int checktime(long long tm);
 	void Update(int next, int duration);
 };
 
 
+//-------------------------- FdWatchInfo ----------------------------------------
+
+enum FdWatchEvents {
+	LAX_FD_Read  = (1<<0),
+	LAX_FD_Write = (1<<1),
+	LAX_FD_Error = (1<<2)
+};
+
+typedef int (*FdCallbackFunc)(int fd, unsigned int events, void *data);
+
+struct FdWatchInfo
+{
+	int fd;
+	unsigned int events; //mask of FdWatchEvents
+	FdCallbackFunc callback;
+	void *data;
+
+	FdWatchInfo(int nfd, unsigned int nevents, FdCallbackFunc func, void *ndata)
+	  : fd(nfd), events(nevents), callback(func), data(ndata) {}
+};
+
+
 //---------------------------- anXApp --------------------------------------
 class anXApp : virtual public anObject
 {
@@ -365,12 +403,14 @@ class anXApp : virtual public anObject
 
   public:
 	bool donotusex;
+	bool use_epoll; //if false or unavailable, run() waits with select() and bump() goes through X
 
 #ifdef _LAX_PLATFORM_XLIB
   protected:
 	 //X specific protected functions
 	virtual void settimeout(struct timeval *timeout);
 	virtual void processXevent(XEvent *event);
+	virtual int  waitForEvents(int xlibfd, struct timeval *timeout);
 
   public:
 	 //X specific variables
@@ -427,10 +467,25 @@ class anXApp : virtual public anObject
 	RefPtrStack<anXWindow>  todelete;
 	PtrStack<EventReceiver> eventreceivers;
 	EventData              *dataevents,*dataevente;
+	std::atomic<EventData*> incoming_events;
 	PtrStack<TimerInfo>     timers;
-	pthread_mutex_t         event_mutex;
+	TimerInfo              *firing_timer;
+	long long               next_deadline;
 	int maxtimeout;
-	//int                     bump_fd;
+
+	 //event loop reactor state, see waitForEvents()
+	PtrStack<FdWatchInfo>   fdwatches;
+	int                     epoll_fd;
+	int                     wake_fd;
+	int                     timer_fd;
+	std::atomic<bool>       loop_running; //read by SendMessage() from any thread
+	pthread_t               loop_thread;
+	virtual int  setupEventLoop();
+	virtual void closeEventLoop();
+	virtual void dispatchFdWatch(int fd, unsigned int events);
+	virtual void timerHeapUp(int index);
+	virtual void timerHeapDown(int index);
+	virtual TimerInfo *timerHeapRemove(int index);
 
 	int                     ttcount;
 	PtrStack<LaxDevice>     tooltipmaybe;
@@ -448,7 +503,11 @@ class anXApp : virtual public anObject
 	virtual void idle(anXWindow *w);
 	virtual int refresh(anXWindow *w);
 	virtual int processdataevents();
+	virtual int takeincomingevents();
 	virtual int processSingleDataEvent(EventReceiver *obj,EventData *ee);
+	PtrStack<MouseEventData> pending_motion;
+	virtual int coalesceMotion(EventReceiver *obj, MouseEventData *ee);
+	virtual void flushMotion();
 	virtual int checkOutClicks(EventReceiver *obj,MouseEventData *ee);
 	virtual int managefocus(anXWindow *ww, EventData *ev);
 	virtual void tooltipcheck(EventData *event, anXWindow *ww);
@@ -514,6 +573,7 @@ class anXApp : virtual public anObject
 	 //special event functions
 	virtual void ThemeReconfigure(Theme *theme=nullptr);
 	virtual void bump();
+	bool IsMainThread();
 	virtual EventReceiver *findEventObj(unsigned long id);
 	virtual int RegisterEventReceiver(EventReceiver *e);
 	virtual int UnregisterEventReceiver(EventReceiver *e);
@@ -551,6 +611,10 @@ class anXApp : virtual public anObject
 	virtual int modifytimer(EventReceiver *win, int timerid,int next,int duration);
 	virtual int addmousetimer(EventReceiver *win);
 	virtual int removetimer(EventReceiver *w,int timerid);
+
+	 //extra input sources
+	virtual int AddFdWatch(int fd, unsigned int events, FdCallbackFunc callback, void *data);
+	virtual int RemoveFdWatch(int fd);
 };
 
 
@@ -157,6 +157,15 @@ Drawable aDrawable::xlibDrawable(int which)
  *   and outside of any connected top level controls, then destroy this window and its connected top
  *   level controls.
  *  #define ANXWIN_OUT_CLICK_DESTROYS
+ *
+ *   Normally, queued motion events for the same mouse are merged into one before being
+ *   delivered, with the skipped samples available from LaxMouse::MotionHistory(). Precision tools
+ *   can set this to get a separate MouseMove() for every motion event instead.
+ *  #define ANXWIN_FULL_MOTION
+ *
+ *   The window's Refresh() knows how to repaint only the area given by DamageRect(). Without this,
+ *   Invalidate() just calls Needtodraw(1).
+ *  #define ANXWIN_DAMAGE_REFRESH
  * \endcode
  *
  *  \todo implement ANXWIN_BARE to have no decorations, but move with the desktop?
@@ -377,6 +386,7 @@ anXWindow::anXWindow(anXWindow *parnt, const char *nname, const char *ntitle,
 #ifdef _LAX_PLATFORM_XLIB
 	 //set up Xlib specific stuff
 	xlib_dnd = nullptr;
+	xlib_damage_gc = 0;
 	xlib_win_hints = nullptr;
 	xlib_win_sizehints = nullptr;
 	xlib_win_xattsmask = 0;
@@ -402,6 +412,7 @@ anXWindow::~anXWindow()
 
 #ifdef _LAX_PLATFORM_XLIB
 	if (xlib_dnd) delete xlib_dnd;
+	if (xlib_damage_gc && anXApp::app && anXApp::app->dpy) XFreeGC(anXApp::app->dpy, xlib_damage_gc);
 	if (xlib_win_hints) XFree(xlib_win_hints);
 	if (xlib_win_sizehints) XFree(xlib_win_sizehints);
 #endif //_LAX_PLATFORM_XLIB
@@ -809,12 +820,22 @@ void anXWindow::SetupBackBuffer()
  * Default is to call <tt>XdbeSwapBuffers(app->dpy,&swapinfo,1)</tt>
  * with <tt>swapinfo.swap_window=window</tt> and <tt>swapinfo.swap_action=XdbeBackground</tt>.
  * If xlib_backbuffer==0, then nothing is done.
+ *
+ * If only part of the window was redrawn (see DamageRect()), then the Displayer copies just
+ * the damaged area from the back buffer instead.
  */
 void anXWindow::SwapBuffers()
 {
 #ifdef _LAX_PLATFORM_XLIB
 	 // swap buffers
 	if (xlib_backbuffer) {
+		if (DamageRect(nullptr)) {
+			Displayer *dp = GetDisplayer();
+			if (dp->GetDrawable() != this) dp->MakeCurrent(this);
+			dp->SwapBuffers();
+			return;
+		}
+
 		XdbeSwapInfo swapinfo;
 		swapinfo.swap_window=xlib_window;
 		swapinfo.swap_action=XdbeBackground;
@@ -823,6 +844,69 @@ void anXWindow::SwapBuffers()
 #endif //_LAX_PLATFORM_XLIB
 }
 
+#ifdef _LAX_PLATFORM_XLIB
+/*! If only part of the window was redrawn (see DamageRect()), copy just that area from the
+ * back buffer to the window, and return 1. Otherwise do nothing and return 0.
+ * Displayers call this from their SwapBuffers(). The GC for the copy is kept in xlib_damage_gc,
+ * rather than made for every frame.
+ */
+int anXWindow::CopyDamage()
+{
+	IntRectangle rect;
+	if (!xlib_backbuffer || !xlib_window || !DamageRect(&rect)) return 0;
+
+	if (!xlib_damage_gc) xlib_damage_gc = XCreateGC(app->dpy, xlib_window, 0, nullptr);
+	XCopyArea(app->dpy, xlib_backbuffer, xlib_window, xlib_damage_gc,
+			  rect.x,rect.y, rect.width,rect.height, rect.x,rect.y);
+	return 1;
+}
+#endif //_LAX_PLATFORM_XLIB
+
+/*! Mark a rectangle of the window, in window coordinates, as needing to be redrawn.
+ * Rectangles are unioned together until the next refresh. If needtodraw is also set by then,
+ * the whole window is redrawn as usual.
+ *
+ * If ANXWIN_DAMAGE_REFRESH is not set in win_style, this just calls Needtodraw(1).
+ */
+void anXWindow::Invalidate(int x,int y,int w,int h)
+{
+	if (!(win_style & ANXWIN_DAMAGE_REFRESH)) { Needtodraw(1); return; }
+
+	 //clamp to window
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x+w > win_w) w = win_w - x;
+	if (y+h > win_h) h = win_h - y;
+	if (w <= 0 || h <= 0) return;
+
+	if (win_damage.width <= 0 || win_damage.height <= 0) {
+		win_damage.set(x,y,w,h);
+		return;
+	}
+
+	int x2 = win_damage.x + win_damage.width, y2 = win_damage.y + win_damage.height;
+	if (x+w > x2) x2 = x+w;
+	if (y+h > y2) y2 = y+h;
+	if (x < win_damage.x) win_damage.x = x;
+	if (y < win_damage.y) win_damage.y = y;
+	win_damage.width  = x2 - win_damage.x;
+	win_damage.height = y2 - win_damage.y;
+}
+
+/*! Return 1 if only part of the window needs redrawing, and put that area in rect_ret if not null.
+ * Return 0 if there is no damage, or if needtodraw is set, meaning the whole window
+ * should be redrawn anyway.
+ *
+ * Displayers use this to clip drawing in StartDrawing(), and to copy only the damaged
+ * area in SwapBuffers(). anXApp calls ClearDamage() after each Refresh().
+ */
+int anXWindow::DamageRect(IntRectangle *rect_ret)
+{
+	if (needtodraw || win_damage.width <= 0 || win_damage.height <= 0) return 0;
+	if (rect_ret) *rect_ret = win_damage;
+	return 1;
+}
+
 //! Replace the current tooltip, return the current tooltip (after replacing).
 /*! If tooltips are active, the anXApp calls tooltip() to find the tip for this window.
  * Thus, the window can redefine this function if there are multiple tooltips for some reason.
@@ -1268,6 +1352,14 @@ int anXWindow::Event(const EventData *data,const char *mes)
 		const_cast<LaxMouse*>(dynamic_cast<const LaxMouse*>(ee->device))->setMouseShape(this, win_pointer_shape);
 	}
 
+	int mes_id = EventMessageId(data, mes);
+	if (mes && (EventMessageIs(mes_id, mes, LARK("imageloaded")) || EventMessageIs(mes_id, mes, LARK("previewready")))) {
+		 //an image from LaxCairoImage::DisplayImage() finished loading in the background,
+		 //or a preview from Previewable::GetPreviewAsync() finished rendering
+		needtodraw = 1;
+		return 0;
+	}
+
 	return 1;
 }
 
@@ -22,6 +22,7 @@
 
 #include <cstdlib>
 #include <cctype>
+#include <new>
 #include <lax/attributes.h>
 #include <lax/fileutils.h>
 #include <lax/strmanip.h>
@@ -30,9 +31,13 @@
 #include <lax/colors.h>
 #include <lax/cssutils.h>
 #include <lax/language.h>
+#include <lax/lark.h>
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <limits.h>
 #include <iostream>
 
@@ -1408,6 +1413,278 @@ void skip_to_next_attribute(IOBuffer &f,int indent)
 }
 
 
+//---------------------------------- AttributeBlob -----------------------------------	
+/*! \class AttributeBlob
+ * \ingroup attributes
+ * \brief A typed array of numbers that an Attribute can hold instead of a text value.
+ *
+ * Blobs let objects store bulk data like point lists without printing and reparsing
+ * every number. When read from a binary file with BinaryFileToAttribute(), data points straight
+ * into the memory mapped file, and source keeps the mapping alive, so nothing is copied.
+ *
+ * Text output of an Attribute with a blob but no value uses ToString(), so any tree
+ * can still be written as text. Objects that write blobs when DumpContext::format is ATT_Binary
+ * must also still accept their old text value on reading.
+ */
+
+
+/*! Allocate space for nn elements of ntype, which is owned by this. Fill it in with Data().
+ */
+AttributeBlob::AttributeBlob(int ntype, long nn)
+{
+	type   = ntype;
+	n      = nn;
+	source = nullptr;
+	data   = (n > 0 ? new char[Size()] : nullptr);
+}
+
+/*! If nsource, then data is not copied, and nsource is inc_count()'d for the life of the blob.
+ * Otherwise data is copied.
+ */
+AttributeBlob::AttributeBlob(int ntype, long nn, const void *ndata, RefCounted *nsource)
+{
+	type   = ntype;
+	n      = nn;
+	source = nsource;
+
+	if (source) {
+		source->inc_count();
+		data = ndata;
+	} else {
+		data = (n > 0 ? new char[Size()] : nullptr);
+		if (data && ndata) memcpy(const_cast<void*>(data), ndata, Size());
+	}
+}
+
+AttributeBlob::~AttributeBlob()
+{
+	if (source) source->dec_count();
+	else delete[] (char*)data;
+}
+
+//! Number of bytes in one element of type, or 0 for unknown type.
+int AttributeBlob::ElementSize(int type)
+{
+	if (type == ATTBLOB_Char)   return sizeof(char);
+	if (type == ATTBLOB_Int)    return sizeof(int);
+	if (type == ATTBLOB_Float)  return sizeof(float);
+	if (type == ATTBLOB_Double) return sizeof(double);
+	return 0;
+}
+
+//! Return element i as a double, whatever the type. Out of range returns 0.
+double AttributeBlob::Get(long i)
+{
+	if (i < 0 || i >= n) return 0;
+	if (type == ATTBLOB_Char)   return ((const char*)  data)[i];
+	if (type == ATTBLOB_Int)    return ((const int*)   data)[i];
+	if (type == ATTBLOB_Float)  return ((const float*) data)[i];
+	if (type == ATTBLOB_Double) return ((const double*)data)[i];
+	return 0;
+}
+
+//! Return a new[]'d string of all the elements, separated by spaces.
+char *AttributeBlob::ToString()
+{
+	char *str = new char[n*24 + 1];
+	char *p = str;
+	*p = '\0';
+
+	for (long c=0; c<n; c++) {
+		if (c) *p++ = ' ';
+		if (type == ATTBLOB_Float || type == ATTBLOB_Double) p += sprintf(p, "%.10g", Get(c));
+		else p += sprintf(p, "%d", (int)Get(c));
+	}
+	return str;
+}
+
+
+//---------------------------------- AttributeArena -----------------------------------	
+/*! \class AttributeArena
+ * \ingroup attributes
+ * \brief Bump allocator for Attribute nodes and strings of big trees read in from files.
+ *
+ * Turn it on for a tree with Attribute::UseArena() on the root before reading. Subattributes
+ * read in with the ida parser or BinaryToAttribute() are then placement constructed in blocks of
+ * ATTARENA_NODES_PER_BLOCK nodes, their values are copied into large string blocks, and their names are
+ * interned through the lark table, so Attribute::find() compares ids instead of strings. Binary files
+ * read with BinaryFileToAttribute() are kept as a source, and values point straight into them.
+ * Everything is freed at once when the root lets go of the arena.
+ *
+ * Attribute::arena_flags says which parts of a node are not owned by the node. Code that
+ * changes name, value, or comment of nodes in an arena must use Attribute::Name(), Value(), and Comment()
+ * rather than makestr(). Arena nodes can be moved around within their tree with push() and remove(),
+ * but must not outlive the root. Use duplicate() to keep a part of the tree.
+ */
+
+
+#define ATTARENA_BLOCK_SIZE      65536
+#define ATTARENA_NODES_PER_BLOCK 512
+
+
+AttributeArena::AttributeArena()
+  : blocks(LISTS_DELETE_Array),
+	node_blocks(LISTS_DELETE_Array),
+	sources(LISTS_DELETE_None)
+{
+	current      = nullptr;
+	current_used = current_size = 0;
+	nodes_used   = 0;
+	intern_str   = nullptr;
+	intern_id    = nullptr;
+	intern_n     = intern_max = 0;
+	bytes        = 0;
+}
+
+AttributeArena::~AttributeArena()
+{
+	for (int c=0; c<node_blocks.n; c++) {
+		int n = (c == node_blocks.n-1 ? nodes_used : ATTARENA_NODES_PER_BLOCK);
+		for (int c2=0; c2<n; c2++) {
+			((Attribute*)(node_blocks.e[c] + c2*sizeof(Attribute)))->~Attribute();
+		}
+	}
+	for (int c=0; c<sources.n; c++) sources.e[c]->dec_count();
+	delete[] intern_str;
+	delete[] intern_id;
+}
+
+//! Return size bytes, aligned to 8, that last as long as the arena.
+void *AttributeArena::Alloc(long size)
+{
+	size = (size + 7) & ~7L;
+	bytes += size;
+
+	if (size > ATTARENA_BLOCK_SIZE/4) {
+		 //big things get their own block, so the current one is not wasted
+		char *block = new char[size];
+		blocks.push(block);
+		return block;
+	}
+
+	if (!current || current_used + size > current_size) {
+		current = new char[ATTARENA_BLOCK_SIZE];
+		blocks.push(current);
+		current_used = 0;
+		current_size = ATTARENA_BLOCK_SIZE;
+	}
+
+	void *mem = current + current_used;
+	current_used += size;
+	return mem;
+}
+
+//! Return a copy of str in arena memory. If len<0, use strlen(str).
+char *AttributeArena::NewString(const char *str, int len)
+{
+	if (!str) return nullptr;
+	if (len < 0) len = strlen(str);
+	char *s = (char*)Alloc(len+1);
+	memcpy(s, str, len);
+	s[len] = '\0';
+	return s;
+}
+
+static unsigned int attarena_hash(const char *str, int len)
+{
+	unsigned int h = 2166136261u;
+	for (int c=0; c<len; c++) {
+		h ^= (unsigned char)str[c];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+//! Return the lark string for len chars of str, and its id in id_ret.
+/*! Each distinct name is looked up in the global lark table only the first time this arena sees it.
+ * The returned string lasts for the life of the program.
+ */
+const char *AttributeArena::Intern(const char *str, int len, int *id_ret)
+{
+	if (len < 0) len = strlen(str);
+
+	if (2*(intern_n+1) > intern_max) {
+		 //grow and rehash
+		int newmax = (intern_max ? 2*intern_max : 256);
+		const char **newstrs = new const char*[newmax];
+		int *newids = new int[newmax];
+		memset(newstrs, 0, newmax*sizeof(const char*));
+		for (int c=0; c<intern_max; c++) {
+			if (!intern_str[c]) continue;
+			unsigned int i = attarena_hash(intern_str[c], strlen(intern_str[c])) & (newmax-1);
+			while (newstrs[i]) i = (i+1) & (newmax-1);
+			newstrs[i] = intern_str[c];
+			newids[i]  = intern_id[c];
+		}
+		delete[] intern_str;
+		delete[] intern_id;
+		intern_str = newstrs;
+		intern_id  = newids;
+		intern_max = newmax;
+	}
+
+	unsigned int i = attarena_hash(str, len) & (intern_max-1);
+	while (intern_str[i]) {
+		if (!strncmp(intern_str[i], str, len) && intern_str[i][len] == '\0') {
+			if (id_ret) *id_ret = intern_id[i];
+			return intern_str[i];
+		}
+		i = (i+1) & (intern_max-1);
+	}
+
+	int id = lark_id_from_strn(str, len, 1);
+
+	intern_str[i] = lark_str_from_id(id);
+	intern_id[i]  = id;
+	intern_n++;
+	if (id_ret) *id_ret = id;
+	return intern_str[i];
+}
+
+//! Return the lark id of str if some name in this arena has been interned with it, else 0.
+int AttributeArena::FindId(const char *str)
+{
+	if (!intern_n) return 0;
+	int len = strlen(str);
+	unsigned int i = attarena_hash(str, len) & (intern_max-1);
+	while (intern_str[i]) {
+		if (!strcmp(intern_str[i], str)) return intern_id[i];
+		i = (i+1) & (intern_max-1);
+	}
+	return 0;
+}
+
+//! Return a new blank Attribute in arena memory. It must not be deleted, the arena destroys it.
+Attribute *AttributeArena::NewAttribute()
+{
+	if (!node_blocks.n || nodes_used == ATTARENA_NODES_PER_BLOCK) {
+		node_blocks.push(new char[ATTARENA_NODES_PER_BLOCK * sizeof(Attribute)]);
+		nodes_used = 0;
+	}
+
+	Attribute *att = new (node_blocks.e[node_blocks.n-1] + nodes_used*sizeof(Attribute)) Attribute();
+	nodes_used++;
+	bytes += sizeof(Attribute);
+	att->arena = this;
+	att->arena_flags = ATTARENA_Node;
+	return att;
+}
+
+//! Keep source alive for the life of the arena, so that strings can point into it.
+void AttributeArena::AddSource(RefCounted *source)
+{
+	if (!source || sources.Contains(source)) return;
+	source->inc_count();
+	sources.push(source);
+}
+
+long AttributeArena::NumNodes()
+{
+	if (!node_blocks.n) return 0;
+	return (node_blocks.n-1) * (long)ATTARENA_NODES_PER_BLOCK + nodes_used;
+}
+
+
 //---------------------------------- Attribute -----------------------------------	
 /*! \class Attribute
  * \ingroup attributes
@@ -1434,6 +1711,9 @@ void skip_to_next_attribute(IOBuffer &f,int indent)
  *
  * Attribute::flags is not natively used by Attribute. It exists to aid other
  * classes to keep a simple hint about what data is contained.
+ *
+ * For big trees that are read in and then only looked at, call UseArena() on the root first.
+ * See AttributeArena.
  */
 
 
@@ -1444,40 +1724,114 @@ Attribute::Attribute(const char *nn, const char *val,const char *nt)
 	makestr(value,val);
 	makestr(atttype,nt);
 	comment = NULL;
+	blob = NULL;
 	flags=0;
+	arena = NULL;
+	name_id = 0;
+	arena_flags = 0;
+}
+
+//! Delete[] str unless att->arena_flags says it is in arena memory, and set it to NULL.
+static void att_free_str(Attribute *att, char *&str, int flag)
+{
+	if (att->arena_flags & flag) att->arena_flags &= ~flag;
+	else delete[] str;
+	str = NULL;
+}
+
+//! Set a blank att->name from len chars of str, interned by att->arena if any.
+static void att_set_name(Attribute *att, const char *str, int len)
+{
+	if (att->arena) {
+		att->name = const_cast<char*>(att->arena->Intern(str, len, &att->name_id));
+		att->arena_flags |= ATTARENA_Name;
+	} else makenstr(att->name, str, len);
+}
+
+//! Set a blank att->value to a copy of len chars of str, in att->arena if any.
+static void att_set_value(Attribute *att, const char *str, int len)
+{
+	if (att->arena) {
+		att->value = att->arena->NewString(str, len);
+		att->arena_flags |= ATTARENA_Value;
+	} else makenstr(att->value, str, len);
 }
 
 Attribute::~Attribute()
 {
-	delete[] name;
-	delete[] value;
-	delete[] atttype;
-	delete[] comment;
+	att_free_str(this, name,    ATTARENA_Name);
+	att_free_str(this, value,   ATTARENA_Value);
+	att_free_str(this, atttype, ATTARENA_Type);
+	att_free_str(this, comment, ATTARENA_Comment);
+	if (blob) blob->dec_count();
+
+	if (arena && !(arena_flags & ATTARENA_Node)) {
+		 //subattributes in the arena are destroyed with it
+		attributes.flush();
+		arena->dec_count();
+	}
 }
 
 //! Set name, value, atttype, comment to NULL and flush attributes.
+/*! If this owns an arena, it is replaced with a fresh one.
+ */
 void Attribute::clear()
 {
-	delete[] name;    name    = NULL;
-	delete[] value;   value   = NULL;
-	delete[] atttype; atttype = NULL;
-	delete[] comment; comment = NULL;
+	att_free_str(this, name,    ATTARENA_Name);
+	att_free_str(this, value,   ATTARENA_Value);
+	att_free_str(this, atttype, ATTARENA_Type);
+	att_free_str(this, comment, ATTARENA_Comment);
+	name_id = 0;
+	if (blob) { blob->dec_count(); blob = NULL; }
 	attributes.flush();
+
+	if (arena && !(arena_flags & ATTARENA_Node)) {
+		arena->dec_count();
+		arena = new AttributeArena();
+	}
 }
 
 /*! Update this->comment. Important: Currently, should not contain newlines.
  */
 void Attribute::Comment(const char *ncomment)
 {
+	att_free_str(this, comment, ATTARENA_Comment);
 	makestr(comment, ncomment);
 }
 
+/*! Update this->name. Use this instead of makestr() for nodes that might be in an AttributeArena.
+ */
+void Attribute::Name(const char *nname)
+{
+	att_free_str(this, name, ATTARENA_Name);
+	name_id = 0;
+	makestr(name, nname);
+}
+
+/*! Update this->value. Use this instead of makestr() for nodes that might be in an AttributeArena.
+ */
+void Attribute::Value(const char *nvalue)
+{
+	att_free_str(this, value, ATTARENA_Value);
+	makestr(value, nvalue);
+}
+
+/*! Make subattributes read in from now on be allocated from an AttributeArena, which
+ * lasts until this is destroyed or cleared. Returns the arena.
+ */
+AttributeArena *Attribute::UseArena()
+{
+	if (!arena) arena = new AttributeArena();
+	return arena;
+}
+
 //! Return a new deep copy of *this.
 Attribute *Attribute::duplicate()
 {
 	Attribute *att=new Attribute(name,value,atttype);
 	att->flags = flags;
 	makestr(att->comment, comment);
+	if (blob) att->SetBlob(blob, false);
 
 	for (int c=0; c<attributes.n; c++) {
 		if (!attributes.e[c]) continue; //tweak to ignore NULL attributes
@@ -1495,18 +1849,12 @@ Attribute *Attribute::duplicate()
  */
 const char *Attribute::findValue(const char *fromname,int *i_ret)
 {
-	if (i_ret) *i_ret=-1;
-	if (!fromname) return nullptr;
-	for (int c=0; c<attributes.n; c++)
-		if (attributes.e[c]->name && !strcmp(attributes.e[c]->name,fromname)) {
-			if (!isblank(attributes.e[c]->value)) {
-				if (i_ret) *i_ret=c;
-				if (!attributes.e[c]->value) return "";
-				return attributes.e[c]->value;
-			}
-			break;
-		}
-	return nullptr;
+	int i;
+	Attribute *att = find(fromname, &i);
+	if (i_ret) *i_ret = -1;
+	if (!att || isblank(att->value)) return nullptr;
+	if (i_ret) *i_ret = i;
+	return att->value;
 }
 
 //! Convenience function to search for a subattribute, and convert its value to a double.
@@ -1517,17 +1865,12 @@ const char *Attribute::findValue(const char *fromname,int *i_ret)
  */
 double Attribute::findDouble(const char *fromname,int *i_ret)
 {
-	if (i_ret) *i_ret=-1;
-	if (!fromname) return 0;
-	for (int c=0; c<attributes.n; c++)
-		if (attributes.e[c]->name && !strcmp(attributes.e[c]->name,fromname)) {
-			if (!isblank(attributes.e[c]->value)) {
-				if (i_ret) *i_ret=c;
-				return strtod(attributes.e[c]->value, nullptr);
-			}
-			break;
-		}
-	return 0;
+	int i;
+	Attribute *att = find(fromname, &i);
+	if (i_ret) *i_ret = -1;
+	if (!att || isblank(att->value)) return 0;
+	if (i_ret) *i_ret = i;
+	return strtod(att->value, nullptr);
 }
 
 //! Convenience function to search for a subattribute, and convert its value to a long.
@@ -1538,31 +1881,33 @@ double Attribute::findDouble(const char *fromname,int *i_ret)
  */
 long Attribute::findLong(const char *fromname,int *i_ret)
 {
-	if (i_ret) *i_ret=-1;
-	if (!fromname) return 0;
-	for (int c=0; c<attributes.n; c++)
-		if (attributes.e[c]->name && !strcmp(attributes.e[c]->name,fromname)) {
-			if (!isblank(attributes.e[c]->value)) {
-				if (i_ret) *i_ret=c;
-				return strtol(attributes.e[c]->value,NULL,10);
-			}
-			break;
-		}
-	return 0;
+	int i;
+	Attribute *att = find(fromname, &i);
+	if (i_ret) *i_ret = -1;
+	if (!att || isblank(att->value)) return 0;
+	if (i_ret) *i_ret = i;
+	return strtol(att->value,NULL,10);
 }
 
 //! Return the first sub-attribute with the name fromname, or NULL if not found.
 /*! If i_ret!=NULL, then fill it with the index of the attribute, if found, or -1 if not found.
+ *
+ * Names interned by an AttributeArena are compared by lark id.
  */
 Attribute *Attribute::find(const char *fromname,int *i_ret)
 {
 	if (i_ret) *i_ret=-1;
 	if (!fromname) return nullptr;
-	for (int c=0; c<attributes.n; c++)
-		if (attributes.e[c]->name && !strcmp(attributes.e[c]->name,fromname)) {
+
+	int id = (arena ? arena->FindId(fromname) : 0);
+	Attribute *att;
+	for (int c=0; c<attributes.n; c++) {
+		att = attributes.e[c];
+		if (id && att->name_id ? att->name_id == id : (att->name && !strcmp(att->name,fromname))) {
 			if (i_ret) *i_ret=c;
-			return attributes.e[c];
+			return att;
 		}
+	}
 	return nullptr;
 }
 
@@ -1576,14 +1921,36 @@ Attribute *Attribute::pushSubAtt(const char *nname, const char *nvalue, const ch
 	return att;
 }
 
+/*! Push a new Attribute with a blob of n elements of type (see AttributeBlobTypes). If data!=NULL,
+ * it is copied into the blob, otherwise fill in the returned att->blob->Data().
+ */
+Attribute *Attribute::pushBlob(const char *nname, int type, long n, const void *data, const char *ncomment)
+{
+	Attribute *att = new Attribute(nname, nullptr);
+	makestr(att->comment, ncomment);
+	att->blob = new AttributeBlob(type, n, data, nullptr);
+	push(att,-1);
+	return att;
+}
+
+/*! Replace blob with nblob. If absorb, nblob's count is taken, else it is inc_count()'d.
+ */
+void Attribute::SetBlob(AttributeBlob *nblob, bool absorb)
+{
+	if (nblob && !absorb) nblob->inc_count();
+	if (blob) blob->dec_count();
+	blob = nblob;
+}
+
 //! Push a full blown, already constructed Attribute onto the attribute stack.
 /*! If where==-1, then push onto the top of the stack.
- * The calling code must not delete the att. It is now the responsibility of *this.
+ * The calling code must not delete the att. It is now the responsibility of *this,
+ * or of its AttributeArena if att was made by one.
  * Returns the index of the newly pushed att, or -1 if pushing failed.
  */
 int Attribute::push(Attribute *att,int where)
 { 
-	if (att) return attributes.push(att,1,where); 
+	if (att) return attributes.push(att, (att->arena_flags & ATTARENA_Node) ? LISTS_DELETE_None : LISTS_DELETE_Single, where);
 	return -1;
 }
 
@@ -1752,7 +2119,11 @@ void Attribute::dump_out(FILE *f, int indent)
 
 			 //dump out value
 			//sprintf(format, " %%-%ds", valuewidth);
-			dump_out_value(f, indent+2, attributes.e[c]->value, valuewidth, attributes.e[c]->comment, indent+namewidth+valuewidth+2);
+			if (!attributes.e[c]->value && attributes.e[c]->blob) {
+				char *str = attributes.e[c]->blob->ToString();
+				dump_out_value(f, indent+2, str, valuewidth, attributes.e[c]->comment, indent+namewidth+valuewidth+2);
+				delete[] str;
+			} else dump_out_value(f, indent+2, attributes.e[c]->value, valuewidth, attributes.e[c]->comment, indent+namewidth+valuewidth+2);
 		}
 
 		 //dump out subatts
@@ -1796,7 +2167,7 @@ void Attribute::dump_out_full(FILE *f, int indent)
  * Comments are stripped from each line. A comment is anything
  * from an unescaped, unquoted '#' character to the end of the line.
  */
-char *Attribute::dump_in_indented(IOBuffer &f, int Indent)
+static char *read_indented(IOBuffer &f, int Indent)
 {
 	char *line=NULL,*str=NULL,*tline;
 	size_t n;
@@ -1856,7 +2227,7 @@ char *Attribute::dump_in_indented(IOBuffer &f, int Indent)
  * Comments are not stripped. The final newline before the tag is not
  * included.
  */
-char *Attribute::dump_in_until(IOBuffer &f, const char *tag, int Indent)//indent=0
+static char *read_until(IOBuffer &f, const char *tag, int Indent)
 {
 	char *str  = NULL;
 	char *line = NULL, *tline;
@@ -1894,6 +2265,16 @@ char *Attribute::dump_in_until(IOBuffer &f, const char *tag, int Indent)//indent
 	return str;
 }
 
+char *Attribute::dump_in_indented(IOBuffer &f, int Indent)
+{
+	return read_indented(f, Indent);
+}
+
+char *Attribute::dump_in_until(IOBuffer &f, const char *tag, int Indent)//indent=0
+{
+	return read_until(f, tag, Indent);
+}
+
 //! Remove backslashes. Double backslash becomes single backslash.
 /*! Note this does not substitute characters. Thus "\\t" converts to 't'.
  */
@@ -1922,12 +2303,175 @@ int Attribute::dump_in(FILE *f, int Indent,Attribute **stopatsub)//stopatsub=NUL
 	return 0;
 }
 
+//! Read one name and value line at indent >= Indent, and send BeginNode(), Name() and Value() for it.
+/*! line and n are a GetLine() buffer that is reused between calls.
+ * Returns the indent of the line, -1 if there is nothing more at this level, or -2 if events asked to stop.
+ */
+static int ida_read_node(IOBuffer &f, int Indent, char *&line, size_t &n, AttributeEvents *events)
+{
+	int c = getline_indent_nonblank(&line,&n,f,Indent,"#",'"',1);
+	if (c <= 0) return -1; // eof or bad line
+
+	 // now line is on a properly indented line that has no trailing whitespace.
+	 // We need to input name, which can be optionally quoted, otherwise it is continuous non-whitespace
+	char *fld = line;
+	while (isspace(*fld)) fld++;
+	int indent = fld-line; //*** must check for improperly indented file!!
+			// the line should be at least Indent as per the above getline
+			// wrong:
+			//   blah
+			//       subblah
+			//     subblah
+
+	if (!events->BeginNode()) return -2;
+
+	bool keepgoing = true;
+	char *val = fld;
+	if (*val == '\'' || *val == '"') {
+		char *qname = QuotedAttribute(val, &val);
+		if (qname) keepgoing = events->Name(qname, strlen(qname));
+		delete[] qname;
+	} else {
+		while (*val && !isspace(*val)) val++;
+		int nf = val-fld;
+		if (!memchr(fld, '\\', nf)) keepgoing = events->Name(fld, nf);
+		else {
+			char *nm = newnstr(fld, nf);
+			removeescapes(nm);
+			keepgoing = events->Name(nm, strlen(nm));
+			delete[] nm;
+		}
+	}
+	if (!keepgoing) return -2;
+
+	while (isspace(*val)) val++;
+	if (!*val) val = nullptr;
+
+	 // val points to the start of the value part.
+	 // val can be:
+	 //   \       <-- expect simple value indented starting next line..
+	 //   <<<filename <-- signal that format is ATT_VALUE_FILE, contents in file filename
+	 //   << BLAH <-- raw read in until BLAH is encountered again.
+	 //   < BLAH <-- indented raw read in until BLAH is encountered again.
+	 //   (NULL)
+	 //   somesimplevalue
+	 //   "some quoted value, maybe with escaped \t things"
+
+	char *temp = NULL;
+	if (!val) {} // do nothing for null value
+	else if (!strcmp(val,"\\")) {
+		//**** there's confusion when line ends in "\   "..
+		 // name \ #comment should have been stripped
+		 //   stuff
+		val = temp = read_indented(f,indent+1);
+
+	} else if (!strncmp(val,"<<<",3)) {
+		 // <<< filename
+		val += 3;
+		while (isspace(*val)) val++;
+		if (!*val) {
+			val = NULL;
+			DBG cerr <<" <<< broken filename!!"<<endl;
+		} else {
+			// *** supposed to read in file and put it in attribute
+		}
+
+	} else if (!strncmp(val,"<<",2)) {
+		 // << INDENTEDTAG
+		val += 2;
+		while (isspace(*val)) val++;
+		if (!*val) {
+			val = NULL;
+			DBG cerr <<" <<< broken indented tag!! "<<endl;
+		} else {
+			val = temp = read_until(f,val,indent+1);
+		}
+
+	} else if (*val=='<') {
+		 // < RAWTAG
+		val++;
+		while (isspace(*val)) val++;
+		if (!*val) {
+			val = NULL;
+			DBG cerr <<" <<< broken rawtag!! "<<endl;
+		} else {
+			val = temp = read_until(f,val,0);
+		}
+
+	} else { // is a simple value on name line, check for quotes..
+		if (*val=='"') {
+			 // if end of val is a matched quote, remove quotes..
+			int e = 0, //e==1 if a backslash is encountered, and must parse next char
+				m = 0, //the number of recognizable chunks, must be 1 at end to remove quotes
+				q = 0; //the position of the last unescaped quote
+			for (c=1; val[c]!='\0'; c++) {
+				if (e) { e = 0; continue; }
+				if (q>0 && !isspace(val[c])) { m = 2; break; }
+				if (val[c]=='\\') e = !e;
+				else if (val[c]=='"') { q = c; m++; }
+			}
+			// if loop was broken 1 before end, then remove quotes
+			if (m==1) { // was matched quote, need to unescape quotes now
+				val[q]='\0';
+				val++;
+				for (c=0; val[c]!='\0'; c++) {
+					if (val[c]=='\\') {
+						if (val[c+1]=='"') memmove(val+c,val+c+1,strlen(val+c+1)+1);
+					}
+				}
+			}
+		}
+	}
+	if (val) keepgoing = events->Value(val, strlen(val));
+	delete[] temp;
+
+	return keepgoing ? indent : -2;
+}
+
+//! Send events for all the nodes at indent >= Indent, and their subnodes.
+/*! Returns 0 when there are no more lines at Indent, or 1 if events asked to stop.
+ * If numread, it is incremented for each node at this level.
+ */
+static int ida_parse(IOBuffer &f, int Indent, char *&line, size_t &n, AttributeEvents *events, int *numread)
+{
+	while (!f.IsEOF()) {
+		int indent = ida_read_node(f, Indent, line, n, events);
+		if (indent == -1) break;
+		if (indent == -2) return 1;
+		if (numread) (*numread)++;
+
+		if (ida_parse(f, indent+1, line, n, events, NULL)) return 1;
+		if (!events->EndNode()) return 1;
+	}
+	return 0;
+}
+
+//! Read in the indented data format from f, sending each part to events instead of building an Attribute.
+/*! Each node at indent >= indent gets BeginNode(), Name(), Value() if it has one, then the same for
+ * each of its subnodes, then EndNode(). Reading stops as soon as any event returns false, leaving
+ * f just after the current line. Only the current line and value are ever in memory.
+ *
+ * Attribute::dump_in(IOBuffer&,int,Attribute**) is an AttributeTreeBuilder fed by this.
+ *
+ * Returns 0 for read to the end of the indented block, or 1 for stopped by events.
+ */
+int ParseAttributeEvents(IOBuffer &f, int indent, AttributeEvents *events)
+{
+	char *line = NULL;
+	size_t n = 0;
+	int status = ida_parse(f, indent, line, n, events, NULL);
+	if (line) f.FreeGetLinePtr(line);
+	return status;
+}
+
+
 //! Read in sub-attribute data, starting after initial line...
 /*! This function is meant to be called after the line with this->name and value has
  * already been parsed. This function just parses in all the subattributes,
  * and recursively their subattributes. Usually it will be called with Indent equal
  * to 1 more than what this->name/value was indented at. The actual indentation of
  * the subattribute must only be greater than or equal to Indent.
+ * This is an AttributeTreeBuilder fed by ParseAttributeEvents().
  *
  * Each subelement parsed in is pushed onto the top of the attributes stack.
  *
@@ -1965,139 +2509,23 @@ int Attribute::dump_in(FILE *f, int Indent,Attribute **stopatsub)//stopatsub=NUL
  */
 int Attribute::dump_in(IOBuffer &f, int Indent,Attribute **stopatsub)
 {
-	if (f.IsEOF()) return 0;
-
-	char *line=NULL;
-	int c,indent;
-	size_t n=0;
-	char *val,*fld,*temp=NULL;
-	int nf,numattsread=0;
 	if (stopatsub) *stopatsub=NULL;
+	if (f.IsEOF()) return 0;
 
-	while (!f.IsEOF()) {
-		c = getline_indent_nonblank(&line,&n,f,Indent,"#",'"',1);
-		if (c <= 0) break; // eof or bad line
-		
-		 // now line is on a properly indented line that has no trailing whitespace.
-		 // We need to input name, which can be optionally quoted, otherwise it is continuous non-whitespace
-		fld = line;
-		while (isspace(*fld)) fld++;
-		indent = fld-line; //*** must check for improperly indented file!!
-				// the line should be at least Indent as per the above getline
-				// wrong:
-				//   blah
-				//       subblah
-				//     subblah
-
-		Attribute *att = new Attribute;
-		val = fld;
-		if (*val == '\'' || *val == '"') {
-			char *qname = QuotedAttribute(val, &val);
-			att->name = qname;
-		} else {
-			while (*val && !isspace(*val)) val++;
-			nf = val-fld;
-			makenstr(att->name, fld, nf);
-			removeescapes(att->name);
-		}
-
-		while (isspace(*val)) val++;
-		if (!*val) val = nullptr;
-
-		 // now fld points to the potential field name, which goes for nf chars,
-		attributes.push(att);
-		 
-		 // val points to the start of the value part.
-		 // val can be: 
-		 //   \       <-- expect simple value indented starting next line..
-		 //   <<<filename <-- signal that format is ATT_VALUE_FILE, contents in file filename 
-		 //   << BLAH <-- raw read in until BLAH is encountered again. 
-		 //   < BLAH <-- indented raw read in until BLAH is encountered again. 
-		 //   (NULL)
-		 //   somesimplevalue
-		 //   "some quoted value, maybe with escaped \t things"
-
-		numattsread++;
-		if (!val) {} // do nothing for null value
-		else if (!strcmp(val,"\\")) {
-			//**** there's confusion when line ends in "\   "..
-			 // name \ #comment should have been stripped
-			 //   stuff
-			val = temp = dump_in_indented(f,indent+1);
-
-		} else if (!strncmp(val,"<<<",3)) {
-			 // <<< filename
-			val += 3;
-			while (isspace(*val)) val++;
-			if (!*val) { 
-				val = NULL; 
-				DBG cerr <<" <<< broken filename!!"<<endl; 
-			} else {
-				// *** supposed to read in file and put it in attribute
-			}
-
-		} else if (!strncmp(val,"<<",2)) {
-			 // << INDENTEDTAG
-			val += 2;
-			while (isspace(*val)) val++;
-			if (!*val) { 
-				val = NULL;
-				DBG cerr <<" <<< broken indented tag!! "<<endl;
-			} else {
-				val = temp = dump_in_until(f,val,indent+1);
-			}
-
-		} else if (*val=='<') {
-			 // < RAWTAG
-			val++;
-			while (isspace(*val)) val++;
-			if (!*val) {
-				val = NULL;
-				DBG cerr <<" <<< broken rawtag!! "<<endl;
-			} else {
-				val = temp = dump_in_until(f,val,0);
-			}
-
-		} else { // is a simple value on name line, check for quotes.. 
-			if (*val=='"') { 
-				 // if end of val is a matched quote, remove quotes..
-				int e = 0, //e==1 if a backslash is encountered, and must parse next char
-					m = 0, //the number of recognizable chunks, must be 1 at end to remove quotes
-					q = 0; //the position of the last unescaped quote
-				for (c=1; val[c]!='\0'; c++) {
-					if (e) { e = 0; continue; }
-					if (q>0 && !isspace(val[c])) { m = 2; break; }
-					if (val[c]=='\\') e = !e;
-					else if (val[c]=='"') { q = c; m++; }
-				}
-				// if loop was broken 1 before end, then remove quotes
-				if (m==1) { // was matched quote, need to unescape quotes now
-					val[q]='\0';
-					val++;
-					for (c=0; val[c]!='\0'; c++) {
-						if (val[c]=='\\') {
-							if (val[c+1]=='"') memmove(val+c,val+c+1,strlen(val+c+1)+1);
-						}
-					}
-				}
-			}
-		}
-		if (val) makestr(att->value,val);
-		if (temp) { delete[] temp; temp=NULL; }
-
-		//DBG char spc[indent+1]; memset(spc,' ',indent); spc[indent]='\0';
-		//DBG cerr<<spc<<"Found att("<<attributes.n<<"):\""<<(att->name?att->name:"(no name)")<<"\" = \""
-		//DBG 	<< (att->value?att->value:"(no name)")<<"\""<<((att->format==ATT_VALUE_FILE)?"(is file)":"")<<endl;
+	AttributeTreeBuilder builder(this);
+	char *line = NULL;
+	size_t n = 0;
 
-		if (stopatsub) {
-			*stopatsub=att;
-			if (temp) delete[] temp;
-			if (line) f.FreeGetLinePtr(line);
-			return indent;
-		} else att->dump_in(f,indent+1);
+	if (stopatsub) {
+		int indent = ida_read_node(f, Indent, line, n, &builder);
+		if (line) f.FreeGetLinePtr(line);
+		if (indent < 0) return -1;
+		*stopatsub = builder.Current();
+		return indent;
 	}
 
-	if (temp) delete[] temp;
+	int numattsread = 0;
+	ida_parse(f, Indent, line, n, &builder, &numattsread);
 	if (line) f.FreeGetLinePtr(line);
 	return numattsread;
 }
@@ -2106,7 +2534,8 @@ int Attribute::dump_in(IOBuffer &f, int Indent,Attribute **stopatsub)
 //! Read in a whole database.
 /*! The base is name=file, value=filename.
  * For what, see AttributeTypes. Default is ATT_Att.
- * Also checks for ATT_Json and ATT_Xml.
+ * Also checks for ATT_Json, ATT_Xml, and ATT_Binary. Binary files are also recognized
+ * when what is ATT_Att, so files saved either way load the same.
  * Warning that xml may fail for html that does not have closing indications on any tags.
  *
  * \todo *** when dumping in, it is sometimes useful to preserve what the position in the file
@@ -2126,6 +2555,12 @@ int Attribute::dump_in(const char *filename, int what)
 		if (XMLFileToAttribute(this, filename, NULL) == this) return 0;
 		return 1;
 	}
+	if (what == ATT_Binary || (what == ATT_Att && IsBinaryAttributeFile(filename))) {
+		if (BinaryFileToAttribute(filename, this, NULL) != this) return 1;
+		Name("file");
+		Value(filename);
+		return 0;
+	}
 
 	IOBuffer f;
 	f.OpenFile(filename, "r");
@@ -2135,9 +2570,9 @@ int Attribute::dump_in(const char *filename, int what)
 		return 1;
 	}
 
-	makestr(name,"file");
-	makestr(value,filename);
-	makestr(atttype,NULL);
+	Name("file");
+	Value(filename);
+	att_free_str(this, atttype, ATTARENA_Type);
 
 	DBG cerr <<"Reading "<<filename<<"...."<<endl;
 
@@ -2316,6 +2751,7 @@ Attribute *AttributeObject::duplicate()
 {
 	AttributeObject *att=new AttributeObject(name,value,atttype);
 	att->flags=flags;
+	if (blob) att->SetBlob(blob, false);
 	for (int c=0; c<attributes.n; c++) {
 		if (!attributes.e[c]) continue; //tweak to ignore NULL attributes
 		att->push(attributes.e[c]->duplicate(),-1);
@@ -2337,21 +2773,147 @@ void AttributeObject::SetData(anObject *ndata, int absorb)
 	}
 }
 
-//---------------------------------- XML Conversion Helpers -----------------------------------	
-
-/*! Warning: completely overwrites the file.
- *
- * Returns 0 for success. Non-zero for error.
+//---------------------------------- AttributeTreeBuilder -----------------------------------	
+/*! \class AttributeEvents
+ * \ingroup attributes
+ * \brief Receives the parts of a file one at a time from ParseAttributeEvents(), ParseXMLEvents(),
+ *   ParseJsonEvents(), or ParseCSVEvents(), instead of a whole Attribute tree at the end.
  *
- * The attribute passed in must be particularly formatted. For each main tag, any subtag
- * that is not named "content:" is written as an XML attribute of that tag, not as an element. Those
- * must have only a name and value. Any sub-attributes they may have are ignored.
- * There should be only one "content:" sub-attribute for a tag. This will contain all the elements
- * in the tag. That "content:" sub-attribute might contain several "cdata:" elements, which
- * are character data in between other tagged elements. "cdata:" attributes must have a value, but not
- * have any subattributes.
+ * Each node in the file comes as BeginNode(), then Name(), Value(), and Flags() as
+ * available, then the same for each subnode, then EndNode(). Strings passed in are only valid
+ * during the call, and are not null terminated. Return false from any of them to stop parsing.
+ * This lets big files be processed as they are read, in constant memory.
  *
- * \todo perhaps have a niceness parameter, so to lay out XML attributes inside a
+ * See AttributeTreeBuilder for the events that the usual Attribute readers are built on.
+ */
+
+/*! \class AttributeTreeBuilder
+ * \ingroup attributes
+ * \brief AttributeEvents that build subattributes of root, in root's AttributeArena if any.
+ */
+
+
+AttributeTreeBuilder::AttributeTreeBuilder(Attribute *nroot)
+  : stack(LISTS_DELETE_None)
+{
+	root = nroot;
+}
+
+bool AttributeTreeBuilder::BeginNode()
+{
+	Attribute *parent = Current();
+	Attribute *att = (parent->arena ? parent->arena->NewAttribute() : new Attribute());
+	 //grow geometrically, since streamed files can have huge numbers of rows or elements
+	if (parent->attributes.n == parent->attributes.Allocated()) parent->attributes.Allocate(2*parent->attributes.n + 10);
+	parent->push(att, -1);
+	stack.push(att);
+	return true;
+}
+
+bool AttributeTreeBuilder::Name(const char *str, int len)
+{
+	Attribute *att = Current();
+	att_free_str(att, att->name, ATTARENA_Name);
+	att->name_id = 0;
+	att_set_name(att, str, len);
+	return true;
+}
+
+bool AttributeTreeBuilder::Value(const char *str, int len)
+{
+	Attribute *att = Current();
+	att_free_str(att, att->value, ATTARENA_Value);
+	att_set_value(att, str, len);
+	return true;
+}
+
+void AttributeTreeBuilder::Flags(unsigned int nflags)
+{
+	Current()->flags = nflags;
+}
+
+bool AttributeTreeBuilder::EndNode()
+{
+	if (stack.n) stack.pop();
+	return true;
+}
+
+
+//! Size of the chunks AttCharReader reads from an IOBuffer.
+#define ATT_READ_CHUNK 16384
+
+/*! \class AttCharReader
+ * Internal buffered character input for the streaming XML and Json parsers.
+ * Reads chunks from an IOBuffer, or walks a block of memory.
+ */
+class AttCharReader
+{
+  public:
+	IOBuffer *f;
+	const char *mem;
+	long n, pos;
+	long start; //!< file position of mem[0]
+	char chunk[ATT_READ_CHUNK];
+
+	AttCharReader(IOBuffer *nf) { f = nf; mem = chunk; n = pos = start = 0; }
+	AttCharReader(const char *buf, long len) { f = nullptr; mem = buf; n = len; pos = start = 0; }
+
+	bool Fill()
+	{
+		if (!f) return false;
+		start += n;
+		pos = 0;
+		n = f->Read(chunk, 1, ATT_READ_CHUNK);
+		return n > 0;
+	}
+	int Peek() { if (pos >= n && !Fill()) return EOF; return (unsigned char)mem[pos]; }
+	int Get()  { if (pos >= n && !Fill()) return EOF; return (unsigned char)mem[pos++]; }
+	void SkipSpace() { int ch; while ((ch = Peek()) != EOF && isspace(ch)) pos++; }
+	long Position() { return start + pos; }
+};
+
+/*! \class AttCharBuffer
+ * Internal growable string for the streaming parsers. s is always null terminated.
+ */
+class AttCharBuffer
+{
+  public:
+	char *s;
+	long n, max;
+
+	AttCharBuffer() { max = 256; s = new char[max]; Clear(); }
+	~AttCharBuffer() { delete[] s; }
+	void Clear() { n = 0; s[0] = '\0'; }
+	void Add(int ch)
+	{
+		if (n+1 >= max) {
+			max *= 2;
+			char *ns = new char[max];
+			memcpy(ns, s, n);
+			delete[] s;
+			s = ns;
+		}
+		s[n++] = ch;
+		s[n] = '\0';
+	}
+};
+
+
+//---------------------------------- XML Conversion Helpers -----------------------------------	
+
+/*! Warning: completely overwrites the file.
+ *
+ * Returns 0 for success. Non-zero for error.
+ *
+ * The attribute passed in must be particularly formatted. For each main tag, any subtag
+ * that is not named "content:" is written as an XML attribute of that tag, not as an element. Those
+ * must have only a name and value. Any sub-attributes they may have are ignored.
+ * There should be only one "content:" sub-attribute for a tag. This will contain all the elements
+ * in the tag. That "content:" sub-attribute might contain several "cdata:" elements, which
+ * are character data in between other tagged elements. "cdata:" attributes must have a value, but not
+ * have any subattributes.
+ *
+ * \todo perhaps have a niceness parameter, so to lay out XML attributes inside a
  *   tag on separate lines:
  *   <blah first="1"
  *         second="2">
@@ -2538,10 +3100,7 @@ Attribute *XMLFileToAttributeLocked(Attribute *att,const char *file,const char *
  * have no closing tag, and do not explicitly end in /&lt;.
  * 
  * See XMLChunkToAttribute(Attribute*,const char *,long,long*,const char *,const char **)
- * for details about the conversion.
- * 
- * \todo this just reads in the whole file to memory then parses it, which might be rather
- *   inefficient, but it is easy to code..
+ * for details about the conversion. The file is read a chunk at a time with ParseXMLEvents().
  */
 Attribute *XMLChunkToAttribute(Attribute *att,FILE *f,const char **stand_alone_tag_list)
 {
@@ -2550,18 +3109,11 @@ Attribute *XMLChunkToAttribute(Attribute *att,FILE *f,const char **stand_alone_t
 	// <?xml version="1.0"?>
 	// <!DOCTYPE svg PUBLIC "-//W3C//DTD SVG 1.1//EN" "http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd">
 	
-	int n;
-	long revertpos=ftell(f); // position to revert to if too much of file read in.
-	fseek(f,0,SEEK_END);
-	long maxbuf=ftell(f)-revertpos;
-	fseek(f,revertpos,SEEK_SET);
-	char buf[maxbuf+1];
-	memset(buf, 0, maxbuf+1); //doing this, while should be unnecessary, clears valgrind warning
-	
-	n=fread(buf,1,maxbuf,f);
-	if (n<=0) return NULL; //error
-	
-	XMLChunkToAttribute(att,buf,maxbuf,NULL,NULL,stand_alone_tag_list);
+	IOBuffer ff;
+	ff.UseThis(f);
+	AttributeTreeBuilder builder(att);
+	ParseXMLEvents(ff, stand_alone_tag_list, &builder);
+	ff.UseThis(NULL);
 	
 	return att;
 }
@@ -2587,6 +3139,297 @@ int one_of_them(const char *str,const char **list)
 	return 0;
 }
 
+static int xml_parse_element(AttCharReader &in, AttCharBuffer &tag, const char **stand_alone_tag_list,
+							 AttributeEvents *events, AttCharBuffer &closing);
+
+//! Send a "cdata:" node with text as its value.
+static bool xml_cdata(AttributeEvents *events, AttCharBuffer &text)
+{
+	return events->BeginNode() && events->Name("cdata:", 6) && events->Value(text.s, text.n) && events->EndNode();
+}
+
+//! Read character data into text up to the next '<' or eof.
+static void xml_read_text(AttCharReader &in, AttCharBuffer &text)
+{
+	text.Clear();
+	int ch;
+	while ((ch = in.Peek()) != EOF && ch != '<') text.Add(in.Get());
+}
+
+//! The '<' has been read. Read the rest of the tag into tag, up to and including the final '>'.
+/*! A '>' in a quoted xml attribute value does not end the tag, and comments end only at "-->".
+ * Returns false for eof before the end of the tag.
+ */
+static bool xml_read_tag(AttCharReader &in, AttCharBuffer &tag)
+{
+	tag.Clear();
+	int ch, quote = 0;
+
+	while ((ch = in.Get()) != EOF) {
+		tag.Add(ch);
+
+		if (tag.n == 3 && !strncmp(tag.s, "!--", 3)) {
+			 // found a comment!! must parse specially
+			while ((ch = in.Get()) != EOF) {
+				tag.Add(ch);
+				if (ch == '>' && tag.n >= 6 && !strncmp(tag.s + tag.n-3, "-->", 3)) return true;
+			}
+			return false;
+		}
+
+		if (quote) { if (ch == quote) quote = 0; }
+		else if (ch == '"' || ch == '\'') quote = ch;
+		else if (ch == '>') return true;
+	}
+	return false;
+}
+
+//! Reduce a closing tag like "  name >" read by xml_read_tag() to just the name.
+static void xml_closing_name(AttCharBuffer &closing)
+{
+	long c = 0, c2;
+	skipws(closing.s, closing.n, &c);
+	c2 = c;
+	while (c<closing.n && !isspace(closing.s[c]) && closing.s[c]!='>') c++;
+	memmove(closing.s, closing.s+c2, c-c2);
+	closing.n = c-c2;
+	closing.s[closing.n] = '\0';
+}
+
+//! Send events for the content of element name, up to and including its closing tag.
+/*! Content goes in a "content:" node, opened only when a subelement or comment shows up. Content
+ * that is only text becomes the value of the element instead, or the value of "content:" when
+ * the element has xml attributes.
+ *
+ * Returns 0 for closed by the element's own closing tag, 2 for closed by some other closing
+ * tag whose name is put in closing, 1 for stopped by events, or -1 for eof or error.
+ */
+static int xml_parse_children(AttCharReader &in, const char *name, bool has_atts, const char **stand_alone_tag_list,
+							  AttributeEvents *events, AttCharBuffer &closing)
+{
+	AttCharBuffer text, tag;
+	bool content = false, pending = false;
+	int status;
+
+	while (1) {
+		in.SkipSpace();
+		if (in.Peek() == EOF) {
+			events->Error(_("Missing end tag"));
+			status = -1;
+			break;
+		}
+
+		if (in.Peek() != '<') {
+			 //hold on to text until we know if it is the whole content
+			xml_read_text(in, text);
+			pending = true;
+			continue;
+		}
+
+		in.Get();
+		if (in.Peek() == '/') {
+			 // this is a closing tag!
+			in.Get();
+			if (!xml_read_tag(in, closing)) {
+				events->Error(_("Missing end tag"));
+				status = -1;
+				break;
+			}
+			xml_closing_name(closing);
+			if (!strcmp(closing.s, name)) status = 0;
+			else {
+				 //close anyway, and let the parents check if it is theirs
+				events->Error(_("Missing end tag"));
+				status = 2;
+			}
+			break;
+		}
+
+		if (!content) {
+			if (!events->BeginNode() || !events->Name("content:", 8)) return 1;
+			content = true;
+		}
+		if (pending) {
+			if (!xml_cdata(events, text)) return 1;
+			pending = false;
+		}
+
+		if (!xml_read_tag(in, tag)) {
+			events->Error(_("Unterminated tag"));
+			status = -1;
+			break;
+		}
+		status = xml_parse_element(in, tag, stand_alone_tag_list, events, closing);
+		if (status == 1) return 1;
+		if (status == 2 && !strcmp(closing.s, name)) { status = 0; break; } //a subelement was missing its end tag
+		if (status != 0) break;
+	}
+
+	if (content) {
+		if (pending && !xml_cdata(events, text)) return 1;
+		if (!events->EndNode()) return 1;
+
+	} else if (has_atts) {
+		if (!events->BeginNode() || !events->Name("content:", 8)) return 1;
+		if (pending && !events->Value(text.s, text.n)) return 1;
+		if (!events->EndNode()) return 1;
+
+	} else if (pending) {
+		 //slightly flatten for simple values, so
+		 //<title>blah</title> -->  name=title, value=blah
+		if (!events->Value(text.s, text.n)) return 1;
+	}
+
+	return status;
+}
+
+//! Send events for the element or comment in tag, which was read by xml_read_tag(), plus its content.
+/*! Returns 0 for success, 1 for stopped by events, -1 for error, or 2 for closed by the wrong
+ * closing tag, as for xml_parse_children().
+ */
+static int xml_parse_element(AttCharReader &in, AttCharBuffer &tag, const char **stand_alone_tag_list,
+							 AttributeEvents *events, AttCharBuffer &closing)
+{
+	char *buf = tag.s;
+	long n = tag.n, c = 0, c2;
+	char *nm, *vl, *e;
+	char final;
+	bool hassubs = true, has_atts = false;
+	int status = 0;
+
+	skipws(buf,n,&c);
+	c2 = c;
+	 //scan for tag name text as a string of non-whitespace, and not '/' or '>'
+	while (c<n && !isspace(buf[c]) && buf[c]!='/' && buf[c]!='>') c++;
+	if (c == c2) {
+		events->Error(_("Empty tag"));
+		return -1;
+	}
+
+	if (!strncmp(buf+c2, "!--", 3)) {
+		 //comment, value is everything between "<!--" and "-->"
+		long end = n;
+		if (n-c2 >= 6 && !strncmp(buf+n-3, "-->", 3)) end = n-3;
+		if (!events->BeginNode() || !events->Name("!--", 3)
+				|| !events->Value(buf+c2+3, end-c2-3) || !events->EndNode()) return 1;
+		return 0;
+	}
+
+	char *name = newnstr(buf+c2, c-c2);
+	if (!events->BeginNode() || !events->Name(name, c-c2)) { delete[] name; return 1; }
+
+	 //detect <?... ?> and <!...>
+	if (name[0]=='!') {
+		final='!';
+		hassubs=false;
+	} else if (name[0]=='?') {
+		final='?';
+		hassubs=false;
+	} else final='/';
+
+	 // parse in xml attributes name=value name="value"... until > or (final)>
+	skipws(buf,n,&c);
+	while (c<n && buf[c]!='>' && buf[c]!=final) {
+		 // name=value
+		 // name="value"
+		 // name = "val; val  val \" vala \""
+		nm = vl = nullptr;
+		NameValueAttribute(buf+c, &nm, &vl, &e, '=', 0, "/>", ">");
+		if (e == buf+c) break;
+		c = e-buf;
+		has_atts = true;
+		if (!events->BeginNode()
+				|| (nm && !events->Name(nm, strlen(nm)))
+				|| (vl && !events->Value(vl, strlen(vl)))
+				|| !events->EndNode())
+			status = 1;
+		delete[] nm;
+		delete[] vl;
+		if (status) { delete[] name; return 1; }
+		skipws(buf,n,&c);
+	}
+
+	while (c<n && buf[c]!='>' && buf[c]!=final) c++;
+	if (c<n && buf[c]==final && buf[c+1]=='>') hassubs = false;
+
+	 //add all the xml sub-elements  ==  Attribute sub-attributes)
+	 // and parse out the closing tag
+	if (hassubs && !one_of_them(name,stand_alone_tag_list))
+		status = xml_parse_children(in, name, has_atts, stand_alone_tag_list, events, closing);
+	delete[] name;
+
+	if (status == 1 || !events->EndNode()) return 1;
+	return status;
+}
+
+//! Send events for everything in in, until eof or a closing tag that was not opened in in.
+/*! In memory, in is left at the '<' of such a closing tag.
+ *
+ * Returns 0 for success, 1 for stopped by events, or -1 for error.
+ */
+static int xml_parse_top(AttCharReader &in, const char **stand_alone_tag_list, AttributeEvents *events)
+{
+	AttCharBuffer text, tag, closing;
+	bool pending = false;
+	int status = 0, numnodes = 0;
+	long tagpos;
+
+	while (1) {
+		in.SkipSpace();
+		if (in.Peek() == EOF) break;
+
+		if (in.Peek() != '<') {
+			 // add a cdata block, all till '<' or eof
+			xml_read_text(in, text);
+			pending = true;
+			numnodes++;
+			continue;
+		}
+
+		tagpos = in.pos;
+		in.Get();
+		if (in.Peek() == '/') {
+			 // this is a closing tag!
+			if (!in.f) in.pos = tagpos;
+			break;
+		}
+
+		if (pending) {
+			if (!xml_cdata(events, text)) return 1;
+			pending = false;
+		}
+		if (!xml_read_tag(in, tag)) {
+			events->Error(_("Unterminated tag"));
+			return -1;
+		}
+		status = xml_parse_element(in, tag, stand_alone_tag_list, events, closing);
+		numnodes++;
+		if (status == 1) return 1;
+		if (status != 0) break;
+	}
+
+	if (pending) {
+		 //slightly flatten for simple values, so a lone bit of text becomes the value
+		if (numnodes == 1) { if (!events->Value(text.s, text.n)) return 1; }
+		else if (!xml_cdata(events, text)) return 1;
+	}
+
+	return status < 0 ? -1 : 0;
+}
+
+//! Read XML from f, sending each part to events instead of building an Attribute.
+/*! Elements, their xml attributes, "content:", "cdata:", and comments come as nodes laid out
+ * the same as XMLChunkToAttribute() makes them. Only the current tag and the text since the
+ * last tag are kept in memory, so this works on very big files, like large svg imports.
+ *
+ * Returns 0 for success, 1 for stopped by events, or -1 for a parse error.
+ */
+int ParseXMLEvents(IOBuffer &f, const char **stand_alone_tag_list, AttributeEvents *events)
+{
+	AttCharReader in(&f);
+	return xml_parse_top(in, stand_alone_tag_list, events);
+}
+
 //! Read in XML to an Attribute from a memory buffer.
 /*!
  * Say you have something like this Passepartout file:
@@ -2679,146 +3522,13 @@ Attribute *XMLChunkToAttribute(Attribute *att,
 {
 	if (!att) att=new Attribute;
 
-	char *error=NULL, *value=NULL, *name=NULL;
-	char *nm,*vl,*e;
-	char final;
-	long c=0,c2=0;
-	int hassubs=1;
-	if (C) c=*C; else c=0;
-	
-	while (c<n && !error) {
-		skipws(buf,n,&c);
-		if (c<n && buf[c]!='<') { 
-			 // add a cdata block, all till '<' or eof
-			c2=c;
-			while (c<n && buf[c]!='<') c++;
-			value=newnstr(buf+c2,c-c2);
-			att->push("cdata:",value);
-			delete[] value;
-		}
-		if (c<n && buf[c]=='<' && n>c+1) { 
-			hassubs=1;
-			
-			 // found a tag at last
-			c++;
-			if (buf[c]=='/') {
-				 // this is a closing tag!
-				if (C) *C=c-1;
-				break;
-			}
-			skipws(buf,n,&c);
-			c2=c;
-			 //scan for tag name text as a string of non-whitespace, and not '/' or '>'
-			while (c<n && !isspace(buf[c]) && buf[c]!='/' && buf[c]!='>') c++;
-			 //now c2 points to beginning of name, c points to char just after name
-			if (c==c2) {
-				makestr(error,"Empty Tag! Aborting..");
-				break;
-			} else name = newnstr(buf+c2,c-c2);
-			att->push(name);
-			
-			 //detect <?... ?> and <!...> and <!--...-->
-			if (name[0]=='!' && name[1]=='-' && name[2]=='-') {
-				 // found a comment!! must parse specially
-				 // c points to char just after "!--"
-				e=const_cast<char*>(strstr(buf+c,"-->"));
-				if (!e) c2=n-c; else c2= (e-(buf+c)); //c2==length of comment not including '-->'
-				makenstr(att->attributes.e[att->attributes.n-1]->value,buf+c,c2);
-				c=c+c2+3;
-				if (c>n) c=n;
-				delete[] name; name = nullptr;
-				continue;
-			} else if (name[0]=='!') {
-				final='!';
-				hassubs=0;
-			} else if (name[0]=='?') {
-				final='?';
-				hassubs=0;
-			} else final='/';
-
-			 // parse in xml attributes name=value name="value"... until > or (final)>
-			skipws(buf,n,&c);
-			while (c<n && buf[c]!='>' && buf[c]!=final) {
-				 // name=value
-				 // name="value"
-				 // name = "val; val  val \" vala \""
-				nm = vl = nullptr;
-				NameValueAttribute(buf+c, &nm, &vl, &e, '=', 0, "/>", ">");
-				if (e != buf+c) {
-					att->attributes.e[att->attributes.n-1]->push(nm,vl);
-					c = e-buf;
-					delete[] nm; nm = nullptr;
-					delete[] vl; vl = nullptr;
-				} else break;
-				//if (e == buf+c) break;
-				skipws(buf,n,&c);
-			}
-			
-			 //advance past final '>'
-			c2=c;
-			while (c<n && buf[c]!='>' && buf[c]!=final) c++;
-			if (c<n) {
-				if (buf[c]==final && buf[c+1]=='>') { c+=2; hassubs=0; }
-				else if (buf[c]=='>') c++;
-			}
-			 
-			 //add all the xml sub-elements  ==  Attribute sub-attributes)
-			 // and parse out the closing tag
-			if (hassubs && !one_of_them(name,stand_alone_tag_list)) {
-				att->attributes.e[att->attributes.n-1]->push("content:");
-				XMLChunkToAttribute(att->attributes.e[att->attributes.n-1]
-									  ->attributes.e[att->attributes.e[att->attributes.n-1]->attributes.n-1],
-									buf,n, &c, name, stand_alone_tag_list);
-
-				 //should be the closing tag for name now
-				skipws(buf,n,&c);
-				c2=c;
-				if (c<n && buf[c]=='<') {
-					c++; //skip the '<'
-					skipws(buf,n,&c);
-					if (buf[c]=='/') {
-						c++;
-						skipws(buf,n,&c);
-						if (c+(long)strlen(name)<n && !strncmp(name,buf+c,strlen(name))) {
-							c+=strlen(name);
-							skipws(buf,n,&c);
-							c++; //*** assuming final '>'
-							Attribute *att2=att->attributes.e[att->attributes.n-1];
-							if (att2->attributes.n==1 
-								  && !att2->value
-								  && !strcmp(att2->attributes.e[0]->name,"content:")
-								  && att2->attributes.e[0]->attributes.n==0)	{
-								makestr(att2->value,att2->attributes.e[0]->value);
-								att2->attributes.flush();
-							}
-						} else {
-							makestr(error,"Missing end tag");
-						}
-					} else {
-						makestr(error,"Missing end tag");
-					}
-				} else {
-					makestr(error,"Missing end tag");
-				}
-				if (error) c=c2; //reposition to start of mystery tag
-				if (C) *C=c;
-			}
-
-		} else c++; //was at final char, which was a '<'
+	long c = (C ? *C : 0);
+	if (c > n) c = n;
+	AttCharReader in(buf+c, n-c);
+	AttributeTreeBuilder builder(att);
+	xml_parse_top(in, stand_alone_tag_list, &builder);
+	if (C) *C = c + in.Position();
 
-		delete[] name;  name = nullptr;
-	}
-	DBG if (error) cerr <<"XML-in error: "<<error<<endl;
-	 
-	 //slightly flatten attribute for simple values, so
-	 //<title>blah</title> -->  name=title, value=blah
-	if (att->attributes.n==1 
-		  && !att->value
-		  && !strcmp(att->attributes.e[0]->name,"cdata:")
-		  && att->attributes.e[0]->attributes.n==0)	{
-		makestr(att->value,att->attributes.e[0]->value);
-		att->attributes.flush();
-	}
 	return att;
 }
 
@@ -3053,10 +3763,164 @@ int DumpAttributeToJson(FILE *f, Attribute *att, int indent)
 
 Attribute *JsonFileToAttribute (const char *jsonfile, Attribute *att)
 {
-	char *contents = read_in_whole_file(jsonfile, NULL, 0);
-	Attribute *a = JsonStringToAttribute(contents, att, NULL);
-	delete[] contents;
-	return a;
+	IOBuffer f;
+	if (f.OpenFile(jsonfile, "r") != 0) return nullptr;
+
+	bool newatt = false;
+	if (!att) { newatt = true; att = new Attribute(); }
+
+	AttributeTreeBuilder builder(att);
+	if (ParseJsonEvents(f, &builder) != 0) {
+		if (newatt) delete att;
+		return nullptr;
+	}
+	return att;
+}
+
+//! Parse one Json value from in, sending events for the current node, and wrapped subnodes for array and object elements.
+/*! buf is scratch space. Returns 0 for success, 1 for stopped by events, or -1 for error.
+ */
+static int json_parse_value(AttCharReader &in, AttributeEvents *events, AttCharBuffer &buf)
+{
+	in.SkipSpace();
+	int ch = in.Peek();
+	int status;
+
+	if (ch=='t' || ch=='f' || ch=='n') {
+		const char *word = (ch=='t' ? "true" : ch=='f' ? "false" : "null");
+		for (const char *w = word; *w; w++) {
+			if (in.Get() != *w) return -1;
+		}
+		if (!(ch=='n' ? events->Name("null", 4) : events->Name("boolean", 7))
+				|| !events->Value(word, strlen(word))) return 1;
+		events->Flags(ch=='t' ? JSON_True : ch=='f' ? JSON_False : JSON_Null);
+		return 0;
+
+	} else if (ch=='"') {
+		 //read in the raw quoted string, then unescape it with QuotedAttribute()
+		buf.Clear();
+		buf.Add(in.Get());
+		while ((ch = in.Get()) != EOF) {
+			buf.Add(ch);
+			if (ch == '\\') {
+				if ((ch = in.Get()) == EOF) break;
+				buf.Add(ch);
+			} else if (ch == '"') break;
+		}
+		if (ch != '"') return -1;
+
+		char *s = QuotedAttribute(buf.s, nullptr);
+		if (!s) return -1;
+		bool ok = events->Name("string", 6) && events->Value(s, strlen(s));
+		delete[] s;
+		if (!ok) return 1;
+		events->Flags(JSON_String);
+		return 0;
+
+	} else if (isdigit(ch) || ch == '.' || ch == '-') {
+		 //is number
+		bool isint = true;
+		buf.Clear();
+		if (ch == '-') buf.Add(in.Get());
+
+		while (isdigit(in.Peek())) buf.Add(in.Get()); //int part
+		if (in.Peek() == '.') { //fraction
+			isint = false;
+			buf.Add(in.Get());
+			while (isdigit(in.Peek())) buf.Add(in.Get());
+		}
+		if (in.Peek() == 'e' || in.Peek() == 'E') {
+			isint = false;
+			buf.Add(in.Get());
+			if (in.Peek() == '+' || in.Peek() == '-') buf.Add(in.Get());
+			if (!isdigit(in.Peek())) return -1; //malformed number!
+			while (isdigit(in.Peek())) buf.Add(in.Get());
+		}
+		if (!strpbrk(buf.s, "0123456789")) return -1; //just "-" or "."
+
+		if (!events->Name(isint ? "int" : "float", isint ? 3 : 5) || !events->Value(buf.s, buf.n)) return 1;
+		events->Flags(isint ? JSON_Int : JSON_Float);
+		return 0;
+
+	} else if (ch=='[') {
+		in.Get();
+		if (!events->Name("array", 5)) return 1;
+		events->Flags(JSON_Array);
+
+		while (1) {
+			in.SkipSpace();
+			if (in.Peek() == ']') break;
+
+			if (!events->BeginNode()) return 1;
+			status = json_parse_value(in, events, buf);
+			if (status) return status;
+			if (!events->EndNode()) return 1;
+
+			in.SkipSpace();
+			if (in.Peek() != ',') break;
+			in.Get();
+		}
+
+		if (in.Get() != ']') return -1; // *** error!! missing close bracket
+		return 0;
+
+	} else if (ch=='{') {
+		in.Get();
+		if (!events->Name("object", 6)) return 1;
+		events->Flags(JSON_Object);
+
+		while (1) {
+			 //scan for key, which is kept raw
+			in.SkipSpace();
+			if (in.Peek() != '"') break;
+			in.Get();
+
+			buf.Clear();
+			while ((ch = in.Get()) != EOF && ch != '"') {
+				buf.Add(ch);
+				if (ch == '\\') {
+					if ((ch = in.Get()) == EOF) break;
+					buf.Add(ch);
+				}
+			}
+			if (ch != '"') return -1; //badly formed string!
+
+			if (!events->BeginNode() || !events->Name("key", 3) || !events->Value(buf.s, buf.n)) return 1;
+
+			in.SkipSpace();
+			if (in.Get() != ':') return -1; //expected object
+
+			if (!events->BeginNode()) return 1;
+			status = json_parse_value(in, events, buf);
+			if (status) return status;
+			if (!events->EndNode() || !events->EndNode()) return 1;
+
+			in.SkipSpace();
+			if (in.Peek() != ',') break;
+			in.Get();
+		}
+
+		in.SkipSpace();
+		if (in.Get() != '}') return -1; // *** error!! missing close curly brace
+		return 0;
+	}
+
+	//fail!
+	return -1;
+}
+
+//! Read one Json value from f, sending each part to events instead of building an Attribute.
+/*! The value itself goes to the current node, so there is no BeginNode() or EndNode() for it.
+ * Each array element is a wrapped node, and each object member is a "key" node whose value
+ * is the raw key, containing a node for the member value, just like JsonStringToAttribute().
+ *
+ * Returns 0 for success, 1 for stopped by events, or -1 for a parse error.
+ */
+int ParseJsonEvents(IOBuffer &f, AttributeEvents *events)
+{
+	AttCharReader in(&f);
+	AttCharBuffer buf;
+	return json_parse_value(in, events, buf);
 }
 
 /*! Read in a single element.
@@ -3088,198 +3952,312 @@ Attribute *JsonFileToAttribute (const char *jsonfile, Attribute *att)
  *     key hashname2
  *       null
  * </pre>
+ *
+ * This is an AttributeTreeBuilder on the same parser as ParseJsonEvents().
  */
 Attribute *JsonStringToAttribute (const char *jsonstring, Attribute *att, const char **end_ptr)
 {
-	const char *str = jsonstring;
-	const char *strend;
-	char *endptr;
-
-	while (*str && isspace(*str)) str++;
-
-	if (*str=='t' && !strncmp(str, "true", 4)) {
-		if (!att) att = new Attribute();
-		str += 4;
-		att->flags = JSON_True;
-		makestr(att->name, "boolean");
-		makestr(att->value, "true");
-		if (end_ptr) *end_ptr = str;
-		return att;
-
-	} else if (*str=='f' && !strncmp(str, "false", 5)) {
-		if (!att) att = new Attribute();
-		str += 5;
-		att->flags = JSON_False;
-		makestr(att->name, "boolean");
-		makestr(att->value, "false");
-		if (end_ptr) *end_ptr = str;
-		return att;
-
-	} else if (*str=='n' && !strncmp(str, "null", 4)) {
-		if (!att) att = new Attribute();
-		str += 4;
-		att->flags = JSON_Null;
-		makestr(att->name, "null");
-		makestr(att->value, "null");
-		if (end_ptr) *end_ptr = str;
-		return att;
-
-	} else if (*str=='"') {
-		if (!att) att = new Attribute();
-		char *s = QuotedAttribute(str, &endptr);
-		if (!s || str == endptr) {
-			 // *** uh oh! problem in the parsing!
-			s++;
-			return nullptr;
+	if (!jsonstring) return nullptr;
 
-		} else {
-			if (!att) att = new Attribute();
-			str = endptr;
-			att->flags = JSON_String;
-			makestr(att->name, "string");
-			if (att->value) delete[] att->value;
-			att->value = s;
-			if (end_ptr) *end_ptr = str;
-			return att;
-		}
+	bool newatt = false;
+	if (!att) { newatt = true; att = new Attribute(); }
 
-	} else if (isdigit(*str) || *str == '.') {
-		 //is number
-		int isint = 1;
-		strend = str;
-
-		while (isdigit(*strend)) strend++; //int part
-		if (*strend == '.') { //fraction
-			isint = 0;
-			strend++;
-			while (isdigit(*strend)) strend++;
-		}
-		if (*strend == 'e' || *strend == 'E') {
-			strend++;
-			if (*strend == '+' || *strend == '-') strend++;
-			if (!isdigit(*strend)) {
-				//malformed number!
-				return nullptr;
-			}
-			while (isdigit(*strend)) strend++;
-		}
-		//if (str == strend) { break; }  <- this shouldn't happen
+	AttCharReader in(jsonstring, strlen(jsonstring));
+	AttCharBuffer buf;
+	AttributeTreeBuilder builder(att);
+	int status = json_parse_value(in, &builder, buf);
+	if (end_ptr) *end_ptr = jsonstring + in.Position();
 
-		if (!att) att = new Attribute();
-		makestr(att->name, isint ? "int" : "float");
-		makenstr(att->value, str, strend-str);
-		str = strend;
+	if (status != 0) {
+		if (newatt) delete att;
+		return nullptr;
+	}
+	return att;
+}
 
-		if (end_ptr) *end_ptr = str;
-		return att;
 
-	} else if (*str=='[') {
-		str++;
-		bool newatt = false;
-		if (!att) { newatt = true; att = new Attribute(); }
-		makestr(att->name, "array");
-		att->flags = JSON_Array;
+//---------------------------------- Binary Conversion helpers -------------------------------
+/*! \defgroup attributebinaryformat Binary Attribute Files
+ * \ingroup attributes
+ *
+ * A whole Attribute tree in one file, laid out so it can be memory mapped and read in place.
+ * All values are in the byte order of the machine that wrote them. Everything is padded
+ * to 8 bytes, so AttributeBlob data can be used directly from the mapping.
+ *
+\verbatim
+  header: "LAXATTB" + '\0', int32 byte order check 0x01020304, int32 version 1
+  node:   int32 fields (ATTBIN_*), uint32 flags, int32 number of subattributes, int32 0
+          then for each of name, value, atttype, comment in fields:
+              int32 length, the bytes, '\0', padding
+          then if ATTBIN_Blob: int32 type, int32 0, int64 number of elements, the elements, padding
+          then each subattribute node
+\endverbatim
+ */
 
-		while (*str && isspace(*str)) str++;
-		while (1) {
-			endptr = nullptr;
-			Attribute *att3 = JsonStringToAttribute(str, nullptr, &strend);
-			if (att3) {
-				att->push(att3, -1);
-				str = strend;
-			} else break;
-			
-			while (*str && isspace(*str)) str++;
-			if (*str != ',') break;
-			str++;
-		}
+#define ATTBIN_MAGIC     "LAXATTB"
+#define ATTBIN_BYTEORDER 0x01020304
+#define ATTBIN_VERSION   1
+#define ATTBIN_MAXDEPTH  1000
+
+enum AttributeBinaryFields {
+	ATTBIN_Name    = (1<<0),
+	ATTBIN_Value   = (1<<1),
+	ATTBIN_Type    = (1<<2),
+	ATTBIN_Comment = (1<<3),
+	ATTBIN_Blob    = (1<<4)
+};
+
+//! Holds a whole file, for AttributeBlob::source. Mapped if possible, else read into memory.
+class AttributeFileData : public RefCounted
+{
+  public:
+	char *data;
+	long size;
+	bool mapped;
+
+	AttributeFileData() { data = nullptr; size = 0; mapped = false; }
+	virtual ~AttributeFileData()
+	{
+		if (mapped) munmap(data, size);
+		else delete[] data;
+	}
+};
 
-		while (*str && isspace(*str)) str++;
-		if (*str != ']') {
-			// *** error!! missing close bracket
-			if (newatt) delete att;
-			return nullptr;
-		}
+static int attbin_pad(FILE *f, long n)
+{
+	static const char zeros[8] = { 0,0,0,0,0,0,0,0 };
+	if (n % 8) return fwrite(zeros, 1, 8 - n%8, f) == size_t(8 - n%8) ? 0 : 1;
+	return 0;
+}
 
-		str++;
-		if (end_ptr) *end_ptr = str;
-		return att;
+static int attbin_out_string(FILE *f, const char *str)
+{
+	int32_t len = strlen(str);
+	if (fwrite(&len, sizeof(len), 1, f) != 1) return 1;
+	if (fwrite(str, 1, len+1, f) != size_t(len+1)) return 1;
+	return attbin_pad(f, sizeof(len) + len+1);
+}
 
-	} else if (*str=='{') {
-		str++;
-		bool newatt = false;
-		if (!att) { newatt = true; att = new Attribute(); }
-		makestr(att->name, "object");
-		att->flags = JSON_Object;
+static int attbin_out_node(FILE *f, Attribute *att)
+{
+	int32_t head[4];
+	head[0] = (att->name    ? ATTBIN_Name    : 0)
+			| (att->value   ? ATTBIN_Value   : 0)
+			| (att->atttype ? ATTBIN_Type    : 0)
+			| (att->comment ? ATTBIN_Comment : 0)
+			| (att->blob && att->blob->data ? ATTBIN_Blob : 0);
+	head[1] = att->flags;
+	head[2] = 0;
+	head[3] = 0;
+	for (int c=0; c<att->attributes.n; c++) if (att->attributes.e[c]) head[2]++;
+	if (fwrite(head, sizeof(head), 1, f) != 1) return 1;
+
+	if (att->name    && attbin_out_string(f, att->name))    return 1;
+	if (att->value   && attbin_out_string(f, att->value))   return 1;
+	if (att->atttype && attbin_out_string(f, att->atttype)) return 1;
+	if (att->comment && attbin_out_string(f, att->comment)) return 1;
+
+	if (head[0] & ATTBIN_Blob) {
+		int32_t type[2] = { att->blob->type, 0 };
+		int64_t n = att->blob->n;
+		if (fwrite(type, sizeof(type), 1, f) != 1) return 1;
+		if (fwrite(&n, sizeof(n), 1, f) != 1) return 1;
+		if (fwrite(att->blob->data, 1, att->blob->Size(), f) != size_t(att->blob->Size())) return 1;
+		if (attbin_pad(f, att->blob->Size())) return 1;
+	}
 
-		while (1) {
-			//scan for key
-			while (*str && isspace(*str)) str++;
-			if (*str != '"') {
-				if (*str != '}') {
-					//error! expecting a string or empty object!
-					if (newatt) { delete att; att = nullptr; }
-					return nullptr;
-				}
-				break;
-			}
+	for (int c=0; c<att->attributes.n; c++) {
+		if (!att->attributes.e[c]) continue;
+		if (attbin_out_node(f, att->attributes.e[c])) return 1;
+	}
+	return 0;
+}
 
-			str++;
-			strend = str;
-			while (*strend && *strend != '"') {
-				if (*strend == '\\') strend++;
-				if (*strend) strend++;
-			}
+/*! Write att, including its own name and value, and all subattributes to f
+ * in the \ref attributebinaryformat. Return 0 for success, or nonzero for write error.
+ */
+int DumpAttributeToBinary(FILE *f, Attribute *att)
+{
+	if (!f || !att) return 1;
 
-			if (*strend == '\0' || *strend != '"') {
-				//badly formed string!
-				if (newatt) { delete att; att = nullptr; }
-				return nullptr;
-			}
+	char magic[8];
+	memset(magic, 0, 8);
+	memcpy(magic, ATTBIN_MAGIC, strlen(ATTBIN_MAGIC));
+	int32_t info[2] = { ATTBIN_BYTEORDER, ATTBIN_VERSION };
+	if (fwrite(magic, 8, 1, f) != 1) return 1;
+	if (fwrite(info, sizeof(info), 1, f) != 1) return 1;
 
-			Attribute *key = new Attribute("key", NULL);
-			makenstr(key->value, str, strend-str);
-			att->push(key, -1);
+	return attbin_out_node(f, att);
+}
 
-			str = strend+1; //so right after closing quote
-			while (*str && isspace(*str)) str++;
-			if (*str != ':') {
-				//expected object
-				if (newatt) { delete att; att = nullptr; }
-				return nullptr;
-			}
-			str++;
-
-			endptr = NULL;
-			Attribute *value = JsonStringToAttribute(str, NULL, &strend);
-			if (!value) {
-				//expected object
-				if (newatt) { delete att; att = nullptr; }
-				return nullptr;
-			}
-			key->push(value, -1);
-			str = strend;
-			
-			while (*str && isspace(*str)) str++;
-			if (*str != ',') break;
-			str++;
-		}
+/*! Write att to file with DumpAttributeToBinary(). Return 0 for success, or nonzero for error.
+ */
+int AttributeToBinaryFile(const char *file, Attribute *att)
+{
+	FILE *f = fopen(file, "w");
+	if (!f) return 1;
+	int status = DumpAttributeToBinary(f, att);
+	if (fclose(f) != 0) status = 1;
+	return status;
+}
 
-		while (*str && isspace(*str)) str++;
-		if (*str != '}') {
-			// *** error!! missing close curly brace
-			if (newatt) { delete att; att = nullptr; }
-			return nullptr;
-		}
+//! Return whether file starts like a file written by AttributeToBinaryFile().
+bool IsBinaryAttributeFile(const char *file)
+{
+	FILE *f = fopen(file, "r");
+	if (!f) return false;
+	char magic[8];
+	bool yes = (fread(magic, 8, 1, f) == 1 && !memcmp(magic, ATTBIN_MAGIC, strlen(ATTBIN_MAGIC)+1));
+	fclose(f);
+	return yes;
+}
 
-		str++;
-		if (end_ptr) *end_ptr = str;
-		return att;
+/*! Read a string into str, which is flag in att->arena_flags. For arena nodes, names are interned,
+ * and other strings point into the data if in_place, else are copied to the arena.
+ */
+static const char *attbin_in_string(const char *p, const char *end, Attribute *att, char **str, int flag, bool in_place)
+{
+	if (end-p < 4) return nullptr;
+	int32_t len;
+	memcpy(&len, p, sizeof(len));
+	if (len < 0 || end-p < 4+len+1 || p[4+len] != '\0') return nullptr;
+
+	if (!att->arena) makenstr(*str, p+4, len);
+	else {
+		if (flag == ATTARENA_Name) *str = const_cast<char*>(att->arena->Intern(p+4, len, &att->name_id));
+		else if (in_place) *str = const_cast<char*>(p+4);
+		else *str = att->arena->NewString(p+4, len);
+		att->arena_flags |= flag;
 	}
+	long n = 4+len+1;
+	if (n % 8) n += 8 - n%8;
+	return p + n;
+}
 
-	//fail!
-	if (end_ptr) *end_ptr = str;
-	return nullptr;
+static const char *attbin_in_node(const char *p, const char *end, const char *start, Attribute *att, RefCounted *source, int depth)
+{
+	if (depth > ATTBIN_MAXDEPTH) return nullptr;
+	if (end-p < 16) return nullptr;
+
+	int32_t head[4];
+	memcpy(head, p, sizeof(head));
+	p += sizeof(head);
+	if (head[2] < 0) return nullptr;
+	att->flags = head[1];
+
+	 //the root might not be in the arena, so its strings are always its own
+	bool in_place = (source && (att->arena_flags & ATTARENA_Node));
+	if ((head[0] & ATTBIN_Name)    && !(p = attbin_in_string(p, end, att, &att->name,    ATTARENA_Name,    in_place))) return nullptr;
+	if ((head[0] & ATTBIN_Value)   && !(p = attbin_in_string(p, end, att, &att->value,   ATTARENA_Value,   in_place))) return nullptr;
+	if ((head[0] & ATTBIN_Type)    && !(p = attbin_in_string(p, end, att, &att->atttype, ATTARENA_Type,    in_place))) return nullptr;
+	if ((head[0] & ATTBIN_Comment) && !(p = attbin_in_string(p, end, att, &att->comment, ATTARENA_Comment, in_place))) return nullptr;
+
+	if (head[0] & ATTBIN_Blob) {
+		if (end-p < 16) return nullptr;
+		int32_t type[2];
+		int64_t n;
+		memcpy(type, p, sizeof(type));
+		memcpy(&n, p+8, sizeof(n));
+		p += 16;
+
+		int size = AttributeBlob::ElementSize(type[0]);
+		if (size == 0 || n < 0 || n > (end-p)/size) return nullptr;
+		long bytes = n*size;
+
+		 //data is used in place when it is aligned, which it always is for files mapped from the start
+		if (source && (p-start) % 8 == 0 && ((uintptr_t)p) % size == 0)
+			att->SetBlob(new AttributeBlob(type[0], n, p, source), true);
+		else att->SetBlob(new AttributeBlob(type[0], n, p, nullptr), true);
+
+		if (bytes % 8) bytes += 8 - bytes%8;
+		if (end-p < bytes) return nullptr;
+		p += bytes;
+	}
+
+	for (int c=0; c<head[2]; c++) {
+		Attribute *sub = (att->arena ? att->arena->NewAttribute() : new Attribute());
+		att->push(sub, -1);
+		p = attbin_in_node(p, end, start, sub, source, depth+1);
+		if (!p) return nullptr;
+	}
+
+	return p;
+}
+
+/*! Read an Attribute tree in the \ref attributebinaryformat from size bytes of data.
+ * The root node of the data goes into att, which is created if NULL.
+ *
+ * If source is not NULL, it must keep data valid, and blobs point into data rather than copy.
+ * Otherwise, all blob data is copied. If att uses an AttributeArena (see Attribute::UseArena()),
+ * the arena also keeps source, and subattribute strings point into data too.
+ *
+ * Returns att, or NULL on error. On error, error_ret gets 1 for bad header, 2 for damaged data.
+ * If att was passed in, it may be left partially filled.
+ */
+Attribute *BinaryToAttribute(const char *data, long size, RefCounted *source, Attribute *att, int *error_ret)
+{
+	if (error_ret) *error_ret = 0;
+
+	int32_t info[2];
+	if (!data || size < 16 || memcmp(data, ATTBIN_MAGIC, strlen(ATTBIN_MAGIC)+1)) {
+		if (error_ret) *error_ret = 1;
+		return nullptr;
+	}
+	memcpy(info, data+8, sizeof(info));
+	if (info[0] != ATTBIN_BYTEORDER || info[1] != ATTBIN_VERSION) {
+		if (error_ret) *error_ret = 1;
+		return nullptr;
+	}
+
+	bool newatt = (att == nullptr);
+	if (newatt) att = new Attribute();
+	else att->clear();
+	if (att->arena && source) att->arena->AddSource(source);
+
+	if (!attbin_in_node(data+16, data+size, data, att, source, 0)) {
+		if (newatt) delete att;
+		if (error_ret) *error_ret = 2;
+		return nullptr;
+	}
+	return att;
+}
+
+/*! Read a file written by AttributeToBinaryFile(). The file is memory mapped when possible, and
+ * blobs in the returned tree use the mapping directly. The mapping lasts until the last of those
+ * blobs is gone. The root node of the file goes into att, which is created if NULL.
+ *
+ * Returns att, or NULL on error. On error, error_ret gets -1 for can't read file, else see BinaryToAttribute().
+ */
+Attribute *BinaryFileToAttribute(const char *file, Attribute *att, int *error_ret)
+{
+	int fd = open(file, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		if (fd >= 0) close(fd);
+		if (error_ret) *error_ret = -1;
+		return nullptr;
+	}
+
+	AttributeFileData *filedata = new AttributeFileData();
+	filedata->size = st.st_size;
+	 //writable copy on write, so values pointing into it can be changed in place like any other
+	void *mem = (st.st_size > 0 ? mmap(nullptr, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED);
+	if (mem != MAP_FAILED) {
+		filedata->data = (char*)mem;
+		filedata->mapped = true;
+
+	} else {
+		 //read the whole thing instead
+		filedata->data = new char[st.st_size > 0 ? st.st_size : 1];
+		long n = 0, r;
+		while (n < st.st_size && (r = read(fd, filedata->data + n, st.st_size - n)) > 0) n += r;
+		filedata->size = n;
+	}
+	close(fd);
+
+	att = BinaryToAttribute(filedata->data, filedata->size, filedata, att, error_ret);
+	filedata->dec_count();
+	return att;
 }
 
 
@@ -3315,22 +4293,47 @@ Attribute *CSVToAttribute(Attribute *att, IOBuffer &f, const char *delimiter, bo
 		att = new Attribute();
 		newatt = true;
 	}
-	Attribute *currow = nullptr;
-	long linenum = -1;
-	ParseCSV(f, delimiter, has_headers,
-	 		[&]() { linenum++; currow = att->pushSubAtt("row"); }, //new row
-	 		[&](const char *content, int len) { currow->pushn(content, len); },   // NewHeader,
-	 		[&](const char *content, int len) { currow->pushn(content, len); },   //NewCell
-	 		[&](const char *error) {
-	 			if (newatt) delete att;
-	 			att = nullptr;
-	 		}
-	 		);
+	AttributeTreeBuilder builder(att);
+	if (ParseCSVEvents(f, delimiter, &builder) != 0) {
+		if (newatt) delete att;
+		att = nullptr;
+	}
 	if (!att && error_ret) *error_ret = -1;
 	return att;
 }
 
-/*! Return 0 for success, nonzero error. */
+/*! \class CSVCallbackEvents
+ * Internal adapter from ParseCSVEvents() to the callbacks of ParseCSV().
+ */
+class CSVCallbackEvents : public AttributeEvents
+{
+  public:
+	std::function<void()> NewRow;
+	std::function<void(const char *content, int len)> NewHeader;
+	std::function<void(const char *content, int len)> NewCell;
+	std::function<void(const char *error)> OnError;
+	bool has_headers;
+	long linenum;
+	int depth;
+
+	CSVCallbackEvents() { has_headers = false; linenum = 0; depth = 0; }
+	virtual bool BeginNode() { if (++depth == 1) NewRow(); return true; }
+	virtual bool Name(const char *str, int len)
+	{
+		if (depth == 2) {
+			if (linenum == 0 && has_headers) NewHeader(str, len);
+			else NewCell(str, len);
+		}
+		return true;
+	}
+	virtual bool Value(const char *str, int len) { return true; }
+	virtual bool EndNode() { if (--depth == 0) linenum++; return true; }
+	virtual void Error(const char *error) { OnError(error); }
+};
+
+/*! Return 0 for success, nonzero error. This is ParseCSVEvents() passed on to callbacks.
+ * If has_headers, the cells of the first row go to NewHeader instead of NewCell.
+ */
 int ParseCSV(IOBuffer &f, const char *delimiter, bool has_headers,
 		std::function<void()> NewRow,
 		std::function<void(const char *content, int len)> NewHeader,
@@ -3338,72 +4341,76 @@ int ParseCSV(IOBuffer &f, const char *delimiter, bool has_headers,
 		std::function<void(const char *error)> OnError
 	)
 {
-	long linenum = 0;
+	CSVCallbackEvents events;
+	events.NewRow      = NewRow;
+	events.NewHeader   = NewHeader;
+	events.NewCell     = NewCell;
+	events.OnError     = OnError;
+	events.has_headers = has_headers;
+	return ParseCSVEvents(f, delimiter, &events);
+}
+
+//! Read csv from f one line at a time, sending each part to events.
+/*! Each row is a node named "row", with one subnode per cell, named with the cell contents.
+ * Quoted cells lose their quotes, but keep any escaped quotes as is. Reading stops at
+ * eof or a blank line.
+ *
+ * Return 0 for success, 1 for stopped by events, or -1 for error.
+ */
+int ParseCSVEvents(IOBuffer &f, const char *delimiter, AttributeEvents *events)
+{
 	int dlen = strlen(delimiter);
 	char *line = nullptr;
 	char *ptr, *ptr2;
 	size_t n = 0;
-	int c;
-	int err = 0;
+	int c, len;
+	int status = 0;
 
-	while (!f.IsEOF() && !err) {
-		// pos = f.Curpos();
+	while (!f.IsEOF() && !status) {
 		c = f.GetLine(&line,&n);
-		if (!c) break;
-		NewRow();
+		if (c <= 0) break;
 
 		ptr = line;
 		if (*ptr == '\n' || (*ptr == '\r' && ptr[1] == '\n')) break; //blank line
 
-		while (ptr && *ptr) {
-			ptr2 = ptr;
+		if (!events->BeginNode() || !events->Name("row", 3)) { status = 1; break; }
 
-			if (*ptr2 != '"') {
+		while (ptr && *ptr) {
+			if (*ptr != '"') {
 				ptr2 = strstr(ptr, delimiter);
-				if (ptr2) {
-					if (linenum == 0 && has_headers) NewHeader(ptr, ptr2 - ptr);
-					else NewCell(ptr, ptr2-ptr);
-					ptr = ptr2 + dlen;
-
-				} else { //final element
+				if (!ptr2) { //final element
 					ptr2 = ptr;
 					while (*ptr2 && *ptr2 != '\n' && *ptr2 != '\r') ptr2++;
-					if (linenum == 0 && has_headers) NewHeader(ptr, ptr2 - ptr);
-					else NewCell(ptr, ptr2-ptr);
-					break;
 				}
-				ptr2++;
+				len = ptr2 - ptr;
+				if (!events->BeginNode() || !events->Name(ptr, len) || !events->EndNode()) { status = 1; break; }
+				ptr = (*ptr2 && *ptr2 != '\n' && *ptr2 != '\r' ? ptr2 + dlen : nullptr);
 
-			} else { // read in until unescaped quote.. if eol happens, need to read in next line
+			} else { // read in until unescaped quote..
 				ptr++;
 				ptr2 = ptr;
-				while (*ptr2 && *ptr2 != '"') {
-					if (*ptr2 == '\\' && ptr2[1] == '"') ptr2 ++;
-					if (!*ptr2 || *ptr2 == '\n' || (*ptr2 == '\r' && ptr2[1] == '\n')) {
-						//hit eol without closing quote, continues on next line
-						// *** punting on multiline cells for now
-						OnError(_("Missing end quote"));
-						err = 1;
-					}
+				while (*ptr2 && *ptr2 != '"' && *ptr2 != '\n' && *ptr2 != '\r') {
+					if (*ptr2 == '\\' && ptr2[1] == '"') ptr2++;
 					ptr2++;
 				}
-				if (!err && *ptr2 != '"') {
-					OnError(_("Missing end quote"));
-					err = 1;
-				} else {
-					if (linenum == 0 && has_headers) NewHeader(ptr, ptr2 - ptr);
-					else NewCell(ptr, ptr2-ptr);
-					ptr = strstr(ptr2, delimiter);
-					if (ptr) ptr += dlen;
+				if (*ptr2 != '"') {
+					 //hit eol without closing quote
+					 // *** punting on multiline cells for now
+					events->Error(_("Missing end quote"));
+					status = -1;
+					break;
 				}
+				if (!events->BeginNode() || !events->Name(ptr, ptr2 - ptr) || !events->EndNode()) { status = 1; break; }
+				ptr = strstr(ptr2, delimiter);
+				if (ptr) ptr += dlen;
 			}
 		}
 
-		linenum++;
+		if (!status && !events->EndNode()) status = 1;
 	}
 	if (line) f.FreeGetLinePtr(line);
 
-	return 0;
+	return status;
 }
 
 } //namespace
@@ -25,6 +25,7 @@
 #include <lax/lists.h>
 #include <lax/vectors.h>
 #include <lax/anobject.h>
+#include <lax/refcounted.h>
 #include <lax/iobuffer.h>
 #include <lax/screencolor.h>
 
@@ -44,20 +45,100 @@ enum AttributeTypes {
 	ATT_Json,
 	ATT_Xml,
 	ATT_Css,
+	ATT_Binary,
 	ATT_MAX
 };
 
+enum AttributeBlobTypes {
+	ATTBLOB_None = 0,
+	ATTBLOB_Char,
+	ATTBLOB_Int,
+	ATTBLOB_Float,
+	ATTBLOB_Double,
+	ATTBLOB_MAX
+};
+
+class AttributeBlob : public RefCounted
+{
+ public:
+	int type; //see AttributeBlobTypes
+	long n; //number of elements, not bytes
+	const void *data;
+	RefCounted *source; //if non-null, data is in memory kept alive by source, else data is owned
+
+	AttributeBlob(int ntype, long nn);
+	AttributeBlob(int ntype, long nn, const void *ndata, RefCounted *nsource);
+	virtual ~AttributeBlob();
+
+	static int ElementSize(int type);
+	long Size() { return n * ElementSize(type); }
+	void *Data() { return source ? nullptr : const_cast<void*>(data); }
+	const char   *Chars()   { return type == ATTBLOB_Char   ? (const char*)  data : nullptr; }
+	const int    *Ints()    { return type == ATTBLOB_Int    ? (const int*)   data : nullptr; }
+	const float  *Floats()  { return type == ATTBLOB_Float  ? (const float*) data : nullptr; }
+	const double *Doubles() { return type == ATTBLOB_Double ? (const double*)data : nullptr; }
+	double Get(long i);
+	char *ToString();
+};
+
+class Attribute;
+
+enum AttributeArenaFlags {
+	ATTARENA_Node    = (1<<0),
+	ATTARENA_Name    = (1<<1),
+	ATTARENA_Value   = (1<<2),
+	ATTARENA_Type    = (1<<3),
+	ATTARENA_Comment = (1<<4)
+};
+
+class AttributeArena : public RefCounted
+{
+ protected:
+	PtrStack<char> blocks; //string memory
+	char *current;
+	long current_used, current_size;
+
+	PtrStack<char> node_blocks; //Attribute memory, ATTARENA_NODES_PER_BLOCK each
+	int nodes_used; //in last node block
+
+	PtrStack<RefCounted> sources;
+
+	const char **intern_str; //hash of interned name -> lark string
+	int *intern_id;
+	int intern_n, intern_max;
+
+	long bytes;
+
+ public:
+	AttributeArena();
+	virtual ~AttributeArena();
+
+	virtual void *Alloc(long size);
+	virtual char *NewString(const char *str, int len=-1);
+	virtual const char *Intern(const char *str, int len, int *id_ret);
+	virtual int FindId(const char *str);
+	virtual Attribute *NewAttribute();
+	virtual void AddSource(RefCounted *source);
+	virtual long NumNodes();
+	virtual long BytesUsed() { return bytes; }
+};
+
 class Attribute {
  public:
 	char *name;
 	char *value;
 	char *atttype; // hint about what data type value is
 	char *comment;
+	AttributeBlob *blob; //optional typed binary value, used instead of value for bulk numbers
 	Laxkit::PtrStack<Attribute> attributes;
 
 	unsigned int flags;
 
-	Attribute() { name = value = atttype = comment = NULL;  flags = 0; }
+	AttributeArena *arena; //if non-null, subattributes read in are allocated from here
+	int name_id; //lark id of name, if interned by an arena, else 0
+	unsigned char arena_flags; //see AttributeArenaFlags
+
+	Attribute() { name = value = atttype = comment = NULL;  blob = NULL;  flags = 0;  arena = NULL;  name_id = 0;  arena_flags = 0; }
 	Attribute(const char *nn, const char *nval, const char *nt=NULL);
 	virtual ~Attribute();
 	virtual Attribute *duplicate();
@@ -66,6 +147,8 @@ class Attribute {
 	virtual double      findDouble(const char *fromname, int *i_ret=NULL);
 	virtual long        findLong  (const char *fromname, int *i_ret=NULL);
 	virtual Attribute *pushSubAtt(const char *nname, const char *nvalue=nullptr, const char *ncomment=nullptr);
+	virtual Attribute *pushBlob(const char *nname, int type, long n, const void *data=nullptr, const char *ncomment=nullptr);
+	virtual void SetBlob(AttributeBlob *nblob, bool absorb);
 	virtual int push(Attribute *att, int where);
 	virtual int push(const char *nname);
 	virtual int pushn(const char *nname, int len);
@@ -80,6 +163,9 @@ class Attribute {
 	virtual int remove(int index);
 	virtual void clear();
 	virtual void Comment(const char *ncomment);
+	virtual void Name(const char *nname);
+	virtual void Value(const char *nvalue);
+	virtual AttributeArena *UseArena();
 	virtual int NumAtts() { return attributes.n; }
 	virtual Attribute *Att(int index) { return index >= 0 && index < attributes.n ? attributes.e[index] : nullptr; }
 
@@ -109,6 +195,41 @@ class AttributeObject : public Laxkit::anObject, public Attribute
 	virtual void SetData(anObject *ndata, int absorb);
 };
 
+//---------------------------------- Event parsing ---------------------------------
+class AttributeEvents
+{
+  public:
+	virtual ~AttributeEvents() {}
+	virtual bool BeginNode() = 0;
+	virtual bool Name (const char *str, int len) = 0;
+	virtual bool Value(const char *str, int len) = 0;
+	virtual bool EndNode() = 0;
+	virtual void Flags(unsigned int nflags) {}
+	virtual void Error(const char *error) {}
+};
+
+class AttributeTreeBuilder : public AttributeEvents
+{
+  protected:
+	PtrStack<Attribute> stack;
+
+  public:
+	Attribute *root;
+
+	AttributeTreeBuilder(Attribute *nroot);
+	virtual ~AttributeTreeBuilder() {}
+	virtual Attribute *Current() { return stack.n ? stack.e[stack.n-1] : root; }
+
+	virtual bool BeginNode();
+	virtual bool Name (const char *str, int len);
+	virtual bool Value(const char *str, int len);
+	virtual bool EndNode();
+	virtual void Flags(unsigned int nflags);
+};
+
+int ParseAttributeEvents(IOBuffer &f, int indent, AttributeEvents *events);
+
+
 //---------------------------------- Dump helper functions ---------------------------------
 void dump_out_value(FILE *f, int indent, const char *value, int valuewidth = 1, const char *comment = NULL, int commentindent = 1);
 void dump_out_escaped(FILE *f, const char *str, int n);
@@ -157,6 +278,7 @@ char *AttributeToXML(Attribute *att,char *&appendtothis, char **error_ret);
 Attribute *XMLFileToAttribute (Attribute *att,const char *file,const char **stand_alone_tag_list);
 Attribute *XMLFileToAttributeLocked (Attribute *att,const char *file,const char **stand_alone_tag_list);
 Attribute *XMLChunkToAttribute(Attribute *att,FILE *f,const char **stand_alone_tag_list);
+int ParseXMLEvents(IOBuffer &f, const char **stand_alone_tag_list, AttributeEvents *events);
 Attribute *XMLChunkToAttribute(Attribute *att,const char *buf,long n,
 							   long *C,const char *until,const char **stand_alone_tag_list);
 
@@ -189,6 +311,15 @@ int AttributeToJsonFile(const char *jsonfile, Attribute *att, int indent);
 int DumpAttributeToJson(FILE *f, Attribute *att, int indent);
 Attribute *JsonFileToAttribute (const char *jsonfile, Attribute *att);
 Attribute *JsonStringToAttribute (const char *jsonstring, Attribute *att, const char **end_ptr);
+int ParseJsonEvents(IOBuffer &f, AttributeEvents *events);
+
+
+//---------------------------------- Binary Conversion helpers -------------------------------
+bool IsBinaryAttributeFile(const char *file);
+int AttributeToBinaryFile(const char *file, Attribute *att);
+int DumpAttributeToBinary(FILE *f, Attribute *att);
+Attribute *BinaryFileToAttribute(const char *file, Attribute *att, int *error_ret);
+Attribute *BinaryToAttribute(const char *data, long size, RefCounted *source, Attribute *att, int *error_ret);
 
 
 //---------------------------------- CSV Conversion helpers -------------------------------
@@ -201,6 +332,7 @@ int ParseCSV(IOBuffer &f, const char *delimiter, bool has_headers,
 		std::function<void(const char *content, int len)> NewCell,
 		std::function<void(const char *error)> OnError
 	);
+int ParseCSVEvents(IOBuffer &f, const char *delimiter, AttributeEvents *events);
 
 
 } //namespace Laxkit
@@ -21,7 +21,10 @@
 //
 
 #include <lax/bitmaputils.h>
+#include <lax/workerpool.h>
 
+#include <cstring>
+#include <cmath>
 
 #include <iostream>
 using namespace std;
@@ -46,9 +49,9 @@ void ImageProcessor::MakeValueMap(unsigned char *img, int mapwidth, int mapheigh
 }
 
 int ImageProcessor::GaussianBlur(int radius, char which, unsigned char *img, int orig_width, int orig_height,
-					unsigned char *blurred, bool expand, int depth, int numchannels, int channel_mask )
+					unsigned char *blurred, bool expand, int depth, int numchannels, int channel_mask, int method)
 {
-	return Laxkit::GaussianBlur(radius,which,img,orig_width,orig_height, blurred,expand,depth,numchannels,channel_mask);
+	return Laxkit::GaussianBlur(radius,which,img,orig_width,orig_height, blurred,expand,depth,numchannels,channel_mask,method);
 }
 
 
@@ -89,154 +92,391 @@ void ImageProcessor::SetDefault(ImageProcessor *new_processor)
 
 //---------------------------- default functions --------------------------------------
 
+#define VALUEMAP_BAND_WIDTH 256 //columns per ParallelFor() index in the column pass of MakeValueMap()
+#define VALUEMAP_ROWS       16  //rows per ParallelFor() index in the row pass of MakeValueMap()
+
 /*! From a collection of points that have values, create a one channel, 8 bit value map that is an approximation of the
  * spread out point values.
  *
- * This is quick and dirty and not terribly accurate at the pixel level. It will be faster for high point numbers, and
- * obnoxiously slow for low point numbers.
- *
- * This is done by drawing the initial points on a pixmap, and spreading those values
- * one pixel at a time outward, with the result being a kind of voronoi pattern.
+ * Each pixel gets the value of the nearest point, with the result being a voronoi pattern.
  * This pattern is then blurred by blur pixels vertically and horizontally.
+ *
+ * Nearest points are found with a two pass exact distance transform (Felzenszwalb and Huttenlocher),
+ * so cost is proportional to mapwidth*mapheight, no matter how many points there are. The first pass finds
+ * for each pixel the nearest point in its column, sweeping down then up a band of columns at a time. The second
+ * pass takes the lower envelope of the resulting parabolas along each row. Both passes run on WorkerPool::Default().
+ * Scratch space is on the heap, about 4 bytes per pixel.
  */
 void MakeValueMap(unsigned char *img, int mapwidth, int mapheight, int blur, const DoubleBBox &bounds, flatpoint *points, int numpoints, bool flipy)
 {
-	 //initialize
-	unsigned char map1[mapwidth*mapheight];
-	unsigned char map2[mapwidth*mapheight]; //used as status bits
-	memset(map1, 0, mapwidth*mapheight);
-	memset(map2, 0, mapwidth*mapheight);
+	if (!img || mapwidth<1 || mapheight<1) return;
+
+	 //initialize. nearest[i] is (row of nearest point in the same column)*256 + point value, or -1 for none.
+	 //Points set their own pixel here, the column pass fills in the rest.
+	int n = mapwidth*mapheight;
+	int *nearest = new int[n];
+	for (int c=0; c<n; c++) nearest[c] = -1;
 
 	int v, i;
 	int x,y;
+	int numfilled=0;
 	for (int c=0; c<numpoints; c++) {
 		x=(points[c].x-bounds.minx)/(bounds.maxx-bounds.minx)*mapwidth;
 		if (flipy) y=(bounds.maxy-points[c].y)/(bounds.maxy-bounds.miny)*mapheight;
 		else y=(points[c].y-bounds.miny)/(bounds.maxy-bounds.miny)*mapheight;
 
-		v=points[c].info+1;
+		v=points[c].info;
 		if (v>255) v=255; else if (v<0) v=0;
 		
 		if (x<0 || x>=mapwidth || y<0 || y>=mapheight) continue; 
 
 		i=x + y*mapwidth;
-		map1[i] = v;
-		map2[i] = v;
+		nearest[i] = y*256 + v;
+		numfilled++;
 	}
 
+	if (numfilled==0) {
+		memset(img, 0, n);
+		delete[] nearest;
+		return;
+	}
+
+	WorkerPool *pool = WorkerPool::Default();
+	int nthreads = pool->NumThreads();
+
+	 //column pass: sweep down then up, keeping the last point seen in each column
+	pool->ParallelFor((mapwidth + VALUEMAP_BAND_WIDTH-1) / VALUEMAP_BAND_WIDTH, [&](int index, int thread) {
+		int x0 = index * VALUEMAP_BAND_WIDTH;
+		int bw = (x0 + VALUEMAP_BAND_WIDTH > mapwidth ? mapwidth - x0 : VALUEMAP_BAND_WIDTH);
+		int last[VALUEMAP_BAND_WIDTH];
+
+		for (int c=0; c<bw; c++) last[c] = -1;
+		for (int y=0; y<mapheight; y++) {
+			int *d = nearest + y*mapwidth + x0;
+			for (int c=0; c<bw; c++) {
+				if (d[c] >= 0) last[c] = d[c];
+				else d[c] = last[c];
+			}
+		}
 
-	 //now grow. 
-	 //From top to bottom, for any blank pixel with a filled neighbor, fill that pixel with average
-	 //of the filled neighbors' colors. Repeat until there are no blank pixels left!
-	int startline=0, lastline=mapheight; //used to not check regions already filled
-	unsigned char *m1=map1, *m2=map2;
-	int firstzero=0, lastzero=1, nfilled;
-	int stillzero=0, firstnonzero=mapwidth;
-	int ii, sum;
-	//int curstep=2;
+		for (int c=0; c<bw; c++) last[c] = -1;
+		for (int y=mapheight-1; y>=0; y--) {
+			int *d = nearest + y*mapwidth + x0;
+			for (int c=0; c<bw; c++) {
+				if (d[c] >= 0 && (d[c]>>8) == y) last[c] = d[c]; //point is on this pixel
+				else if (last[c] >= 0 && (d[c] < 0 || (last[c]>>8)-y < y-(d[c]>>8))) d[c] = last[c];
+			}
+		}
+	});
+
+	 //row pass: each pixel gets the value at column q that minimizes (x-q)^2 + (y-pointrow(q))^2
+	int *envelope = new int[nthreads * mapwidth];       //columns of parabolas in the lower envelope
+	double *starts = new double[nthreads * mapwidth]; //where each parabola of the envelope starts being lowest
+
+	pool->ParallelFor((mapheight + VALUEMAP_ROWS-1) / VALUEMAP_ROWS, [&](int index, int thread) {
+		int *vq = envelope + thread*mapwidth;
+		double *z = starts + thread*mapwidth;
+
+		for (int y = index*VALUEMAP_ROWS; y < (index+1)*VALUEMAP_ROWS && y < mapheight; y++) {
+			int *row = nearest + y*mapwidth;
+			unsigned char *out = img + y*mapwidth;
+
+			int k = -1;
+			double s = 0;
+			for (int q=0; q<mapwidth; q++) {
+				if (row[q] < 0) continue; //empty column
+				double dy = (row[q]>>8) - y;
+				double fq = dy*dy + (double)q*q;
+				while (k >= 0) {
+					int p = vq[k];
+					double dp = (row[p]>>8) - y;
+					s = (fq - dp*dp - (double)p*p) / (2.*(q - p));
+					if (s > z[k]) break;
+					k--;
+				}
+				k++;
+				vq[k] = q;
+				z[k] = (k == 0 ? -1e30 : s);
+			}
 
-	DBG int numiter=0;
-	DBG int numfilled=0;
+			int kk = 0;
+			for (int x=0; x<mapwidth; x++) {
+				while (kk < k && z[kk+1] <= x) kk++;
+				out[x] = row[vq[kk]] & 0xff;
+			}
+		}
+	});
 
+	delete[] envelope;
+	delete[] starts;
+	delete[] nearest;
 
-	while (!stillzero) {
-		DBG numiter++;
-		DBG if (numiter>40) break;
 
-		firstzero=mapheight*mapwidth;
-		lastzero=0;
+	 //now blur
+	if (blur>0) {
+		unsigned char *tmp = new unsigned char[n];
+		ImageProcessor *proc = ImageProcessor::GetDefault();
+		proc->GaussianBlur(blur,'x', img,mapwidth,mapheight, tmp, false, 8, 1,1);
+		proc->GaussianBlur(blur,'y', tmp,mapwidth,mapheight, img, false, 8, 1,1);
+		delete[] tmp;
+	}
+}
 
-		DBG numfilled=0;
 
-		stillzero=1;
-		for (int y=startline; y<lastline && y<mapheight; y++) {
-			i=y*mapwidth;
 
-			for (int x=0; x<mapwidth; x++, i++) {
-				if (m1[i]!=0) {
-					DBG numfilled++;
-					m2[i]=m1[i];
-					continue; //pixel filled, go to next one
-				}
 
-				if (stillzero) {
-					stillzero=0;
-					firstnonzero=i;
-				}
+//---------------------------- blur helpers
 
-				 //check for filled neighbors, average from any filled
-				 //If no filled neighbors, go to next pixel
-				nfilled=0;
-				ii=i-1-mapwidth;
-				sum=0;
+#define BLUR_ROWS_PER_JOB  8   //rows of the horizontal pass done per ParallelFor() index
+#define BLUR_BAND_WIDTH    256 //samples per row in a band of the vertical pass
+#define BLUR_BOX_RADIUS    8   //BLUR_Auto uses box approximation at this radius or more
 
-				for (int yy=y-1; yy<y+2; yy++, ii+=mapwidth-3) {
-					if (yy<0 || yy>=mapheight) { ii+=3; continue; }
+/*! Fill kernel[0..2*radius] with a normalized gaussian of sigma=radius/3.
+ */
+static void GaussianKernel(int radius, float *kernel)
+{
+	double sigma = radius/3.;
+	double *k = new double[2*radius+1];
+	double sum = 0;
 
-					for (int xx=x-1; xx<x+2; xx++, ii++) {
-						if (xx<0 || xx>=mapwidth || (xx==x && yy==y)) continue;
+	for (int c=0; c<=radius; c++) {
+		k[radius-c] = k[radius+c] = 1/sqrt(2*M_PI*sigma*sigma) * exp(-c*c/2/sigma/sigma);
+	}
+	for (int c=0; c<=2*radius; c++) sum += k[c];
+	for (int c=0; c<=2*radius; c++) kernel[c] = k[c]/sum;
+	delete[] k;
+}
 
-						if (m1[ii]==0) continue; //blank pixel, skip
-						sum+=m1[ii];
-						nfilled++;
-					}
-				}
+/*! Radii of 3 box blurs whose combination approximates a gaussian of sigma=radius/3.
+ * Box sizes are chosen so their combined variance is as close to sigma^2 as possible.
+ */
+static void BoxRadii(int radius, int *radii)
+{
+	double sigma = radius/3.;
+	int wl = floor(sqrt(12*sigma*sigma/3 + 1));
+	if (wl%2 == 0) wl--;
+	int m = floor((12*sigma*sigma - 3*wl*wl - 12*wl - 9)/(-4.*wl - 4) + .5);
 
+	for (int c=0; c<3; c++) radii[c] = ((c<m ? wl : wl+2) - 1)/2;
+}
 
-				if (nfilled==0) {
-					if (i<firstzero) firstzero=i;
-					if (i>lastzero)  lastzero=i;
-				} else {
-					m2[i]=sum/nfilled;
+/*! Running sum box blur of in to out, each of n samples. If zero_edges, samples off the ends are 0,
+ * otherwise they are ignored and the average is over only the samples within the line.
+ */
+static void BoxLine(const float *in, float *out, int n, int r, bool zero_edges)
+{
+	double sum = 0;
+	int count = 0;
 
-					DBG numfilled++;
-				}
-				
-			}
-		}
+	for (int c=0; c<r && c<n; c++) { sum += in[c]; count++; }
 
-		if (m1==map1) { m1=map2; m2=map1; }
-		else { m1=map1; m2=map2; }
+	for (int c=0; c<n; c++) {
+		if (c+r < n)    { sum += in[c+r];   count++; }
+		if (c-r-1 >= 0) { sum -= in[c-r-1]; count--; }
+		out[c] = sum / (zero_edges ? 2*r+1 : count);
+	}
+}
 
-		startline=firstnonzero/mapwidth;
-		//lastline=lastzero/mapwidth+1;
+template <class T>
+static inline T BlurClamp(float v, float max)
+{
+	if (v <= 0) return 0;
+	if (v >= max) return max;
+	return v + .5f;
+}
 
+/*! Horizontal pass of GaussianBlur(). width and height are of img. Each row is read into a line buffer
+ * padded with zeros, blurred one channel at a time, and written out.
+ */
+template <class T>
+static void BlurRows(int radius, bool box, T *img, int width, int height, T *blurred,
+					 bool expand, int numchannels, int channel_mask, float max)
+{
+	int pad       = (expand ? radius : 0);
+	int new_width = width + 2*pad;
+	int nthreads  = WorkerPool::Default()->NumThreads();
+
+	float *kernel = new float[2*radius+1];
+	int radii[3];
+	if (box) BoxRadii(radius, radii);
+	else GaussianKernel(radius, kernel);
+
+	 //when !expand, weights of kernel samples that are off the image are redistributed
+	float *scale = new float[new_width];
+	for (int x=0; x<new_width; x++) {
+		scale[x] = 1;
+		if (expand || box || (x >= radius && x < width-radius)) continue;
+		float sum = 0;
+		for (int c=-radius; c<=radius; c++) if (x+c >= 0 && x+c < width) sum += kernel[c+radius];
+		scale[x] = 1/sum;
 	}
 
+	 //per thread line buffers
+	int linesize = new_width + 2*radius;
+	float *lines = new float[nthreads * 2 * linesize];
 
-	 //now blur
-	if (blur>0) {
-		GaussianBlur(blur,'x', m2,mapwidth,mapheight, m1, false, 8, 1,1);
-		GaussianBlur(blur,'y', m1,mapwidth,mapheight, m2, false, 8, 1,1);
-		m1=m2;
+	WorkerPool::Default()->ParallelFor((height + BLUR_ROWS_PER_JOB-1) / BLUR_ROWS_PER_JOB, [&](int index, int thread) {
+		float *in  = lines + thread*2*linesize; //in[radius+x] is output column x
+		float *out = in + linesize;
 
-	} else m1=m2;
+		for (int y = index*BLUR_ROWS_PER_JOB; y < (index+1)*BLUR_ROWS_PER_JOB && y < height; y++) {
+			T *src = img     + y*width*numchannels;
+			T *dst = blurred + y*new_width*numchannels;
 
-	 //we had values+1, so remove the +1, we need that 0...
-	i=0;
-	for (y=0; y<mapheight; y++) {
-		for (x=0; x<mapheight; x++) {
-			if (m1[i]>0) m1[i++]--;
-		}
-	}
+			for (int ch=0; ch<numchannels; ch++) {
+				if ((channel_mask & (1<<ch)) == 0) {
+					 //just copy (and shift)
+					if (expand) {
+						for (int x=0; x<new_width; x++) in[x] = (x>=pad && x<pad+width ? src[(x-pad)*numchannels + ch] : 0);
+						for (int x=0; x<new_width; x++) dst[x*numchannels + ch] = in[x];
+					} else if (dst != src) for (int x=0; x<width; x++) dst[x*numchannels + ch] = src[x*numchannels + ch];
+					continue;
+				}
+
+				memset(in, 0, linesize*sizeof(float));
+				for (int x=0; x<width; x++) in[radius + pad + x] = src[x*numchannels + ch];
 
-	 //finally blit the correct data to img
-	memcpy(img, m1, mapwidth*mapheight);
+				if (box) {
+					float *line = in + radius;
+					BoxLine(line, out,  new_width, radii[0], expand);
+					BoxLine(out,  line, new_width, radii[1], expand);
+					BoxLine(line, out,  new_width, radii[2], expand);
 
+				} else {
+					memset(out, 0, new_width*sizeof(float));
+					for (int c=0; c<=2*radius; c++) {
+						float k = kernel[c];
+						float *inc = in + c;
+						for (int x=0; x<new_width; x++) out[x] += k * inc[x];
+					}
+					if (!expand) for (int x=0; x<new_width; x++) out[x] *= scale[x];
+				}
 
+				for (int x=0; x<new_width; x++) dst[x*numchannels + ch] = BlurClamp<T>(out[x], max);
+			}
+		}
+	});
+
+	delete[] lines;
+	delete[] scale;
+	delete[] kernel;
 }
 
+/*! Vertical pass of GaussianBlur(). width and height are of img. Rows are split into bands of
+ * BLUR_BAND_WIDTH samples, and each band is copied to a float buffer, then blurred a whole band row at a time.
+ */
+template <class T>
+static void BlurColumns(int radius, bool box, T *img, int width, int height, T *blurred,
+						bool expand, int numchannels, int channel_mask, float max)
+{
+	int pad        = (expand ? radius : 0);
+	int new_height = height + 2*pad;
+	int rowsize    = width * numchannels;
+	int nbands     = (rowsize + BLUR_BAND_WIDTH-1) / BLUR_BAND_WIDTH;
+	int nthreads   = WorkerPool::Default()->NumThreads();
+
+	float *kernel = new float[2*radius+1];
+	int radii[3];
+	if (box) BoxRadii(radius, radii);
+	else GaussianKernel(radius, kernel);
+
+	 //per thread band buffers, with room for 2 copies of the band when using box
+	int bandsize = new_height * BLUR_BAND_WIDTH;
+	float *bands = new float[nthreads * 2 * bandsize];
+
+	WorkerPool::Default()->ParallelFor(nbands, [&](int index, int thread) {
+		int s0 = index * BLUR_BAND_WIDTH;
+		int bw = (s0 + BLUR_BAND_WIDTH > rowsize ? rowsize - s0 : BLUR_BAND_WIDTH);
+		float *band = bands + thread*2*bandsize; //band[(y+pad)*bw + s] is sample s0+s of row y
+		float *tmp  = band + bandsize;
+		double acc[BLUR_BAND_WIDTH];
+
+		memset(band, 0, new_height*bw*sizeof(float));
+		for (int y=0; y<height; y++) {
+			T *src = img + y*rowsize + s0;
+			float *b = band + (y+pad)*bw;
+			for (int s=0; s<bw; s++) b[s] = src[s];
+		}
+
+		if (box) {
+			 //running sums down the columns, a whole band row at a time
+			float *in = band, *out = tmp;
+			for (int p=0; p<3; p++) {
+				int r = radii[p];
+				int count = 0;
+				memset(acc, 0, bw*sizeof(double));
+				for (int y=0; y<r && y<new_height; y++) {
+					for (int s=0; s<bw; s++) acc[s] += in[y*bw + s];
+					count++;
+				}
+				for (int y=0; y<new_height; y++) {
+					if (y+r < new_height) {
+						float *add = in + (y+r)*bw;
+						for (int s=0; s<bw; s++) acc[s] += add[s];
+						count++;
+					}
+					if (y-r-1 >= 0) {
+						float *sub = in + (y-r-1)*bw;
+						for (int s=0; s<bw; s++) acc[s] -= sub[s];
+						count--;
+					}
+					float scale = 1./(expand ? 2*r+1 : count);
+					float *o = out + y*bw;
+					for (int s=0; s<bw; s++) o[s] = acc[s] * scale;
+				}
+				float *t = in; in = out; out = t;
+			}
+			if (in != tmp) memcpy(tmp, in, new_height*bw*sizeof(float));
+
+		} else {
+			for (int y=0; y<new_height; y++) {
+				memset(acc, 0, bw*sizeof(double));
+				float sum = 0;
+				for (int c=-radius; c<=radius; c++) {
+					if (y+c < 0 || y+c >= new_height) continue;
+					float k = kernel[c+radius];
+					float *in = band + (y+c)*bw;
+					for (int s=0; s<bw; s++) acc[s] += k * in[s];
+					sum += k;
+				}
+				float scale = (expand ? 1 : 1/sum);
+				float *o = tmp + y*bw;
+				for (int s=0; s<bw; s++) o[s] = acc[s] * scale;
+			}
+		}
+
+		 //write out, unmasked channels get the original values
+		for (int y=0; y<new_height; y++) {
+			T *dst = blurred + y*rowsize + s0;
+			T *src = (y-pad >= 0 && y-pad < height ? img + (y-pad)*rowsize + s0 : NULL);
+			float *o = tmp + y*bw;
+			for (int s=0; s<bw; s++) {
+				if (channel_mask & (1<<((s0+s) % numchannels))) dst[s] = BlurClamp<T>(o[s], max);
+				else dst[s] = (src ? src[s] : 0);
+			}
+		}
+	});
 
+	delete[] bands;
+	delete[] kernel;
+}
 
 
 /*! Gaussian: 1/(2*pi*sigma^2) * exp(-(x^2 + y^2)/(2*sigma^2)
  * in one dim: 1/sqrt(2*pi*sigma^2) * exp(-x^2/2/sigma^2)
  * 
- * This is usually below 1 pixel when d=3*sigma.
+ * This is usually below 1 pixel when d=3*sigma, so sigma is radius/3.
  *
  * If expand, then the blurred image needs to be sized (orig_width + 2*xradius, orig_height + 2*yradius).
  * In this case, the boundary outside the original image is taken to be transparent black.
- * If !expand, blurred needs to be the same size as img.
+ * If !expand, blurred needs to be the same size as img, and may be the same buffer as img.
+ *
+ * Samples are unsigned char for depth 8, or unsigned short in native byte order for depth 16.
+ * Channels not in channel_mask are copied unchanged.
+ *
+ * Rows are processed in parallel with WorkerPool::Default(). For BLUR_Gaussian, cost per pixel grows
+ * with radius. BLUR_Box instead does 3 running sum box blurs that approximate the gaussian, which cost the
+ * same for any radius. BLUR_Auto picks box for radius of BLUR_BOX_RADIUS or more.
  *
  * Return 0 for success, or nonzero for error (like bad inputs).
  */
@@ -247,118 +487,31 @@ int GaussianBlur(int radius, //!< Pixels to blur from to left and right of a giv
 					bool expand, //!< true to have new image
 					int depth,  //<8 or 16, per channel
 					int numchannels, //!< Number of channels to be blurred independent of each other
-					int channel_mask //!< Bit 0 is for channel 1, bit 1 for channel 2, etc. A mask of 0 means do all.
+					int channel_mask, //!< Bit 0 is for channel 1, bit 1 for channel 2, etc. A mask of 0 means do all.
+					int method //!< A BlurMethods
 					)
 {
-	if (depth!=8) {
-		cerr << " *** WARNING!!! GaussianBlur depth greater than 8 needs to be implemented!!!"<<endl;
-	}
-
-	if (!img || !blurred || orig_width<1 || orig_height<1) return 1;
-
-	if (depth==16) depth=2;
-	else depth=1;
+	if (!img || !blurred || orig_width<1 || orig_height<1 || numchannels<1) return 1;
+	if (depth!=8 && depth!=16) return 2;
+	if (which!='x' && which!='y') return 3;
+	if (radius<0) radius=0;
 	if (channel_mask==0) channel_mask=~0;
-		
-	int xradius = (which=='x' ? radius : 0);
-	int yradius = (which=='y' ? radius : 0);
-
-	int new_width  = orig_width  + (expand ? xradius*2 : 0);
-	//int new_height = orig_height + (expand ? yradius*2 : 0);
-
-	int xoff=0;
-	int yoff=0;
-	if (expand){
-		xoff+=xradius;
-		yoff+=yradius;
-	}
-
-	 //create the bell shaped blur kernel
-	int n=radius*2+1;
-	double kernel[n];
-	double sigma=radius/3.;
-
-	for (int c=0; c<=radius; c++) {
-		kernel[radius-c-1] = kernel[radius+c] = 1/sqrt(2*M_PI*sigma*sigma) * exp(-c*c/2/sigma/sigma);
-	}
-
-	 //normalize the kernel, so all values add to 1.0
-	double summ=0;
-	for (int c=0; c<=2*radius; c++) {
-		summ+=kernel[c];
-	}
-	if (summ!=1.0) for (int c=0; c<=2*radius; c++) {
-		kernel[c]/=summ;
-	}
-
-	//int i;
-	int v, ii, dopartial;
-	double sum,tsum;
-	int stride = orig_width*numchannels*depth;
-	int pixwidth = numchannels*depth;
-
-
-	 //blur horizontal
-	if (xradius>0) { 
-		for (int x=0; x<orig_width; x++) {
-		  for (int y=0; y<orig_height; y++) {
-
-			for (int ch=0; ch<numchannels; ch++) {
-			  if ((channel_mask&(1<<ch))==0) continue;
-
-				//i=y*stride + x*pixwidth; // *** <- this and below can be optimized
-
-				sum=tsum=0;
-				if (!expand && (x<radius || x>=orig_width-radius)) dopartial=1;
-				else dopartial=0;
-				for (int c=-radius; c<=radius; c++) {
-					ii=x + c;
-
-					if (ii>=0 && ii<orig_width) {
-						v=img[y*stride + ii*pixwidth + ch*depth];
-						sum  += v * kernel[c+radius];
-						if (dopartial) tsum += kernel[c+radius]; //for when part of kernel is out of bounds
-					} else { v=0; }
 
-
-				}
-				if (dopartial) blurred[((y+yoff)*new_width + (x+xoff))*pixwidth + ch*depth]=sum/tsum;
-				else blurred[((y+yoff)*new_width + (x+xoff))*pixwidth + ch*depth]=sum;
-			}
-		  }
-		}
+	if (radius==0) {
+		if (blurred!=img) memcpy(blurred, img, orig_width*orig_height*numchannels*depth/8);
+		return 0;
 	}
 
-	if (yradius>0) { 
-		for (int x=0; x<orig_width; x++) {
-		  for (int y=0; y<orig_height; y++) {
-
-			for (int ch=0; ch<numchannels; ch++) {
-			  if ((channel_mask&(1<<ch))==0) continue;
-
-				//i=y*stride + x*pixwidth; // *** <- this and below can be optimized
+	bool box = (method==BLUR_Box || (method==BLUR_Auto && radius>=BLUR_BOX_RADIUS));
 
-				sum=tsum=0;
-				if (!expand && (y<radius || y>orig_height-radius)) dopartial=1;
-				else dopartial=0;
-				for (int c=-radius; c<=radius; c++) {
-					ii=y + c;
-
-					if (ii>=0 && ii<orig_height) {
-						v=img[ii*stride + x*pixwidth + ch*depth];
-						sum  += v * kernel[c+radius];
-						if (dopartial) tsum += kernel[c+radius]; //for when part of kernel is out of bounds
-					} else v=0;
-
-				}
-				if (dopartial) blurred[((y+yoff)*new_width + (x+xoff))*pixwidth + ch*depth]=sum/tsum;
-				else blurred[((y+yoff)*new_width + (x+xoff))*pixwidth + ch*depth]=sum;
-			}
-		  }
-		}
+	if (depth==16) {
+		if (which=='x') BlurRows   <unsigned short>(radius, box, (unsigned short*)img, orig_width,orig_height, (unsigned short*)blurred, expand, numchannels,channel_mask, 65535);
+		else            BlurColumns<unsigned short>(radius, box, (unsigned short*)img, orig_width,orig_height, (unsigned short*)blurred, expand, numchannels,channel_mask, 65535);
+	} else {
+		if (which=='x') BlurRows   <unsigned char>(radius, box, img, orig_width,orig_height, blurred, expand, numchannels,channel_mask, 255);
+		else            BlurColumns<unsigned char>(radius, box, img, orig_width,orig_height, blurred, expand, numchannels,channel_mask, 255);
 	}
 
-
 	return 0;
 }
 
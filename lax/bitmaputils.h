@@ -36,9 +36,15 @@ using namespace std;
 namespace Laxkit {
 
 
+enum BlurMethods {
+	BLUR_Auto = 0, //gaussian for small radii, else box
+	BLUR_Gaussian,
+	BLUR_Box       //3 box blurs approximating a gaussian, cost does not depend on radius
+};
+
 void MakeValueMap(unsigned char *img, int mapwidth, int mapheight, int blur, const DoubleBBox &bounds, flatpoint *points, int numpoints, bool flipy);
 int GaussianBlur(int radius, char which, unsigned char *img, int orig_width, int orig_height,
-					unsigned char *blurred, bool expand, int depth, int numchannels, int channel_mask );
+					unsigned char *blurred, bool expand, int depth, int numchannels, int channel_mask, int method = BLUR_Auto);
 
 //---------------------------- ImageProcessor --------------------------------------
 class ImageProcessor : public anObject
@@ -56,7 +62,7 @@ class ImageProcessor : public anObject
 
 	virtual void MakeValueMap(unsigned char *img, int mapwidth, int mapheight, int blur, const DoubleBBox &bounds, flatpoint *points, int numpoints, bool flipy);
 	virtual int GaussianBlur(int radius, char which, unsigned char *img, int orig_width, int orig_height,
-					unsigned char *blurred, bool expand, int depth, int numchannels, int channel_mask );
+					unsigned char *blurred, bool expand, int depth, int numchannels, int channel_mask, int method = BLUR_Auto);
 };
 
 
@@ -0,0 +1,439 @@
+//
+//
+//    The Laxkit, a windowing toolkit
+//    Please consult https://github.com/Laidout/laxkit about where to send any
+//    correspondence about this software.
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 3 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; If not, see <http://www.gnu.org/licenses/>.
+//
+//    Copyright (C) 2024 by Tom Lechner
+//
+
+#include <lax/boundstree.h>
+
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+namespace Laxkit {
+
+
+//---------------------------------- BoundsTree ---------------------------------
+
+/*! \class BoundsTree
+ * \brief Bounding volume hierarchy of boxes, for fast point and box searches.
+ *
+ * Items are referred to by index, which is meant to be the position of an object in some
+ * stack, such as ViewportWithStack::datastack. Insert() and Remove() shift the indices of
+ * the items above, just like inserting or removing in the stack would. Search results are
+ * returned in index order.
+ *
+ * This is a dynamic tree, where leaves are inserted next to whichever existing node makes the
+ * smallest increase in total perimeter, and rebalanced by rotation on the way back up.
+ * Leaf bounds are enlarged by margin, so that objects moving a little bit can just be
+ * checked with Update(), without restructuring the tree.
+ */
+
+static inline double perimeter(double minx,double maxx,double miny,double maxy)
+{
+	return 2*((maxx-minx) + (maxy-miny));
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+
+BoundsTree::BoundsTree()
+{
+	nodes     = nullptr;
+	nodes_n   = 0;
+	nodes_max = 0;
+	root      = -1;
+	free_node = -1;
+	margin    = .1;
+	leaves.Delta(1000);
+
+	search_stack = nullptr;
+	search_n     = 0;
+	search_max   = 0;
+}
+
+BoundsTree::~BoundsTree()
+{
+	delete[] nodes;
+	delete[] search_stack;
+}
+
+//! Remove all items.
+void BoundsTree::Flush()
+{
+	delete[] nodes;
+	nodes     = nullptr;
+	nodes_n   = 0;
+	nodes_max = 0;
+	root      = -1;
+	free_node = -1;
+	leaves.flush();
+}
+
+//! Return the height of the tree, or -1 if there are no items.
+int BoundsTree::Height()
+{
+	if (root < 0) return -1;
+	return nodes[root].height;
+}
+
+//! Return a node from the free list, or a new one at the end of nodes.
+int BoundsTree::NewNode()
+{
+	int node;
+	if (free_node >= 0) {
+		node = free_node;
+		free_node = nodes[node].parent;
+	} else {
+		if (nodes_n == nodes_max) {
+			nodes_max = (nodes_max ? nodes_max*2 : 64);
+			Node *nnodes = new Node[nodes_max];
+			if (nodes) memcpy(nnodes, nodes, nodes_n*sizeof(Node));
+			delete[] nodes;
+			nodes = nnodes;
+		}
+		node = nodes_n++;
+	}
+
+	memset(&nodes[node], 0, sizeof(Node));
+	nodes[node].parent = nodes[node].left = nodes[node].right = -1;
+	nodes[node].index  = -1;
+	return node;
+}
+
+void BoundsTree::FreeNode(int node)
+{
+	nodes[node].parent = free_node;
+	nodes[node].height = -1;
+	free_node = node;
+}
+
+/*! Set both tight and enlarged bounds of leaf.
+ */
+void BoundsTree::SetLeafBounds(int leaf, const DoubleBBox &box)
+{
+	Node &l = nodes[leaf];
+	l.tminx = box.minx;  l.tmaxx = box.maxx;
+	l.tminy = box.miny;  l.tmaxy = box.maxy;
+
+	double dx = margin * (box.maxx - box.minx);
+	double dy = margin * (box.maxy - box.miny);
+	l.minx = box.minx - dx;  l.maxx = box.maxx + dx;
+	l.miny = box.miny - dy;  l.maxy = box.maxy + dy;
+}
+
+/*! Add a box with index, shifting up the index of any existing items at index or above.
+ * If index<0 or index>NumItems(), the item goes on the end.
+ * Returns the index of the new item.
+ */
+int BoundsTree::Insert(int index, const DoubleBBox &box)
+{
+	if (index < 0 || index > leaves.n) index = leaves.n;
+
+	int leaf = NewNode();
+	SetLeafBounds(leaf, box);
+	leaves.push(leaf, index);
+	for (int c = index; c < leaves.n; c++) nodes[leaves.e[c]].index = c;
+
+	InsertLeaf(leaf);
+	return index;
+}
+
+/*! Call when the bounds of an item change. Returns 0 for success, or 1 for no such index.
+ */
+int BoundsTree::Update(int index, const DoubleBBox &box)
+{
+	if (index < 0 || index >= leaves.n) return 1;
+	int leaf = leaves.e[index];
+	Node &l = nodes[leaf];
+
+	 //still fits in the old enlarged bounds, no need to move leaf
+	if (box.minx >= l.minx && box.maxx <= l.maxx && box.miny >= l.miny && box.maxy <= l.maxy) {
+		l.tminx = box.minx;  l.tmaxx = box.maxx;
+		l.tminy = box.miny;  l.tmaxy = box.maxy;
+		return 0;
+	}
+
+	RemoveLeaf(leaf);
+	SetLeafBounds(leaf, box);
+	InsertLeaf(leaf);
+	return 0;
+}
+
+/*! Remove index, shifting down the indices of any items above it.
+ * Returns 0 for success, or 1 for no such index.
+ */
+int BoundsTree::Remove(int index)
+{
+	if (index < 0 || index >= leaves.n) return 1;
+
+	int leaf = leaves.e[index];
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+
+	leaves.remove(index);
+	for (int c = index; c < leaves.n; c++) nodes[leaves.e[c]].index = c;
+	return 0;
+}
+
+void BoundsTree::InsertLeaf(int leaf)
+{
+	if (root < 0) {
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+
+	 //find the best sibling for leaf
+	Node *l = &nodes[leaf];
+	int sibling = root;
+	while (nodes[sibling].left >= 0) {
+		Node &n = nodes[sibling];
+		double area     = perimeter(n.minx, n.maxx, n.miny, n.maxy);
+		double combined = perimeter(min(n.minx,l->minx), max(n.maxx,l->maxx), min(n.miny,l->miny), max(n.maxy,l->maxy));
+
+		 //cost of making a new parent for sibling and leaf here, and the minimum cost pushed down to children
+		double cost = 2*combined;
+		double inheritance = 2*(combined - area);
+
+		double childcost[2];
+		int children[2] = { n.left, n.right };
+		for (int c = 0; c < 2; c++) {
+			Node &ch = nodes[children[c]];
+			double p = perimeter(min(ch.minx,l->minx), max(ch.maxx,l->maxx), min(ch.miny,l->miny), max(ch.maxy,l->maxy));
+			if (ch.left < 0) childcost[c] = p + inheritance;
+			else childcost[c] = p - perimeter(ch.minx, ch.maxx, ch.miny, ch.maxy) + inheritance;
+		}
+
+		if (cost < childcost[0] && cost < childcost[1]) break;
+		sibling = (childcost[0] < childcost[1] ? n.left : n.right);
+	}
+
+	 //new parent for sibling and leaf
+	int oldparent = nodes[sibling].parent;
+	int newparent = NewNode();
+	l = &nodes[leaf]; //NewNode() may move nodes
+	Node &s = nodes[sibling];
+	Node &p = nodes[newparent];
+	p.parent = oldparent;
+	p.minx = min(s.minx, l->minx);  p.maxx = max(s.maxx, l->maxx);
+	p.miny = min(s.miny, l->miny);  p.maxy = max(s.maxy, l->maxy);
+	p.height = s.height + 1;
+	p.left  = sibling;
+	p.right = leaf;
+	s.parent = newparent;
+	l->parent = newparent;
+
+	if (oldparent >= 0) {
+		if (nodes[oldparent].left == sibling) nodes[oldparent].left = newparent;
+		else nodes[oldparent].right = newparent;
+	} else root = newparent;
+
+	 //refit and rebalance ancestors
+	int node = l->parent;
+	while (node >= 0) {
+		node = Balance(node);
+		Node &n = nodes[node];
+		Node &a = nodes[n.left];
+		Node &b = nodes[n.right];
+		n.height = 1 + max(a.height, b.height);
+		n.minx = min(a.minx, b.minx);  n.maxx = max(a.maxx, b.maxx);
+		n.miny = min(a.miny, b.miny);  n.maxy = max(a.maxy, b.maxy);
+		node = n.parent;
+	}
+}
+
+void BoundsTree::RemoveLeaf(int leaf)
+{
+	if (leaf == root) {
+		root = -1;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandparent = nodes[parent].parent;
+	int sibling = (nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left);
+
+	if (grandparent >= 0) {
+		if (nodes[grandparent].left == parent) nodes[grandparent].left = sibling;
+		else nodes[grandparent].right = sibling;
+		nodes[sibling].parent = grandparent;
+		FreeNode(parent);
+
+		int node = grandparent;
+		while (node >= 0) {
+			node = Balance(node);
+			Node &n = nodes[node];
+			Node &a = nodes[n.left];
+			Node &b = nodes[n.right];
+			n.height = 1 + max(a.height, b.height);
+			n.minx = min(a.minx, b.minx);  n.maxx = max(a.maxx, b.maxx);
+			n.miny = min(a.miny, b.miny);  n.maxy = max(a.maxy, b.maxy);
+			node = n.parent;
+		}
+	} else {
+		root = sibling;
+		nodes[sibling].parent = -1;
+		FreeNode(parent);
+	}
+
+	nodes[leaf].parent = -1;
+}
+
+/*! If one child of node a is more than one level taller than the other, rotate the taller
+ * child up. Returns the node now in a's place.
+ */
+int BoundsTree::Balance(int a)
+{
+	Node &A = nodes[a];
+	if (A.left < 0 || A.height < 2) return a;
+
+	int b = A.left, c = A.right;
+	int balance = nodes[c].height - nodes[b].height;
+
+	if (balance > 1 || balance < -1) {
+		 //rotate the taller child, up, putting a below it
+		int up = (balance > 1 ? c : b);
+		int other = (balance > 1 ? b : c);
+		Node &U = nodes[up];
+		int f = U.left, g = U.right;
+
+		U.left = a;
+		U.parent = A.parent;
+		A.parent = up;
+
+		if (U.parent >= 0) {
+			if (nodes[U.parent].left == a) nodes[U.parent].left = up;
+			else nodes[U.parent].right = up;
+		} else root = up;
+
+		 //keep the taller of up's children at up, move the shorter under a
+		int keep = f, give = g;
+		if (nodes[f].height < nodes[g].height) { keep = g; give = f; }
+
+		U.right = keep;
+		if (balance > 1) A.right = give; else A.left = give;
+		nodes[give].parent = a;
+
+		Node &O = nodes[other];
+		Node &G = nodes[give];
+		Node &K = nodes[keep];
+		A.minx = min(O.minx, G.minx);  A.maxx = max(O.maxx, G.maxx);
+		A.miny = min(O.miny, G.miny);  A.maxy = max(O.maxy, G.maxy);
+		A.height = 1 + max(O.height, G.height);
+
+		U.minx = min(A.minx, K.minx);  U.maxx = max(A.maxx, K.maxx);
+		U.miny = min(A.miny, K.miny);  U.maxy = max(A.maxy, K.maxy);
+		U.height = 1 + max(A.height, K.height);
+		return up;
+	}
+
+	return a;
+}
+
+//! Make sure there is room for at least n more nodes on search_stack.
+void BoundsTree::SearchRoom(int n)
+{
+	if (search_n + n <= search_max) return;
+	search_max = (search_max ? search_max*2 : 64);
+	if (search_max < search_n + n) search_max = search_n + n;
+	int *nstack = new int[search_max];
+	if (search_n) memcpy(nstack, search_stack, search_n*sizeof(int));
+	delete[] search_stack;
+	search_stack = nstack;
+}
+
+/*! Put in index_ret the indices of all items whose bounds contain p, in increasing order.
+ * index_ret is flushed first. Returns the number found.
+ */
+int BoundsTree::FindPoint(flatpoint p, NumStack<int> &index_ret)
+{
+	index_ret.flush_n();
+	if (root < 0) return 0;
+
+	search_n = 0;
+	SearchRoom(1);
+	search_stack[search_n++] = root;
+
+	while (search_n) {
+		Node &n = nodes[search_stack[--search_n]];
+		if (p.x < n.minx || p.x > n.maxx || p.y < n.miny || p.y > n.maxy) continue;
+
+		if (n.left < 0) {
+			if (p.x >= n.tminx && p.x <= n.tmaxx && p.y >= n.tminy && p.y <= n.tmaxy)
+				index_ret.push(n.index);
+			continue;
+		}
+
+		SearchRoom(2);
+		search_stack[search_n++] = n.left;
+		search_stack[search_n++] = n.right;
+	}
+
+	if (index_ret.n > 1) qsort(index_ret.e, index_ret.n, sizeof(int), cmp_int);
+	return index_ret.n;
+}
+
+/*! Put in index_ret the indices of all items whose bounds touch box, in increasing order.
+ * If contained, then the item bounds must be totally inside box.
+ * index_ret is flushed first. Returns the number found.
+ */
+int BoundsTree::FindBox(const DoubleBBox &box, NumStack<int> &index_ret, bool contained)
+{
+	index_ret.flush_n();
+	if (root < 0) return 0;
+	if (index_ret.Delta() < 100) index_ret.Delta(100);
+
+	search_n = 0;
+	SearchRoom(1);
+	search_stack[search_n++] = root;
+
+	while (search_n) {
+		Node &n = nodes[search_stack[--search_n]];
+		if (box.maxx < n.minx || box.minx > n.maxx || box.maxy < n.miny || box.miny > n.maxy) continue;
+
+		if (n.left < 0) {
+			if (contained) {
+				if (n.tminx >= box.minx && n.tmaxx <= box.maxx && n.tminy >= box.miny && n.tmaxy <= box.maxy)
+					index_ret.push(n.index);
+			} else if (!(box.maxx < n.tminx || box.minx > n.tmaxx || box.maxy < n.tminy || box.miny > n.tmaxy))
+				index_ret.push(n.index);
+			continue;
+		}
+
+		SearchRoom(2);
+		search_stack[search_n++] = n.left;
+		search_stack[search_n++] = n.right;
+	}
+
+	if (index_ret.n > 1) qsort(index_ret.e, index_ret.n, sizeof(int), cmp_int);
+	return index_ret.n;
+}
+
+
+} //namespace Laxkit
+
@@ -0,0 +1,87 @@
+//
+//
+//    The Laxkit, a windowing toolkit
+//    Please consult https://github.com/Laidout/laxkit about where to send any
+//    correspondence about this software.
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 3 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; If not, see <http://www.gnu.org/licenses/>.
+//
+//    Copyright (C) 2024 by Tom Lechner
+//
+#ifndef _LAX_BOUNDSTREE_H
+#define _LAX_BOUNDSTREE_H
+
+#include <lax/lists.h>
+#include <lax/vectors.h>
+#include <lax/doublebbox.h>
+
+
+namespace Laxkit {
+
+
+//---------------------------------- BoundsTree ---------------------------------
+
+class BoundsTree
+{
+  protected:
+	class Node
+	{
+	  public:
+		double minx,maxx,miny,maxy; //enlarged bounds, so small moves don't need reinsertion
+		double tminx,tmaxx,tminy,tmaxy; //actual bounds, for leaves
+		int parent; //or next free node
+		int left,right; //left==-1 for leaves
+		int height; //leaves are 0, -1 for free nodes
+		int index; //stack index, for leaves
+	};
+
+	Node *nodes;
+	int nodes_n, nodes_max;
+	int root;
+	int free_node;
+	NumStack<int> leaves; //leaves[index] is the node for index
+
+	int *search_stack; //reused between searches
+	int search_n, search_max;
+	void SearchRoom(int n);
+
+	int  NewNode();
+	void FreeNode(int node);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	int  Balance(int node);
+	void SetLeafBounds(int leaf, const DoubleBBox &box);
+
+  public:
+	double margin; //fraction of a box's size to enlarge leaves by
+
+	BoundsTree();
+	virtual ~BoundsTree();
+	virtual void Flush();
+	virtual int NumItems() { return leaves.n; }
+	virtual int Height();
+
+	virtual int Insert(int index, const DoubleBBox &box);
+	virtual int Update(int index, const DoubleBBox &box);
+	virtual int Remove(int index);
+
+	virtual int FindPoint(flatpoint p, NumStack<int> &index_ret);
+	virtual int FindBox(const DoubleBBox &box, NumStack<int> &index_ret, bool contained = false);
+};
+
+
+} //namespace Laxkit
+
+#endif
+
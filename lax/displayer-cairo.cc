@@ -172,7 +172,7 @@ DisplayerCairo::~DisplayerCairo()
 	if (curfont)       cairo_font_face_destroy(curfont);
 	if (curscaledfont) cairo_scaled_font_destroy(curscaledfont);
 
-	if (imagebuffer) imagebuffer->dec_count();
+	releaseImageBuffer();
 
 	delete[] cairo_glyphs;
 	delete[] tbuffer;
@@ -190,8 +190,25 @@ cairo_t *DisplayerCairo::GetCairo() { return cr; }
 
 //------------------------- Surface prep functions ------------------------
 
+/*! Show the back buffer of the current window. If the window has only partial damage
+ * (see anXWindow::DamageRect()), just that area is copied from the back buffer to the window.
+ * Otherwise, the buffers are swapped with Xdbe like anXWindow::SwapBuffers().
+ */
 void DisplayerCairo::SwapBuffers()
-{ cout <<"*** imp DisplayerCairo::swapbuffers()"<<endl; }
+{
+#ifdef _LAX_PLATFORM_XLIB
+	if (!xw || !xw->xlibDrawable(1)) return;
+
+	if (surface) cairo_surface_flush(surface);
+
+	if (xw->CopyDamage()) return;
+
+	XdbeSwapInfo swapinfo;
+	swapinfo.swap_window = xw->xlibDrawable(0);
+	swapinfo.swap_action = XdbeBackground;
+	XdbeSwapBuffers(dpy, &swapinfo, 1);
+#endif
+}
 
 void DisplayerCairo::BackBuffer(int on)
 { cout <<"*** imp DisplayerCairo::backbuffer()"<<endl; }
@@ -204,6 +221,19 @@ int DisplayerCairo::StartDrawing(aDrawable *buffer)
 	MakeCurrent(buffer);
 	Updates(0);
 	NewFG(fgRed, fgGreen, fgBlue, fgAlpha);
+
+	 //clip to damaged area when the window only needs a partial redraw
+	IntRectangle rect;
+	if (xw && cr && xw->DamageRect(&rect)) {
+		cairo_matrix_t m;
+		cairo_get_matrix(cr, &m);
+		cairo_identity_matrix(cr);
+		cairo_reset_clip(cr);
+		cairo_new_path(cr);
+		cairo_rectangle(cr, rect.x,rect.y, rect.width,rect.height);
+		cairo_clip(cr);
+		cairo_set_matrix(cr, &m);
+	}
 	return 0;
 }
 
@@ -251,6 +281,22 @@ int DisplayerCairo::CurrentResized(aDrawable *buffer, int nwidth,int nheight)
 	return 0;
 }
 
+//! Give back the image from MakeCurrent(LaxImage*), if any, to the image cache.
+void DisplayerCairo::releaseImageBuffer()
+{
+	if (!imagebuffer) return;
+	LaxCairoImage *img = dynamic_cast<LaxCairoImage*>(imagebuffer);
+	if (img) img->doneForNow();
+	imagebuffer->dec_count();
+	imagebuffer = nullptr;
+}
+
+/*! Draw on buffer, which must be a LaxCairoImage. The image is fetched with Image(), so it stays
+ * in memory while current, and marked Modified(), so the cache never reloads it from its file over
+ * what is drawn. Switching to another target gives it back with doneForNow().
+ *
+ * Returns 0 for success, 2 for no buffer, 3 for not a LaxCairoImage, or 4 if the image could not be loaded.
+ */
 int DisplayerCairo::MakeCurrent(LaxImage *buffer)
 {
 	if (!buffer) return 2;
@@ -260,7 +306,10 @@ int DisplayerCairo::MakeCurrent(LaxImage *buffer)
 	if (cr && imagebuffer==buffer) return 0;
 
 	if (imagebuffer!=buffer) {
-		if (imagebuffer) imagebuffer->dec_count();
+		if (!img->Image()) return 4;
+		img->Modified();
+
+		releaseImageBuffer();
 		imagebuffer=buffer;
 		imagebuffer->inc_count();
 
@@ -326,7 +375,7 @@ int DisplayerCairo::MakeCurrent(aDrawable *buffer)
 	dr = buffer;
 	xw = dynamic_cast<anXWindow*>(buffer);
 	w = buffer->xlibDrawable();
-	if (imagebuffer) { imagebuffer->dec_count(); imagebuffer = nullptr; }
+	releaseImageBuffer();
 
 
 	if (!xw) {
@@ -439,7 +488,7 @@ int DisplayerCairo::CreateSurface(int width,int height, int type)
 	xw=nullptr;
 	dr=nullptr;
 	w=0;
-	if (imagebuffer) { imagebuffer->dec_count(); imagebuffer=nullptr; }
+	releaseImageBuffer();
 
 	if (surface) cairo_surface_destroy(surface);
 	if (cr) cairo_destroy(cr);
@@ -1337,9 +1386,6 @@ double DisplayerCairo::textextent(LaxFont *thisfont, const char *str,int len, do
 { 
 	//DBG cerr <<"-------cairo textextent-------"<<endl;
 
-	LaxFont *oldfont=nullptr;
-	//double oldheight=0;
-
 	LaxFontCairo *cfont=dynamic_cast<LaxFontCairo*>(thisfont);
 
 	if (!curfont) initFont();
@@ -1354,15 +1400,47 @@ double DisplayerCairo::textextent(LaxFont *thisfont, const char *str,int len, do
 		return 0;
 	}
 
+	 //check the cache before switching fonts or making a temporary cairo_t
+	bool otherfont = (cfont && laxfont!=thisfont);
+	double m[4];
+	int surface_type;
+	textMatrix(m, &surface_type);
+	CairoTextKey key(otherfont ? cfont : laxfont, otherfont ? cfont->font : curfont,
+					 otherfont ? cfont->textheight() : _textheight, m, surface_type, str, len);
+
+	cairo_text_extents_t extents;
+	cairo_font_extents_t fextents;
+	if (!CairoTextCache::Default()->Extents(key, &extents, &fextents)) {
+		measureText(otherfont ? cfont : nullptr, str, len, &extents, &fextents);
+		CairoTextCache::Default()->Add(key, &extents, &fextents, nullptr, 0);
+	}
+
+	if (ascent)  *ascent =fextents.ascent;
+	if (descent) *descent=fextents.descent;
+	if (height)  { if (real) *height=extents.height; else *height=fextents.height; }
+	if (width)   { if (real) *width =extents.width;  else *width=extents.x_advance; }
+
+	//DBG cerr <<" found extent: adv="<<extents.x_advance<<"  width="<<extents.width<<endl;
+	//DBG cerr <<"-------end cairo textextent-------"<<endl;
+
+	if (real) return extents.width;
+	return extents.x_advance;
+}
+
+/*! Ask cairo for the extents of str, in thisfont if not null, else the current font.
+ * If there is no current cairo_t, a temporary one is used.
+ */
+void DisplayerCairo::measureText(LaxFontCairo *thisfont, const char *str, int len, cairo_text_extents_t *extents, cairo_font_extents_t *fextents)
+{
+	LaxFont *oldfont=nullptr;
+
 	//DBG cerr <<" font curfont start: "<<cairo_font_face_get_reference_count(curfont) <<endl;
-	//DBG if (cfont) cerr <<" temp font count start: "<<cairo_font_face_get_reference_count(cfont->font) <<endl;
+	//DBG if (thisfont) cerr <<" temp font count start: "<<cairo_font_face_get_reference_count(thisfont->font) <<endl;
 
-	if (cfont && laxfont!=thisfont) {
+	if (thisfont) {
 		oldfont=laxfont;
 		oldfont->inc_count();
-		//oldheight=_textheight;
-		font(cfont,cfont->textheight()); //dec count old, inc new font if the cairo font not same as new one
-		//font(thisfont,thisfont->textheight()); 
+		font(thisfont,thisfont->textheight()); //dec count old, inc new font if the cairo font not same as new one
 	}
 	//DBG cerr <<" font curfont 2: "<<cairo_font_face_get_reference_count(oldfont ? oldfont : curfont) <<endl;
 
@@ -1387,23 +1465,15 @@ double DisplayerCairo::textextent(LaxFont *thisfont, const char *str,int len, do
 		tempcr=1;
 	}
 
-	cairo_text_extents_t extents;
 	memcpy(tbuffer,str,len);
 	tbuffer[len]='\0';
-	cairo_text_extents(cr, tbuffer, &extents);
-
-	cairo_font_extents_t fextents;
-	cairo_font_extents(cr, &fextents);
-
-	if (ascent)  *ascent =fextents.ascent;
-	if (descent) *descent=fextents.descent;
-	if (height)  { if (real) *height=extents.height; else *height=fextents.height; }
-	if (width)   { if (real) *width =extents.width;  else *width=extents.x_advance; }
+	cairo_text_extents(cr, tbuffer, extents);
+	cairo_font_extents(cr, fextents);
 
 	if (tempcr) { cairo_destroy(cr); cr=nullptr; }
 
 	//DBG if (oldfont) cerr <<" curfont count: "<<cairo_font_face_get_reference_count(oldfont) <<endl;
-	//DBG if (cfont) cerr <<" temp font: "<<cairo_font_face_get_reference_count(cfont->font) <<endl;
+	//DBG if (thisfont) cerr <<" temp font: "<<cairo_font_face_get_reference_count(thisfont->font) <<endl;
 
 	if (oldfont) {
 		 //reinstall the old font
@@ -1411,13 +1481,26 @@ double DisplayerCairo::textextent(LaxFont *thisfont, const char *str,int len, do
 		oldfont->dec_count();
 	}
 
-	//DBG if (cfont) cerr <<" temp font count end: "<<cairo_font_face_get_reference_count(cfont->font) <<endl;
+	//DBG if (thisfont) cerr <<" temp font count end: "<<cairo_font_face_get_reference_count(thisfont->font) <<endl;
 	//DBG cerr <<" font curfont end: "<<cairo_font_face_get_reference_count(curfont) <<endl;
-	//DBG cerr <<" found extent: adv="<<extents.x_advance<<"  width="<<extents.width<<endl;
-	//DBG cerr <<"-------end cairo textextent-------"<<endl;
+}
 
-	if (real) return extents.width;
-	return extents.x_advance;
+/*! Set m to the scale and rotation part of the transform text is measured in, and surface_type to the
+ * cairo_surface_type_t it is measured on, for a CairoTextKey. This is the same as what measureText() uses.
+ */
+void DisplayerCairo::textMatrix(double *m, int *surface_type)
+{
+	if (cr) {
+		cairo_matrix_t cm;
+		cairo_get_matrix(cr, &cm);
+		m[0] = cm.xx; m[1] = cm.yx; m[2] = cm.xy; m[3] = cm.yy;
+		*surface_type = cairo_surface_get_type(cairo_get_target(cr));
+		return;
+	}
+
+	if (real_coordinates) memcpy(m, ctm, 4*sizeof(double));
+	else { m[0] = m[3] = 1; m[1] = m[2] = 0; }
+	*surface_type = (surface ? cairo_surface_get_type(surface) : CAIRO_SURFACE_TYPE_IMAGE);
 }
 
 void DisplayerCairo::initFont()
@@ -1450,14 +1533,39 @@ double DisplayerCairo::textout_line(double x,double y,const char *str,int len,un
 	if (!str) return 0;
 	if (len < 0) len = strlen(str);
 	if (len == 0) return 0;
-	if (len > tbufferlen) reallocBuffer(len);
-	strncpy(tbuffer,str,len);
-	tbuffer[len]='\0';
 
 	if (!curfont) initFont();
 
+	 //glyphs and extents for str are usually in CairoTextCache already
+	double m[4];
+	int surface_type;
+	textMatrix(m, &surface_type);
+	CairoTextKey key(laxfont, curfont, _textheight, m, surface_type, str, len);
+
 	cairo_text_extents_t extents;
-	cairo_text_extents(cr, tbuffer, &extents);
+	int numglyphs = CairoTextCache::Default()->Glyphs(key, cairo_glyphs, numalloc_glyphs, &extents);
+	if (numglyphs < 0) {
+		cairo_glyph_t *glyphs = nullptr;
+		if (cairo_scaled_font_text_to_glyphs(cairo_get_scaled_font(cr), 0,0, str,len, &glyphs,&numglyphs, nullptr,nullptr,nullptr)
+				!= CAIRO_STATUS_SUCCESS) {
+			numglyphs = 0;
+		}
+
+		if ((unsigned int)numglyphs > numalloc_glyphs) {
+			delete[] cairo_glyphs;
+			numalloc_glyphs = numglyphs+10;
+			cairo_glyphs = new cairo_glyph_t[numalloc_glyphs];
+		}
+		if (numglyphs) memcpy(cairo_glyphs, glyphs, numglyphs*sizeof(cairo_glyph_t));
+		cairo_glyph_free(glyphs);
+
+		cairo_glyph_extents(cr, cairo_glyphs, numglyphs, &extents);
+		if (numglyphs) {
+			cairo_font_extents_t fextents;
+			cairo_font_extents(cr, &fextents);
+			CairoTextCache::Default()->Add(key, &extents, &fextents, cairo_glyphs, numglyphs);
+		}
+	}
 
     double ox,oy;
 	if (align & LAX_LEFT) ox = x;
@@ -1470,11 +1578,19 @@ double DisplayerCairo::textout_line(double x,double y,const char *str,int len,un
     else oy=y - (curfont_extents.height)/2 + curfont_extents.ascent; //center
 
 
-	cairo_move_to(cr, ox,oy);
-	if (len==0) return 0;
+	if (laxfont->Layers()==1) {
+		for (int i = 0; i < numglyphs; i++) {
+			cairo_glyphs[i].x += ox;
+			cairo_glyphs[i].y += oy;
+		}
+		cairo_show_glyphs(cr, cairo_glyphs, numglyphs);
+		cairo_move_to(cr, ox+extents.x_advance, oy+extents.y_advance); //same as cairo_show_text()
+
+	} else {
+		if (len > tbufferlen) reallocBuffer(len);
+		memcpy(tbuffer,str,len);
+		tbuffer[len]='\0';
 
-	if (laxfont->Layers()==1) cairo_show_text(cr, tbuffer);
-	else {
 		 //layered color font...
 		LaxFontCairo *f = laxfont;
 		int l=0;
@@ -1745,7 +1861,10 @@ void DisplayerCairo::imageout(LaxImage *img,double x,double y)
 	if (!img || img->imagetype()!=LAX_IMAGE_CAIRO) return; 
 	LaxCairoImage *i=dynamic_cast<LaxCairoImage*>(img);
 
-	cairo_surface_t *t=i->Image();
+	 //onscreen, a smaller proxy may stand in while the full image loads in the background,
+	 //and the window redraws when it is done. Offscreen drawing always gets the full image.
+	double scale = 1;
+	cairo_surface_t *t = (xw ? i->DisplayImage(&scale, xw->object_id) : i->Image());
 	if (!t) return;
 	
 	cairo_save(cr);
@@ -1761,6 +1880,11 @@ void DisplayerCairo::imageout(LaxImage *img,double x,double y)
 
 
 	cairo_set_source_surface(cr, t, 0,0);
+	if (scale != 1) {
+		cairo_matrix_t m;
+		cairo_matrix_init_scale(&m, 1/scale, 1/scale);
+		cairo_pattern_set_matrix(cairo_get_source(cr), &m);
+	}
 	if (mask) cairo_mask_surface(cr,mask,0,0);
 	else if (mask_pattern) cairo_mask(cr,mask_pattern);
 	else cairo_paint(cr);
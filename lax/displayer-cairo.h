@@ -44,8 +44,11 @@ class DisplayerCairo : public Displayer
 	char *tbuffer;
 	int tbufferlen;
 	virtual int reallocBuffer(int len);
+	virtual void textMatrix(double *m, int *surface_type);
+	virtual void measureText(LaxFontCairo *thisfont, const char *str, int len, cairo_text_extents_t *extents, cairo_font_extents_t *fextents);
 
-	LaxImage *imagebuffer;
+	LaxImage *imagebuffer; //from MakeCurrent(LaxImage*), held with Image() until releaseImageBuffer()
+	virtual void releaseImageBuffer();
 	Display *dpy;  //if any
 	Visual *vis;
 	Window w;
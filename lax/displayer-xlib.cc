@@ -192,8 +192,21 @@ Displayer *DisplayerXlib::duplicate()
 void DisplayerXlib::show()
 { cout <<"*** imp DisplayerXlib::show()"<<endl; }
 
+/*! Show the back buffer of the current window. If the window has only partial damage
+ * (see anXWindow::DamageRect()), just that area is copied from the back buffer to the window.
+ * Otherwise, the buffers are swapped with Xdbe like anXWindow::SwapBuffers().
+ */
 void DisplayerXlib::SwapBuffers()
-{ cout <<"*** imp DisplayerXlib::swapbuffers()"<<endl; }
+{
+	if (!xw || !xw->xlibDrawable(1)) return;
+
+	if (xw->CopyDamage()) return;
+
+	XdbeSwapInfo swapinfo;
+	swapinfo.swap_window = xw->xlibDrawable(0);
+	swapinfo.swap_action = XdbeBackground;
+	XdbeSwapBuffers(anXApp::app->dpy, &swapinfo, 1);
+}
 
 //! Turn on or off the usage of double buffering.
 void DisplayerXlib::BackBuffer(int on)
@@ -1661,6 +1674,19 @@ int DisplayerXlib::StartDrawing(aDrawable *buffer)//buffer=0
 	//}
 	on=1;
 	Updates(0);
+
+	 //clip to damaged area when the window only needs a partial redraw
+	IntRectangle rect;
+	if (xw && xw->DamageRect(&rect)) {
+		XRectangle xrect;
+		xrect.x = rect.x;  xrect.width  = rect.width;
+		xrect.y = rect.y;  xrect.height = rect.height;
+		Region region = XCreateRegion();
+		XUnionRectWithRegion(&xrect, region, region);
+		if (clipregion) XDestroyRegion(clipregion);
+		clipregion = region;
+		XSetRegion(dpy,gc,clipregion);
+	}
 	return 0;
 }
 
@@ -1770,6 +1796,7 @@ int DisplayerXlib::ResizeSurface(int width, int height)
 int DisplayerXlib::EndDrawing()
 {
 	if (xw==NULL) Updates(1);
+	else if (xw->DamageRect(NULL)) ClearClip(); //remove damage clip from the shared gc
 	gc=0;
 	if (!isinternal) w=0;
 	on=0;
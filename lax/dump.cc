@@ -78,6 +78,10 @@ namespace Laxkit {
 /*! The default function here ignores what (assumes it is 0).
  * Creates a new Attribute, does newatt->dump_in(f,indent), then calls
  * dump_in_atts(newatt,loadcontext). Puts the plain att in Att if Att!=NULL. Otherwise deletes the nem att.
+ * When Att==NULL and loadcontext->use_arena is true, the att is read into an AttributeArena,
+ * which is much faster for big trees. Only set use_arena when dump_in_atts() does not keep
+ * any of the nodes, nor change their strings with makestr(). Otherwise the att is allocated
+ * normally.
  *
  * what==0 means f is an Attribute formatted file. Other values of what can be used by
  * subclasses to read in from other file formats, like a PathsData reading in an SVG,
@@ -88,6 +92,7 @@ namespace Laxkit {
 void DumpUtility::dump_in(FILE *f,int indent,int what,DumpContext *loadcontext,Attribute **Att)
 {
 	Attribute *att=new Attribute;
+	if (!Att && loadcontext && loadcontext->use_arena) att->UseArena(); //tree only lives through dump_in_atts()
 	att->dump_in(f,indent);
 	dump_in_atts(att,0,loadcontext);
 	if (Att) *Att=att;
@@ -96,6 +101,7 @@ void DumpUtility::dump_in(FILE *f,int indent,int what,DumpContext *loadcontext,A
 
 /*! Read in string as an attribute,  and pass parsing duties to dump_in_atts().
  * Return the created Attribute in att if not null.
+ * Uses an AttributeArena under the same conditions as dump_in().
  */
 void DumpUtility::dump_in_str(const char *str, int what, DumpContext *context, Attribute **Att)
 {
@@ -103,6 +109,7 @@ void DumpUtility::dump_in_str(const char *str, int what, DumpContext *context, A
 	buffer.OpenCString(str);
 
 	Attribute *att = new Attribute;
+	if (!Att && context && context->use_arena) att->UseArena();
 	att->dump_in(buffer, 0);
 
 	dump_in_atts(att,0,context);
@@ -42,6 +42,8 @@ class DumpContext : public Laxkit::anObject
 	char *basedir;
 	bool subs_only;
 	bool render_proxies = false; //when a group has a proxy_shape defined
+	int format = ATT_Att; //ATT_Binary lets dump_out_atts() put bulk numbers in AttributeBlob values
+	bool use_arena = false; //dump_in() may read throwaway trees into an AttributeArena, see DumpUtility::dump_in()
 	Laxkit::anObject *extra;
 
 	Laxkit::ErrorLog *log;
@@ -22,6 +22,9 @@
 
 
 
+#include <atomic>
+#include <new>
+
 #include <lax/anxapp.h>
 #include <lax/events.h>
 #include <lax/strmanip.h>
@@ -74,6 +77,9 @@ const char *lax_event_name(int e)
  *
  * anXApp calls anXWindow::Event(const EventData *,const char *mes) is called, where mes is the string corresponding to
  * EventData::send_message.
+ *
+ * send_message is always the interned lark string of message_id, so setting a message never allocates
+ * once that message has been seen before, and events need not free it.
  */
 
 
@@ -81,6 +87,7 @@ EventData::EventData()
 {
 	isuserevent  = 1;
 	send_message = NULL;
+	message_id   = 0;
 	type         = LAX_UserEvent;
 	subtype      = 0;
 	usertype     = 0;
@@ -95,7 +102,9 @@ EventData::EventData(const char *message, unsigned long fromwindow, unsigned lon
 {
 	isuserevent = 1;
 	type        = LAX_UserEvent;
-	send_message= newstr(message);
+	send_message= NULL;
+	message_id  = 0;
+	SetMessage(message);
 	from        = fromwindow;
 	to          = towindow;
 	send_time   = 0; 
@@ -112,6 +121,7 @@ EventData::EventData(LaxEventType message, unsigned long fromwindow, unsigned lo
 	subtype     = 0;
 	usertype    = 0;
 	send_message= NULL;
+	message_id  = 0;
 	from        = fromwindow;
 	to          = towindow;
 	send_time   = 0; 
@@ -121,10 +131,155 @@ EventData::EventData(LaxEventType message, unsigned long fromwindow, unsigned lo
 
 EventData::~EventData()
 {
-	if (send_message) delete[] send_message;
 	if (next) delete next;
 }
 
+//! Set message_id to the lark id of message, and send_message to its lark string. message can be NULL.
+void EventData::SetMessage(const char *message)
+{
+	if (message && message == send_message && message == lark_str_from_id(message_id)) return;
+	message_id   = lark_id_from_str(message, 1);
+	send_message = lark_str_from_id(message_id);
+}
+
+
+//---------------------------- EventData pool ----------------------------
+//
+// EventData objects are made on any thread (device threads, SendMessage() callers),
+// and deleted on the event loop thread once dispatched. To keep steady state event
+// delivery from hitting the heap, blocks are recycled through free lists, one per
+// size class, so each EventData subclass effectively gets its own pool.
+//
+// Freed blocks are pushed onto a shared lock free stack. Allocating threads pop from
+// their own thread local list, and when that is empty, take the entire shared stack
+// at once with an exchange, which avoids the ABA problem of popping single nodes.
+//
+
+#define EVENTPOOL_GRAIN    16
+#define EVENTPOOL_BUCKETS  16
+#define EVENTPOOL_MAX_FREE 4096
+
+struct EventPoolBlock
+{
+	EventPoolBlock *next;
+};
+
+struct EventPoolShared
+{
+	std::atomic<EventPoolBlock*> head;
+	std::atomic<int> count;
+};
+
+static EventPoolShared event_pool[EVENTPOOL_BUCKETS];
+static std::atomic<long> event_pool_allocations(0);
+
+static void event_pool_push(int bucket, EventPoolBlock *block)
+{
+	EventPoolShared &pool = event_pool[bucket];
+	EventPoolBlock *head = pool.head.load(std::memory_order_relaxed);
+	do {
+		block->next = head;
+	} while (!pool.head.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+	pool.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+struct EventPoolLocal
+{
+	EventPoolBlock *head[EVENTPOOL_BUCKETS];
+
+	EventPoolLocal() { for (int c=0; c<EVENTPOOL_BUCKETS; c++) head[c] = nullptr; }
+	~EventPoolLocal()
+	{
+		 //hand any cached blocks back for other threads to use
+		for (int c=0; c<EVENTPOOL_BUCKETS; c++) {
+			while (head[c]) {
+				EventPoolBlock *block = head[c];
+				head[c] = block->next;
+				event_pool_push(c, block);
+			}
+		}
+	}
+};
+
+static thread_local EventPoolLocal event_pool_local;
+
+//! Bucket for a size, or -1 if size is too large to pool.
+static inline int event_pool_bucket(std::size_t size)
+{
+	std::size_t bucket = (size + EVENTPOOL_GRAIN-1) / EVENTPOOL_GRAIN - 1;
+	return bucket < EVENTPOOL_BUCKETS ? (int)bucket : -1;
+}
+
+/*! Allocate from a per size free list. See EventDataPoolAllocations().
+ */
+void *EventData::operator new(std::size_t size)
+{
+	int bucket = event_pool_bucket(size);
+	if (bucket < 0) return ::operator new(size);
+
+	EventPoolBlock *&local = event_pool_local.head[bucket];
+	if (!local) {
+		 //grab everything other threads have freed so far
+		EventPoolBlock *list = event_pool[bucket].head.exchange(nullptr, std::memory_order_acquire);
+		int n = 0;
+		for (EventPoolBlock *b = list; b; b = b->next) n++;
+		if (n) event_pool[bucket].count.fetch_sub(n, std::memory_order_relaxed);
+		local = list;
+	}
+
+	if (local) {
+		EventPoolBlock *block = local;
+		local = block->next;
+		return block;
+	}
+
+	event_pool_allocations.fetch_add(1, std::memory_order_relaxed);
+	return ::operator new((bucket+1) * EVENTPOOL_GRAIN);
+}
+
+/*! Return the block to its free list, or to the heap if that free list is already large.
+ */
+void EventData::operator delete(void *p, std::size_t size)
+{
+	if (!p) return;
+	int bucket = event_pool_bucket(size);
+	if (bucket < 0 || event_pool[bucket].count.load(std::memory_order_relaxed) >= EVENTPOOL_MAX_FREE) {
+		::operator delete(p);
+		return;
+	}
+	event_pool_push(bucket, static_cast<EventPoolBlock*>(p));
+}
+
+/*! Return how many EventData blocks have been allocated from the heap so far. Once an application
+ * reaches a steady state of events, this should stop increasing.
+ */
+long EventDataPoolAllocations()
+{
+	return event_pool_allocations.load(std::memory_order_relaxed);
+}
+
+//! Return the lark id of mes, or 0 if mes has never been interned.
+/*! This is data->message_id when mes is data's own send_message, as it is when anXApp delivers
+ * events, so usually no lookup is needed. Otherwise mes is only looked up, never added, so that
+ * arbitrary message strings do not pile up in the lark table. Compare the result with
+ * EventMessageIs(), which falls back to comparing strings when the id is 0.
+ */
+int EventMessageId(const EventData *data, const char *mes)
+{
+	if (data && data->message_id && mes == data->send_message) return data->message_id;
+	return lark_id_from_str(mes, 0);
+}
+
+//! Whether a message is the one with lark_id, usually LARK("somemessage").
+/*! mes_id should be from EventMessageId(mes). When it is 0, mes was not interned at the time,
+ * but lark_id may have been added since, so the strings are compared instead.
+ */
+bool EventMessageIs(int mes_id, const char *mes, int lark_id)
+{
+	if (mes_id) return mes_id == lark_id;
+	return mes && !strcmp(mes, lark_str_from_id(lark_id));
+}
+
 
 //---------------------------- RefCountedEventData ----------------------------
 /*! \class RefCountedEventData
@@ -247,6 +402,11 @@ InOutData::InOutData(LaxEventType ntype)
  *
  * For LAX_onMouseMove, button should be ignored.
  *
+ * When several LAX_onMouseMove events for the same device and window are queued up,
+ * anXApp merges them into the newest one with Absorb(). The position, pressure, tilt
+ * and time of the older ones are kept in history, oldest first. Windows get at these through
+ * LaxMouse::MotionHistory() while handling MouseMove().
+ *
  * \todo implement adequate controls for retrieving attached valuator data like pressure, etc.
  */
 
@@ -259,11 +419,49 @@ MouseEventData::MouseEventData(LaxEventType ntype)
 	pressure(1),
 	tilt(0),
 	depth(0),
-	modifiers(0)
+	tilty(0),
+	modifiers(0),
+	target(NULL),
+	device(NULL),
+	history(NULL),
+	history_n(0),
+	history_max(0)
 { type = ntype; }
 
 MouseEventData::~MouseEventData()
-{}
+{
+	delete[] history;
+}
+
+/*! Take the history of older, plus older's own sample, onto the front of our history.
+ * older is not deleted here.
+ */
+void MouseEventData::Absorb(MouseEventData *older)
+{
+	int n = older->history_n + 1 + history_n;
+	if (n > history_max) {
+		int newmax = (n < 8 ? 8 : 2*n);
+		MotionSample *nh = new MotionSample[newmax];
+		if (history_n) memcpy(nh + older->history_n+1, history, history_n*sizeof(MotionSample));
+		delete[] history;
+		history = nh;
+		history_max = newmax;
+	} else if (history_n) {
+		memmove(history + older->history_n+1, history, history_n*sizeof(MotionSample));
+	}
+
+	if (older->history_n) memcpy(history, older->history, older->history_n*sizeof(MotionSample));
+
+	MotionSample &s = history[older->history_n];
+	s.x        = older->x;
+	s.y        = older->y;
+	s.pressure = older->pressure;
+	s.tiltx    = older->tilt;
+	s.tilty    = older->tilty;
+	s.time     = older->xlib_time;
+
+	history_n = n;
+}
 
 
 //-------------------------- KeyEventData
@@ -32,9 +32,11 @@
 
 
 #include <sys/times.h>
+#include <cstddef>
 
 #include <lax/anobject.h>
 #include <lax/laxdevices.h>
+#include <lax/lark.h>
 
 
 namespace Laxkit {
@@ -106,7 +108,8 @@ class EventData
 	LaxEventType type;
 	unsigned long subtype;
 	int usertype;
-	char *send_message;
+	const char *send_message; //the lark string of message_id, not owned. Change with SetMessage()
+	int message_id; //lark id of send_message, or 0
 
 	unsigned long from; //EventReceiver object_id
 	unsigned long to;
@@ -122,8 +125,17 @@ class EventData
 	EventData(const char *message,  unsigned long fromwindow=0, unsigned long towindow=0);
 	EventData(LaxEventType message, unsigned long fromwindow=0, unsigned long towindow=0);
 	virtual ~EventData();
+	void SetMessage(const char *message);
+
+	 //pooled allocation for EventData and all its subclasses
+	static void *operator new(std::size_t size);
+	static void operator delete(void *p, std::size_t size);
 };
 
+long EventDataPoolAllocations();
+int EventMessageId(const EventData *data, const char *mes);
+bool EventMessageIs(int mes_id, const char *mes, int lark_id);
+
 #ifdef _LAX_PLATFORM_XLIB
 //-------------------------- XEventData
 class XEventData : public EventData
@@ -184,19 +196,32 @@ typedef InOutData FocusChangeData;
 typedef InOutData EnterExitData;
 
 //-------------------------- ButtonEventData
+struct MotionSample
+{
+	double x,y;
+	double pressure, tiltx, tilty;
+	unsigned long time; //xlib_time of the original event
+};
+
 class MouseEventData : public EventData
 {
  public:
 	int x,y;
 	int button, count, size;
 	double pressure, tilt, depth;
+	double tilty; //tilt is x tilt
 	unsigned int modifiers; //of paired keyboard, if any
 
 	anXWindow *target;
 	LaxMouse *device;
 
+	 //older motion merged into this one, oldest first, see anXApp::coalesceMotion()
+	MotionSample *history;
+	int history_n, history_max;
+
 	MouseEventData(LaxEventType ntype);
 	virtual ~MouseEventData();
+	virtual void Absorb(MouseEventData *older);
 };
 
 //-------------------------- KeyEventData
@@ -1141,7 +1141,7 @@ int FontDialog::send()
 	if (currentfont<0) FindFont();
 
 	StrsEventData *s=new StrsEventData;
-	s->send_message=newstr(win_sendthis);
+	s->SetMessage(win_sendthis);
 	s->to=win_owner;
 	s->from=object_id;
 
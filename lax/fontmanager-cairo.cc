@@ -265,6 +265,7 @@ LaxFontCairo::~LaxFontCairo()
 {
 	DBG cerr <<"LaxFontCairo destructor..."<<endl;
 
+	CairoTextCache::Default()->ForgetFont(object_id);
 	if (scaledfont) cairo_scaled_font_destroy(scaledfont);
 	if (font) cairo_font_face_destroy(font);
 	if (options) cairo_font_options_destroy(options);
@@ -386,6 +387,7 @@ int LaxFontCairo::SetFromFile(const char *nfile, const char *nfamily, const char
 
 
 	 //delete old info if any
+	if (font) CairoTextCache::Default()->ForgetFont(object_id);
 	if (scaledfont) cairo_scaled_font_destroy(scaledfont);
 	if (font) cairo_font_face_destroy(font);
 	if (options) cairo_font_options_destroy(options);
@@ -436,19 +438,26 @@ double LaxFontCairo::Extent(const char *str,int len)
 	if (!str) return 0;
 	if (len<0) len=strlen(str);
 
+	CairoTextKey key(this, font, textheight(), nullptr, CAIRO_SURFACE_TYPE_IMAGE, str, len);
+	cairo_text_extents_t extent;
+	if (CairoTextCache::Default()->Extents(key, &extent, nullptr)) return extent.x_advance;
+
 	cairo_surface_t * ref_surface=cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1,1); 
 	cairo_t *cr=cairo_create(ref_surface);
 
 	cairo_set_scaled_font(cr, scaledfont);
 	//cairo_set_font_size(cr, _textheight/height_over_M);
  
-	cairo_text_extents_t extent;
 	char buffer[len+1];
     memcpy(buffer,str,len);
     buffer[len]='\0';
 
     cairo_text_extents(cr, buffer, &extent);
 
+	cairo_font_extents_t fextents;
+	cairo_font_extents(cr, &fextents);
+	CairoTextCache::Default()->Add(key, &extent, &fextents, nullptr, 0);
+
 	cairo_surface_destroy(ref_surface);
 	cairo_destroy(cr);
     
@@ -513,6 +522,288 @@ double LaxFontCairo::contextcharwidth(char *start,char *pos,int real,double *wid
 }
 
 
+//---------------------------- CairoTextCache -------------------------------
+
+/*! \class CairoTextKey
+ * \brief What CairoTextCache finds runs of text by.
+ *
+ * str is not copied, so the key is only good while str is.
+ */
+
+/*! m is the xx, yx, xy, yy of the cairo transform the text is measured in, or NULL for identity.
+ * surface_type is a cairo_surface_type_t.
+ */
+CairoTextKey::CairoTextKey(LaxFont *font, cairo_font_face_t *nface, double nsize, const double *m, int nsurface_type, const char *nstr, int nlen)
+{
+	font_id = (font ? font->object_id : 0);
+	face = nface;
+	size = nsize;
+	if (m) memcpy(matrix, m, 4*sizeof(double));
+	else { matrix[0] = matrix[3] = 1; matrix[1] = matrix[2] = 0; }
+	surface_type = nsurface_type;
+	str = nstr;
+	len = nlen;
+
+	 //FNV-1a over the string, then everything else
+	unsigned int h = 2166136261u;
+	for (int c=0; c<len; c++) h = (h ^ (unsigned char)str[c]) * 16777619u;
+	const unsigned char *p = (const unsigned char *)matrix;
+	for (unsigned int c=0; c<sizeof(matrix); c++) h = (h ^ p[c]) * 16777619u;
+	p = (const unsigned char *)&size;
+	for (unsigned int c=0; c<sizeof(size); c++) h = (h ^ p[c]) * 16777619u;
+	h = (h ^ (unsigned int)font_id) * 16777619u;
+	h = (h ^ (unsigned int)((unsigned long)face >> 4)) * 16777619u;
+	h = (h ^ surface_type) * 16777619u;
+	hash = h;
+}
+
+
+//! One cached run of CairoTextCache.
+class CairoTextRun
+{
+  public:
+	CairoTextRun *next_in_bucket;
+	CairoTextRun *prev, *next; //older and newer
+	unsigned int hash;
+	unsigned long font_id;
+	cairo_font_face_t *face;
+	double size;
+	double matrix[4];
+	int surface_type;
+	char *str;
+	int len;
+
+	cairo_text_extents_t extents;
+	cairo_font_extents_t font_extents;
+	cairo_glyph_t *glyphs; //positioned from 0,0, or NULL if only extents have been needed
+	int numglyphs;
+
+	CairoTextRun(const CairoTextKey &key) {
+		next_in_bucket = prev = next = nullptr;
+		hash = key.hash;
+		font_id = key.font_id;
+		face = key.face;
+		size = key.size;
+		memcpy(matrix, key.matrix, sizeof(matrix));
+		surface_type = key.surface_type;
+		str = newnstr(key.str, key.len);
+		len = key.len;
+		glyphs = nullptr;
+		numglyphs = 0;
+	}
+	~CairoTextRun() {
+		delete[] str;
+		delete[] glyphs;
+	}
+	bool Matches(const CairoTextKey &key) {
+		return hash == key.hash && len == key.len && font_id == key.font_id && face == key.face
+			&& size == key.size && surface_type == key.surface_type
+			&& !memcmp(matrix, key.matrix, sizeof(matrix)) && !memcmp(str, key.str, len);
+	}
+};
+
+
+/*! \class CairoTextCache
+ * \brief Least recently used cache of text extents and glyph runs.
+ *
+ * DisplayerCairo::textextent() and textout_line(), and LaxFontCairo::Extent(), get the metrics of
+ * each string from here, measuring with cairo only the first time a string is seen with a particular font,
+ * size, and transform. textout_line() also keeps the glyphs, so redrawing the same text skips turning
+ * utf8 into glyphs. Changing any of those is a different key, so nothing is ever stale. Fonts
+ * call ForgetFont() when they change or are destroyed, so their runs do not just sit there.
+ *
+ * Default() is shared by all displayers, and is safe to use from any thread.
+ */
+
+CairoTextCache::CairoTextCache(int nmax)
+{
+	max_runs = (nmax > 0 ? nmax : CAIRO_TEXT_CACHE_SIZE);
+	num_runs = 0;
+	num_hits = num_misses = 0;
+	oldest = newest = nullptr;
+
+	 //keep buckets about half full when full
+	numbuckets = 64;
+	while (numbuckets < 2*max_runs) numbuckets *= 2;
+	buckets = new CairoTextRun*[numbuckets];
+	memset(buckets, 0, numbuckets*sizeof(CairoTextRun*));
+}
+
+CairoTextCache::~CairoTextCache()
+{
+	Clear();
+	delete[] buckets;
+}
+
+//! Return the run for key, or nullptr. Must have the mutex.
+CairoTextRun *CairoTextCache::find(const CairoTextKey &key)
+{
+	for (CairoTextRun *run = buckets[key.hash & (numbuckets-1)]; run; run = run->next_in_bucket) {
+		if (run->Matches(key)) return run;
+	}
+	return nullptr;
+}
+
+//! Make run the newest. Must have the mutex.
+void CairoTextCache::touch(CairoTextRun *run)
+{
+	if (run == newest) return;
+
+	 //unlink
+	if (run->prev) run->prev->next = run->next;
+	if (run->next) run->next->prev = run->prev;
+	if (oldest == run) oldest = run->next;
+
+	 //add as newest
+	run->prev = newest;
+	run->next = nullptr;
+	if (newest) newest->next = run;
+	newest = run;
+	if (!oldest) oldest = run;
+}
+
+//! Unlink and delete run. Must have the mutex.
+void CairoTextCache::remove(CairoTextRun *run)
+{
+	CairoTextRun **r = &buckets[run->hash & (numbuckets-1)];
+	while (*r != run) r = &(*r)->next_in_bucket;
+	*r = run->next_in_bucket;
+
+	if (run->prev) run->prev->next = run->next;
+	else oldest = run->next;
+	if (run->next) run->next->prev = run->prev;
+	else newest = run->prev;
+
+	delete run;
+	num_runs--;
+}
+
+/*! If key is known, put its extents and font extents in extents and fextents, either of which
+ * can be null, and return true. Else return false.
+ */
+bool CairoTextCache::Extents(const CairoTextKey &key, cairo_text_extents_t *extents, cairo_font_extents_t *fextents)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	CairoTextRun *run = find(key);
+	if (!run) {
+		num_misses++;
+		return false;
+	}
+	num_hits++;
+	touch(run);
+	if (extents) *extents = run->extents;
+	if (fextents) *fextents = run->font_extents;
+	return true;
+}
+
+/*! If key has glyphs, copy them to glyphs, reallocating if numalloc is not enough, set extents if nonnull,
+ * and return the number of glyphs. Return -1 if there are no glyphs for key yet.
+ */
+int CairoTextCache::Glyphs(const CairoTextKey &key, cairo_glyph_t *&glyphs, unsigned int &numalloc, cairo_text_extents_t *extents)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	CairoTextRun *run = find(key);
+	if (!run || !run->glyphs) {
+		num_misses++;
+		return -1;
+	}
+	num_hits++;
+	touch(run);
+
+	if ((unsigned int)run->numglyphs > numalloc) {
+		delete[] glyphs;
+		numalloc = run->numglyphs + 10;
+		glyphs = new cairo_glyph_t[numalloc];
+	}
+	memcpy(glyphs, run->glyphs, run->numglyphs * sizeof(cairo_glyph_t));
+	if (extents) *extents = run->extents;
+	return run->numglyphs;
+}
+
+/*! Remember the metrics of key, and its glyphs if glyphs is not null. If key is already known,
+ * it is updated, which is how glyphs get added to runs that only had extents.
+ * Strings longer than CAIRO_TEXT_CACHE_MAX_LEN bytes are ignored, as they are unlikely to repeat.
+ * If this makes the cache too big, the least recently used runs are removed.
+ */
+void CairoTextCache::Add(const CairoTextKey &key, const cairo_text_extents_t *extents, const cairo_font_extents_t *fextents,
+						 const cairo_glyph_t *glyphs, int numglyphs)
+{
+	if (key.len > CAIRO_TEXT_CACHE_MAX_LEN) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	CairoTextRun *run = find(key);
+	if (!run) {
+		run = new CairoTextRun(key);
+		CairoTextRun **bucket = &buckets[key.hash & (numbuckets-1)];
+		run->next_in_bucket = *bucket;
+		*bucket = run;
+		num_runs++;
+	}
+	touch(run);
+
+	run->extents = *extents;
+	run->font_extents = *fextents;
+	if (glyphs) {
+		delete[] run->glyphs;
+		run->glyphs = new cairo_glyph_t[numglyphs > 0 ? numglyphs : 1];
+		memcpy(run->glyphs, glyphs, numglyphs * sizeof(cairo_glyph_t));
+		run->numglyphs = numglyphs;
+	}
+
+	while (num_runs > max_runs) remove(oldest);
+}
+
+//! Remove all runs of the LaxFont with object_id font_id.
+void CairoTextCache::ForgetFont(unsigned long font_id)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	CairoTextRun *run = oldest, *next;
+	while (run) {
+		next = run->next;
+		if (run->font_id == font_id) remove(run);
+		run = next;
+	}
+}
+
+void CairoTextCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	while (oldest) remove(oldest);
+}
+
+//! Set how many runs to keep, removing the oldest if there are more already.
+void CairoTextCache::SetMax(int nmax)
+{
+	if (nmax <= 0) nmax = CAIRO_TEXT_CACHE_SIZE;
+	std::lock_guard<std::mutex> lock(mutex);
+	max_runs = nmax;
+	while (num_runs > max_runs) remove(oldest);
+}
+
+int CairoTextCache::NumRuns()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return num_runs;
+}
+
+//! Lookups that found something and that did not, since the cache was created.
+void CairoTextCache::Stats(long *hits, long *misses)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (hits) *hits = num_hits;
+	if (misses) *misses = num_misses;
+}
+
+/*! The cache shared by all DisplayerCairo and LaxFontCairo objects. It is never deleted, since
+ * fonts might still be forgetting things during static destruction.
+ */
+CairoTextCache *CairoTextCache::Default()
+{
+	static CairoTextCache *cache = new CairoTextCache();
+	return cache;
+}
+
+
 //--------------------------- FontManagerCairo ------------------------------------------
 
 
@@ -34,6 +34,8 @@
 
 #include <cairo/cairo-xlib.h>
 
+#include <mutex>
+
 
 namespace Laxkit {
 
@@ -69,6 +71,60 @@ class LaxFontCairo : public LaxFont
 };
 
 
+//---------------------------- CairoTextCache -------------------------------
+
+#define CAIRO_TEXT_CACHE_SIZE 4096 //default number of runs to keep
+#define CAIRO_TEXT_CACHE_MAX_LEN 256 //longer strings are not cached
+
+class CairoTextKey
+{
+  public:
+	unsigned long font_id; //object_id of the LaxFont
+	cairo_font_face_t *face;
+	double size;
+	double matrix[4]; //scale, rotation and skew of the cairo transform
+	int surface_type; //metrics hinting can depend on the kind of surface
+	const char *str;
+	int len;
+	unsigned int hash;
+
+	CairoTextKey(LaxFont *font, cairo_font_face_t *nface, double nsize, const double *m, int nsurface_type, const char *nstr, int nlen);
+};
+
+class CairoTextRun;
+
+class CairoTextCache
+{
+  protected:
+	std::mutex mutex;
+	CairoTextRun **buckets;
+	int numbuckets;
+	CairoTextRun *oldest, *newest;
+	int num_runs, max_runs;
+	long num_hits, num_misses;
+
+	CairoTextRun *find(const CairoTextKey &key);
+	void touch(CairoTextRun *run);
+	void remove(CairoTextRun *run);
+
+  public:
+	CairoTextCache(int nmax = CAIRO_TEXT_CACHE_SIZE);
+	virtual ~CairoTextCache();
+
+	virtual bool Extents(const CairoTextKey &key, cairo_text_extents_t *extents, cairo_font_extents_t *fextents);
+	virtual int Glyphs(const CairoTextKey &key, cairo_glyph_t *&glyphs, unsigned int &numalloc, cairo_text_extents_t *extents);
+	virtual void Add(const CairoTextKey &key, const cairo_text_extents_t *extents, const cairo_font_extents_t *fextents,
+					 const cairo_glyph_t *glyphs, int numglyphs);
+	virtual void ForgetFont(unsigned long font_id);
+	virtual void Clear();
+	virtual void SetMax(int nmax);
+	virtual int NumRuns();
+	virtual void Stats(long *hits, long *misses);
+
+	static CairoTextCache *Default();
+};
+
+
 //---------------------------- FontManager -------------------------------
 class FontManagerCairo : public FontManager, protected RefPtrStack<LaxFont>
 {
@@ -1123,6 +1123,7 @@ int FontManager::DumpInFontList(const char *file, ErrorLog *log)
 
 
 	Attribute att;
+	att.UseArena();
 	att.dump_in(file);
 
 	for (int c=0; c<att.attributes.n; c++) {
@@ -29,6 +29,7 @@
 using namespace Laxkit;
 
 
+#include <cmath>
 #include <iostream>
 using namespace std;
 #define DBG 
@@ -417,6 +418,21 @@ Laxkit::anXWindow *anInterface::CurrentWindow(Laxkit::anXWindow *ncur)
 	return curwindow=ncur;
 }
 
+/*! Ask curwindow to redraw only screenbox (in curwindow coordinates), plus pad pixels on each side,
+ * rather than setting needtodraw. This is for things like a hovered handle, where the old and new
+ * handle areas are all that change. Note the whole viewport still gets redrawn, but clipped to the damage.
+ * If there is no curwindow, then needtodraw is set instead.
+ */
+void anInterface::Invalidate(const Laxkit::DoubleBBox &screenbox, double pad)
+{
+	if (screenbox.maxx < screenbox.minx || screenbox.maxy < screenbox.miny) return;
+	if (!curwindow) { needtodraw = 1; return; }
+
+	int x1 = floor(screenbox.minx - pad), y1 = floor(screenbox.miny - pad);
+	int x2 = ceil (screenbox.maxx + pad), y2 = ceil (screenbox.maxy + pad);
+	curwindow->Invalidate(x1,y1, x2-x1+1, y2-y1+1);
+}
+
 /*! Will not add ch if child!=nullptr.
  * If addbefore!=0, then add at index-1 in viewport->interfaces. Else after *this.
  *
@@ -110,6 +110,7 @@ class anInterface : virtual public Laxkit::EventReceiver,
 
 	virtual int Needtodraw() { return needtodraw; }
 	virtual int Needtodraw(int n) { return needtodraw|=n; }
+	virtual void Invalidate(const Laxkit::DoubleBBox &screenbox, double pad=0);
 	
 	 // return 0 if interface absorbs event, MouseMove never absorbs: must return 1;
 	virtual int LBDown(int x,int y,unsigned int state,int count, const Laxkit::LaxMouse *d) { return 1; }
@@ -40,6 +40,9 @@
 using namespace Laxkit;
 
 
+#include <algorithm>
+#include <cmath>
+
 #include <iostream>
 using namespace std;
 #define DBG 
@@ -440,6 +443,7 @@ void VoronoiData::RelaxBarycenter(int iters, double strength, DoubleBBox box)
 			if (l < smallestdist) smallestdist = l;
 			points.e[c]->p += v * strength;
 		}
+		InvalidateIndex();
 		RebuildVoronoi(true);
 	}
 }
@@ -545,57 +549,11 @@ void VoronoiData::Triangulate()
 	if (points.n<3) return;
 
 	triangles.flush_n();
-	triangles.Allocate(3*points.n);
-	//triangles.flush();
-	//triangles.Allocate(3*points.n);
+	triangles.Allocate(2*points.n);
 
+	 //this also sets triangle links
 	DelaunayTriangulate(points.e,points.n, triangles.e,&triangles.n);
 	FindBBox();
-
-	 //reset triangle links
-	for (int c=0; c<triangles.n; c++) {
-		triangles.e[c].t[0]=triangles.e[c].t[1]=triangles.e[c].t[2]=-1;
-	}
-
-	 //find triangle links
-	IndexTriangle *tri;
-	int e;
-	for (int c=0; c<triangles.n; c++) {
-		tri=&triangles.e[c];
-
-		 //find triangle connections, the triangle on other side of edges
-		if (tri->t[0]==-1) {
-			for (int c2=c+1; c2<triangles.n; c2++) {
-				e=triangles.e[c2].HasCCWEdge(tri->p1,tri->p2);
-				if (e) {
-					tri->t[0]=c2;
-					triangles.e[c2].t[e-1]=c;
-				}
-			}
-		}
-
-		 //find t2, the triangle on other side of p2-p3 edge
-		if (tri->t[1]==-1) {
-			for (int c2=c+1; c2<triangles.n; c2++) {
-				e=triangles.e[c2].HasCCWEdge(tri->p2,tri->p3);
-				if (e) {
-					tri->t[1]=c2;
-					triangles.e[c2].t[e-1]=c;
-				}
-			}
-		}
-
-		 //find t3, the triangle on other side of p3-p1 edge
-		if (tri->t[2]==-1) {
-			for (int c2=c+1; c2<triangles.n; c2++) {
-				e=triangles.e[c2].HasCCWEdge(tri->p3,tri->p1);
-				if (e) {
-					tri->t[2]=c2;
-					triangles.e[c2].t[e-1]=c;
-				}
-			}
-		}
-	}
 }
 
 /*! If triangulate_also, call Triangulate() first. Otherwise, assume that has already been called,
@@ -620,6 +578,15 @@ void VoronoiData::RebuildVoronoi(bool triangulate_also)
 	int ntri, curtri;
 	flatpoint v;
 
+	 //one triangle for each point to start walking from
+	int *pointtri=new int[points.n];
+	for (int c=0; c<points.n; c++) pointtri[c]=-1;
+	for (int c=triangles.n-1; c>=0; c--) {
+		pointtri[triangles.e[c].p1]=c;
+		pointtri[triangles.e[c].p2]=c;
+		pointtri[triangles.e[c].p3]=c;
+	}
+
 	for (int c=0; c<points.n; c++) {
 		region            = &regions.e[c];
 		region->point     = points.e[c]->p;
@@ -627,18 +594,11 @@ void VoronoiData::RebuildVoronoi(bool triangulate_also)
 		region->tris.flush();
 
 		// find a triangle that has the point
-		pos=-1;
-		for (int c2=0; c2<triangles.n; c2++) {
-			pos=triangles.e[c2].Has(c);
-			if (pos) {
-				tri=&triangles.e[c2];
-				region->tris.push(c2);
-				first=c2;
-				curtri=c2;
-				break;
-			}
-		}
-		if (pos<=0) break; //error! no triangle has point!
+		if (pointtri[c]<0) continue; //no triangle has point, such as a duplicate point
+		first=curtri=pointtri[c];
+		tri=&triangles.e[first];
+		pos=tri->Has(c);
+		region->tris.push(first);
 
 		 //find next triangles, going clockwise
 		while (1) {
@@ -707,6 +667,8 @@ void VoronoiData::RebuildVoronoi(bool triangulate_also)
 
 		//*****
 	}
+
+	delete[] pointtri;
 }
 
 //int VoronoiData::FindNextTri(int p1,int p2)
@@ -1337,6 +1299,7 @@ int DelaunayInterface::MouseMove(int x,int y,unsigned int state, const Laxkit::L
 
 	flatpoint d=data->transformPointInverse(screentoreal(x,y))-data->transformPointInverse(screentoreal(lx,ly));
 	data->points.e[curpoint]->p += d;
+	data->InvalidateIndex();
 	Triangulate();
 	data->touchContents();
 
@@ -2040,23 +2003,22 @@ void DelaunayInterface::Triangulate()
 //-----------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------
 //-------------------- Delaunay Triangulation ---------------------------------------------
-//---------------- Adapted from Paul Bourke's C implementation ----------------------------
+//-------------- Sweep hull, adapted from Mapbox's Delaunator ----------------------------
 //-----------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------
 //-----------------------------------------------------------------------------------------
 
 
+#define DELAUNAY_EPSILON    (2.220446049250313e-16)
+#define DELAUNAY_EDGE_STACK 512
 
-//forward declarations...
-int CompareXCoord(const void *v1,const void *v2);
-int CircumCircle(double xp,double yp,
-				 double x1,double y1,double x2,double y2,double x3,double y3,
-				 double *xc,double *yc,double *rsqr);
-int Triangulate(int nv,flatpoint *pxyz,IndexTriangle *v,int *ntri);
 
+//forward declarations...
+int Triangulate(int nv, const flatpoint *pts, IndexTriangle *tri_ret, int *ntri_ret);
 
 
-/*! tri_ret should be large enough to hold 3*nv triangles. The actual number of triangles is returned in n_ret.
+/*! tri_ret should be large enough to hold 2*nv triangles. The actual number of triangles is returned in n_ret.
+ * Triangle links (IndexTriangle::t) and circumcenters are filled in too.
  *
  * Return 0 for success, 1 for not enough points (need more than 2).
  *
@@ -2067,368 +2029,444 @@ int Triangulate(int nv,flatpoint *pxyz,IndexTriangle *v,int *ntri);
  */
 int DelaunayTriangulate(flatpoint *pts, int nv, IndexTriangle *tri_ret, int *ntri_ret)
 {
-   if (nv < 3) return 1;
-
-   flatpoint p[nv+3];
-   for (int c=0; c<nv; c++) pts[c].info=c;
-   memcpy(p,pts, nv*sizeof(flatpoint));
-
-    //need to order points by x
-   qsort(p,nv,sizeof(flatpoint),CompareXCoord);
-   Triangulate(nv,p, tri_ret,ntri_ret);
-
-    //need to convert indices to what they were before qsort
-   for (int c=0; c<*ntri_ret; c++) {
-	   tri_ret[c].p1 = p[tri_ret[c].p1].info;
-	   tri_ret[c].p2 = p[tri_ret[c].p2].info;
-	   tri_ret[c].p3 = p[tri_ret[c].p3].info;
-   }
+	if (nv < 3) return 1;
 
+	for (int c=0; c<nv; c++) pts[c].info=c;
+	Triangulate(nv,pts, tri_ret,ntri_ret);
 
-   DBG cerr << "DelaunayTriangulate: Formed "<<(*ntri_ret)<<" triangles"<<endl;
-   return 0;
+	DBG cerr << "DelaunayTriangulate: Formed "<<(*ntri_ret)<<" triangles"<<endl;
+	return 0;
 }
 
 int DelaunayTriangulate(PointSet::PointObj **pts, int nv, IndexTriangle *tri_ret, int *ntri_ret)
 {
 	if (nv < 3) return 1;
 
-	flatpoint p[nv+3];
-	for (int c=0; c<nv; c++) {
-		p[c] = pts[c]->p;
-		p[c].info = c;
-	}
+	flatpoint *p = new flatpoint[nv];
+	for (int c=0; c<nv; c++) p[c] = pts[c]->p;
 
-	//need to order points by x
-	qsort(p,nv,sizeof(flatpoint),CompareXCoord);
 	Triangulate(nv,p, tri_ret,ntri_ret);
-
-	//need to convert indices to what they were before qsort
-	for (int c=0; c<*ntri_ret; c++) {
-	   tri_ret[c].p1 = p[tri_ret[c].p1].info;
-	   tri_ret[c].p2 = p[tri_ret[c].p2].info;
-	   tri_ret[c].p3 = p[tri_ret[c].p3].info;
-	}
+	delete[] p;
 
 	DBG cerr << "DelaunayTriangulate: Formed "<<(*ntri_ret)<<" triangles"<<endl;
 	return 0;
 }
 
 
+//--------------------------
 
-int CompareXCoord(const void *v1,const void *v2)
+/*! True if r,q,p are counterclockwise, with a relative tolerance on the sign.
+ */
+static bool DelaunayOrient(const flatpoint &r, const flatpoint &q, const flatpoint &p)
 {
-   const flatpoint *p1,*p2;
-   p1 = (const flatpoint*)v1;
-   p2 = (const flatpoint*)v2;
-   if (p1->x < p2->x)
-      return(-1);
-   else if (p1->x > p2->x)
-      return(1);
-   else 
-      return(0); 
-}       
+	double l, rr, sign = 0;
 
+	l  = (r.y - p.y) * (q.x - p.x);
+	rr = (r.x - p.x) * (q.y - p.y);
+	if (fabs(l - rr) >= 3.3306690738754716e-16 * fabs(l + rr)) sign = l - rr;
 
-//--------------------------
+	if (sign == 0) {
+		l  = (q.y - r.y) * (p.x - r.x);
+		rr = (q.x - r.x) * (p.y - r.y);
+		if (fabs(l - rr) >= 3.3306690738754716e-16 * fabs(l + rr)) sign = l - rr;
+	}
+
+	if (sign == 0) {
+		l  = (p.y - q.y) * (r.x - q.x);
+		rr = (p.x - q.x) * (r.y - q.y);
+		if (fabs(l - rr) >= 3.3306690738754716e-16 * fabs(l + rr)) sign = l - rr;
+	}
+
+	return sign < 0;
+}
+
+/*! True if p is inside the circumcircle of clockwise triangle a,b,c.
+ */
+static bool DelaunayInCircle(const flatpoint &a, const flatpoint &b, const flatpoint &c, const flatpoint &p)
+{
+	double dx = a.x - p.x, dy = a.y - p.y;
+	double ex = b.x - p.x, ey = b.y - p.y;
+	double fx = c.x - p.x, fy = c.y - p.y;
+
+	double ap = dx * dx + dy * dy;
+	double bp = ex * ex + ey * ey;
+	double cp = fx * fx + fy * fy;
+
+	return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) + ap * (ex * fy - ey * fx) < 0;
+}
+
+/*! Return square of circumradius of a,b,c, or a huge number if they are collinear.
+ */
+static double DelaunayCircumradius(const flatpoint &a, const flatpoint &b, const flatpoint &c)
+{
+	double dx = b.x - a.x, dy = b.y - a.y;
+	double ex = c.x - a.x, ey = c.y - a.y;
+	double bl = dx * dx + dy * dy;
+	double cl = ex * ex + ey * ey;
+	double det = dx * ey - dy * ex;
+	if (det == 0) return HUGE_VAL;
+
+	double d = 0.5 / det;
+	double x = (ey * bl - dy * cl) * d;
+	double y = (dx * cl - ex * bl) * d;
+	double r = x * x + y * y;
+	return std::isfinite(r) ? r : HUGE_VAL;
+}
 
-class IndexEdge
+static flatpoint DelaunayCircumcenter(const flatpoint &a, const flatpoint &b, const flatpoint &c)
+{
+	double dx = b.x - a.x, dy = b.y - a.y;
+	double ex = c.x - a.x, ey = c.y - a.y;
+	double bl = dx * dx + dy * dy;
+	double cl = ex * ex + ey * ey;
+	double d = 0.5 / (dx * ey - dy * ex);
+
+	return flatpoint(a.x + (ey * bl - dy * cl) * d, a.y + (dx * cl - ex * bl) * d);
+}
+
+/*! Monotonic stand in for atan2, in range [0..1].
+ */
+static double DelaunayPseudoAngle(double dx, double dy)
+{
+	double p = dx / (fabs(dx) + fabs(dy));
+	return (dy > 0 ? 3 - p : 1 + p) / 4;
+}
+
+
+/*! Working state of Triangulate(). Triangles are stored as 3 consecutive vertex indices in triangles,
+ * and halfedges[e] is the opposite half edge of edge e, or -1. Edge e goes from triangles[e] to the next
+ * vertex of its triangle.
+ */
+class SweepHull
 {
   public:
-    int p1,p2;
+	const flatpoint *pts;
+	int n;
+
+	int *triangles;
+	int *halfedges;
+	int trianglesLen;
+
+	int *hullPrev;
+	int *hullNext;
+	int *hullTri; //edge of a hull triangle that lies along the hull, starting at hull vertex i
+	int *hullHash;
+	int hashSize;
+	int hullStart;
+	flatpoint center;
+
+	int edgeStack[DELAUNAY_EDGE_STACK];
+
+	SweepHull(const flatpoint *p, int nv);
+	~SweepHull();
+
+	int HashKey(const flatpoint &p) {
+		return (int)floor(DelaunayPseudoAngle(p.x - center.x, p.y - center.y) * hashSize) % hashSize;
+	}
+	void Link(int a, int b) {
+		halfedges[a] = b;
+		if (b != -1) halfedges[b] = a;
+	}
+	int AddTriangle(int i0, int i1, int i2, int a, int b, int c) {
+		int t = trianglesLen;
+		triangles[t]   = i0;
+		triangles[t+1] = i1;
+		triangles[t+2] = i2;
+		Link(t, a);
+		Link(t+1, b);
+		Link(t+2, c);
+		trianglesLen += 3;
+		return t;
+	}
+	int Legalize(int a);
+	void Run();
 };
 
+SweepHull::SweepHull(const flatpoint *p, int nv)
+{
+	pts = p;
+	n = nv;
+
+	int maxTriangles = (n > 2 ? 2*n - 5 : 1);
+	triangles = new int[3*maxTriangles];
+	halfedges = new int[3*maxTriangles];
+	trianglesLen = 0;
+
+	hashSize = (int)ceil(sqrt((double)n));
+	hullPrev = new int[n];
+	hullNext = new int[n];
+	hullTri  = new int[n];
+	hullHash = new int[hashSize];
+	hullStart = 0;
+}
 
-/*!
- *    Triangulation subroutine
- *    Takes as input NV vertices in array pxyz
- *    Returned is a list of ntri triangular faces in the array v
- *    These triangles are arranged in a consistent clockwise order.
- *    The triangle array 'v' should be malloced to 3 * nv
- *    The vertex array pxyz must be big enough to hold 3 more points
- *    The vertex array MUST be sorted in increasing x values say
- * 
- *   \code
- *    qsort(p,nv,sizeof(flatpoint),CompareXCoord);
- *       :
- *    int CompareXCoord(void *v1,void *v2)
- *    {
- *       flatpoint *p1,*p2;
- *       p1 = v1;
- *       p2 = v2;
- *       if (p1->x < p2->x)
- *          return(-1);
- *       else if (p1->x > p2->x)
- *          return(1);
- *       else
- *          return(0);
- *    }
- *   \endcode
+SweepHull::~SweepHull()
+{
+	delete[] triangles;
+	delete[] halfedges;
+	delete[] hullPrev;
+	delete[] hullNext;
+	delete[] hullTri;
+	delete[] hullHash;
+}
+
+/*! Flip edge a and its neighbors until they are all locally delaunay. Uses edgeStack in place of recursion.
+ * Returns the edge of a's triangle that follows a after any flips.
  */
-int Triangulate(int nv,flatpoint *pxyz,IndexTriangle *v,int *ntri)
+int SweepHull::Legalize(int a)
 {
-   int *complete = NULL;
-   IndexEdge *edges = NULL;
-   int nedge = 0;
-   int trimax,emax = 200;
-
-   int inside;
-   int i,j,k;
-   double xp,yp,x1,y1,x2,y2,x3,y3,xc,yc,r;
-   double xmin,xmax,ymin,ymax,xmid,ymid;
-   double dx,dy,dmax;
-
-
-   /* Allocate memory for the completeness list, flag for each triangle */
-   trimax = 4 * nv;
-   complete=new int[trimax];
-   if (!complete) return 1;
-
-   /* Allocate memory for the edge list */
-   edges = new IndexEdge[emax]; //reallocated below as needed
-   if (!edges) {
-	   delete[] complete;
-	   return 2;
-   }
-
-
-   /*
-      Find the maximum and minimum vertex bounds.
-      This is to allow calculation of the bounding triangle
-   */
-   xmin = pxyz[0].x;
-   ymin = pxyz[0].y;
-   xmax = xmin;
-   ymax = ymin;
-   for (i=1;i<nv;i++) {
-      if (pxyz[i].x < xmin) xmin = pxyz[i].x;
-      if (pxyz[i].x > xmax) xmax = pxyz[i].x;
-      if (pxyz[i].y < ymin) ymin = pxyz[i].y;
-      if (pxyz[i].y > ymax) ymax = pxyz[i].y;
-   }
-   dx = xmax - xmin;
-   dy = ymax - ymin;
-   dmax = (dx > dy) ? dx : dy;
-   xmid = (xmax + xmin) / 2.0;
-   ymid = (ymax + ymin) / 2.0;
-
-   /*
-      Set up the supertriangle
-      This is a triangle which encompasses all the sample points.
-      The supertriangle coordinates are added to the end of the
-      vertex list. The supertriangle is the first triangle in
-      the triangle list.
-   */
-   pxyz[nv+0].x = xmid - 20 * dmax;
-   pxyz[nv+0].y = ymid - dmax;
-   //pxyz[nv+0].z = 0.0;
-   pxyz[nv+1].x = xmid;
-   pxyz[nv+1].y = ymid + 20 * dmax;
-   //pxyz[nv+1].z = 0.0;
-   pxyz[nv+2].x = xmid + 20 * dmax;
-   pxyz[nv+2].y = ymid - dmax;
-   //pxyz[nv+2].z = 0.0;
-   v[0].p1 = nv;
-   v[0].p2 = nv+1;
-   v[0].p3 = nv+2;
-   complete[0] = false;
-   *ntri = 1;
-
-   /*
-      Include each point one at a time into the existing mesh
-   */
-   for (i=0; i<nv; i++) {
-
-      xp = pxyz[i].x;
-      yp = pxyz[i].y;
-      nedge = 0;
-
-      /*
-         Set up the edge buffer.
-         If the point (xp,yp) lies inside the circumcircle then the
-         three edges of that triangle are added to the edge buffer
-         and that triangle is removed.
-      */
-      for (j=0; j<(*ntri); j++) {
-         if (complete[j]) continue;
-
-         x1 = pxyz[v[j].p1].x;
-         y1 = pxyz[v[j].p1].y;
-         x2 = pxyz[v[j].p2].x;
-         y2 = pxyz[v[j].p2].y;
-         x3 = pxyz[v[j].p3].x;
-         y3 = pxyz[v[j].p3].y;
-         inside = CircumCircle(xp,yp,x1,y1,x2,y2,x3,y3,&xc,&yc,&r);
-         if (xc < xp && ((xp-xc)*(xp-xc)) > r)
-				complete[j] = true;
-
-		 v[j].circumcenter.x = xc;
-		 v[j].circumcenter.y = yc;
-
-         if (inside) {
-            /* Check that we haven't exceeded the edge list size */
-            if (nedge+3 >= emax) {
-               emax += 100;
-			   IndexEdge *newedges = new IndexEdge[emax];
-               if (!newedges) {
-				  delete[] edges; 
-				  delete[] complete;
-				  return 3;
-               }
-			   memcpy(newedges,edges, (emax-100)*sizeof(IndexEdge));
-			   delete[] edges;
-			   edges=newedges;
-            }
+	int i = 0;
+	int ar = 0;
+
+	while (true) {
+		int b = halfedges[a];
+
+		 /* if the pair of triangles doesn't satisfy the Delaunay condition
+		  * (p1 is inside the circumcircle of [p0, pl, pr]), flip them,
+		  * then do the same check/flip recursively for the new pair of triangles
+		  *
+		  *           pl                    pl
+		  *          /||\                  /  \
+		  *       al/ || \bl            al/    \a
+		  *        /  ||  \              /      \
+		  *       /  a||b  \    flip    /___ar___\
+		  *     p0\   ||   /p1   =>   p0\---bl---/p1
+		  *        \  ||  /              \      /
+		  *       ar\ || /br             b\    /br
+		  *          \||/                  \  /
+		  *           pr                    pr
+		  */
+		int a0 = a - a % 3;
+		ar = a0 + (a + 2) % 3;
+
+		if (b == -1) { // convex hull edge
+			if (i == 0) break;
+			a = edgeStack[--i];
+			continue;
+		}
 
-            edges[nedge+0].p1 = v[j].p1;
-            edges[nedge+0].p2 = v[j].p2;
-            edges[nedge+1].p1 = v[j].p2;
-            edges[nedge+1].p2 = v[j].p3;
-            edges[nedge+2].p1 = v[j].p3;
-            edges[nedge+2].p2 = v[j].p1;
-            nedge += 3;
-            v[j] = v[(*ntri)-1];
-            complete[j] = complete[(*ntri)-1];
-            (*ntri)--;
-            j--;
-         }
-      }
-
-      /*
-         Tag multiple edges
-         Note: if all triangles are specified anticlockwise then all
-               interior edges are opposite pointing in direction.
-      */
-      for (j=0; j<nedge-1; j++) {
-         for (k=j+1; k<nedge; k++) {
-            if ((edges[j].p1 == edges[k].p2) && (edges[j].p2 == edges[k].p1)) {
-               edges[j].p1 = -1;
-               edges[j].p2 = -1;
-               edges[k].p1 = -1;
-               edges[k].p2 = -1;
-            }
-            /* Shouldn't need the following, see note above */
-            if ((edges[j].p1 == edges[k].p1) && (edges[j].p2 == edges[k].p2)) {
-               edges[j].p1 = -1;
-               edges[j].p2 = -1;
-               edges[k].p1 = -1;
-               edges[k].p2 = -1;
-            }
-         }
-      }
-
-      /*
-         Form new triangles for the current point
-         Skipping over any tagged edges.
-         All edges are arranged in clockwise order.
-      */
-      for (j=0; j<nedge; j++) {
-         if (edges[j].p1 < 0 || edges[j].p2 < 0) continue;
-
-         if ((*ntri) >= trimax) {
-			delete[] edges;
-			delete[] complete;
-            return 4;
-         }
-
-         v[*ntri].p1 = edges[j].p1;
-         v[*ntri].p2 = edges[j].p2;
-         v[*ntri].p3 = i;
-
-		  //need to grab circumcenter, not necessary for delaunay triangles only
-         CircumCircle(0,0,
-				 pxyz[v[*ntri].p1].x,pxyz[v[*ntri].p1].y,
-				 pxyz[v[*ntri].p2].x,pxyz[v[*ntri].p2].y,
-				 pxyz[v[*ntri].p3].x,pxyz[v[*ntri].p3].y,
-				 &xc,&yc,&r);
-		 v[*ntri].circumcenter.x=xc;
-		 v[*ntri].circumcenter.y=yc;
-
-         complete[*ntri] = false;
-         (*ntri)++;
-      }
-   }
-
-   /*
-      Remove triangles with supertriangle vertices
-      These are triangles which have a vertex number greater than nv
-   */
-   for (i=0; i<(*ntri); i++) {
-      if (v[i].p1 >= nv || v[i].p2 >= nv || v[i].p3 >= nv) {
-         v[i] = v[(*ntri)-1];
-         (*ntri)--;
-         i--;
-      }
-   }
-
-
-   return 0;
+		int b0 = b - b % 3;
+		int al = a0 + (a + 1) % 3;
+		int bl = b0 + (b + 2) % 3;
+
+		int p0 = triangles[ar];
+		int pr = triangles[a];
+		int pl = triangles[al];
+		int p1 = triangles[bl];
+
+		if (DelaunayInCircle(pts[p0], pts[pr], pts[pl], pts[p1])) {
+			triangles[a] = p1;
+			triangles[b] = p0;
+
+			int hbl = halfedges[bl];
+
+			 //edge swapped on the other side of the hull (rare), fix the halfedge reference
+			if (hbl == -1) {
+				int e = hullStart;
+				do {
+					if (hullTri[e] == bl) {
+						hullTri[e] = a;
+						break;
+					}
+					e = hullPrev[e];
+				} while (e != hullStart);
+			}
+			Link(a, hbl);
+			Link(b, halfedges[ar]);
+			Link(ar, bl);
+
+			int br = b0 + (b + 1) % 3;
+			if (i < DELAUNAY_EDGE_STACK) edgeStack[i++] = br;
+
+		} else {
+			if (i == 0) break;
+			a = edgeStack[--i];
+		}
+	}
+
+	return ar;
 }
 
+void SweepHull::Run()
+{
+	 //bounds
+	double minx = pts[0].x, maxx = minx, miny = pts[0].y, maxy = miny;
+	for (int c=1; c<n; c++) {
+		if (pts[c].x < minx) minx = pts[c].x;
+		if (pts[c].x > maxx) maxx = pts[c].x;
+		if (pts[c].y < miny) miny = pts[c].y;
+		if (pts[c].y > maxy) maxy = pts[c].y;
+	}
+	flatpoint mid((minx + maxx) / 2, (miny + maxy) / 2);
+
+	 //seed point closest to the middle
+	int i0 = 0, i1 = -1, i2 = -1;
+	double mindist = HUGE_VAL, d;
+	for (int c=0; c<n; c++) {
+		d = (pts[c] - mid).norm2();
+		if (d < mindist) { i0 = c; mindist = d; }
+	}
+
+	 //point closest to the seed
+	mindist = HUGE_VAL;
+	for (int c=0; c<n; c++) {
+		if (c == i0) continue;
+		d = (pts[c] - pts[i0]).norm2();
+		if (d < mindist && d > 0) { i1 = c; mindist = d; }
+	}
+	if (i1 < 0) return; //all points the same
+
+	 //third point that makes the smallest circumcircle with the first two
+	double minradius = HUGE_VAL;
+	for (int c=0; c<n; c++) {
+		if (c == i0 || c == i1) continue;
+		double r = DelaunayCircumradius(pts[i0], pts[i1], pts[c]);
+		if (r < minradius) { i2 = c; minradius = r; }
+	}
+	if (minradius == HUGE_VAL) return; //all points collinear, no triangles
+
+	 //make the seed triangle clockwise
+	if (DelaunayOrient(pts[i0], pts[i1], pts[i2])) {
+		int t = i1;
+		i1 = i2;
+		i2 = t;
+	}
+
+	center = DelaunayCircumcenter(pts[i0], pts[i1], pts[i2]);
+
+	 //sweep points outward from the seed circumcenter
+	int *ids = new int[n];
+	double *dists = new double[n];
+	for (int c=0; c<n; c++) {
+		ids[c] = c;
+		dists[c] = (pts[c] - center).norm2();
+	}
+	std::sort(ids, ids+n, [dists](int a, int b) { return dists[a] < dists[b]; });
+
+	 //hull starts as the seed triangle
+	hullStart = i0;
+	hullNext[i0] = hullPrev[i2] = i1;
+	hullNext[i1] = hullPrev[i0] = i2;
+	hullNext[i2] = hullPrev[i1] = i0;
+
+	hullTri[i0] = 0;
+	hullTri[i1] = 1;
+	hullTri[i2] = 2;
+
+	for (int c=0; c<hashSize; c++) hullHash[c] = -1;
+	hullHash[HashKey(pts[i0])] = i0;
+	hullHash[HashKey(pts[i1])] = i1;
+	hullHash[HashKey(pts[i2])] = i2;
+
+	trianglesLen = 0;
+	AddTriangle(i0, i1, i2, -1, -1, -1);
+
+	flatpoint pp;
+	for (int k=0; k<n; k++) {
+		int i = ids[k];
+		const flatpoint &p = pts[i];
+
+		 //skip near duplicate points
+		if (k > 0 && fabs(p.x - pp.x) <= DELAUNAY_EPSILON && fabs(p.y - pp.y) <= DELAUNAY_EPSILON) continue;
+		pp = p;
+
+		 //skip seed triangle points
+		if (i == i0 || i == i1 || i == i2) continue;
+
+		 //find a visible edge on the convex hull using edge hash
+		int start = 0;
+		int key = HashKey(p);
+		for (int j=0; j<hashSize; j++) {
+			start = hullHash[(key + j) % hashSize];
+			if (start != -1 && start != hullNext[start]) break;
+		}
+
+		start = hullPrev[start];
+		int e = start, q;
+		while (q = hullNext[e], !DelaunayOrient(p, pts[e], pts[q])) {
+			e = q;
+			if (e == start) {
+				e = -1;
+				break;
+			}
+		}
+		if (e == -1) continue; //likely a near duplicate point, skip it
+
+		 //add the first triangle from the point
+		int t = AddTriangle(e, i, hullNext[e], -1, -1, hullTri[e]);
+
+		 //recursively flip triangles from the point until they satisfy the Delaunay condition
+		hullTri[i] = Legalize(t + 2);
+		hullTri[e] = t; //keep track of boundary triangles on the hull
+
+		 //walk forward through the hull, adding more triangles and flipping recursively
+		int nn = hullNext[e];
+		while (q = hullNext[nn], DelaunayOrient(p, pts[nn], pts[q])) {
+			t = AddTriangle(nn, i, q, hullTri[i], -1, hullTri[nn]);
+			hullTri[i] = Legalize(t + 2);
+			hullNext[nn] = nn; //mark as removed
+			nn = q;
+		}
+
+		 //walk backward from the other side, adding more triangles and flipping
+		if (e == start) {
+			while (q = hullPrev[e], DelaunayOrient(p, pts[q], pts[e])) {
+				t = AddTriangle(q, i, e, -1, hullTri[e], hullTri[q]);
+				Legalize(t + 2);
+				hullTri[q] = t;
+				hullNext[e] = e; //mark as removed
+				e = q;
+			}
+		}
 
-#define EPSILON (1e-10)
+		 //update the hull indices
+		hullStart = hullPrev[i] = e;
+		hullNext[e] = hullPrev[nn] = i;
+		hullNext[i] = nn;
 
+		 //save the two new edges in the hash table
+		hullHash[HashKey(p)] = i;
+		hullHash[HashKey(pts[e])] = e;
+	}
 
-/*
-   Return true if a point (xp,yp) is inside the circumcircle made up
-   of the points (x1,y1), (x2,y2), (x3,y3)
-   The circumcircle centre is returned in (xc,yc) and the radius r
-   NOTE: A point on the edge is inside the circumcircle
-*/
-int CircumCircle(double xp,double yp,
-				 double x1,double y1,double x2,double y2,double x3,double y3,
-				 double *xc,double *yc,double *rsqr)
+	delete[] ids;
+	delete[] dists;
+}
+
+
+/*! Triangulate with a sweep hull (after Mapbox's Delaunator): points are added in order of
+ * distance from a small seed triangle, each one attaching to the visible part of the current convex hull,
+ * and new triangles are flipped until they are locally delaunay. A hash on angle around the seed
+ * finds the visible hull edge, so the whole thing is about O(n log n).
+ *
+ * Returned triangles are clockwise, with their links in t and their circumcenters set.
+ * tri_ret must have room for 2*nv triangles. Near duplicate points are left out of the triangulation.
+ *
+ * Returns 0 for success, or 1 if there are too few points.
+ */
+int Triangulate(int nv, const flatpoint *pts, IndexTriangle *tri_ret, int *ntri_ret)
 {
-   double m1,m2,mx1,mx2,my1,my2;
-   double dx,dy,drsqr;
-   double fabsy1y2 = fabs(y1-y2);
-   double fabsy2y3 = fabs(y2-y3);
-
-   /* Check for coincident points */
-   if (fabsy1y2 < EPSILON && fabsy2y3 < EPSILON)
-       return(false);
-
-   if (fabsy1y2 < EPSILON) {
-      m2 = - (x3-x2) / (y3-y2);
-      mx2 = (x2 + x3) / 2.0;
-      my2 = (y2 + y3) / 2.0;
-      *xc = (x2 + x1) / 2.0;
-      *yc = m2 * (*xc - mx2) + my2;
-
-   } else if (fabsy2y3 < EPSILON) {
-      m1 = - (x2-x1) / (y2-y1);
-      mx1 = (x1 + x2) / 2.0;
-      my1 = (y1 + y2) / 2.0;
-      *xc = (x3 + x2) / 2.0;
-      *yc = m1 * (*xc - mx1) + my1;
-
-   } else {
-      m1 = - (x2-x1) / (y2-y1);
-      m2 = - (x3-x2) / (y3-y2);
-      mx1 = (x1 + x2) / 2.0;
-      mx2 = (x2 + x3) / 2.0;
-      my1 = (y1 + y2) / 2.0;
-      my2 = (y2 + y3) / 2.0;
-      *xc = (m1 * mx1 - m2 * mx2 + my2 - my1) / (m1 - m2);
-      if (fabsy1y2 > fabsy2y3) {
-         *yc = m1 * (*xc - mx1) + my1;
-      } else {
-         *yc = m2 * (*xc - mx2) + my2;
-      }
-   }
-
-   dx = x2 - *xc;
-   dy = y2 - *yc;
-   *rsqr = dx*dx + dy*dy;
-
-   dx = xp - *xc;
-   dy = yp - *yc;
-   drsqr = dx*dx + dy*dy;
-
-   // Original
-   //return((drsqr <= *rsqr) ? true : false);
-   // Proposed by Chuck Morris
-   return((drsqr - *rsqr) <= EPSILON ? true : false);
+	*ntri_ret = 0;
+	if (nv < 3) return 1;
+
+	SweepHull hull(pts, nv);
+	hull.Run();
+
+	int ntri = hull.trianglesLen / 3;
+	for (int c=0; c<ntri; c++) {
+		IndexTriangle &tri = tri_ret[c];
+		tri.p1 = hull.triangles[3*c];
+		tri.p2 = hull.triangles[3*c+1];
+		tri.p3 = hull.triangles[3*c+2];
+		for (int e=0; e<3; e++) {
+			int h = hull.halfedges[3*c+e];
+			tri.t[e] = (h < 0 ? -1 : h/3);
+		}
+		tri.circumcenter = DelaunayCircumcenter(pts[tri.p1], pts[tri.p2], pts[tri.p3]);
+	}
+
+	*ntri_ret = ntri;
+	return 0;
 }
 
 
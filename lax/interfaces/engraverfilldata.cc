@@ -33,6 +33,7 @@
 #include <lax/iconmanager.h>
 #include <lax/laxutils.h>
 #include <lax/bitmaputils.h>
+#include <lax/workerpool.h>
 #include <lax/colorsliders.h>
 #include <lax/strmanip.h>
 #include <lax/language.h>
@@ -240,6 +241,7 @@ LinePoint::LinePoint()
 	weight=1;
 	weight_orig=1;
 	spacing=-1;
+	length=0;
 	next=prev=NULL;
 	needtosync=1;
 
@@ -257,6 +259,7 @@ LinePoint::LinePoint(double ss, double tt, double ww)
 	weight_orig=ww;
 	weight=ww;
 	spacing=-1;
+	length=0;
 	needtosync=1;
 
 	cache=NULL;
@@ -425,6 +428,7 @@ EngraverDirection::EngraverDirection()
 	scale_profile    = false;
 
 	grow_lines   = false;
+	grow_iteration_limit = GROW_ITERATION_LIMIT;
 	merge        = true;
 	fill         = true;
 	spread       = 1.5;
@@ -657,6 +661,7 @@ EngraverDirection *EngraverDirection::duplicate()
 	dup->profile_end = profile_end;
 
 	dup->grow_lines = grow_lines;
+	dup->grow_iteration_limit = grow_iteration_limit;
 	dup->merge = merge;
 	dup->fill = fill;
 	dup->spread = spread;
@@ -775,6 +780,7 @@ Attribute *EngraverDirection::dump_out_atts(Attribute *att,int what,Laxkit::Dump
     att->push("scale_profile", scale_profile ? "yes" : "no");
 
 	att->push("grow", grow_lines ? "yes" : "no");
+	att->push("grow_iteration_limit", grow_iteration_limit);
 	att->push("fill", fill       ? "yes" : "no");
 	att->push("merge", merge     ? "yes" : "no");
 	att->push("spread", spread);
@@ -939,6 +945,9 @@ void EngraverDirection::dump_in_atts(Laxkit::Attribute *att,int flag,Laxkit::Dum
 		} else if (!strcmp(name,"grow")) {
 			grow_lines=BooleanAttribute(value);
 
+		} else if (!strcmp(name,"grow_iteration_limit")) {
+			IntAttribute(value, &grow_iteration_limit, NULL);
+
 		} else if (!strcmp(name,"fill")) {
 			fill=BooleanAttribute(value);
 
@@ -1414,6 +1423,11 @@ TraceObject::TraceObject()
 	samplew=sampleh=0;
 	trace_sample_cache=NULL;
 	cachetime=0;
+	cache_modtime=0;
+
+	num_levels=0;
+	level_w=level_h=NULL;
+	levels=NULL;
 
 	 //black and white cache:
 	tw=th=0; //dims of trace_ref_bw
@@ -1424,7 +1438,7 @@ TraceObject::~TraceObject()
 {
 	if (object) object->dec_count();
 	delete[] image_file;
-	delete[] trace_sample_cache;
+	ClearCache(false);
 	delete[] trace_ref_bw;
 }
 
@@ -1533,41 +1547,125 @@ void TraceObject::dump_in_atts(Laxkit::Attribute *att,int flag,Laxkit::DumpConte
 	ClearCache(false);
 }
 
-/*! Note this is more for one time lookups. Not very efficient for mass lookups.
- * Returns -1 for point outside of trace object.
+#define TRACE_POINTS_PER_JOB 4096 //points per ParallelFor() index in TraceObject::GetValues()
+
+/*! Bilinear sample of one pyramid level. x,y are in pixels of that level, with pixel centers at +.5.
+ */
+static void SampleTraceLevel(const unsigned char *level, int w, int h, double x, double y, double *value, double *alpha)
+{
+	x -= .5;
+	y -= .5;
+	int x0 = floor(x), y0 = floor(y);
+	double fx = x-x0, fy = y-y0;
+	int x1 = x0+1, y1 = y0+1;
+
+	if (x0 < 0) x0 = 0; else if (x0 >= w) x0 = w-1;
+	if (x1 < 0) x1 = 0; else if (x1 >= w) x1 = w-1;
+	if (y0 < 0) y0 = 0; else if (y0 >= h) y0 = h-1;
+	if (y1 < 0) y1 = 0; else if (y1 >= h) y1 = h-1;
+
+	const unsigned char *r0 = level + 2*y0*w;
+	const unsigned char *r1 = level + 2*y1*w;
+	x0 *= 2;
+	x1 *= 2;
+
+	*value = (1-fy)*((1-fx)*r0[x0]   + fx*r0[x1])   + fy*((1-fx)*r1[x0]   + fx*r1[x1]);
+	*alpha = (1-fy)*((1-fx)*r0[x0+1] + fx*r0[x1+1]) + fy*((1-fx)*r1[x0+1] + fx*r1[x1+1]);
+}
+
+/*! Sample t's value pyramid at p, which is in object coordinates. Returns -1 for outside object, else
+ * value in range [0..1]. Alpha in [0..1] is put in alpha. footprint is as for TraceObject::GetValue().
+ */
+static double SampleTraceObject(TraceObject *t, flatpoint p, double footprint, double *alpha)
+{
+	*alpha = 0;
+	SomeData *object = t->object;
+	if (!t->levels || !object || object->maxx<=object->minx || object->maxy<=object->miny) return -1;
+
+	double x = t->samplew*(p.x-object->minx)/(object->maxx-object->minx);
+	double y = t->sampleh*(p.y-object->miny)/(object->maxy-object->miny);
+	if (!(x>=0 && x<t->samplew && y>=0 && y<t->sampleh)) return -1; // point outside sample area
+
+	 //pick levels so that one pixel is about footprint wide
+	double lod = 0;
+	if (footprint > 0) {
+		lod = log2(footprint*t->samplew/(object->maxx-object->minx));
+		if (!(lod > 0)) lod = 0;
+		else if (lod > t->num_levels-1) lod = t->num_levels-1;
+	}
+	int l = lod;
+	double f = lod - l;
+
+	double v, a;
+	SampleTraceLevel(t->levels[l], t->level_w[l], t->level_h[l],
+			x*t->level_w[l]/t->samplew, y*t->level_h[l]/t->sampleh, &v, &a);
+
+	if (f > 0 && l+1 < t->num_levels) {
+		 //trilinear, blend with next smaller level
+		double v2, a2;
+		l++;
+		SampleTraceLevel(t->levels[l], t->level_w[l], t->level_h[l],
+				x*t->level_w[l]/t->samplew, y*t->level_h[l]/t->sampleh, &v2, &a2);
+		v = (1-f)*v + f*v2;
+		a = (1-f)*a + f*a2;
+	}
+
+	*alpha = a/255;
+	return v/255;
+}
+
+/*! Returns -1 for point outside of trace object, or for a transparent point.
+ * Otherwise return a value in range [0..1], where 0 is white and 1 is black.
  *
- * trace_sample_cache MUST be set up properly. TRACE_Current is just pass through for p->weight.
+ * The cache MUST be set up properly with UpdateCache(). TRACE_Current is just pass through for p->weight.
  *
  * If transform!=NULL, then transform p->p by transform before using.
+ *
+ * footprint is the width in object coordinates that the sample should average over, usually
+ * line spacing. Samples are bilinear for footprints under a cache pixel, and are otherwise trilinear
+ * between the 2 closest levels of the value pyramid.
  */
-double TraceObject::GetValue(LinePoint *p, double *transform)
+double TraceObject::GetValue(LinePoint *p, double *transform, double footprint)
 {
 	if (type==TRACE_Current) return p->weight;
 
-	int x,y,i;
-	int sample, samplea;
 	flatpoint pp=p->p;
 	if (transform) pp=transform_point(transform,pp);
 
-	x=samplew*(pp.x-object->minx)/(object->maxx-object->minx);
-	y=sampleh*(pp.y-object->miny)/(object->maxy-object->miny);
+	return GetValue(pp, footprint, NULL);
+}
 
-	if (x>=0 && x<samplew && y>=0 && y<sampleh) {
-		i=4*(x+(sampleh-y)*samplew);
+/*! Like GetValue(LinePoint*,double*,double), but p is already in object coordinates.
+ * Not for TRACE_Current. If alpha_ret!=NULL, return alpha of the sample in it, in range [0..1].
+ */
+double TraceObject::GetValue(flatpoint p, double footprint, double *alpha_ret)
+{
+	double a;
+	double v = SampleTraceObject(this, p, footprint, &a);
+	if (alpha_ret) *alpha_ret = a;
 
-		samplea=trace_sample_cache[i+3];
-		if (samplea==0) return -1; //transparent sample!
+	if (a*255 < .5) return -1; //transparent sample!
+	return v;
+}
 
-		sample=0.3*trace_sample_cache[i] + 0.59*trace_sample_cache[i+1] + 0.11*trace_sample_cache[i+2];
-		if (sample>255) {
-			sample=255;
-		}
+/*! Batch lookup of many points, which are already in object coordinates. Points are split
+ * over WorkerPool::Default().
+ *
+ * values_ret gets -1 for points outside the object, otherwise a value in [0..1]. Unlike GetValue(),
+ * transparent points still get their value, and have alpha 0 in alphas_ret, which may be NULL.
+ * Not for TRACE_Current.
+ */
+void TraceObject::GetValues(const flatpoint *points, int n, double *values_ret, double *alphas_ret, double footprint)
+{
+	if (n <= 0) return;
 
-		return (255-sample)/255.; 
-	}
-	
-	// else point outside sample area
-	return -1;
+	WorkerPool::Default()->ParallelFor((n + TRACE_POINTS_PER_JOB-1) / TRACE_POINTS_PER_JOB, [&](int index, int thread) {
+		double a;
+		for (int c = index*TRACE_POINTS_PER_JOB; c < (index+1)*TRACE_POINTS_PER_JOB && c < n; c++) {
+			values_ret[c] = SampleTraceObject(this, points[c], footprint, &a);
+			if (alphas_ret) alphas_ret[c] = a;
+		}
+	});
 }
 
 /*! Count on obj will be incremented, unless obj is alread object.
@@ -1625,6 +1723,15 @@ void TraceObject::ClearCache(bool obj_too)
 	trace_sample_cache=NULL;
 	samplew=sampleh=0;
 	cachetime=0;
+	cache_modtime=0;
+
+	for (int c=0; c<num_levels; c++) delete[] levels[c];
+	delete[] levels;
+	delete[] level_w;
+	delete[] level_h;
+	levels=NULL;
+	level_w=level_h=NULL;
+	num_levels=0;
 
 	if (obj_too) {
 		delete[] object_idstr;
@@ -1636,18 +1743,16 @@ void TraceObject::ClearCache(bool obj_too)
 
 int TraceObject::NeedsUpdating()
 {
-	if (!trace_sample_cache) return 1;
-	if (type==TRACE_Object) {
-		if (!object) return 1;
-		if (object->modtime>cachetime) return 1;
-	}
+	if (!trace_sample_cache || !levels) return 1;
+	if (type==TRACE_Object && !object) return 1;
+	if (object && object->modtime!=cache_modtime) return 1;
 	
 	return 0;
 }
 
 /*! Calling this will always force a redrawing of the cache.
- * trace_sample_cache will only be reallocated if it is not currently large enough to hold data from object.
- *
+ * trace_sample_cache and the value pyramid are only reallocated when the rendered size changes.
+ * Otherwise, only the part of the pyramid under pixels that changed since the last render is updated.
  */
 int TraceObject::UpdateCache()
 {
@@ -1710,26 +1815,118 @@ int TraceObject::UpdateCache()
 
 	delete ddp;
 
-	if (trace_sample_cache) {
-		if (img->w()*img->h()>samplew*sampleh) {
-			 //old isn't big enough to hold the new
-			delete[] trace_sample_cache;
-			trace_sample_cache=NULL;
+	unsigned char *data=img->getImageBuffer();
+	int x1=0, y1=0, x2=img->w(), y2=img->h(); //area to update, in pyramid rows
+
+	if (trace_sample_cache && levels && img->w()==samplew && img->h()==sampleh) {
+		 //find bounds of changed pixels
+		x1=samplew; y1=sampleh; x2=y2=0;
+		for (int r=0; r<sampleh; r++) {
+			const unsigned int *o=(const unsigned int*)(trace_sample_cache + 4*r*samplew);
+			const unsigned int *n=(const unsigned int*)(data + 4*r*samplew);
+			if (!memcmp(o,n,4*samplew)) continue;
+
+			int a=0, b=samplew-1;
+			while (o[a]==n[a]) a++;
+			while (o[b]==n[b]) b--;
+			if (a<x1) x1=a;
+			if (b+1>x2) x2=b+1;
+			if (sampleh-1-r<y1) y1=sampleh-1-r;
+			if (sampleh-r>y2) y2=sampleh-r;
 		}
+
+	} else {
+		ClearCache(false);
+		samplew=img->w();
+		sampleh=img->h();
+		trace_sample_cache=new unsigned char[4*samplew*sampleh];
+	}
+
+	if (x2>x1 && y2>y1) {
+		memcpy(trace_sample_cache, data, 4*samplew*sampleh);
+		UpdateLevels(x1,y1,x2,y2);
 	}
-	samplew=img->w();
-	sampleh=img->h();
-	if (trace_sample_cache==NULL) trace_sample_cache=new unsigned char[4*samplew*sampleh];
 
-	unsigned char *data=img->getImageBuffer();
-	memcpy(trace_sample_cache, data, 4*samplew*sampleh);
 	img->doneWithBuffer(data);
 	cachetime=time(NULL);
+	cache_modtime=object->modtime;
 	img->dec_count();
 
 	return 0;
 }
 
+/*! Recompute the value pyramid from trace_sample_cache within level 0 pixels [x1,x2) x [y1,y2),
+ * allocating the pyramid first if necessary. Pyramid row 0 is the last row of trace_sample_cache.
+ * Rows are split over WorkerPool::Default().
+ */
+void TraceObject::UpdateLevels(int x1, int y1, int x2, int y2)
+{
+	if (!trace_sample_cache || samplew<1 || sampleh<1) return;
+
+	if (!levels) {
+		num_levels=1;
+		for (int w=samplew, h=sampleh; w>1 || h>1; w=(w+1)/2, h=(h+1)/2) num_levels++;
+
+		levels =new unsigned char*[num_levels];
+		level_w=new int[num_levels];
+		level_h=new int[num_levels];
+		for (int c=0, w=samplew, h=sampleh; c<num_levels; c++, w=(w+1)/2, h=(h+1)/2) {
+			level_w[c]=w;
+			level_h[c]=h;
+			levels[c]=new unsigned char[2*w*h];
+		}
+		x1=y1=0;
+		x2=samplew;
+		y2=sampleh;
+	}
+
+	if (x1<0) x1=0;
+	if (y1<0) y1=0;
+	if (x2>samplew) x2=samplew;
+	if (y2>sampleh) y2=sampleh;
+	if (x1>=x2 || y1>=y2) return;
+
+	WorkerPool *pool=WorkerPool::Default();
+
+	 //level 0: luminance from BGRA
+	pool->ParallelFor(y2-y1, [&](int index, int thread) {
+		int y=y1+index;
+		const unsigned char *src=trace_sample_cache + 4*(sampleh-1-y)*samplew;
+		unsigned char *dst=levels[0] + 2*y*samplew;
+		for (int x=x1; x<x2; x++) {
+			int lum=(28*src[4*x] + 151*src[4*x+1] + 77*src[4*x+2] + 128)>>8;
+			dst[2*x]  =255-lum;
+			dst[2*x+1]=src[4*x+3];
+		}
+	});
+
+	 //each next level averages 2x2 blocks of the last
+	for (int l=1; l<num_levels; l++) {
+		x1/=2; y1/=2;
+		x2=(x2+1)/2; y2=(y2+1)/2;
+		if (x2>level_w[l]) x2=level_w[l];
+		if (y2>level_h[l]) y2=level_h[l];
+
+		int pw=level_w[l-1], ph=level_h[l-1];
+		unsigned char *prev=levels[l-1];
+		unsigned char *cur =levels[l];
+		int w=level_w[l];
+
+		pool->ParallelFor(y2-y1, [&](int index, int thread) {
+			int y=y1+index;
+			const unsigned char *r0=prev + 2*(2*y)*pw;
+			const unsigned char *r1=prev + 2*(2*y+1<ph ? 2*y+1 : 2*y)*pw;
+			unsigned char *dst=cur + 2*y*w;
+			for (int x=x1; x<x2; x++) {
+				int a=2*(2*x);
+				int b=2*(2*x+1<pw ? 2*x+1 : 2*x);
+				dst[2*x]  =(r0[a]   + r0[b]   + r1[a]   + r1[b]   + 2)>>2;
+				dst[2*x+1]=(r0[a+1] + r0[b+1] + r1[a+1] + r1[b+1] + 2)>>2;
+			}
+		});
+	}
+}
+
 
 //------------------------------ EngraverTraceSettings -------------------------------
 
@@ -2646,8 +2843,29 @@ Laxkit::Attribute *EngraverPointGroup::dump_out_atts(Laxkit::Attribute *att,int
 	LinePoint *p;
 	Utf8String s,s2;
 	const char *ons, *dash;
+	bool binary = (context && context->format==ATT_Binary);
 	for (int c=0; c<lines.n; c++) {
 		s.Sprintf("%d", c);
+
+		if (binary) {
+			 //s,t,weight for each point in a double blob, and on|off in a char blob.
+			 //Caches are regenerated on reading, so they are not saved.
+			int n=0;
+			for (p = lines.e[c]; p; p = p->next) n++;
+
+			att2 = att->pushBlob("line", ATTBLOB_Double, 3*n, nullptr, s.c_str());
+			Attribute *onatt = att2->pushBlob("on", ATTBLOB_Char, n);
+			double *d = (double*)att2->blob->Data();
+			char *o = (char*)onatt->blob->Data();
+			for (p = lines.e[c]; p; p = p->next) {
+				*d++ = p->s;
+				*d++ = p->t;
+				*d++ = p->weight;
+				*o++ = p->on;
+			}
+			continue;
+		}
+
 		att2 = att->pushSubAtt("line", nullptr, s.c_str());
 
 		p = lines.e[c];
@@ -2657,7 +2875,7 @@ Laxkit::Attribute *EngraverPointGroup::dump_out_atts(Laxkit::Attribute *att,int
 			else if (p->on==ENGRAVE_On) ons="on";
 			else if (p->on==ENGRAVE_EndPoint) ons="end";
 			else if (p->on==ENGRAVE_StartPoint) ons="start";
-			s2.Sprintf("%s  (%.10g, %.10g) %.10g %s\n", p->s,p->t, p->weight, ons);
+			s2.Sprintf("  (%.10g, %.10g) %.10g %s\n", p->s,p->t, p->weight, ons);
 			s.Append(s2);
 
 			p = p->next;
@@ -2880,6 +3098,27 @@ void EngraverPointGroup::dump_in_atts(Laxkit::Attribute *att,int flag,Laxkit::Du
 			spacing->dump_in_atts(att->attributes.e[c],flag,context);
 
 
+		} else if (!strcmp(name,"line") && att->attributes.e[c]->blob) {
+			 //binary: s,t,weight for each point, with on|off in subattribute "on"
+			AttributeBlob *blob = att->attributes.e[c]->blob;
+			Attribute *onatt = att->attributes.e[c]->find("on");
+			const double *d = blob->Doubles();
+			const char *ons = (onatt && onatt->blob && onatt->blob->n*3 >= blob->n) ? onatt->blob->Chars() : NULL;
+			LinePoint *lstart=NULL, *ll=NULL, *np;
+
+			for (long i=0; d && i<blob->n/3; i++, d+=3) {
+				np=new LinePoint(d[0],d[1], d[2]);
+				np->on = ons ? (signed char)ons[i] : ENGRAVE_On;
+				if (!lstart) lstart=ll=np;
+				else {
+					ll->next=np;
+					np->prev=ll;
+					ll=np;
+				}
+			}
+
+			if (lstart) lines.push(lstart);
+
 		} else if (!strcmp(name,"line")) {
 			char *end_ptr=NULL;
 			flatpoint v;
@@ -3245,15 +3484,7 @@ int EngraverPointGroup::Trace(Affine *aa)
 	if (!trace->traceobject->trace_sample_cache || trace->traceobject->NeedsUpdating())
 		trace->traceobject->UpdateCache();
 
-	int samplew=trace->traceobject->samplew;
-	int sampleh=trace->traceobject->sampleh;
-
-	int x,y, i;
-	int sample, samplea;
 	double me[6],mti[6];
-	unsigned char *rgb;
-	flatpoint pp;
-	double a;
 
 	SomeData *to=trace->traceobject->object;
 	if (to) {
@@ -3263,68 +3494,100 @@ int EngraverPointGroup::Trace(Affine *aa)
 	} else transform_identity(me);
 
 
-	for (int c=0; c<lines.n; c++) {
-		LinePoint *l=lines.e[c];
+	if (to) {
+		 //gather all points at once for one GetValues() call, rather than sampling each point on its own
+		int n=0;
+		for (int c=0; c<lines.n; c++) {
+			LinePoint *l=lines.e[c];
+			while (l) {
+				n++;
+				l=l->next;
+				if (l==lines.e[c]) break;
+			}
+		}
 
-		while (l) {
-			pp=transform_point(me,l->p);
-			//pp=l->p;
-			//pp=transform_point(mti,pp);
-
-			if (to) {
-				x=samplew*(pp.x-to->minx)/(to->maxx-to->minx);
-				y=sampleh*(pp.y-to->miny)/(to->maxy-to->miny);
-
-				if (x>=0 && x<samplew && y>=0 && y<sampleh) {
-					i=4*(x+(sampleh-y)*samplew);
-					rgb=trace->traceobject->trace_sample_cache+i;
-
-					samplea=rgb[3];
-					sample=0.3*rgb[0] + 0.59*rgb[1] + 0.11*rgb[2];
-					if (sample>255) {
-						sample=255;
-					}
+		flatpoint *pts=new flatpoint[n];
+		double *values=new double[2*n];
+		double *alphas=values+n;
+		LinePoint **points=new LinePoint*[n];
 
-					a=(255-sample)/255.;
-					a=trace->value_to_weight->f(a);
-					l->weight=spacing->spacing*a; // *** this seems off
-					l->on = samplea>0 ? ENGRAVE_On : ENGRAVE_Off;
+		n=0;
+		for (int c=0; c<lines.n; c++) {
+			LinePoint *l=lines.e[c];
+			while (l) {
+				points[n]=l;
+				pts[n++]=transform_point(me,l->p);
+				l=l->next;
+				if (l==lines.e[c]) break;
+			}
+		}
+
+		 //sample over about one line spacing, in trace object coordinates
+		double footprint=spacing->spacing * sqrt(fabs(me[0]*me[3]-me[1]*me[2]));
+		trace->traceobject->GetValues(pts,n, values,alphas, footprint);
+
+		 //map values to weights
+		if (n) trace->value_to_weight->f(0); //make sure any lazy curve setup happens before threads read it
+
+		double sp=spacing->spacing;
+		CurveInfo *curve=trace->value_to_weight;
+		WorkerPool::Default()->ParallelFor((n + TRACE_POINTS_PER_JOB-1) / TRACE_POINTS_PER_JOB, [&](int index, int thread) {
+			int end=(index+1)*TRACE_POINTS_PER_JOB;
+			if (end>n) end=n;
+
+			for (int c=index*TRACE_POINTS_PER_JOB; c<end; c++) {
+				LinePoint *l=points[c];
+				if (values[c]>=0) {
+					l->weight=sp*curve->f(values[c]); // *** this seems off
+					l->on = alphas[c]*255>=.5 ? ENGRAVE_On : ENGRAVE_Off;
 				} else {
 					l->weight=0;
 					l->on=ENGRAVE_Off;
 				}
-
-			} else { //use current
-				a=spacing->spacing * trace->value_to_weight->f(l->weight_orig/spacing->spacing);
-				l->weight=a;
 			}
+		});
 
-			l=l->next;
-		}
-	} //each line
+		delete[] pts;
+		delete[] values;
+		delete[] points;
+
+	} else {
+		 //use current
+		if (lines.n) trace->value_to_weight->f(0); //make sure any lazy curve setup happens before threads read it
+
+		double sp=spacing->spacing;
+		CurveInfo *curve=trace->value_to_weight;
+		WorkerPool::Default()->ParallelFor(lines.n, [&](int index, int thread) {
+			LinePoint *l, *lstart;
+			l=lstart=lines.e[index];
+			while (l) {
+				l->weight = sp * curve->f(l->weight_orig/sp);
+				l=l->next;
+				if (l==lstart) break;
+			}
+		});
+	}
 
 	UpdateDashCache();
 	return 0;
 }
 
 /*! Call UpdateBezCache(), then update any LinePointCache that run along the actual lines.
+ * Lines are done in parallel.
  * 
  * This does NOT recreate cache points. Use UpdateDashCache() for that.
  * Does NOT update on/off state, which is also done in UpdateDashCache().
  */
 void EngraverPointGroup::UpdatePositionCache()
 {
-	DBG cerr <<" *** EngraverPointGroup::UpdatePositionCache() needs to be optimized"<<endl;
-	
 	UpdateBezCache();
 	
-	LinePointCache *cache, *start;
-	LinePoint *l;
-
-	for (int c=0; c<lines.n; c++) {
-		start=cache=lines.e[c]->cache;
+	WorkerPool::Default()->ParallelFor(lines.n, [&](int index, int thread) {
+		LinePointCache *cache, *start;
+		LinePoint *l;
 
-		if (!cache) continue;
+		start=cache=lines.e[index]->cache;
+		if (!cache) return;
 		l=cache->original;
 
 		do {
@@ -3337,20 +3600,19 @@ void EngraverPointGroup::UpdatePositionCache()
 
 			cache=cache->next;
 		} while (cache && cache!=start);
-	}
+	});
 }
 
-/*! Update the bez handles and bez length of all points.
+/*! Update the bez handles and bez length of all points. Lines are done in parallel.
  * This dose NOT create, install, or update any LinePointCache.
  */
 void EngraverPointGroup::UpdateBezCache()
 {
-	LinePoint *p, *start;
-
-	for (int c=0; c<lines.n; c++) {
-		start=p=lines.e[c];
+	WorkerPool::Default()->ParallelFor(lines.n, [&](int index, int thread) {
+		LinePoint *p, *start;
+		start=p=lines.e[index];
 
-		if (!p) continue;
+		if (!p) return;
 
 		do {
 			p->UpdateBezHandles();
@@ -3360,7 +3622,7 @@ void EngraverPointGroup::UpdateBezCache()
 
 			p=p->next;
 		} while (p && p!=start);
-	}
+	});
 }
 
 /*! Update (or create) any additional points added to the lines.
@@ -4583,6 +4845,11 @@ StarterPoint::StarterPoint(flatpoint p, int indir, double weight,int groupid, in
 //------------------------ class GrowContext --------------------------
 /*! \class GrowContext
  * Holds cached data so that processing for growing lines can be spread across multiple frames.
+ *
+ * Every grown point is kept in scratch_blocks, chained by grid cell, so growing ends look only
+ * at nearby cells to decide whether they have run into another line,
+ * rather than checking against every point of every line. Points are added a block at a time,
+ * so a big fill never stops to copy all of them into a larger array.
  */
 
 GrowContext::GrowContext()
@@ -4590,12 +4857,97 @@ GrowContext::GrowContext()
 
 GrowContext::~GrowContext()
 {
-	delete[] scratch_data;
+	ClearGrid();
 	if (spacingmap)   spacingmap  ->dec_count();
 	if (weightmap)    weightmap   ->dec_count();
 	if (directionmap) directionmap->dec_count();
 }
 
+void GrowContext::ClearGrid()
+{
+	scratch_blocks.flush();
+	delete[] grid;
+	grid = nullptr;
+	scratch_n = 0;
+	grid_w = grid_h = 0;
+}
+
+/*! Set up an empty occupancy grid covering box, with square cells of size cell.
+ */
+void GrowContext::InitGrid(Laxkit::DoubleBBox &box, double cell)
+{
+	ClearGrid();
+
+	bounds = box;
+	grid_cell = cell;
+	grid_w = (box.maxx-box.minx)/cell + 1;
+	grid_h = (box.maxy-box.miny)/cell + 1;
+	if (grid_w<1) grid_w = 1;
+	if (grid_h<1) grid_h = 1;
+
+	grid = new int[grid_w*grid_h];
+	for (int c=0; c<grid_w*grid_h; c++) grid[c] = -1;
+}
+
+/*! Return the index in grid of the cell containing p, or -1 if p is outside the grid.
+ */
+int GrowContext::Cell(Laxkit::flatpoint p)
+{
+	if (!grid) return -1;
+	int x = floor((p.x-bounds.minx)/grid_cell);
+	int y = floor((p.y-bounds.miny)/grid_cell);
+	if (x<0 || x>=grid_w || y<0 || y>=grid_h) return -1;
+	return y*grid_w + x;
+}
+
+/*! Record that point number point of line is at p.
+ * Returns the index of the new ScratchData, or -1 if p is outside the grid.
+ */
+int GrowContext::Mark(Laxkit::flatpoint p, int group, int line, int point)
+{
+	int cell = Cell(p);
+	if (cell<0) return -1;
+
+	if (scratch_n == (scratch_blocks.n << GROW_SCRATCH_BITS))
+		scratch_blocks.push(new ScratchData[1<<GROW_SCRATCH_BITS], LISTS_DELETE_Array);
+
+	ScratchData *d = Scratch(scratch_n);
+	d->group = group;
+	d->line  = line;
+	d->point = point;
+	d->p     = p;
+	d->next  = grid[cell];
+	grid[cell] = scratch_n;
+	return scratch_n++;
+}
+
+/*! Return whether any marked point is closer than radius to p.
+ * Points of the same line within window steps of point are ignored, so a growing end
+ * does not collide with the points just behind it. Pass line<0 to count all points.
+ */
+bool GrowContext::Occupied(Laxkit::flatpoint p, double radius, int line, int point, int window)
+{
+	if (!grid) return false;
+
+	int r  = ceil(radius/grid_cell);
+	int cx = floor((p.x-bounds.minx)/grid_cell);
+	int cy = floor((p.y-bounds.miny)/grid_cell);
+	double r2 = radius*radius;
+	ScratchData *d;
+
+	for (int y=(cy-r<0 ? 0 : cy-r); y<=cy+r && y<grid_h; y++) {
+		for (int x=(cx-r<0 ? 0 : cx-r); x<=cx+r && x<grid_w; x++) {
+			for (int i=grid[y*grid_w + x]; i>=0; i=d->next) {
+				d = Scratch(i);
+				if (d->line==line && abs(d->point-point)<=window) continue;
+				if ((d->p.x-p.x)*(d->p.x-p.x) + (d->p.y-p.y)*(d->p.y-p.y) < r2) return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 
 /*! Initialize growing points. 
  * If growpoint_ret already has points in it, use those, don't create automatically along edges.
@@ -4631,7 +4983,8 @@ GrowContext *EngraverPointGroup::GrowLines_Init(EngraverFillData *data,
 	grow_cache = new GrowContext();
 	GrowContext *context = grow_cache;
 
-	context->resolution = resolution;
+	context->data = data;
+	context->resolution = resolution/data->getScaling(.5,.5,false);
 	context->defaultspace = defaultspace;
 	context->spacingmap = spacingmap;
 	if (spacingmap) spacingmap->inc_count();
@@ -4801,39 +5154,221 @@ GrowContext *EngraverPointGroup::GrowLines_Init(EngraverFillData *data,
 		}
 	}
 
+	 //starters are positioned in bounds units, but lines keep s,t in [0..1], so they are
+	 //usable as is while still growing
+	context->InitGrid(bounds, GROW_MERGE_SPACE * defaultspace/data->getScaling(.5,.5,false));
+	for (int c=0; c<generators.n; c++) {
+		g = generators.e[c];
+		flatpoint p(g->line->s, g->line->t);
+		context->Mark(p, id, g->lineref, 0);
+		g->line->s = p.x/bounds.maxx;
+		g->line->t = p.y/bounds.maxy;
+	}
+	context->fill_point.set(bounds.minx, bounds.miny);
+
 	return context;
 }
 
-/*! Return true if there is more to iterate.
+/*! Start a new line at p, in the bounds units of context.
+ */
+static StarterPoint *AddGrowLine(EngraverPointGroup *group, GrowContext *context, flatpoint p)
+{
+	DoubleBBox &bounds = context->bounds;
+	flatpoint pp = context->data->getPoint(p.x,p.y, true);
+	double weight = context->defaultweight;
+	if (context->weightmap) weight = context->weightmap->GetValue(pp);
+
+	StarterPoint *g = new StarterPoint(flatpoint(p.x/bounds.maxx, p.y/bounds.maxy), 3, weight, group->id, group->lines.n);
+	g->line->p = pp;
+	g->line->needtosync = 0;
+	group->lines.push(g->line);
+	context->generators.push(g,1);
+	context->Mark(p, group->id, g->lineref, 0);
+	return g;
+}
+
+/*! Do one round of growing: advance each generator one step, stop ends that leave the
+ * bounds or come too close to other lines, and when all generators are done,
+ * start one new line in a gap, if any.
+ * Lines are left in a usable state after each step, so they can be drawn while still growing.
+ *
+ * If deadline is not 0, stop partway through the generators once MonotonicMicroseconds() reaches it.
+ * The next call picks up the round where this one left off.
+ *
+ * Return true if there is more to grow.
+ */
+bool EngraverPointGroup::GrowLines_Step(long long deadline)
+{
+	if (!grow_cache || !grow_cache->active) return false;
+
+	GrowContext *context = grow_cache;
+	EngraverFillData *data = context->data;
+	PtrStack<StarterPoint> &generators = context->generators;
+	DirectionMap *directionmap = context->directionmap ? context->directionmap : this;
+	DoubleBBox &bounds = context->bounds;
+	double resolution = context->resolution;
+	double curspace = context->defaultspace/data->getScaling(.5,.5,false);
+	double weight = context->defaultweight;
+
+	int start = context->next_generator;
+	if (start < 0 || start >= generators.n) {
+		context->iteration++;
+		if (context->iteration >= context->iteration_limit) {
+			DBG cerr <<"Warning! EngraverPointGroup GrowLines() hit iteration limit of: "<<context->iteration_limit<<endl;
+			return false;
+		}
+		start = generators.n-1;
+	}
+	context->next_generator = -1;
+
+	StarterPoint *g;
+	LinePoint *end, *np;
+	flatpoint v, vt, p, p2, q;
+	int point;
+	int split_every = curspace/resolution;
+	if (split_every<1) split_every = 1;
+
+	for (int c=start; c>=0; c--) {
+		if (deadline && c<start && MonotonicMicroseconds() >= deadline) {
+			context->next_generator = c;
+			return true;
+		}
+		g = generators.e[c];
+
+		 //dir==1 for forward, 2 for backward
+		for (int dir=1; dir<=2; dir++) {
+			if (!(g->dodir&dir)) continue;
+
+			end = (dir==1 ? g->last : g->first);
+			v = directionmap->Direction(end->s, end->t);
+			if (v.isZero()) { g->dodir &= ~dir; continue; }
+			v *= resolution/norm(v);
+			if (dir==2) v = -v;
+
+			p.set(end->s*bounds.maxx + v.x, end->t*bounds.maxy + v.y);
+			p2 = data->getPoint(p.x,p.y, true);
+			if (context->spacingmap) curspace = context->spacingmap->GetValue(p2)/data->getScaling(p.x,p.y,true); //else spacing is constant
+			if (context->weightmap)  weight   = context->weightmap ->GetValue(p2); //else weight is constant
+
+			 //merge: stop before running into another line, or into an earlier part of this one
+			point = (dir==1 ? g->iteration+1 : -(g->piteration+1));
+			if (context->Occupied(p, GROW_MERGE_SPACE*curspace, g->lineref, point, int(2*curspace/resolution)+2)) {
+				g->dodir &= ~dir;
+				continue;
+			}
+
+			np = new LinePoint(p.x/bounds.maxx, p.y/bounds.maxy, weight);
+			np->p = p2;
+			np->needtosync = 0;
+			if (dir==1) {
+				g->last->Add(np);
+				g->last = np;
+				g->iteration++;
+			} else {
+				g->first->AddBefore(np);
+				g->first = np;
+				g->piteration++;
+				lines.e[g->lineref] = np; //lines always point to the head of the line
+			}
+			context->Mark(p, id, g->lineref, point);
+
+			 //terminate lines now out of bounds
+			 // *** todo: don't stretch so far out of bounds, interpolate to edge
+			if (!bounds.boxcontains(p.x,p.y)) {
+				g->dodir &= ~dir;
+				continue;
+			}
+
+			 //split: about once per spacing, remember empty space a spacing to either side,
+			 //which is where lines spread apart. New lines start there once current lines are done.
+			if (point % split_every == 0) {
+				vt = transpose(v) * (curspace/resolution);
+				for (int side=0; side<2; side++) {
+					q = (side ? p-vt : p+vt);
+					if (bounds.boxcontains(q.x,q.y) && !context->Occupied(q, GROW_MERGE_SPACE*curspace, -1,0,0))
+						context->split_points.push(q);
+				}
+			}
+		}
+
+		if (g->dodir==0) generators.remove(c);
+	}
+
+	if (generators.n) return true;
+
+
+	 //no more generators, start a new line in the next gap, most recent first
+	for (int c=0; c<GROW_CHECKS_PER_STEP && context->split_points.n; c++) {
+		p = context->split_points.pop();
+		if (context->spacingmap)
+			curspace = context->spacingmap->GetValue(data->getPoint(p.x,p.y, true))/data->getScaling(p.x,p.y,true);
+		if (context->Occupied(p, GROW_MERGE_SPACE*curspace, -1,0,0)) continue;
+
+		AddGrowLine(this, context, p);
+		return true;
+	}
+	if (context->split_points.n) return true;
+
+	 //then search for holes to fill, one column per step, this might happen with specialized direction maps
+	double &xx = context->fill_point.x;
+	double &yy = context->fill_point.y;
+	if (xx>=bounds.maxx) return false;
+
+	for ( ; yy<bounds.maxy; yy+=curspace) {
+		p.set(xx,yy);
+		if (context->spacingmap)
+			curspace = context->spacingmap->GetValue(data->getPoint(xx,yy, true))/data->getScaling(xx,yy,true);
+
+		if (!context->Occupied(p, 2*curspace, -1,0,0)) {
+			 //nothing was very close
+			DBG cerr <<"Add fill point at "<<xx<<','<<yy<<endl;
+			AddGrowLine(this, context, p);
+			yy += curspace;
+			return true;
+		}
+	}
+	yy = bounds.miny;
+	xx += curspace;
+
+	return xx<bounds.maxx;
+}
+
+/*! Grow for up to grow_cache->time_slice seconds. This is meant to be called repeatedly, such as
+ * from a timer, so that large fills grow a bit at a time without blocking everything else.
+ * The time is checked between generators, so a round with many lines is spread over several calls.
+ * Lines are usable (and drawable) between calls.
+ *
+ * Return true if there is more to iterate. When this returns false, call GrowLines_Finish().
  */
 bool EngraverPointGroup::GrowLines_Iterate()
 {
-	if (!grow_cache) return false;
-	return false; //TODO!
+	if (!grow_cache || !grow_cache->active) return false;
+
+	long long end = MonotonicMicroseconds() + grow_cache->time_slice*1000000;
+	do {
+		if (!GrowLines_Step(end)) return false;
+	} while (MonotonicMicroseconds() < end);
+
+	return true;
 }
 
+/*! Stop growing, keeping whatever lines have been grown so far.
+ */
+void EngraverPointGroup::GrowLines_Cancel()
+{
+	if (!grow_cache || !grow_cache->active) return;
+	GrowLines_Finish();
+}
+
+/*! Clean up after growing. Lines stay as grown, but all the growing state is discarded.
+ */
 void EngraverPointGroup::GrowLines_Finish()
 {
 	if (!grow_cache) return;
 
-	 //Finish off lines
-//	LinePoint *lp, *ll;
-//	for (int c=0; c<lines.n; c++) {
-//		lp=lines.e[c];
-//
-//		 //need to normalize all points
-//		ll=lp;
-//		while (ll) {
-//			ll->s = (ll->s - bounds.minx) / (bounds.maxx - bounds.minx);
-//			ll->t = (ll->t - bounds.miny) / (bounds.maxy - bounds.miny);
-//
-//			if (ll->s >= 1 || ll->t >= 1 || ll->s <= 0 || ll->t <= 0) {
-//				ll->p = data->getPoint(ll->s, ll->t, false);
-//				ll->needtosync = 0;
-//			}
-//			ll = ll->next;
-//		}
-//	}
+	grow_cache->generators.flush();
+	grow_cache->split_points.flush();
+	grow_cache->ClearGrid();
 
 	grow_cache->active = false;
 	//delete grow_cache;
@@ -5645,14 +6180,14 @@ SomeData *EngraverFillData::duplicate(SomeData *dup)
  */
 void EngraverFillData::Sync(bool asneeded)
 {
-	LinePoint *l;
+	LinePoint *l, *lstart;
 	EngraverPointGroup *group;
 
 	for (int g=0; g<groups.n; g++) {
 		group=groups.e[g];
 
 		for (int c=0; c<group->lines.n; c++) {
-			l=group->lines.e[c];
+			l=lstart=group->lines.e[c];
 
 			while (l) {
 				if (!asneeded || (asneeded && l->needtosync==1))
@@ -5660,6 +6195,7 @@ void EngraverFillData::Sync(bool asneeded)
 				l->needtosync=0;
 
 				l=l->next;
+				if (l==lstart) break;
 			}
 		}
 	}
@@ -5922,7 +6458,7 @@ void EngraverFillData::Update()
 
 		if (group->needtoreline) {
 			if (group->direction->grow_lines) {
-				if (!group->grow_cache) {
+				if (!group->Growing()) {
 					//initialize growing lines.. this will start iterating growth over many frames
 					group->growpoints.flush();
 					group->GrowLines_Init(this,
@@ -5930,7 +6466,7 @@ void EngraverFillData::Update()
 								 group->spacing->spacing, NULL,
 								 .01, NULL,
 								 group->directionv,group,
-								 1000, //iteration limit
+								 group->direction->grow_iteration_limit,
 								 &group->growpoints
 								);
 				} else {
@@ -6006,6 +6542,7 @@ PathsData *EngraverFillData::MakePathsData(int whichgroup)
 
 	NumStack<flatvector> points;
 	NumStack<flatvector> points2;
+	NumStack<flatpoint> outline;
 
 	LinePoint *l;
 	LinePointCache *lc, *lcstart;
@@ -6083,11 +6620,18 @@ PathsData *EngraverFillData::MakePathsData(int whichgroup)
 
 					BezApproximate(points,points2);
 
-					paths->moveTo(points.e[1]);
+					 //build the whole outline at once, since PathsData::curveTo() searches for the end
+					 //of the path on every call
+					outline.flush_n();
 					for (int c2=1; c2<points.n; c2+=3) {
-						paths->curveTo(points.e[c2+1], points.e[(c2+2)%points.n], points.e[(c2+3)%points.n]);
+						p1=points.e[c2+1];            outline.push(flatpoint(p1.x,p1.y, LINE_Bez));
+						p1=points.e[(c2+2)%points.n]; outline.push(flatpoint(p1.x,p1.y, LINE_Bez));
+						p1=points.e[(c2+3)%points.n]; outline.push(flatpoint(p1.x,p1.y, LINE_Vertex));
 					}
 
+					if (paths->paths.n==paths->paths.Allocated()) paths->paths.Allocate(2*paths->paths.n+64);
+					paths->moveTo(points.e[1]);
+					paths->appendCoord(FlatpointToCoordinate(outline.e,outline.n));
 					paths->close();
 
 					points.flush_n();
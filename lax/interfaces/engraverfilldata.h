@@ -363,8 +363,15 @@ class TraceObject : public Laxkit::Resourceable, public Laxkit::DumpUtility
 	char *image_file;
 
 	int samplew, sampleh;
-	unsigned char *trace_sample_cache;
+	unsigned char *trace_sample_cache; //BGRA, as rendered
 	std::time_t cachetime;
+	std::clock_t cache_modtime; //object->modtime when cache was last updated
+
+	 //value pyramid made from trace_sample_cache, 2 bytes per pixel: value (0 white, 255 black), then alpha.
+	 //Level 0 is samplew x sampleh with row 0 at object->miny, each next level is half the size of the last.
+	int num_levels;
+	int *level_w, *level_h;
+	unsigned char **levels;
 
 	 //black and white cache:
 	int tw,th; //dims of trace_ref_bw
@@ -379,9 +386,12 @@ class TraceObject : public Laxkit::Resourceable, public Laxkit::DumpUtility
 	virtual Laxkit::Attribute *dump_out_atts(Laxkit::Attribute *att,int what,Laxkit::DumpContext *savecontext);
 	virtual void dump_in_atts(Laxkit::Attribute *att,int flag,Laxkit::DumpContext *context);
 	
-	double GetValue(LinePoint *p, double *transform);
+	double GetValue(LinePoint *p, double *transform, double footprint=0);
+	double GetValue(Laxkit::flatpoint p, double footprint=0, double *alpha_ret=NULL);
+	void GetValues(const Laxkit::flatpoint *points, int n, double *values_ret, double *alphas_ret, double footprint=0);
 	void ClearCache(bool obj_too);
 	int UpdateCache();
+	void UpdateLevels(int x1, int y1, int x2, int y2);
 	int NeedsUpdating();
 
 	void Install(TraceObjectType ntype, SomeData *obj);
@@ -555,24 +565,39 @@ class StarterPoint
 
 
 //------------------------ GrowContext --------------------------
+
+#define GROW_MERGE_SPACE  .9  //a growing end stops when this close to another line, as a fraction of spacing
+#define GROW_TIME_SLICE   .01 //default seconds of work per GrowLines_Iterate()
+#define GROW_CHECKS_PER_STEP 1000 //most gaps checked per GrowLines_Step()
+#define GROW_ITERATION_LIMIT 1000 //default for EngraverDirection::grow_iteration_limit
+#define GROW_SCRATCH_BITS 14 //GrowContext::scratch_blocks each hold 1<<GROW_SCRATCH_BITS points
+
 class GrowContext
 {
   public:
   	struct ScratchData
   	{
   		int group;
-  		int line;
-  		int point;
-  		Laxkit::flatpoint dir;
+  		int line; //index in group's lines
+  		int point; //steps from the line's starter point, negative for before it
+  		int next; //next point in the same grid cell, or -1
+  		Laxkit::flatpoint p; //position, in the same units as bounds
   	};
 
   	bool active = true;
-  	ScratchData *scratch_data = nullptr;
+  	Laxkit::PtrStack<ScratchData> scratch_blocks; //one ScratchData per grown point, chained per grid cell
+	int scratch_n = 0;
+	int *grid = nullptr; //grid_w x grid_h cells over bounds, each the index of the first ScratchData in it, or -1
+	int grid_w = 0, grid_h = 0;
+	double grid_cell = 0;
+	Laxkit::DoubleBBox bounds; //growing happens in [0..xsize/3, 0..ysize/3]
 
   	GrowContext();
-  	~GrowContext();
+  	virtual ~GrowContext();
 
   	Laxkit::PtrStack<StarterPoint> generators;
+	Laxkit::NumStack<Laxkit::flatpoint> split_points; //gaps found beside growing lines, to start new lines in later
+	Laxkit::flatpoint fill_point; //where the scan for holes left off
 
   	//EngraverDirection *direction;
   	//EngraverSpacing *spacing;
@@ -582,6 +607,8 @@ class GrowContext
 
   	int iteration = 0;
 	int iteration_limit;
+	int next_generator = -1; //where a time limited GrowLines_Step() stopped, or -1 to start a new round
+	double time_slice = GROW_TIME_SLICE;
 
   	EngraverFillData *data = nullptr;
 	double resolution = -1; 
@@ -594,6 +621,13 @@ class GrowContext
 
 	Laxkit::flatpoint directionv;
 	DirectionMap *directionmap = nullptr;
+
+	virtual void InitGrid(Laxkit::DoubleBBox &box, double cell);
+	virtual int Cell(Laxkit::flatpoint p);
+	virtual void ClearGrid();
+	virtual int Mark(Laxkit::flatpoint p, int group, int line, int point);
+	ScratchData *Scratch(int i) { return scratch_blocks.e[i >> GROW_SCRATCH_BITS] + (i & ((1<<GROW_SCRATCH_BITS)-1)); }
+	virtual bool Occupied(Laxkit::flatpoint p, double radius, int line, int point, int window);
 };
 
 
@@ -658,6 +692,7 @@ class EngraverDirection : public Laxkit::Resourceable, public Laxkit::DumpUtilit
 	bool scale_profile;
 
 	bool grow_lines;
+	int grow_iteration_limit; //most rounds of growing before giving up
 	bool fill;
 	bool merge;
 	double spread;
@@ -801,8 +836,11 @@ class EngraverPointGroup : public DirectionMap
 								int iteration_limit,
 								Laxkit::PtrStack<GrowPointInfo> *custom_starters
 								);
+	virtual bool GrowLines_Step(long long deadline = 0);
 	virtual bool GrowLines_Iterate();
+	virtual void GrowLines_Cancel();
 	virtual void GrowLines_Finish();
+	virtual bool Growing() { return grow_cache && grow_cache->active; }
 
 	virtual void UpdateBezCache();
 	virtual void UpdatePositionCache();
@@ -863,6 +901,7 @@ class EngraverFillData : virtual public PatchData
 	virtual SomeData *duplicate(SomeData *dup);
 	virtual int renderToBuffer(unsigned char *buffer, int bufw, int bufh, int bufstride, int bufdepth, int bufchannels);
 	virtual int renderToBufferImage(Laxkit::LaxImage *image);
+	virtual Laxkit::PreviewRender *NewPreviewRender() { return nullptr; } //renderToBufferImage() is not thread safe
 
 	virtual double DefaultSpacing(double nspacing);
 	virtual void MakeDefaultGroup();
@@ -156,6 +156,7 @@ EngraverFillInterface::EngraverFillInterface(int nid,Displayer *ndp)
 	mode=controlmode=EMODE_Mesh;
 
 	directionmap=NULL;
+	grow_timer=0;
 
 	curvemapi.owner=this;
 	curvemapi.ChangeEditable(CurveMapInterface::YMax, 1);
@@ -331,6 +332,7 @@ void EngraverFillInterface::deletedata(bool flush_selection)
 //! Flush curpoints.
 int EngraverFillInterface::InterfaceOff()
 {
+	CancelGrow();
 	PatchInterface::InterfaceOff();
 	curvemapi.SetInfo(NULL);
     return 0;
@@ -2901,7 +2903,7 @@ int EngraverFillInterface::Refresh()
 				{
 					dp->NewFG(activate_color);
 				
-					p = group->grow_cache->generators.e[c]->last->p;
+					p.set(group->grow_cache->generators.e[c]->last->s, group->grow_cache->generators.e[c]->last->t);
 					v = group->Direction(p.x, p.y);
 					v.normalize();
 					p2 = edata->getPoint(p.x + .01 * v.x, p.y + .01 * v.y, false);
@@ -2922,7 +2924,7 @@ int EngraverFillInterface::Refresh()
 				{
 					dp->NewFG(activate_color); 
 				
-					p = group->grow_cache->generators.e[c]->first->p;
+					p.set(group->grow_cache->generators.e[c]->first->s, group->grow_cache->generators.e[c]->first->t);
 					v = group->Direction(p.x, p.y);
 					v.normalize();
 					p2 = edata->getPoint(p.x + .01 * v.x, p.y + .01 * v.y, false);
@@ -5068,11 +5070,62 @@ int EngraverFillInterface::Grow(bool all, bool allindata)
 					 group->spacing->spacing, NULL,
 					 .01, NULL,
 					 group->directionv,group,
-					 1000, //iteration limit
+					 group->direction->grow_iteration_limit,
 					 nullptr //&group->growpoints
 					);
+	group->needtoreline=true;
 	edata->touchContents();
 
+	 //grow a little at a time, so editing is not blocked
+	if (!grow_timer) grow_timer=app->addtimer(this, 1000/30, 1000/30, -1);
+	needtodraw=1;
+
+	return 0;
+}
+
+/*! Stop any growing lines in edata, keeping what has grown so far.
+ */
+int EngraverFillInterface::CancelGrow()
+{
+	if (grow_timer) {
+		app->removetimer(this, grow_timer);
+		grow_timer=0;
+	}
+	if (!edata) return 1;
+
+	for (int c=0; c<edata->groups.n; c++) {
+		EngraverPointGroup *group=edata->groups.e[c];
+		if (!group->Growing()) continue;
+
+		group->GrowLines_Cancel();
+		group->needtoreline=false;
+		group->UpdateBezCache();
+		edata->touchContents();
+		needtodraw=1;
+	}
+
+	return 0;
+}
+
+/*! Step any growing lines in edata, see Grow().
+ */
+int EngraverFillInterface::Idle(int tid, double delta)
+{
+	if (tid!=grow_timer) return 1; //1 means remove timer
+
+	bool growing=false;
+	if (edata) {
+		edata->Update();
+		for (int c=0; c<edata->groups.n; c++) {
+			if (edata->groups.e[c]->Growing()) { growing=true; break; }
+		}
+	}
+
+	needtodraw=1;
+	if (!growing) {
+		grow_timer=0;
+		return 1;
+	}
 	return 0;
 }
 
@@ -5202,7 +5255,10 @@ int EngraverFillInterface::ActivatePathInterface()
 
 int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *mes)
 {
-	if (!strcmp(mes,"menuevent")) {
+	 //compare lark ids rather than strcmp down the whole chain
+	int mes_id = EventMessageId(e_data, mes);
+
+	if (EventMessageIs(mes_id, mes, LARK("menuevent"))) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 		int i     =s->info2; //id of menu item
 		unsigned int interf=s->info4; //is curvemapi.object_id if from there
@@ -5253,7 +5309,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 
 		return 0;
 
-	} else if (!strcmp(mes,"traceobjectmenu")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("traceobjectmenu"))) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 		int id  =s->info2; //id of menu item
 		int info=s->info4; //is menuitem info
@@ -5338,7 +5394,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		return 0;
 
 
-	} else if (!strcmp(mes,"PathInterface")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("PathInterface"))) {
         if (data) {
             data->UpdateFromPath();
 
@@ -5353,7 +5409,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
         }
         return 0;
 
-	} else if (!strcmp(mes,"dashlength")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("dashlength"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 		EngraverPointGroup *group=edata->GroupFromIndex(current_group);
@@ -5366,7 +5422,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		}
  		return 0;
 
-	} else if (!strcmp(mes,"dashseed")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("dashseed"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 		EngraverPointGroup *group=edata->GroupFromIndex(current_group);
@@ -5380,7 +5436,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 
  		return 0;
 
-	} else if (!strcmp(mes,"defaultspacing")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("defaultspacing"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 		EngraverPointGroup *group=edata->GroupFromIndex(current_group);
@@ -5398,7 +5454,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
  		return 0;
 
-	} else if (!strcmp(mes,"newcolor")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("newcolor"))) {
  		//got a new color for current group
     	const SimpleColorEventData *ce=dynamic_cast<const SimpleColorEventData *>(e_data);
         if (!ce) return 1;
@@ -5434,7 +5490,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
 		return 0;
 
-	} else if (!strcmp(mes,"renameobject")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renameobject"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 		if (eventobject==edata->object_id) {
@@ -5444,7 +5500,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
 		return 0;
 
-	} else if (!strcmp(mes,"renamegroup")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renamegroup"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 
@@ -5464,7 +5520,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
  		return 0;
 
-	} else if (!strcmp(mes,"renametraceobject")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renametraceobject"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 
@@ -5475,7 +5531,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
 		return 0;
 
-	} else if (!strcmp(mes,"renametrace")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renametrace"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 
@@ -5495,7 +5551,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
  		return 0;
 
-	} else if (!strcmp(mes,"renamedash")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renamedash"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 
@@ -5506,7 +5562,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
  		return 0;
 
-	} else if (!strcmp(mes,"renamespacing")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renamespacing"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 
@@ -5517,7 +5573,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
  		return 0;
 
-	} else if (!strcmp(mes,"renamedirection")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("renamedirection"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 
@@ -5528,7 +5584,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
  		return 0;
 
-	} else if (!strcmp(mes,"exportsvg")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("exportsvg"))) {
         if (!edata) return 0;
 
         const StrEventData *s=dynamic_cast<const StrEventData *>(e_data);
@@ -5539,7 +5595,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		}
         return 0;
 
-	} else if (!strcmp(mes,"exportsnapshot")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("exportsnapshot"))) {
         if (!edata) return 0;
 
         const StrEventData *s=dynamic_cast<const StrEventData *>(e_data);
@@ -5556,7 +5612,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		PostMessage(_("Snapshot exported."));
         return 0;
 
-	} else if (!strcmp(mes,"savetraceimage")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("savetraceimage"))) {
         const StrEventData *s=dynamic_cast<const StrEventData *>(e_data);
 		if (!s || isblank(s->str)) return 0;
 
@@ -5573,7 +5629,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 
 		return 0;
 
-	} else if (!strcmp(mes,"loadimage")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("loadimage"))) {
         const StrEventData *s=dynamic_cast<const StrEventData *>(e_data);
 		if (!s || isblank(s->str)) return 0;
 		LaxImage *img = ImageLoader::LoadImage(s->str);
@@ -5614,7 +5670,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		PostMessage(_("Image to trace loaded."));
 		return 0;
 
-	} else if (!strcmp(mes,"loadnormal")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("loadnormal"))) {
         const StrEventData *s=dynamic_cast<const StrEventData *>(e_data);
 		if (!s || isblank(s->str)) return 0;
 
@@ -5651,20 +5707,20 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		PostMessage(_("Normal map loaded."));
 		return 0;
 
-	} else if (!strcmp(mes,"sharedirection")
-				|| !strcmp(mes,"sharedash")
-				|| !strcmp(mes,"sharespacing")
-				|| !strcmp(mes,"sharetrace")
+	} else if (EventMessageIs(mes_id, mes, LARK("sharedirection"))
+				|| EventMessageIs(mes_id, mes, LARK("sharedash"))
+				|| EventMessageIs(mes_id, mes, LARK("sharespacing"))
+				|| EventMessageIs(mes_id, mes, LARK("sharetrace"))
 					) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 		int i =s->info2; //id of menu item
 		int info =s->info4; //info of menu item
 
 		int what=0;
-		if (!strcmp(mes,"sharedirection"))    what=ENGRAVE_Direction;
-		else if (!strcmp(mes,"sharedash"))    what=ENGRAVE_Dashes;
-		else if (!strcmp(mes,"sharespacing")) what=ENGRAVE_Spacing;
-		else if (!strcmp(mes,"sharetrace"))   what=ENGRAVE_Tracing;
+		if (EventMessageIs(mes_id, mes, LARK("sharedirection")))    what=ENGRAVE_Direction;
+		else if (EventMessageIs(mes_id, mes, LARK("sharedash")))    what=ENGRAVE_Dashes;
+		else if (EventMessageIs(mes_id, mes, LARK("sharespacing"))) what=ENGRAVE_Spacing;
+		else if (EventMessageIs(mes_id, mes, LARK("sharetrace")))   what=ENGRAVE_Tracing;
 
 
 		if (info==-3) {
@@ -5744,7 +5800,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
 		return 0;
 
-	} else if (!strcmp(mes,"quickadjust")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("quickadjust"))) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 		
 		double factor;
@@ -5754,7 +5810,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		}
 		return 0; 
 
-	} else if (!strcmp(mes,"orientspacing")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("orientspacing"))) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 		
 		double spacing;
@@ -5774,7 +5830,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		}
 		return 0;
 
-	} else if (!strcmp(mes,"orientdirection")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("orientdirection"))) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 		
 		double angle;
@@ -5796,7 +5852,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		return 0;
 
 		//-----------------------Direction related
-	} else if (!strcmp(mes,"directiontype")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("directiontype"))) {
 		EngraverPointGroup *group=(edata ? edata->GroupFromIndex(current_group) : NULL);
 		if (!group) return 0;
 
@@ -5816,7 +5872,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		needtodraw=1;
 		return 0;
 
-	} else if (!strcmp(mes,"lineprofilemenu")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("lineprofilemenu"))) {
     	const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
 
 		EngraverPointGroup *group=edata->GroupFromIndex(current_group);
@@ -5838,7 +5894,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 		}
 		return 0;
 
-	} else if (!strcmp(mes,"directionseed")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("directionseed"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 		EngraverPointGroup *group=edata->GroupFromIndex(current_group);
@@ -5853,7 +5909,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 
 
 		//-----------------------Spacing related
-	} else if (!strcmp(mes,"spacingmenu")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("spacingmenu"))) {
         const SimpleMessage *s=dynamic_cast<const SimpleMessage*>(e_data);
         if (!edata || isblank(s->str)) return 0;
 		EngraverPointGroup *group=edata->GroupFromIndex(current_group);
@@ -5877,7 +5933,7 @@ int EngraverFillInterface::Event(const Laxkit::EventData *e_data, const char *me
 
 
 		//-----------------------other
-	} else if (!strcmp(mes,"FreehandInterface")) {
+	} else if (EventMessageIs(mes_id, mes, LARK("FreehandInterface"))) {
 		 //got new freehand mesh
 
         const RefCountedEventData *s=dynamic_cast<const RefCountedEventData *>(e_data);
@@ -6186,6 +6242,11 @@ int EngraverFillInterface::CharInput(unsigned int ch, const char *buffer,int len
 		}
 	}
 
+	if (ch==LAX_Esc && grow_timer) {
+		CancelGrow();
+		return 0;
+	}
+
 	if (	 mode==EMODE_Thickness
 		  || mode==EMODE_Blockout
 		  || mode==EMODE_Turbulence
@@ -106,6 +106,7 @@ class EngraverFillInterface : public PatchInterface
 	bool show_trace_object;
 	bool show_object;
 	bool grow_lines;
+	int grow_timer; //drives GrowLines_Iterate() while any group in edata is growing
 	bool always_warp;
 	bool auto_reline;
 	//Laxkit::CurveInfo tracemap;
@@ -175,6 +176,7 @@ class EngraverFillInterface : public PatchInterface
 	virtual int CharInput(unsigned int ch,const char *buffer,int len,unsigned int state,const Laxkit::LaxKeyboard *d);
 	virtual int KeyUp(unsigned int ch,unsigned int state,const Laxkit::LaxKeyboard *d);
 	virtual int Refresh();
+	virtual int Idle(int tid, double delta);
 	virtual int Event(const Laxkit::EventData *data, const char *mes);
 	virtual Laxkit::MenuInfo *ContextMenu(int x,int y,int deviceid, Laxkit::MenuInfo *menu);
 	virtual int InterfaceOff();
@@ -189,6 +191,7 @@ class EngraverFillInterface : public PatchInterface
 	virtual int Trace(bool do_once=false);
 	virtual int Reline(bool do_once=true, int which=3);
 	virtual int Grow(bool alldir, bool allindata);
+	virtual int CancelGrow();
 
 	virtual int AddToSelection(ObjectContext *oc);
 };
@@ -537,14 +537,36 @@ int FreehandInterface::MouseMove(int x,int y,unsigned int state, const Laxkit::L
 	flatpoint p=dp->screentoreal(x,y);
 	RawPointLine *line=lines.e[i];
 
+	tms tms_;
+	clock_t now=times(&tms_);
+
+	 //motion events might have been merged, so add any skipped samples first.
+	 //Sample times are X server milliseconds, so convert to clock ticks relative to now.
+	int nhistory=0;
+	const MotionSample *history=d->MotionHistory(&nhistory);
+	for (int c=0; c<nhistory; c++) {
+		RawPoint *hp=new RawPoint(dp->screentoreal(history[c].x,history[c].y));
+		hp->pressure=history[c].pressure;
+		hp->tiltx   =history[c].tiltx;
+		hp->tilty   =history[c].tilty;
+		hp->time    =now - (clock_t)((d->current_motion->xlib_time - history[c].time) * sysconf(_SC_CLK_TCK) / 1000);
+		if (hp->pressure<0 || hp->pressure>1) hp->pressure=1;
+		line->push(hp);
+	}
+
 	RawPoint *pp=new RawPoint(p);
 
-	double xx,yy;
-	const_cast<LaxMouse*>(d)->getInfo(NULL,NULL,NULL,&xx,&yy,NULL,&pp->pressure,&pp->tiltx,&pp->tilty,NULL);
+	if (d->current_motion) {
+		 //the event already carries valuators, no need to query the device
+		pp->pressure=d->current_motion->pressure;
+		pp->tiltx   =d->current_motion->tilt;
+		pp->tilty   =d->current_motion->tilty;
+	} else {
+		double xx,yy;
+		const_cast<LaxMouse*>(d)->getInfo(NULL,NULL,NULL,&xx,&yy,NULL,&pp->pressure,&pp->tiltx,&pp->tilty,NULL);
+	}
 
-	tms tms_;
-	pp->time=times(&tms_);
-	p=dp->screentoreal(xx,yy);
+	pp->time=now;
 	if (pp->pressure<0 || pp->pressure>1) pp->pressure=1; //non-pressure sensitive map to full pressure
 	line->push(pp);
 
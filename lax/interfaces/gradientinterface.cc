@@ -1510,7 +1510,7 @@ int GradientInterface::Refresh()
 	if ((showdecs & ShowColors) && data->strip->colors.n) {
 		int d = 1;
 		if (usepreview) {
-			LaxImage *preview = data->GetPreview();
+			LaxImage *preview = data->GetPreviewAsync(curwindow ? curwindow->object_id : 0);
 			if (preview) {
 				d = dp->imageout(preview,data->minx,data->miny, data->maxx-data->minx, data->maxy-data->miny);
 				if (d<0) d=1; else d=0; //draw lines if problem with image
@@ -1014,11 +1014,13 @@ int ImageInterface::LBUp(int x,int y,unsigned int state,const Laxkit::LaxMouse *
 			if (!undomanager) return 0;
 
 			Affine mo(m_orig);
-			undomanager->AddUndo(new SomeDataUndo(data,
+			SomeDataUndo *undo = new SomeDataUndo(data,
 										&mo,NULL,
 										data,NULL,
 										SomeDataUndo::SDUNDO_Transform,
-										false));
+										false);
+			undo->coalesce_key = SomeDataUndo::SDUNDO_Transform;
+			undomanager->AddUndo(undo);
 		}
 	}
 
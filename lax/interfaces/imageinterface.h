@@ -48,6 +48,7 @@ class ImageData : public Laxkit::ImageInfo, virtual public SomeData
 	virtual const char *whattype() { return "ImageData"; }
 	ImageData &operator=(ImageData &i);
 	virtual SomeData *duplicate(SomeData *dup);
+	virtual Laxkit::PreviewRender *NewPreviewRender() { return nullptr; } //duplicates share image, which is not thread safe
 
 	virtual void Flip(int horiz);
 	virtual void Flip(Laxkit::flatpoint f1, Laxkit::flatpoint f2);
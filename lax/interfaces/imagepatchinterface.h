@@ -60,6 +60,7 @@ class ImagePatchData : public PatchData
 	virtual int SetImage(const char *fname);
 
 	virtual int renderToBufferImage(Laxkit::LaxImage *image);
+	virtual Laxkit::PreviewRender *NewPreviewRender() { return nullptr; } //previews come from renderToBuffer(), not a tool
 };
 
 
@@ -247,15 +247,7 @@ int InterfaceManager::DrawData(Displayer *dp,SomeData *data,anObject *a1,anObjec
 int InterfaceManager::DrawDataStraight(Laxkit::Displayer *dp,LaxInterfaces::SomeData *data,
 							Laxkit::anObject *a1,Laxkit::anObject *a2,unsigned int info)
 {
-	if (!tools) return -1;
-
-	ResourceType *interfs = tools->FindType("tools");
-	anInterface *interf=NULL;
-
-	for (int c=0; c<interfs->resources.n; c++) {
-		interf=dynamic_cast<anInterface*>(interfs->resources.e[c]->object);
-		if (interf && interf->draws(data->whattype())) break;
-	}
+	anInterface *interf = GetDrawer(data);
 
 	if (interf) {
 		interf->DrawDataDp(dp,data,a1,a2);
@@ -265,6 +257,24 @@ int InterfaceManager::DrawDataStraight(Laxkit::Displayer *dp,LaxInterfaces::Some
 	return -1;
 }
 
+/*! Return the tool that draws data, or NULL if none does. This is the tool instance in
+ * GetTools(), so if you need one to use on its own, such as in another thread, use a duplicate() of it.
+ */
+anInterface *InterfaceManager::GetDrawer(LaxInterfaces::SomeData *data)
+{
+	if (!tools || !data) return NULL;
+
+	ResourceType *interfs = tools->FindType("tools");
+	if (!interfs) return NULL;
+
+	for (int c=0; c<interfs->resources.n; c++) {
+		anInterface *interf=dynamic_cast<anInterface*>(interfs->resources.e[c]->object);
+		if (interf && interf->draws(data->whattype())) return interf;
+	}
+
+	return NULL;
+}
+
 /*! Return the square edge length in pixels to use as the default preview size for SomeData objects
  * that use the SomeData::GetPreview() mechanism.
  *
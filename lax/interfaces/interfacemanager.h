@@ -91,6 +91,7 @@ class InterfaceManager : public Laxkit::anObject
 
 	virtual int DrawData(Laxkit::Displayer *dp, LaxInterfaces::SomeData *ndata,
 							Laxkit::anObject *a1=NULL, Laxkit::anObject *a2=NULL, unsigned int info=0);
+	virtual anInterface *GetDrawer(LaxInterfaces::SomeData *data);
 	virtual int DrawDataStraight(Laxkit::Displayer *dp, LaxInterfaces::SomeData *ndata,
 							Laxkit::anObject *a1=NULL, Laxkit::anObject *a2=NULL, unsigned int info=0);
 
@@ -567,11 +567,14 @@ int ObjectInterface::InstallTransformUndo()
 	}
 
 	for (int c=0; c<selection->n(); c++) {
-		undomanager->AddUndo(new SomeDataUndo(selection->e(c)->obj,
+		SomeDataUndo *undo = new SomeDataUndo(selection->e(c)->obj,
 									initial.e[c],NULL,
 									selection->e(c)->obj,NULL,
 									SomeDataUndo::SDUNDO_Transform,
-									(c==0 ? false : true)));
+									(c==0 ? false : true));
+		 //quick successive changes to one object can merge, see UndoManager::SetCoalesceTime()
+		if (selection->n() == 1) undo->coalesce_key = SomeDataUndo::SDUNDO_Transform;
+		undomanager->AddUndo(undo);
 	}
 
 	UpdateInitial();
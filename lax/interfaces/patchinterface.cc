@@ -31,6 +31,7 @@
 #include <lax/laxutils.h>
 #include <lax/bezutils.h>
 #include <lax/language.h>
+#include <lax/workerpool.h>
 
 #include <iostream>
 using namespace std;
@@ -647,6 +648,17 @@ Laxkit::Attribute *PatchData::dump_out_atts(Laxkit::Attribute *att,int what,Laxk
 
     Utf8String s,s2;
     s2.Sprintf("%dx%d",xsize,ysize);
+	if (context && context->format==ATT_Binary) {
+		 //x,y pairs, in a double blob
+		att2 = att->pushBlob("points", ATTBLOB_Double, 2*xsize*ysize, nullptr, s2.c_str());
+		double *d = (double*)att2->blob->Data();
+		for (int c=0; c<xsize*ysize; c++) {
+			*d++ = points[c].x;
+			*d++ = points[c].y;
+		}
+		return att;
+	}
+
 	att2 = att->pushSubAtt("points", nullptr, s2.c_str());
 	for (int c=0; c<xsize*ysize; c++) {
 		s2.Sprintf("%.10g %.10g\n", points[c].x,points[c].y);
@@ -714,7 +726,14 @@ void PatchData::dump_in_atts(Attribute *att,int flag,Laxkit::DumpContext *contex
 		if (points) delete[] points;
 		points=new flatpoint[xsize*ysize];
 
-		for (c=0; c<xsize*ysize; c++) {
+		AttributeBlob *blob = att->attributes.e[p]->blob;
+		if (blob && blob->Doubles() && blob->n >= 2*xsize*ysize) {
+			const double *d = blob->Doubles();
+			for (c=0; c<xsize*ysize; c++) {
+				points[c].x = d[2*c];
+				points[c].y = d[2*c+1];
+			}
+		} else for (c=0; c<xsize*ysize; c++) {
 			DoubleAttribute(value,&x,&name);
 			if (name!=value) {
 				points[c].x=x;
@@ -2464,15 +2483,21 @@ int PatchData::hasColorData()
 int PatchData::WhatColor(double s,double t,ScreenColor *color_ret)
 { return 1; }
 
-//! Write to buffer assuming samples are 8 bit ARGB.
+#define PATCH_TILE_SIZE     64  //width and height in pixels of the tiles renderToBuffer() splits the buffer into
+#define PATCH_LEAF_SAMPLES  128 //most samples in each direction renderTile() will compute at once
+#define PATCH_SAMPLE_GAP    .7  //max pixel distance between samples in renderTile()
+
+//! Write to buffer assuming samples are 8 or 16 bit ARGB.
 /*! Blanks out the buffer, then renders the patch into it, if any.
  * 
- * Currently, buffer is width x height pixels, and must be 8bit ARGB.
+ * Currently, buffer is width x height pixels, and must be 8 or 16 bit per channel ARGB, with channels in
+ * BGRA order in memory. For 16 bit, buffer must be aligned for unsigned short.
  *
- * Subclasses need not redefine this function, rpatchpoint(), or patchpoint(). They need only
- * redefine WhatColor().
+ * The buffer is split into tiles of PATCH_TILE_SIZE pixels, which are cleared and rendered in parallel
+ * with WorkerPool::Default(). Each tile only renders the subpatches whose bounds touch it, via renderTile().
  *
- * \todo *** this is EXTREMELY innefficient
+ * Subclasses need not redefine this function, rpatchpoint(), or patchpoint(). They need only
+ * redefine WhatColor(), which must be safe to call from several threads at once.
  */
 int PatchData::renderToBuffer(unsigned char *buffer, int bufw, int bufh, int bufstride, int bufdepth, int bufchannels)
 {
@@ -2480,82 +2505,235 @@ int PatchData::renderToBuffer(unsigned char *buffer, int bufw, int bufh, int buf
 
 	//DBG cerr <<"...Render "<<whattype()<<" to buffer, w,h:"<<bufw<<','<<bufh<<" rdepth="<<renderdepth<<endl;
 
-	if (bufdepth!=8 || bufchannels!=4) {
-		cerr <<" *** must implement ImagePatchData::renderToBuffer() for non 8 bit rgba!!"<<endl;
+	if ((bufdepth!=8 && bufdepth!=16) || bufchannels!=4) {
+		cerr <<" *** must implement PatchData::renderToBuffer() for other than 8 or 16 bit rgba!!"<<endl;
 		return 1;
 	}
 	if (bufstride==0) bufstride=bufw*bufdepth/8*bufchannels;
-	memset(buffer,0,bufw*bufh*4); //make it totally transparent
-
-	if (!hasColorData()) return 0; //blank out the buffer, but don't try to render if there is no color data!!
-	
-	PatchRenderContext context;
-
-	context.buffer=buffer;
-	context.bufferwidth=bufw;
-	context.bufferheight=bufh;
-	context.stride=bufstride;
-	
-
-	int r,c,roff,coff;
-	flatpoint fp;
-	double C[16],Gty[16],Gtx[16];
-	DoubleBBox bufbox(0,bufw,0,bufh), 
-			   bbox;
-
-	 //create transform taking object space to buffer space
-	double a=(maxx-minx)/bufw,
-		   d=(miny-maxy)/bufh;
-	double m[6]; //takes points from i to buffer
-	m[0]=1/a;
-	m[1]=0;
-	m[2]=0;
-	m[3]=1/d;
-	m[4]=-minx/a;
-	m[5]=-maxy/d;
-	
-	 //for each patch, create the proper matrices, then call rpatchpoint()
-	for (roff=0; roff<ysize/3; roff++) {
-		for (coff=0; coff<xsize/3; coff++) {
-			getGt(Gtx,roff*3,coff*3,0);
-			getGt(Gty,roff*3,coff*3,1);
-			bbox.ClearBBox();
-			for (r=0; r<4; r++) {
-				for (c=0; c<4; c++) {
-					fp=flatpoint(Gtx[c*4+r],Gty[c*4+r]);//fp is in object space, not buffer space
-					fp=transform_point(m,fp); //transform to buffer space
-					Gtx[c*4+r]=fp.x;
-					Gty[c*4+r]=fp.y;
-					bbox.addtobounds(fp);
+	int pixelsize = bufdepth/8*bufchannels;
+
+
+	 //set up render context for each subpatch that touches the buffer
+	int npatches = 0;
+	PatchRenderContext *contexts = NULL;
+	DoubleBBox *boxes = NULL;
+
+	if (hasColorData() && xsize>=4 && ysize>=4) { //don't try to render if there is no color data!!
+		int r,c,roff,coff;
+		flatpoint fp;
+		double C[16],Gty[16],Gtx[16];
+		DoubleBBox bufbox(0,bufw,0,bufh), 
+				   bbox;
+
+		 //create transform taking object space to buffer space
+		double a=(maxx-minx)/bufw,
+			   d=(miny-maxy)/bufh;
+		double m[6]; //takes points from i to buffer
+		m[0]=1/a;
+		m[1]=0;
+		m[2]=0;
+		m[3]=1/d;
+		m[4]=-minx/a;
+		m[5]=-maxy/d;
+
+		contexts = new PatchRenderContext[(ysize/3)*(xsize/3)];
+		boxes    = new DoubleBBox[(ysize/3)*(xsize/3)];
+		
+		for (roff=0; roff<ysize/3; roff++) {
+			for (coff=0; coff<xsize/3; coff++) {
+				getGt(Gtx,roff*3,coff*3,0);
+				getGt(Gty,roff*3,coff*3,1);
+				bbox.ClearBBox();
+				for (r=0; r<4; r++) {
+					for (c=0; c<4; c++) {
+						fp=flatpoint(Gtx[c*4+r],Gty[c*4+r]);//fp is in object space, not buffer space
+						fp=transform_point(m,fp); //transform to buffer space
+						Gtx[c*4+r]=fp.x;
+						Gty[c*4+r]=fp.y;
+						bbox.addtobounds(fp);
+					}
 				}
-			}
-			//***is this check necessary?? this version of render assumes whole patch on buffer....
-			if (!bufbox.intersect(&bbox,0)) continue;
-			
-			m_times_m(B,Gty,C);
-			m_times_m(C,B,context.Cy);
-			m_times_m(B,Gtx,C);
-			m_times_m(C,B,context.Cx);  //Cx = B Gtx B
-			
-			context.s0=coff*3./(xsize-1); //point in range [0..1]
-			context.ds=3./(xsize-1);      //portion of [0..1] occupied by a single mesh square
-			context.t0=roff*3./(ysize-1);
-			context.dt=3./(ysize-1);
-			//DBG cerr <<" draw patch s:"<<context.s0<<','<<context.ds<<"  t:"<<context.t0<<','<<context.dt<<endl;
+				if (!bufbox.intersect(&bbox,0)) continue;
+
+				PatchRenderContext &context = contexts[npatches];
+				context.buffer=buffer;
+				context.bufferwidth=bufw;
+				context.bufferheight=bufh;
+				context.stride=bufstride;
+				context.numchannels=bufchannels;
+				context.bitsperchannel=bufdepth;
+				
+				m_times_m(B,Gty,C);
+				m_times_m(C,B,context.Cy);
+				m_times_m(B,Gtx,C);
+				m_times_m(C,B,context.Cx);  //Cx = B Gtx B
 				
-			//DBG d=0;
-			//DBG cerr <<(renderdepth==0?"rpatchpoint:":"patchpoint:")<<endl;
+				context.s0=coff*3./(xsize-1); //point in range [0..1]
+				context.ds=3./(xsize-1);      //portion of [0..1] occupied by a single mesh square
+				context.t0=roff*3./(ysize-1);
+				context.dt=3./(ysize-1);
 
-			
-			//if (renderdepth>=0) rpatchpoint(&context,flatpoint(),flatpoint(),flatpoint(),flatpoint(), 0.,0.,1.,1.,15);
-			//else if (renderdepth<0) patchpoint(&context, context.s0,context.ds,context.t0,context.dt, -renderdepth);
-			rpatchpoint(&context,flatpoint(),flatpoint(),flatpoint(),flatpoint(), 0.,0.,1.,1.,15);
+				boxes[npatches] = bbox;
+				npatches++;
+			}
 		}
 	}
+
+
+	 //clear and render each tile
+	int tilesx = (bufw + PATCH_TILE_SIZE-1) / PATCH_TILE_SIZE;
+	int tilesy = (bufh + PATCH_TILE_SIZE-1) / PATCH_TILE_SIZE;
+
+	WorkerPool::Default()->ParallelFor(tilesx*tilesy, [&](int index, int thread) {
+		IntRectangle tile((index%tilesx)*PATCH_TILE_SIZE, (index/tilesx)*PATCH_TILE_SIZE, PATCH_TILE_SIZE, PATCH_TILE_SIZE);
+		if (tile.x+tile.width  > bufw) tile.width  = bufw - tile.x;
+		if (tile.y+tile.height > bufh) tile.height = bufh - tile.y;
+
+		 //make it totally transparent
+		for (int y=tile.y; y<tile.y+tile.height; y++)
+			memset(buffer + y*bufstride + tile.x*pixelsize, 0, tile.width*pixelsize);
+
+		 //samples round to the nearest pixel, so tile covers [x-.5, x+w-.5)
+		for (int c=0; c<npatches; c++) {
+			if (boxes[c].maxx < tile.x-.5 || boxes[c].minx >= tile.x+tile.width-.5
+			 || boxes[c].maxy < tile.y-.5 || boxes[c].miny >= tile.y+tile.height-.5) continue;
+			renderTile(&contexts[c], tile, 0.,0.,1.,1., 0);
+		}
+	});
+
+	delete[] contexts;
+	delete[] boxes;
+
 	//DBG cerr <<"...done rendering to buffer"<<endl;
 	return 0;
 }
 
+/*! Set C_ret to the power basis coefficients of the part of a patch with coefficients C
+ * in [s1,s2]x[t1,t2], so that this part is covered by [0,1]x[0,1].
+ *
+ * With s=s1+h*u, S=M U, where M is like N in the matrix notes above, and then
+ * P = S^t C T = U^t (M^t C N) V.
+ */
+static void subRangeCoefficients(double *C, double s1,double s2, double t1,double t2, double *C_ret)
+{
+	double h=s2-s1, k=t2-t1;
+	double Mt[16]={ h*h*h,        0,       0,     0,
+					3*s1*h*h,     h*h,     0,     0,
+					3*s1*s1*h,    2*s1*h,  h,     0,
+					s1*s1*s1,     s1*s1,   s1,    1 };
+	double N[16]={  k*k*k,  3*t1*k*k,  3*t1*t1*k,  t1*t1*t1,
+					0,      k*k,       2*t1*k,     t1*t1,
+					0,      0,         k,          t1,
+					0,      0,         0,          1 };
+	double tmp[16];
+	m_times_m(C,N,tmp);
+	m_times_m(Mt,tmp,C_ret);
+}
+
+//! Write color to pixel (x,y) of context's 8 or 16 bit BGRA buffer.
+static inline void putPatchPixel(PatchRenderContext *context, int x,int y, const ScreenColor &color)
+{
+	if (context->bitsperchannel==16) {
+		unsigned short *p=(unsigned short*)(context->buffer + y*context->stride) + x*4;
+		p[0]=color.blue;
+		p[1]=color.green;
+		p[2]=color.red;
+		p[3]=color.alpha;
+	} else {
+		unsigned char *p=context->buffer + y*context->stride + x*4;
+		p[0]=(color.blue &0xff00)>>8;
+		p[1]=(color.green&0xff00)>>8;
+		p[2]=(color.red  &0xff00)>>8;
+		p[3]=(color.alpha&0xff00)>>8;
+	}
+}
+
+//! Render the part [s1,s2]x[t1,t2] of context's subpatch that lands in tile. Used by renderToBuffer().
+/*! The control net of the part is found from context->Cx and Cy. Since a bezier patch lies within the bounds
+ * of its control points, parts that miss the tile are skipped. Parts still too big to sample at once
+ * are split in half and recursed.
+ *
+ * Otherwise, the part is evaluated on a grid dense enough that neighboring samples are no more than
+ * PATCH_SAMPLE_GAP pixels apart, a whole row of s values at a time, and each sample is colored with WhatColor()
+ * and written to the nearest pixel.
+ */
+void PatchData::renderTile(PatchRenderContext *context, const IntRectangle &tile,
+						   double s1,double t1, double s2,double t2, int depth)
+{
+	double Cx[16],Cy[16], Gx[16],Gy[16], tmp[16];
+	subRangeCoefficients(context->Cx, s1,s2,t1,t2, Cx);
+	subRangeCoefficients(context->Cy, s1,s2,t1,t2, Cy);
+	m_times_m(Binv,Cx,tmp);
+	m_times_m(tmp,Binv,Gx);
+	m_times_m(Binv,Cy,tmp);
+	m_times_m(tmp,Binv,Gy);
+
+	 //skip if control points miss the tile
+	double minx=Gx[0], maxx=Gx[0], miny=Gy[0], maxy=Gy[0];
+	for (int c=1; c<16; c++) {
+		if (Gx[c]<minx) minx=Gx[c]; else if (Gx[c]>maxx) maxx=Gx[c];
+		if (Gy[c]<miny) miny=Gy[c]; else if (Gy[c]>maxy) maxy=Gy[c];
+	}
+	if (maxx < tile.x-.5 || minx >= tile.x+tile.width-.5 || maxy < tile.y-.5 || miny >= tile.y+tile.height-.5) return;
+
+	 //3 times the longest control polygon leg bounds the length of the derivative in that direction
+	double dsmax=0, dtmax=0, d;
+	for (int r=0; r<4; r++) {
+		for (int c=0; c<3; c++) {
+			d=flatpoint(Gx[(c+1)*4+r]-Gx[c*4+r], Gy[(c+1)*4+r]-Gy[c*4+r]).norm();
+			if (d>dsmax) dsmax=d;
+			d=flatpoint(Gx[r*4+c+1]-Gx[r*4+c], Gy[r*4+c+1]-Gy[r*4+c]).norm();
+			if (d>dtmax) dtmax=d;
+		}
+	}
+	int ns=ceil(3*dsmax/PATCH_SAMPLE_GAP), nt=ceil(3*dtmax/PATCH_SAMPLE_GAP);
+
+	if ((ns>PATCH_LEAF_SAMPLES || nt>PATCH_LEAF_SAMPLES) && depth<30) {
+		if (ns>=nt) {
+			renderTile(context, tile, s1,t1, (s1+s2)/2,t2, depth+1);
+			renderTile(context, tile, (s1+s2)/2,t1, s2,t2, depth+1);
+		} else {
+			renderTile(context, tile, s1,t1, s2,(t1+t2)/2, depth+1);
+			renderTile(context, tile, s1,(t1+t2)/2, s2,t2, depth+1);
+		}
+		return;
+	}
+	if (ns<1) ns=1; else if (ns>PATCH_LEAF_SAMPLES) ns=PATCH_LEAF_SAMPLES;
+	if (nt<1) nt=1; else if (nt>PATCH_LEAF_SAMPLES) nt=PATCH_LEAF_SAMPLES;
+
+
+	double U[PATCH_LEAF_SAMPLES+1], X[PATCH_LEAF_SAMPLES+1], Y[PATCH_LEAF_SAMPLES+1];
+	double T[4],Vx[4],Vy[4], u,v;
+	int x,y, x1=tile.x, x2=tile.x+tile.width, y1=tile.y, y2=tile.y+tile.height;
+	ScreenColor color;
+
+	for (int i=0; i<=ns; i++) U[i]=(double)i/ns;
+
+	for (int j=0; j<=nt; j++) {
+		v=(double)j/nt;
+		getT(T,v);
+		m_times_v(Cx,T,Vx);
+		m_times_v(Cy,T,Vy);
+
+		 //points along this row, with no branches so the compiler can vectorize it
+		for (int i=0; i<=ns; i++) {
+			u=U[i];
+			X[i]=((Vx[0]*u + Vx[1])*u + Vx[2])*u + Vx[3];
+			Y[i]=((Vy[0]*u + Vy[1])*u + Vy[2])*u + Vy[3];
+		}
+
+		for (int i=0; i<=ns; i++) {
+			x=(int)floor(X[i]+.5);
+			y=(int)floor(Y[i]+.5);
+			if (x<x1 || x>=x2 || y<y1 || y>=y2) continue;
+
+			if (WhatColor(context->s0 + context->ds*(s1+(s2-s1)*U[i]),
+						  context->t0 + context->dt*(t1+(t2-t1)*v), &color) != 0) continue;
+			putPatchPixel(context, x,y, color);
+		}
+	}
+}
+
 #define UL  1
 #define UR  2
 #define LL  4
@@ -3617,8 +3795,9 @@ int PatchInterface::Refresh()
 	int dopatches = 1;
 	if (rendermode == RENDER_Controls_Only) dopatches = 0;
 
-	if (rendermode == RENDER_Preview) {
-		LaxImage *preview=data->GetPreview();
+	 //usepreview is 0 while rendering the preview itself
+	if (rendermode == RENDER_Preview && data->usepreview) {
+		LaxImage *preview=data->GetPreviewAsync(curwindow ? curwindow->object_id : 0);
 		if (preview) {
 			dopatches = dp->imageout(preview,data->minx,data->miny, data->maxx-data->minx, data->maxy-data->miny);
 			//DBG if (d<0) cerr <<"- - - Patch do not use preview"<<endl; else cerr <<"- - - Patch using preview"<<endl;
@@ -3824,6 +4003,15 @@ void PatchInterface::drawControlPoint(int i, bool hovered)
 	dp->drawpoint(p.x,p.y,6*thin * (hovered ? 1.2 : 1),0);
 }
 
+//! Damage only the area around point i, such as when hoverpoint changes. See anInterface::Invalidate().
+void PatchInterface::invalidateControlPoint(int i)
+{
+	if (!data || i<0 || i>=data->xsize*data->ysize) return;
+
+	DoubleBBox box(realtoscreen(transform_point(data->m(), data->points[i])));
+	Invalidate(box, 8*ScreenLine());
+}
+
 /*! \todo in the future someday, might be useful to only show control points for "active" subpatches,
  *    or when shift-hovering
  */
@@ -4307,9 +4495,13 @@ int PatchInterface::MouseMove(int x,int y,unsigned int state,const Laxkit::LaxMo
 
 		 // if hover over points, do not do edge or subdivide operations
 		c=scan(x,y);
-		if (c<0 && c!=hoverpoint) { hoverpoint=-1; needtodraw=1; }
+		if (c<0 && c!=hoverpoint) { invalidateControlPoint(hoverpoint); hoverpoint=-1; }
 		if (c>=0 && selectablePoint(c)) {
-			if (c!=hoverpoint) { hoverpoint=c; needtodraw=1; }
+			if (c!=hoverpoint) {
+				invalidateControlPoint(hoverpoint);
+				hoverpoint=c;
+				invalidateControlPoint(hoverpoint);
+			}
 			v=h=hr=hc=-1;
 
 		} else if ((state&LAX_STATE_MASK)==0 
@@ -174,6 +174,8 @@ class PatchData : virtual public SomeData, virtual public Laxkit::PointCollectio
 	 //@{
 	 //rendering functions
 	virtual int renderToBuffer(unsigned char *buffer, int bufw, int bufh, int bufstride, int bufdepth, int bufchannels);
+	virtual void renderTile(PatchRenderContext *context, const Laxkit::IntRectangle &tile,
+								double s1,double t1, double s2,double t2, int depth);
 	virtual void rpatchpoint(PatchRenderContext *context,
 								Laxkit::flatpoint ul,Laxkit::flatpoint ur,Laxkit::flatpoint ll,Laxkit::flatpoint lr,
 								double s1,double t1, double s2,double t2,int which);
@@ -267,6 +269,7 @@ class PatchInterface : public anInterface
 	virtual void drawControls();
 	virtual void drawControlPoints();
 	virtual void drawControlPoint(int i, bool hovered);
+	virtual void invalidateControlPoint(int i);
 	virtual int ActivatePathInterface();
 	virtual int ActivateCircleInterface();
 
@@ -224,6 +224,16 @@ Path::Path()
 	profile       = nullptr;
 	brush         = nullptr;
 	generator_data = nullptr;
+	cache_generation = 0;
+	cache_segments_hash = 0;
+
+	arc_segments   = 0;
+	arc_generation = -1;
+	arc_closed     = false;
+	arc_hash       = 0;
+	arc_segs       = nullptr;
+	arc_lengths    = nullptr;
+	arc_samples    = nullptr;
 
 	// save_cache=true;
 	save_cache = false;
@@ -249,6 +259,7 @@ Path::~Path()
 	if (profile) profile->dec_count();
 	if (brush) brush->dec_count();
 	if (generator_data) generator_data->dec_count();
+	ClearArcTable();
 }
 
 //! Flush all points.
@@ -775,6 +786,290 @@ void Path::UpdateS(bool all, int resolution)
 }
 
 
+//----------------------------- Path arc length table -----------------------------
+
+ //line length sub steps taken between each arc table sample of a bezier segment
+#define PATH_ARC_SUBSTEPS 4
+
+/*! Return the vertex after p, setting c1 and c2 to the controls between. If the segment is
+ * a plain line, then c1==p and c2==the returned vertex. Returns NULL if there is no next vertex.
+ */
+static Coordinate *path_next_segment(Coordinate *p, Coordinate *&c1, Coordinate *&c2)
+{
+	Coordinate *v2 = p->next;
+	if (!v2) return NULL;
+
+	if (v2->flags&POINT_TOPREV) { c1=v2; v2=v2->next; if (!v2) return NULL; }
+	else c1=p;
+
+	if (v2->flags&POINT_TONEXT) { c2=v2; v2=v2->next; if (!v2) return NULL; }
+	else c2=v2;
+
+	return v2;
+}
+
+//! Fold n bytes of data into an FNV-1a style hash h.
+static unsigned long path_hash_bytes(unsigned long h, const void *data, int n)
+{
+	const unsigned char *b = (const unsigned char*)data;
+	for (int c=0; c<n; c++) h = (h ^ b[c]) * 16777619UL;
+	return h;
+}
+
+/*! Quick fingerprint of point positions and structure, so that a table built while
+ * needtorecache is set can be reused when nothing has actually moved.
+ */
+static unsigned long path_arc_hash(Coordinate *start)
+{
+	unsigned long h = 2166136261UL;
+	Coordinate *p = start;
+	do {
+		double v[2] = { p->fp.x, p->fp.y };
+		h = path_hash_bytes(h, v, sizeof(v));
+		h = (h ^ (p->flags & (POINT_VERTEX|POINT_TOPREV|POINT_TONEXT))) * 16777619UL;
+		p = p->next;
+	} while (p && p != start);
+	if (p == start) h = (h ^ 1) * 16777619UL;
+	return h;
+}
+
+//! Length along a segment at segment parameter f, from that segment's arc_samples.
+static double arc_segment_t_to_distance(const double *s, double f)
+{
+	double x = f*PATH_ARC_SAMPLES;
+	int j = (int)x;
+	if (j < 0) j = 0;
+	else if (j >= PATH_ARC_SAMPLES) j = PATH_ARC_SAMPLES-1;
+	return s[j] + (x-j)*(s[j+1]-s[j]);
+}
+
+//! Segment parameter at length d along a segment, from that segment's arc_samples.
+static double arc_segment_distance_to_t(const double *s, double d)
+{
+	int lo = 0, hi = PATH_ARC_SAMPLES, mid;
+	while (hi-lo > 1) {
+		mid = (lo+hi)/2;
+		if (s[mid] <= d) lo = mid; else hi = mid;
+	}
+	double ds = s[lo+1]-s[lo];
+	double f = (ds > 0 ? (d-s[lo])/ds : 0);
+	if (f < 0) f = 0; else if (f > 1) f = 1;
+	return (lo+f)/PATH_ARC_SAMPLES;
+}
+
+/*! Convert distance to path t using the arc table. Closed paths wrap, open paths clamp,
+ * setting *err=0 when clamped, else *err=1.
+ * If hint!=NULL, it is the segment of the previous lookup, and is updated to this one,
+ * which makes runs of increasing distances nearly free.
+ */
+static double arc_distance_to_t(const double *lengths, const double *samples, int n, bool closed,
+								double d, int *hint, int *err)
+{
+	double total = lengths[n];
+	if (err) *err = 1;
+	if (closed && total > 0 && (d < 0 || d > total)) {
+		d = fmod(d, total);
+		if (d < 0) d += total;
+	} else if (d < 0) {
+		if (err) *err = 0;
+		return 0;
+	} else if (d > total) {
+		if (err) *err = 0;
+		return n;
+	}
+
+	int i = -1;
+	if (hint && *hint >= 0 && *hint < n) {
+		if (d >= lengths[*hint] && d <= lengths[*hint+1]) i = *hint;
+		else if (*hint+1 < n && d >= lengths[*hint+1] && d <= lengths[*hint+2]) i = *hint+1;
+	}
+	if (i < 0) {
+		int lo = 0, hi = n, mid;
+		while (hi-lo > 1) {
+			mid = (lo+hi)/2;
+			if (lengths[mid] <= d) lo = mid; else hi = mid;
+		}
+		i = lo;
+	}
+	if (hint) *hint = i;
+
+	return i + arc_segment_distance_to_t(samples + i*(PATH_ARC_SAMPLES+1), d - lengths[i]);
+}
+
+//! Convert path t to distance using the arc table. Wraps and clamps like arc_distance_to_t().
+static double arc_t_to_distance(const double *lengths, const double *samples, int n, bool closed, double t, int *err)
+{
+	if (err) *err = 1;
+	if (closed && (t < 0 || t > n)) {
+		t = fmod(t, (double)n);
+		if (t < 0) t += n;
+	} else if (t < 0) {
+		if (err) *err = 0;
+		return 0;
+	} else if (t > n) {
+		if (err) *err = 0;
+		return lengths[n];
+	}
+
+	int i = (int)floor(t);
+	if (i >= n) i = n-1;
+	return lengths[i] + arc_segment_t_to_distance(samples + i*(PATH_ARC_SAMPLES+1), t-i);
+}
+
+//! Point and tangent at path parameter t, where t is already within [0,n].
+static void arc_point_at(const PathArcSegment *segs, int n, double t, flatpoint *point, flatpoint *tangent)
+{
+	int i = (int)floor(t);
+	if (i < 0) i = 0; else if (i >= n) i = n-1;
+	const PathArcSegment &seg = segs[i];
+	double f = t-i;
+
+	if (seg.isline) {
+		if (point) *point = seg.p1 + f*(seg.p2-seg.p1);
+		if (tangent) *tangent = seg.p2-seg.p1;
+		return;
+	}
+
+	flatpoint pp = bez_point(f, seg.p1,seg.c1,seg.c2,seg.p2);
+	if (point) *point = pp;
+	if (tangent) *tangent = bez_point(f+.01, seg.p1,seg.c1,seg.c2,seg.p2) - pp;
+}
+
+//! Distance from p to the control hull bounds of seg, which is never more than the distance to seg itself.
+static double arc_bounds_distance(const PathArcSegment &seg, flatpoint p)
+{
+	double dx = 0, dy = 0;
+	if (p.x < seg.minx) dx = seg.minx-p.x; else if (p.x > seg.maxx) dx = p.x-seg.maxx;
+	if (p.y < seg.miny) dy = seg.miny-p.y; else if (p.y > seg.maxy) dy = p.y-seg.maxy;
+	return sqrt(dx*dx + dy*dy);
+}
+
+//! Return distance from point to seg, and the segment parameter and point of the closest approach.
+static double arc_segment_closest(const PathArcSegment &seg, flatpoint point, int maxpoints, double *t_ret, flatpoint *found)
+{
+	if (seg.isline) {
+		flatpoint bb = seg.p2-seg.p1;
+		double ss = bb*bb;
+		double sp = (ss ? ((point-seg.p1)*bb)/ss : 0); //guard against p1 and p2 being the same point
+		if (sp < 0) sp = 0; else if (sp > 1) sp = 1;
+		*found = seg.p1 + sp*bb;
+		*t_ret = sp;
+		return norm(point - *found);
+	}
+
+	double d = 0;
+	*t_ret = bez_closest_point(point, seg.p1,seg.c1,seg.c2,seg.p2, maxpoints, &d, NULL, found);
+	return d;
+}
+
+void Path::ClearArcTable()
+{
+	delete[] arc_segs;    arc_segs    = nullptr;
+	delete[] arc_lengths; arc_lengths = nullptr;
+	delete[] arc_samples; arc_samples = nullptr;
+	arc_segments   = 0;
+	arc_generation = -1;
+	arc_closed     = false;
+}
+
+/*! Make sure the arc length table is current, and return the number of segments in it.
+ *
+ * arc_lengths holds the cumulative length at each vertex, and arc_samples holds cumulative
+ * lengths within each segment at PATH_ARC_SAMPLES+1 even steps of t, so distance and t
+ * can be converted with a couple of binary searches rather than measuring the whole path each time.
+ * arc_segs keeps each segment's bezier points and bounds for ClosestPoint().
+ *
+ * The table is trusted as is when needtorecache==0 and UpdateCache() has not rebuilt since the
+ * table was made. Otherwise points are hashed, and the table is rebuilt only when the hash changes.
+ * Like the other caches, edits that move points must set needtorecache.
+ */
+int Path::UpdateArcTable()
+{
+	Coordinate *start = (path ? path->firstPoint(1) : NULL);
+	if (!start) {
+		ClearArcTable();
+		return 0;
+	}
+
+	if (arc_lengths && !needtorecache && arc_generation == cache_generation) return arc_segments;
+
+	unsigned long hash = path_arc_hash(start);
+	if (arc_lengths && hash == arc_hash) {
+		if (!needtorecache) arc_generation = cache_generation;
+		return arc_segments;
+	}
+
+	ClearArcTable();
+
+	Coordinate *p = start, *c1, *c2, *v2;
+	int n = 0;
+	do {
+		v2 = path_next_segment(p, c1,c2);
+		if (!v2) break;
+		n++;
+		p = v2;
+	} while (p != start);
+
+	arc_closed  = (n > 0 && p == start);
+	arc_segs    = new PathArcSegment[n > 0 ? n : 1];
+	arc_lengths = new double[n+1];
+	arc_samples = new double[(n > 0 ? n : 1) * (PATH_ARC_SAMPLES+1)];
+	arc_lengths[0] = 0;
+
+	p = start;
+	for (int i=0; i<n; i++) {
+		v2 = path_next_segment(p, c1,c2);
+		PathArcSegment &seg = arc_segs[i];
+		double *s = arc_samples + i*(PATH_ARC_SAMPLES+1);
+
+		seg.p1 = p->p();
+		seg.p2 = v2->p();
+		seg.isline = (c1 == p && c2 == v2);
+		if (seg.isline) {
+			seg.c1 = seg.p1 + (seg.p2-seg.p1)/3;
+			seg.c2 = seg.p1 + (seg.p2-seg.p1)*2./3;
+		} else {
+			seg.c1 = c1->p();
+			seg.c2 = c2->p();
+		}
+
+		seg.minx = seg.maxx = seg.p1.x;
+		seg.miny = seg.maxy = seg.p1.y;
+		flatpoint hull[3] = { seg.c1, seg.c2, seg.p2 };
+		for (int c=0; c<3; c++) {
+			if (hull[c].x < seg.minx) seg.minx = hull[c].x; else if (hull[c].x > seg.maxx) seg.maxx = hull[c].x;
+			if (hull[c].y < seg.miny) seg.miny = hull[c].y; else if (hull[c].y > seg.maxy) seg.maxy = hull[c].y;
+		}
+
+		s[0] = 0;
+		if (seg.isline) {
+			double len = norm(seg.p2-seg.p1);
+			for (int j=1; j<=PATH_ARC_SAMPLES; j++) s[j] = len*j/PATH_ARC_SAMPLES;
+
+		} else {
+			flatpoint last = seg.p1, pp;
+			double len = 0;
+			for (int j=1; j<=PATH_ARC_SAMPLES; j++) {
+				for (int k=1; k<=PATH_ARC_SUBSTEPS; k++) {
+					pp = bez_point((j-1 + k/(double)PATH_ARC_SUBSTEPS)/PATH_ARC_SAMPLES, seg.p1,seg.c1,seg.c2,seg.p2);
+					len += norm(pp-last);
+					last = pp;
+				}
+				s[j] = len;
+			}
+		}
+
+		arc_lengths[i+1] = arc_lengths[i] + s[PATH_ARC_SAMPLES];
+		p = v2;
+	}
+
+	arc_segments   = n;
+	arc_hash       = hash;
+	arc_generation = (needtorecache ? -1 : cache_generation);
+	return n;
+}
+
+
 // ********************** PUT SOMEWHERE USEFUL!!!! Vvvvvvvvvvv
 
 /*! list contains possibly a mixture of bare sample points and bezier segments.
@@ -797,19 +1092,29 @@ int bez_reduce_approximate(NumStack<flatpoint> *list, double epsilon)
 
 	if (epsilon<0) epsilon=1e-5;
 
+	 //Approximated segments are written to a new list as we go, rather than shifting the rest of
+	 //list over for each one, which made long paths with many joins quadratic. list->e is only read,
+	 //except that the first point of a line is temporarily set to whatever it would have been replaced
+	 //with in place, since wrapping closed segments look at it.
+	flatpoint *e=list->e;
+	int n=list->n;
+	NumStack<flatpoint> out;
+	out.Allocate(3*n+16);
+	out.Delta(n+16);
+
 	int thisclosed=0;
-	int thisstart=0, thisend;
+	int thisstart=0, thisend=0;
 	NumStack<flatpoint> bsamples;
 
-	for (int c=0; c<list->n; c=thisend+1) { //one loop per line in list
+	for (int c=0; c<n; c=thisend+1) { //one loop per line in list
 
 		 //so as not to do buffer overruns below,
 		 //need to find length of current line, which might not be list->n
 		thisstart=c;
-		for (int c2=thisstart; c2<list->n; c2++) { 
-			if      (list->e[c2].info&LINE_Closed) thisclosed= 1;
-			else if (list->e[c2].info&LINE_Open)   thisclosed=-1;
-			else if (c2==list->n-1) thisclosed=-1;
+		for (int c2=thisstart; c2<n; c2++) { 
+			if      (e[c2].info&LINE_Closed) thisclosed= 1;
+			else if (e[c2].info&LINE_Open)   thisclosed=-1;
+			else if (c2==n-1) thisclosed=-1;
 			else thisclosed=0;
 
 			if (thisclosed!=0) {
@@ -818,128 +1123,74 @@ int bez_reduce_approximate(NumStack<flatpoint> *list, double epsilon)
 			}
 		}
 
-		 //the current subpath is contained in thisstart...thisstart+thisn.
+		 //the current subpath is contained in thisstart...thisend.
 		 //Now we need to find the segments of this subpath that need to be approximated.
 		 //It is assumed that segments with LINE_Bez are already approximated, and are skipped.
 		int segstart=thisstart, segend=-1, segn;
-		int diffn;
 		int wrap;
+		int copied=thisstart; //e[copied..thisend] are not in out yet
+		flatpoint runfirst=e[thisstart];
 
 		for (int c2=thisstart; c2<=thisend; c2++) { //one loop per segment
 			 //skip bez segments
 			segstart=c2;
-			while (c2<thisend && (list->e[c2].info&LINE_Bez)) { c2++; segstart=c2; }
-
-			// **** sometimes we need to wrap around, a gnarly situation!
-			//if (c2==thisstart && thisclosed==1 && (list->e[c2].info&LINE_Corner)==0) {
-			//	 //need to do special check for wrapping backwards
-			//	segstart=thisend;
-			//	while (segstart>c2 && (list->e[segstart].info&(LINE_Corner|LINE_Join))==0) segstart--;
-			//}
-			//
-			//if (c2==thisend) {
-			//	if (thisclosed==1) wraps=1; else wraps=0;
-			//}
-
+			while (c2<thisend && (e[c2].info&LINE_Bez)) { c2++; segstart=c2; }
 
 			 //now we should be on either a raw point or a vertex, need to find end of segment
 			
 			if (c2==thisend) break; //at end
-			if (list->e[c2].info&(LINE_Join|LINE_Cap)) continue; //need to skip the join gap, it will be filled in later
+			if (e[c2].info&(LINE_Join|LINE_Cap)) continue; //need to skip the join gap, it will be filled in later
 
 			c2++; //position one past segstart
-			if (list->e[c2].info&LINE_Bez) continue; //need to skip bez segments
+			if (e[c2].info&LINE_Bez) continue; //need to skip bez segments
 
 			 //find all raw points following segstart
-			while (c2<thisend && (list->e[c2].info&(LINE_Corner|LINE_Cap|LINE_Join|LINE_Open|LINE_Closed)) == 0) {
+			while (c2<thisend && (e[c2].info&(LINE_Corner|LINE_Cap|LINE_Join|LINE_Open|LINE_Closed)) == 0) {
 				c2++;
 			}
 
-			//DBG if (list->e[c2].info&LINE_Cap) cerr <<"Line cap at: "<<c2<<endl;
-			//DBG dump_points("seg found:", list->e+segstart, c2-segstart+1, segstart);
-
 			segend=c2;
 			segn=segend-segstart+1;
 
 			if (segn<=2) continue; //segment was just a point or a single line, so go to next
 
 
-			//DBG cerr <<"------list.n="<<list->n<<"   thisstart="<<thisstart<<"   thisend="<<thisend<<endl;
-			//DBG cerr <<"   segstart="<<segstart<<"   segend="<<segend<<"   segn="<<segn<<endl;
-
-			//DBG for (int cc=0; cc<list->n; cc++) { list->e[cc].info2=cc; }
-
-			 //reduce as necessary
-//			diffn=0;
-//			if (epsilon>0) {
-//				dump_points("list before:",list->e,list->n);
-//				int newn=reduce_polyline(list->e, list->e+segstart, segn, epsilon);
-//				diffn=segn-newn;
-//				if (diffn && c2!=list->n-1)
-//					memmove(list->e+segstart+newn, list->e+segend+1, (list->n-segend-1)*sizeof(flatpoint));
-//				list->n-=diffn;
-//				thisend-=diffn;
-//				c2     -=diffn;
-//
-//				dump_points("list after:",list->e,list->n);
-//			}
-
-
 			 //bezier approximate
 			bsamples.flush_n();
-			bsamples.Allocate(3*segn);
+			if (bsamples.Allocated()<3*segn) bsamples.Allocate(3*segn);
 			bsamples.n=3*segn;
-			bez_from_points(bsamples.e, list->e+thisstart,thisend-thisstart+1, segstart-thisstart,segn);
-			//bez_from_points(bsamples.e, list->e,list->n, segstart,segn);
+			flatpoint first=e[thisstart];
+			e[thisstart]=runfirst;
+			bez_from_points(bsamples.e, e+thisstart,thisend-thisstart+1, segstart-thisstart,segn);
+			e[thisstart]=first;
 			bsamples.e[bsamples.n-2].info&=~(LINE_Closed|LINE_Open);
-			//DBG dump_points("bsamples",bsamples.e,bsamples.n);
-
-			//DBG for (int cc=0; cc<bsamples.n; cc++) { bsamples.e[cc].info2=1000+cc; }
-			//DBG cerr <<"   bsamples.n="<<bsamples.n<<endl;
-			//DBG dump_points("list before",list->e,list->n);
 
 			wrap=0;
-			bool onbreak=((list->e[thisend].info&(LINE_Join|LINE_Cap))!=0);
+			bool onbreak=((e[thisend].info&(LINE_Join|LINE_Cap))!=0);
 			if (segstart==thisstart && thisclosed==1 && !onbreak) wrap|=1;
 			if (segend==thisend     && thisclosed==1 && !onbreak) wrap|=2;
 
+			 //output unchanged points up to the segment, then the segment's replacement
+			for ( ; copied<segstart; copied++) out.push(e[copied]);
 
-			// *** should do only one memmove, combine with epsilon above
-			list->Allocate(list->n+2*segn);
-			if (c2!=list->n-1) {
-				 //move points beyond current segment out past where new points must go
-				//memmove(list->e+segstart + 3*segn-2 + (((wrap&1)?1:0)+((wrap&2)?1:0)),  list->e+c2+1, (list->n-c2-1)*sizeof(flatpoint));
-				//----------
-				int num = (list->n-c2-1);
-				int from = c2+1;
-				int to = segstart + 3*segn-2 + (((wrap&1)?1:0)+((wrap&2)?1:0));
-				if (from > to) for (int c3=0; c3<num; c3++) list->e[to+c3] = list->e[from+c3];
-				else for (int c3=num-1; c3>=0; c3--) list->e[to+c3] = list->e[from+c3];
+			int from=((wrap&1) ? 0 : 1);
+			int num=3*segn-(((wrap&1)?0:1)+((wrap&2)?0:1));
+			for (int c3=0; c3<num; c3++) out.push(bsamples.e[from+c3]);
+			copied=segend+1;
 
-				//DBG cerr <<" memmove( list->e + "<<segstart + 3*segn-2 + (((wrap&1)?1:0)+((wrap&2)?1:0))<<", "<<c2+1<<", "<<(list->n-c2-1)<<"*sizeof(flatpoint))"<<endl;
+			if (segstart==thisstart) runfirst=out.e[out.n-num];
+			if (segend==thisend) {
+				if (thisclosed==1) out.e[out.n-1].info|=LINE_Closed;
+				else out.e[out.n-1].info|=LINE_Open; 
 			}
-			//memcpy(list->e+segstart, bsamples.e + ((wrap&1) ? 0 : 1), (3*segn-(((wrap&1)?0:1)+((wrap&2)?0:1)))*sizeof(flatpoint));
-			for (int c3=0; c3<(3*segn-(((wrap&1)?0:1)+((wrap&2)?0:1))); c3++) list->e[segstart+c3] = bsamples.e[((wrap&1) ? 0 : 1) + c3];
-			//DBG cerr <<" memcpy( list->e + "<<segstart<<", bsamples+"<<((wrap&1) ? 0 : 1)<<", "<<(3*segn-(((wrap&1)?0:1)+((wrap&2)?0:1)))<<"*sizeof(flatpoint))"<<endl;
-
-			diffn=2*segn-2+(((wrap&1)?1:0)+((wrap&2)?1:0));
-
-			list->n+=diffn;
-			thisend+=diffn;
-			c2     +=diffn;
-
-			if (c2==thisend) {
-				if (thisclosed==1) list->e[c2].info|=LINE_Closed;
-				else list->e[c2].info|=LINE_Open; 
-			}
-
-
-			//DBG dump_points("list after",list->e,list->n);
 		}
 
-		c=thisend;
+		for ( ; copied<=thisend; copied++) out.push(e[copied]);
 	}
 
+	flatpoint *aa=out.extractArray(&n);
+	list->insertArray(aa,n);
+
 	DBG cerr <<"....end bez_reduce_approximate...."<<endl;
 
 	return 0;
@@ -956,6 +1207,156 @@ int bez_reduce_approximate(NumStack<flatpoint> *list, double epsilon)
 // ^^^^^^^^^^^^^^^^^^^ PUT SOMEWHERE USEFUL!!!! ^^^^^^^^
 
 
+//! Point i of the list being joined, as it would be if joins so far had been inserted in place.
+static flatpoint &path_join_point(NumStack<flatpoint> &out, flatpoint *e, int next, int i)
+{
+	return (i<out.n ? out.e[i] : e[next+i-out.n]);
+}
+
+/*! Add joins and caps to a bezier c-v-c list made by bez_reduce_approximate(),
+ * at points with LINE_Join or LINE_Cap.
+ *
+ * The result is built in a new list rather than inserting into list, so that
+ * long paths with many joins stay linear.
+ */
+static void path_add_joins(NumStack<flatpoint> *list, LineStyle *linestyle, double defaultwidth)
+{
+	int njoin;
+	flatpoint join[8];
+	flatpoint line[8];
+	flatpoint samples[3];
+
+	flatpoint *e=list->e;
+	int n=list->n;
+	NumStack<flatpoint> out;
+	out.Allocate(n+n/2+16);
+	out.Delta(n/2+16);
+
+	int thisclosed=0;
+	int thisstart=0;
+	int thisn=-1;
+	int next=0; //next point of e to add to out
+	int total;  //number of points as if joins so far were inserted into list
+	int c;
+
+	while (next<n) {
+		out.push(e[next++]);
+		c=out.n-1;
+		total=out.n+n-next;
+
+		if (thisn<0 || (thisn>0 && c>=thisstart+thisn)) {
+			 //need to find length of current line, which might not be list->n, so as
+			 //not to do buffer overruns below
+			thisstart=c;
+			for (int c2=thisstart; c2<total; c2++) {
+				flatpoint &p2=path_join_point(out,e,next,c2);
+				if      (p2.info&LINE_Closed) thisclosed= 1;
+				else if (p2.info&LINE_Open)   thisclosed=-1;
+				else if (c2==total-1) thisclosed=-1;
+				else thisclosed=0;
+
+				if (thisclosed!=0) {
+					thisn=c2-thisstart+1;
+					break;
+				}
+			}
+		}
+
+		int jointype = 0;
+		if ((out.e[c].info&LINE_Cap)!=0) {
+			if (linestyle) {
+				if (c == total-1) {
+					//start cap
+					if      (linestyle->capstyle == LAXCAP_Butt)  jointype = LAXJOIN_Bevel;
+					else if (linestyle->capstyle == LAXCAP_Round) jointype = LAXJOIN_Round;
+					else jointype = LAXJOIN_Bevel;
+				} else {
+					//end cap
+					int capstyle = linestyle->endcapstyle;
+					if (capstyle == 0) capstyle = linestyle->capstyle;
+
+					if      (capstyle == LAXCAP_Butt)  jointype = LAXJOIN_Bevel;
+					else if (capstyle == LAXCAP_Round) jointype = LAXJOIN_Round;
+					else jointype = LAXJOIN_Bevel;
+				}
+			}
+			if (!jointype) jointype = LAXJOIN_Bevel;
+		}
+		if ((out.e[c].info&LINE_Join)!=0 && !jointype) {
+			jointype = linestyle ? linestyle->joinstyle : LAXJOIN_Round;
+		} 
+		if (!jointype) continue; //nothing special to do
+
+		// *** trouble spot with following line, should wrap around as appropriate
+		if (c<thisstart+thisn-1 && norm2(out.e[c]-path_join_point(out,e,next,c+1))<1e-5) continue; //don't bother if points really close together
+
+		DBG cerr << "**** JOIN at "<<c<<'/'<<total<<endl;
+
+
+		if (path_join_point(out,e,next, thisstart + (c-thisstart+thisn-1)%thisn).info&LINE_Bez) {
+			 //prev points were bez segment
+			line[3]=out.e[c];
+			line[2]=path_join_point(out,e,next, thisstart + (c-thisstart+thisn-1)%thisn);
+			line[1]=path_join_point(out,e,next, thisstart + (c-thisstart+thisn-2)%thisn);
+			line[0]=path_join_point(out,e,next, thisstart + (c-thisstart+thisn-3)%thisn);
+
+		} else {
+			 //prev points were straight segment
+			samples[1]=out.e[c];
+			samples[0]=path_join_point(out,e,next, thisstart + (c-thisstart+thisn-1)%thisn);
+			flatpoint vv=(samples[1]-samples[0])/3;
+			
+			line[3]=samples[1];
+			line[2]=samples[1]-vv;
+			line[1]=samples[1]-2*vv;
+			line[0]=samples[0];
+		}
+
+		if (path_join_point(out,e,next, thisstart + (c-thisstart+2)%thisn).info&LINE_Bez) {
+			 //next points were bez segment
+			line[4]=path_join_point(out,e,next, thisstart + (c-thisstart+1)%thisn);
+			line[5]=path_join_point(out,e,next, thisstart + (c-thisstart+2)%thisn);
+			line[6]=path_join_point(out,e,next, thisstart + (c-thisstart+3)%thisn);
+			line[7]=path_join_point(out,e,next, thisstart + (c-thisstart+4)%thisn);
+
+		} else {
+			 //next points were straight segment
+			samples[0]=path_join_point(out,e,next, thisstart + (c-thisstart+1)%thisn);
+			samples[1]=path_join_point(out,e,next, thisstart + (c-thisstart+2)%thisn);
+			flatpoint vv=(samples[1]-samples[0])/3;
+
+			line[4]=samples[0];
+			line[5]=samples[0]+vv;
+			line[6]=samples[0]+2*vv;
+			line[7]=samples[1];
+		}
+
+		njoin=0;
+		join_paths(jointype,
+				   linestyle ? linestyle->miterlimit : defaultwidth*200,
+				   line[0],line[1],line[2],line[3],
+				   line[4],line[5],line[6],line[7],
+				   &njoin, join);
+
+		if (njoin>0 && c==thisstart+thisn-1) out.e[c].info&=~(LINE_Closed|LINE_Open);
+		for (int cc=0; cc<njoin; cc++) {
+			out.push(join[cc]);
+			c++;
+			thisn++;
+		}
+
+		if (c==thisstart+thisn-1) {
+			if (thisclosed==1)       out.e[c].info|=LINE_Closed;
+			else if (thisclosed==-1) out.e[c].info|=LINE_Open;
+			thisn=-1;
+		}
+	}
+
+	flatpoint *aa=out.extractArray(&n);
+	list->insertArray(aa,n);
+}
+
+
 /*! Rebuild cache_angle, cache_offset, cache_width.
  */
 void Path::UpdateWidthCache()
@@ -1073,12 +1474,127 @@ void Path::UpdateWidthCache()
 	}
 }
 
+//! Exact compare, including info, since cached samples must match a fresh sampling bit for bit.
+static bool path_same_point(const flatpoint &a, const flatpoint &b)
+{
+	return a.x==b.x && a.y==b.y && a.info==b.info;
+}
+
+/*! Sample seg->p1,c1,c2,p2 to fill seg->top, bottom, and center, using the current
+ * cache_offset, cache_width, and cache_angle. seg->index is the t offset of the segment.
+ * All samples are kept, including the first, which UpdateCache() drops when it is the same as
+ * the end of the previous segment.
+ */
+void Path::SampleCacheSegment(PathCacheSegment *seg, bool hasangle, bool hasoffset)
+{
+	int cp=seg->index;
+	int nsamples=cache_samples;
+	NumStack<flatpoint> bez;
+	NumStack<double> bezt;
+	bezt.Allocate(2*nsamples);
+	bezt.Delta(2*nsamples);
+
+	seg->top   .flush_n();
+	seg->bottom.flush_n();
+	seg->center.flush_n();
+
+	 //figure out where to sample the current bezier segment. When there are weight nodes,
+	 //things can get crazy, so sample a bunch of times in between nodes, not just evenly
+	 //along the whole bezier segment.
+	double lastw=-1, t;
+	double rrr;
+	for (int c=0; c<=pathweights.n; c++) {
+		if (c==pathweights.n) {
+			t=cp+1;
+		} else {
+			if (pathweights.e[c]->t<=cp) continue;
+			if (pathweights.e[c]->t>=cp+1) continue;
+			t=pathweights.e[c]->t;
+		}
+
+		if (lastw<cp) lastw=cp;
+		rrr=(t-lastw)/(nsamples-1);
+		for (int cc=(bezt.n==0 ? 0 : 1); cc<nsamples; cc++) bezt.push(lastw+rrr*cc-cp);
+		lastw=t;
+	}
+
+	bez.Allocate(bezt.n);
+	bez.n=bezt.n;
+
+	flatpoint vvv;
+	if (seg->isline) {
+		vvv=(seg->p2-seg->p1);
+		for (int bb=0; bb<bezt.n; bb++) {
+			bez.e[bb]=seg->p1 + bezt.e[bb]*vvv;
+		}
+	} else {
+		bez_points_at_samples(bez.e, seg->p1, seg->c1,seg->c2, seg->p2, bezt.e,bezt.n, 0);
+	}
+
+	seg->top   .Allocate(bez.n);
+	seg->bottom.Allocate(bez.n);
+	if (hasoffset) seg->center.Allocate(bez.n);
+
+	flatpoint po,vv,vt;
+	flatpoint sht, shb;
+	double width;
+
+	for (int bb=0; bb<bez.n; bb++) {
+		if (seg->isline) vv=vvv;
+		else {
+			vv=bez_visual_tangent(bezt.e[bb], seg->p1, seg->c1,seg->c2, seg->p2);
+		}
+		vv.normalize();
+		vt = transpose(vv);
+		vt.normalize();
+		po=bez.e[bb] + vt*cache_offset.f(cp+bezt.e[bb]);
+		if (hasangle) {
+			if (absoluteangle) vt=rotate(flatpoint(1,0), cache_angle.f(cp+bezt.e[bb]));
+			else vt=rotate(vt, cache_angle.f(cp+bezt.e[bb]));
+		}
+
+		if (hasoffset) seg->center.push(po);
+
+		width = cache_width.f(cp+bezt.e[bb]);
+		if (brush) {
+			brush->MinMax(0, vv, shb, sht);
+			anXApp::app->PostMessage2("v: %f,%f b: %f,%f  t: %f,%f", vt.x,vt.y, shb.x,shb.y, sht.x,sht.y);
+			seg->top   .push(po + width/2 * sht);
+			seg->bottom.push(po + width/2 * shb);
+
+		} else {
+			seg->top   .push(po + width/2 * vt);
+			seg->bottom.push(po - width/2 * vt);
+		}
+	}
+
+	if (!hasoffset) {
+		 //center path is the same as the original path
+		NumStack<flatpoint> &centerp=seg->center;
+		if (seg->isline) {
+			vv=(seg->p2 - seg->p1)/3;
+			centerp.push(seg->p1);      centerp.e[centerp.n-1].info|=LINE_Vertex;
+			centerp.push(seg->p1+vv);   centerp.e[centerp.n-1].info|=LINE_Bez;
+			centerp.push(seg->p1+2*vv); centerp.e[centerp.n-1].info|=LINE_Bez;
+			centerp.push(seg->p2);      centerp.e[centerp.n-1].info|=LINE_Vertex;
+		} else { //add bez
+			centerp.push(seg->p1); centerp.e[centerp.n-1].info|=LINE_Vertex;
+			centerp.push(seg->c1); centerp.e[centerp.n-1].info|=LINE_Bez;
+			centerp.push(seg->c2); centerp.e[centerp.n-1].info|=LINE_Bez;
+			centerp.push(seg->p2); centerp.e[centerp.n-1].info|=LINE_Vertex;
+		}
+	}
+}
+
 /*! Does nothing if needtorecache==0.
  * Otherwise rebuild outlinecache and centercache. centercache is the center of the stroke,
  * inside of which is to be filled. For nonweighted, non-offset paths, this is the same as the base line.O
  *
- * \todo this could be more intelligent in having cache tied to points somehow, so that you only
- *    need to update cache for affected areas. otherwise this will bog down when point count is high
+ * Samples are kept per segment in cache_segments. Segments whose points have not changed reuse
+ * their old samples, so dragging a vertex only resamples the segments on either side of it. Assembling
+ * the samples, bezier approximating, and adding joins is still done over the whole path, but in linear time.
+ * Any change to weights, width, caps, or the number of segments resamples everything.
+ *
  * \todo need to handle dash patterns
  */
 void Path::UpdateCache()
@@ -1146,31 +1662,47 @@ void Path::UpdateCache()
 	 //
 
 
+	 //samples of unchanged segments are reused, unless something they all depend on has changed
+	unsigned long hash=2166136261UL;
+	double width=(linestyle ? linestyle->width : defaultwidth);
+	int ivals[8]={ n, isclosed, cache_samples, absoluteangle, hasangle, hasoffset,
+				   linestyle ? linestyle->capstyle : 0, linestyle ? linestyle->endcapstyle : 0 };
+	hash=path_hash_bytes(hash, ivals, sizeof(ivals));
+	hash=path_hash_bytes(hash, &width, sizeof(double));
+	hash=path_hash_bytes(hash, &defaultwidth, sizeof(double));
+	for (int c=0; c<pathweights.n; c++) {
+		PathWeightNode *w=pathweights.e[c];
+		double wvals[4]={ w->t, w->offset, w->width, w->angle };
+		int wtypes[2]={ w->type, w->nodetype };
+		hash=path_hash_bytes(hash, wvals, sizeof(wvals));
+		hash=path_hash_bytes(hash, wtypes, sizeof(wtypes));
+	}
+	if (brush || hash!=cache_segments_hash) cache_segments.flush();
+	cache_segments_hash=hash;
+
+	int nsamples=n*cache_samples + pathweights.n*cache_samples + 16;
+	topp   .Allocate(2*nsamples); //bottomp gets appended to topp later
+	bottomp.Allocate(nsamples);
+	centerp.Allocate(hasoffset ? nsamples : 4*n+16);
+	if (cache_types & 1) {
+		cache_top   .Allocate(nsamples);
+		cache_bottom.Allocate(nsamples);
+	}
+
+
 	flatpoint c1,c2;
 	p=start;
-	flatpoint pp,po,vv,vt;
-	flatpoint sht, shb;
 	//int ignorefirst=(isclosed?1:0); //index to begin render to segment.. for open paths, must not ignore first
 	int ignorefirst=0; //we need to render the 1st sample point in a segment
 
 
-	int nsamples=cache_samples;
-	NumStack<flatpoint> bez;
-	NumStack<double> bezt;
-	bezt.Allocate(2*nsamples);
-	bezt.Delta(2*nsamples);
-
-
-
 	//
 	//now parse over this's path, adding sampled points segment by segment..
-	//Note that there is surely a more intelligent way to do this...
 	//
 
 	int cp=0; //vertex counter
 	bool isline;
-	flatpoint vvv;
-	double width;
+	PathCacheSegment *seg;
 	double EPSILON = 1e-10;
 
 	do { //one loop per vertex point
@@ -1185,31 +1717,6 @@ void Path::UpdateCache()
 			}
 		}
 
-		 //figure out where to sample the current bezier segment. When there are weight nodes,
-		 //things can get crazy, so sample a bunch of times in between nodes, not just evenly
-		 //along the whole bezier segment.
-		bezt.flush_n();
-		bez.flush_n();
-		double lastw=-1, t;
-		double rrr;
-		for (int c=0; c<=pathweights.n; c++) {
-			if (c==pathweights.n) {
-				t=cp+1;
-			} else {
-				if (pathweights.e[c]->t<=cp) continue;
-				if (pathweights.e[c]->t>=cp+1) continue;
-				t=pathweights.e[c]->t;
-			}
-	
-			if (lastw<cp) lastw=cp;
-			rrr=(t-lastw)/(nsamples-1);
-			for (int cc=(bezt.n==0 ? 0 : 1); cc<nsamples; cc++) bezt.push(lastw+rrr*cc-cp);
-			lastw=t;
-		}
-
-		bez.Allocate(bezt.n);
-		bez.n=bezt.n;
-
 		//p2 now points to first Coordinate after the first vertex
 		//find next 2 control points and next vertex
 		//
@@ -1229,83 +1736,47 @@ void Path::UpdateCache()
 				//p2=p2->next;
 				c2=p2->p();
 			}
-
-			bez_points_at_samples(bez.e, p->p(), c1,c2, p2->p(), bezt.e,bezt.n, ignorefirst);
 			isline=false;
 
 		} else {
 			 //we do not have control points, so is just a straight line segment
-			vvv=(p2->p()-p->p());
-			//vvv.normalize();
-			for (int bb=0; bb<bezt.n; bb++) {
-				bez.e[bb]=p->p() + bezt.e[bb]*vvv;
-			}
 			isline=true;
-
 			c1=p->p();
 			c2=p2->p();
 		}
 
-
-		 //compute sample points of top, bottom, and center, based on found bezier segment
+		 //compute sample points of top, bottom, and center for the segment, if they are not already cached
 		 //
-		for (int bb=ignorefirst; bb<bez.n; bb++) {
-			//DBG cerr <<"bez: "<<bez.e[bb].x<<"  "<<bez.e[bb].y<<endl;
-
-			if (isline) vv=vvv;
-			else {
-				vv=bez_visual_tangent(bezt.e[bb], p->p(), c1,c2, p2->p());
-			}
-			vv.normalize();
-			vt = transpose(vv);
-			vt.normalize();
-			po=bez.e[bb] + vt*cache_offset.f(cp+bezt.e[bb]);
-			if (hasangle) {
-				if (absoluteangle) vt=rotate(flatpoint(1,0), cache_angle.f(cp+bezt.e[bb]));
-				else vt=rotate(vt, cache_angle.f(cp+bezt.e[bb]));
-			}
+		if (cp<cache_segments.n) seg=cache_segments.e[cp];
+		else {
+			seg=new PathCacheSegment;
+			seg->index=-1;
+			cache_segments.push(seg,1);
+		}
 
-			if (hasoffset) centerp.push(po);
+		flatpoint pp1=p->p(), pp2=p2->p();
+		if (seg->index!=cp || seg->isline!=isline
+			  || !path_same_point(seg->p1,pp1) || !path_same_point(seg->c1,c1)
+			  || !path_same_point(seg->c2,c2)  || !path_same_point(seg->p2,pp2)) {
+			seg->index=cp;
+			seg->isline=isline;
+			seg->p1=pp1;
+			seg->c1=c1;
+			seg->c2=c2;
+			seg->p2=pp2;
+			SampleCacheSegment(seg, hasangle, hasoffset);
+		}
 
-			width = cache_width.f(cp+bezt.e[bb]);
-			if (brush) {
-				brush->MinMax(0, vv, shb, sht);
-				anXApp::app->PostMessage2("v: %f,%f b: %f,%f  t: %f,%f", vt.x,vt.y, shb.x,shb.y, sht.x,sht.y);
-				// topp   .push(po + (sht.x * vv + sht.y * vt)*width/2);
-				// bottomp.push(po + (shb.x * vv + shb.y * vt)*width/2);
-				topp   .push(po + width/2 * sht);
-				bottomp.push(po + width/2 * shb);
-
-			} else {
-				topp   .push(po + width/2 * vt);
-				bottomp.push(po - width/2 * vt);
-			}
+		for (int bb=ignorefirst; bb<seg->top.n; bb++) {
+			topp   .push(seg->top   .e[bb]);
+			bottomp.push(seg->bottom.e[bb]);
 
 			if (cache_types & 1) {
-				cache_top   .push(topp   .e[topp.n   -1]);
-				cache_bottom.push(bottomp.e[bottomp.n-1]);
-			}
-		}
-
-		if (!hasoffset) {
-			 //center path is the same as the original path
-			if (isline) {
-				vv=(p2->p() - p->p())/3;
-				if (!ignorefirst) {
-					centerp.push(p->p());  centerp.e[centerp.n-1].info|=LINE_Vertex;
-				}
-				centerp.push(p->p()+vv);   centerp.e[centerp.n-1].info|=LINE_Bez;
-				centerp.push(p->p()+2*vv); centerp.e[centerp.n-1].info|=LINE_Bez;
-				centerp.push(p2->p());     centerp.e[centerp.n-1].info|=LINE_Vertex;
-			} else { //add bez
-				if (!ignorefirst) {
-					centerp.push(p->p()); centerp.e[centerp.n-1].info|=LINE_Vertex;
-				}
-				centerp.push(c1);         centerp.e[centerp.n-1].info|=LINE_Bez;
-				centerp.push(c2);         centerp.e[centerp.n-1].info|=LINE_Bez;
-				centerp.push(p2->p());    centerp.e[centerp.n-1].info|=LINE_Vertex;
+				cache_top   .push(seg->top   .e[bb]);
+				cache_bottom.push(seg->bottom.e[bb]);
 			}
 		}
+		for (int bb=ignorefirst; bb<seg->center.n; bb++) centerp.push(seg->center.e[bb]);
 
 		if (ignorefirst==0) ignorefirst=1;
 
@@ -1335,209 +1806,85 @@ void Path::UpdateCache()
 		cp++;
 	} while (p && p->next && p!=start); //loop over original line
 
-	int closed=(p==start);
-
-	//DBG dump_points("centerp",centerp.e,centerp.n);
-
-	// Now to build actual cache paths from topp, bottomp, and centerp sample points raw materials.
-	//we take the topp and bottomp points, and create a path that incorporates both,
-	//temporarily installing all points to topp...
-	
-
-	if (!closed) {
-		 //top contour is connected to bottom with caps..
-		topp.e[topp.n-1].info|=LINE_Cap;
-
-		// *** add cap at 1st topp.n (original end of path)
-		for (int c=bottomp.n-1; c>=0; c--) {
-			topp.push(bottomp.e[c]);
-			if (topp.e[topp.n-1].info&LINE_Join) {
-				topp.e[topp.n-1].info&=~LINE_Join;
-				if (topp.n>1) topp.e[topp.n-2].info|=LINE_Join;
-			}
-		}
-		// *** add cap at new topp.n (original beginning of path)
-		topp.e[topp.n-1].info|=LINE_Cap;
-		topp.e[topp.n-1].info|=LINE_Closed;
-
-	} else {
-		 //path is closed...
-		if (centerp.e[centerp.n-1]==centerp.e[0]) centerp.n--; //first point will maybe have been repeated
-		centerp.e[centerp.n-1].info|=LINE_Closed;
-
-		 //bottom contour is a seperate path than top contour
-		if (topp.e[topp.n-1]==topp.e[0]) topp.n--; //first point will maybe have been repeated
-		if (bottomp.e[bottomp.n-1]==bottomp.e[0]) bottomp.n--; //first point will maybe have been repeated
-
-		topp.e[topp.n-1].info|=LINE_Closed;
-		if (bottomp.e[bottomp.n-1].info&LINE_Join) bottomp.e[0].info|=LINE_Join;
-		for (int c=bottomp.n-1; c>=0; c--) {
-			topp.push(bottomp.e[c]);
-			if (topp.e[topp.n-1].info&LINE_Join && c>0) {
-				topp.e[topp.n-1].info&=~LINE_Join;
-				if (topp.n>1) topp.e[topp.n-2].info|=LINE_Join;
-			}
-		}
-		topp.e[topp.n-1].info|=LINE_Closed;
-	}
-
-	//DBG dump_points("topp:",topp.e,topp.n);
-
-	//----------------
-	//
-	//Now raw paths for outline and centerline are constructed. need to bezier approximate
-	//from the raw sample points, and add joins where necessary.
-	//
-
-	int thisclosed, thisstart, thisn;
-
-	 //bezier approximate the sample points between join points
-	for (int pth=0; pth<2; pth++) {
-		NumStack<flatpoint> *list;
-		NumStack<flatpoint> newlist;
-
-		if (pth==0) list=&topp;
-		else list=&centerp;
-
+	 //drop samples of segments that no longer exist
+	while (cache_segments.n>cp) cache_segments.remove(cache_segments.n-1);
 
-		DBG if (pth==0) cerr <<"------approximate for topp..."<<endl;
-		DBG if (pth==1) cerr <<"------approximate for centerp..."<<endl;
-		bez_reduce_approximate(list, maxx>minx ? (maxx-minx + maxy-miny)/10000 : 1e-7);
-	}
-
-	//DBG dump_points("topp after approximate:",topp.e,topp.n);
-
-	 //do joins for center and outline paths
-	int njoin;
-	flatpoint join[8];
-	flatpoint line[8];
-	flatpoint samples[3];
-
-	for (int pth=0; pth<2; pth++) {
-	  NumStack<flatpoint> *list;
-	  if (pth==0) list=&topp;
-	  else list=&centerp;
-
-	  thisclosed=0;
-	  thisstart=0;
-	  thisn=-1;
-
-	  DBG if (pth==0) cerr <<"------joins for topp..."<<endl;
-	  DBG if (pth==1) cerr <<"------joins for centerp..."<<endl;
-
-	  for (int c=0; c<list->n; c++) {
-		//DBG cerr <<list->e[c].x<<"   "<<list->e[c].y<<endl;
-		if (thisn<0 || (thisn>0 && c>=thisstart+thisn)) {
-			 //need to find length of current line, which might not be list->n, so as
-			 //not to do buffer overruns below
-			thisstart=c;
-			for (int c2=thisstart; c2<list->n; c2++) {
-				if      (list->e[c2].info&LINE_Closed) thisclosed= 1;
-				else if (list->e[c2].info&LINE_Open)   thisclosed=-1;
-				else if (c2==list->n-1) thisclosed=-1;
-				else thisclosed=0;
-
-				if (thisclosed!=0) {
-					thisn=c2-thisstart+1;
-					break;
-				}
-			}
-		}
-
-		int jointype = 0;
-		if ((list->e[c].info&LINE_Cap)!=0) {
-			if (linestyle) {
-				if (c == list->n-1) {
-					//start cap
-					if      (linestyle->capstyle == LAXCAP_Butt)  jointype = LAXJOIN_Bevel;
-					else if (linestyle->capstyle == LAXCAP_Round) jointype = LAXJOIN_Round;
-					else jointype = LAXJOIN_Bevel;
-				} else {
-					//end cap
-					int capstyle = linestyle->endcapstyle;
-					if (capstyle == 0) capstyle = linestyle->capstyle;
+	int closed=(p==start);
 
-					if      (capstyle == LAXCAP_Butt)  jointype = LAXJOIN_Bevel;
-					else if (capstyle == LAXCAP_Round) jointype = LAXJOIN_Round;
-					else jointype = LAXJOIN_Bevel;
-				}
-			}
-			if (!jointype) jointype = LAXJOIN_Bevel;
-		}
-		if ((list->e[c].info&LINE_Join)!=0 && !jointype) {
-			jointype = linestyle ? linestyle->joinstyle : LAXJOIN_Round;
-		} 
-		if (!jointype) continue; //nothing special to do
+	//DBG dump_points("centerp",centerp.e,centerp.n);
 
-		//DBG cerr <<"maybe join, dist to next point="<<norm2(list->e[c]-list->e[c+1])<<endl; 
+	// Now to build actual cache paths from topp, bottomp, and centerp sample points raw materials.
+	//we take the topp and bottomp points, and create a path that incorporates both,
+	//temporarily installing all points to topp...
+	
 
-		// *** trouble spot with following line, should wrap around as appropriate
-		if (c<thisstart+thisn-1 && norm2(list->e[c]-list->e[c+1])<1e-5) continue; //don't bother if points really close together
+	if (!closed) {
+		 //top contour is connected to bottom with caps..
+		topp.e[topp.n-1].info|=LINE_Cap;
 
-		DBG cerr << "**** JOIN at "<<c<<'/'<<list->n<<endl;
+		// *** add cap at 1st topp.n (original end of path)
+		for (int c=bottomp.n-1; c>=0; c--) {
+			topp.push(bottomp.e[c]);
+			if (topp.e[topp.n-1].info&LINE_Join) {
+				topp.e[topp.n-1].info&=~LINE_Join;
+				if (topp.n>1) topp.e[topp.n-2].info|=LINE_Join;
+			}
+		}
+		// *** add cap at new topp.n (original beginning of path)
+		topp.e[topp.n-1].info|=LINE_Cap;
+		topp.e[topp.n-1].info|=LINE_Closed;
 
+	} else {
+		 //path is closed...
+		if (centerp.e[centerp.n-1]==centerp.e[0]) centerp.n--; //first point will maybe have been repeated
+		centerp.e[centerp.n-1].info|=LINE_Closed;
 
-		if (list->e[thisstart + (c-thisstart+thisn-1)%thisn].info&LINE_Bez) {
-			 //prev points were bez segment
-			line[3]=list->e[c];
-			line[2]=list->e[thisstart + (c-thisstart+thisn-1)%thisn];
-			line[1]=list->e[thisstart + (c-thisstart+thisn-2)%thisn];
-			line[0]=list->e[thisstart + (c-thisstart+thisn-3)%thisn];
+		 //bottom contour is a seperate path than top contour
+		if (topp.e[topp.n-1]==topp.e[0]) topp.n--; //first point will maybe have been repeated
+		if (bottomp.e[bottomp.n-1]==bottomp.e[0]) bottomp.n--; //first point will maybe have been repeated
 
-		} else {
-			 //prev points were straight segment
-			samples[1]=list->e[c];
-			samples[0]=list->e[thisstart + (c-thisstart+thisn-1)%thisn];
-			flatpoint vv=(samples[1]-samples[0])/3;
-			
-			line[3]=samples[1];
-			line[2]=samples[1]-vv;
-			line[1]=samples[1]-2*vv;
-			line[0]=samples[0];
+		topp.e[topp.n-1].info|=LINE_Closed;
+		if (bottomp.e[bottomp.n-1].info&LINE_Join) bottomp.e[0].info|=LINE_Join;
+		for (int c=bottomp.n-1; c>=0; c--) {
+			topp.push(bottomp.e[c]);
+			if (topp.e[topp.n-1].info&LINE_Join && c>0) {
+				topp.e[topp.n-1].info&=~LINE_Join;
+				if (topp.n>1) topp.e[topp.n-2].info|=LINE_Join;
+			}
 		}
+		topp.e[topp.n-1].info|=LINE_Closed;
+	}
 
-		//if (list->e[thisstart + (c-thisstart+1)%thisn].info&LINE_Bez) {
-		if (list->e[thisstart + (c-thisstart+2)%thisn].info&LINE_Bez) {
-			 //next points were bez segment
-			line[4]=list->e[thisstart + (c-thisstart+1)%thisn];
-			line[5]=list->e[thisstart + (c-thisstart+2)%thisn];
-			line[6]=list->e[thisstart + (c-thisstart+3)%thisn];
-			line[7]=list->e[thisstart + (c-thisstart+4)%thisn];
+	//DBG dump_points("topp:",topp.e,topp.n);
 
-		} else {
-			 //next points were straight segment
-			samples[0]=list->e[thisstart + (c-thisstart+1)%thisn];
-			samples[1]=list->e[thisstart + (c-thisstart+2)%thisn];
-			flatpoint vv=(samples[1]-samples[0])/3;
+	//----------------
+	//
+	//Now raw paths for outline and centerline are constructed. need to bezier approximate
+	//from the raw sample points, and add joins where necessary.
+	//
 
-			line[4]=samples[0];
-			line[5]=samples[0]+vv;
-			line[6]=samples[0]+2*vv;
-			line[7]=samples[1];
-		}
+	 //bezier approximate the sample points between join points
+	for (int pth=0; pth<2; pth++) {
+		NumStack<flatpoint> *list;
+		NumStack<flatpoint> newlist;
 
-		njoin=0;
-		join_paths(jointype,
-				   linestyle ? linestyle->miterlimit : defaultwidth*200,
-				   line[0],line[1],line[2],line[3],
-				   line[4],line[5],line[6],line[7],
-				   &njoin, join);
+		if (pth==0) list=&topp;
+		else list=&centerp;
 
-		if (njoin>0 && c==thisstart+thisn-1) list->e[c].info&=~(LINE_Closed|LINE_Open);
-		for (int cc=0; cc<njoin; cc++) {
-			list->push(join[cc],c+1);
-			c++;
-			thisn++;
-		}
 
-		if (c==thisstart+thisn-1) {
-			if (thisclosed==1)       list->e[c].info|=LINE_Closed;
-			else if (thisclosed==-1) list->e[c].info|=LINE_Open;
-			thisn=-1;
-		}
-	  }
+		DBG if (pth==0) cerr <<"------approximate for topp..."<<endl;
+		DBG if (pth==1) cerr <<"------approximate for centerp..."<<endl;
+		bez_reduce_approximate(list, maxx>minx ? (maxx-minx + maxy-miny)/10000 : 1e-7);
 	}
 
+	//DBG dump_points("topp after approximate:",topp.e,topp.n);
+
+	 //do joins for center and outline paths
+	DBG cerr <<"------joins for topp..."<<endl;
+	path_add_joins(&topp, linestyle, defaultwidth);
+	DBG cerr <<"------joins for centerp..."<<endl;
+	path_add_joins(&centerp, linestyle, defaultwidth);
+
 
 	 //finally install topp to outlinecache
 	flatpoint *aa=topp.extractArray(&n);
@@ -1562,6 +1909,7 @@ void Path::UpdateCache()
 	}
 
 	needtorecache = 0;
+	cache_generation++;
 }
 
 
@@ -3416,10 +3764,10 @@ int Path::PointInfo(double t, int tisdistance, flatpoint *point, flatpoint *tang
  * Returns 1 for point found, -1 for point clamped to beginning point, -2 clamped to end,
  * or 0 if there is not a valid path available.
  *
- * \todo be able to wind around the path if continuous, or go backwards (for negative t)
+ * Distances are looked up in the arc length table (see UpdateArcTable()), and wrap around
+ * closed paths. resolution is ignored for distances now, as the table sets its own sampling.
+ *
  * \todo must implement find tangent at clamped endpoints
- * \todo *** note that if you have a loop of null points, and you are going along based
- *   on distance, than this will not break!!
  */
 int Path::PointAlongPath(double t, //!< Either visual distance or bezier parameter, depending on tisdistance
 						 int tisdistance, //!< 1 for visual distance, 0 for t is bez parameter
@@ -3432,7 +3780,6 @@ int Path::PointAlongPath(double t, //!< Either visual distance or bezier paramet
 	Coordinate *start=path->firstPoint(1);
 	if (!start) return 0;
 	Coordinate *p=start, *c1, *c2, *v2;
-	double dd;
 	flatpoint fp;
 
 	if (t<=0 && !IsClosed()) {
@@ -3451,49 +3798,18 @@ int Path::PointAlongPath(double t, //!< Either visual distance or bezier paramet
 		}
 	}
 
-	if (t<0 && tisdistance) {
-		 //to be here, t is distance AND the path is closed..
-
-		do { //one iteration for each segment (a vertex to next vertex)
-			c1=c2=v2=NULL;
-			v2=p->prev;
-			if (!v2) break;
-
-			if (v2->flags&POINT_TONEXT) { c1=v2; v2=v2->prev; if (!v2) break; }
-			else { c1=p;  }
-
-			if (v2->flags&POINT_TOPREV) { c2=v2; v2=v2->prev; if (!v2) break; }
-			else { c2=v2; }
-
-			if (c1==p && c2==v2) {
-				 //we have the simpler case of a line segment
-				fp=v2->p()-p->p(); //current segment
-
-				dd=norm(fp);
-				if (-t>dd) { t+=dd; p=v2; continue; } //not on this segment!
-
-				if (point) *point=(dd ? p->p()-t*fp/dd : p->p());
-				if (tangent) *tangent=-fp;
-				return 1;
-
-			} else {
-				 //must deal with a bezier segment
-				double tt=0;
-
-				dd=bez_segment_length(p->p(),c1->p(),c2->p(),v2->p(), resolution);
-				if (-t>dd) { t+=dd; p=v2; continue; } //not on this segment!
-				tt=bez_distance_to_t(-t, p->p(),c1->p(),c2->p(),v2->p(), resolution);
-				
-				if (point) *point=bez_point(tt, p->p(),c1->p(),c2->p(),v2->p());
-				if (tangent) {
-					*tangent = -bez_point(tt+.01, p->p(),c1->p(),c2->p(),v2->p())
-							   +bez_point(tt, p->p(),c1->p(),c2->p(),v2->p());
-				}
-				return 1;
-			}
-		} while (1);
+	if (tisdistance) {
+		 //convert to t with the arc table, then evaluate there
+		int n = UpdateArcTable();
+		int onpath = 0;
+		double tt = (n ? arc_distance_to_t(arc_lengths, arc_samples, n, arc_closed, t, NULL, &onpath) : 0);
 
-		//theoretically you'll never break out of the loop
+		if (onpath) {
+			arc_point_at(arc_segs, n, tt, point, tangent);
+			if (t<0 && tangent) *tangent = -*tangent; //going backwards around a closed path
+			return 1;
+		}
+		t = n+1; //off the end, fall through to clamp
 	}
 
 	do { //one iteration for each segment (a vertex to next vertex)
@@ -3510,35 +3826,16 @@ int Path::PointAlongPath(double t, //!< Either visual distance or bezier paramet
 		if (c1==p && c2==v2) {
 			 //we have the simpler case of a line segment
 			fp=v2->p()-p->p(); //current segment
-			if (tisdistance) {
-				dd=norm(fp);
-				if (t>dd) { t-=dd; p=v2; continue; } //not on this segment!
+			if (t>1) { p=v2; t-=1; continue; }
 
-				if (point) *point=(dd ? p->p()+t*fp/dd : p->p());
-				if (tangent) *tangent=fp;
-				return 1;
-
-			} else {
-				 //easy to check when using t parameter
-				if (t>1) { p=v2; t-=1; continue; }
-				
-				if (point) *point=p->p()+t*fp;
-				if (tangent) *tangent=fp;
-				return 1;
-			}
+			if (point) *point=p->p()+t*fp;
+			if (tangent) *tangent=fp;
+			return 1;
 
 		} else {
 			 //must deal with a bezier segment
-			double tt=0;
-			if (tisdistance) {
-				dd=bez_segment_length(p->p(),c1->p(),c2->p(),v2->p(), resolution);
-				if (t>dd) { t-=dd; p=v2; continue; } //not on this segment!
-				tt=bez_distance_to_t(t, p->p(),c1->p(),c2->p(),v2->p(), resolution);
-			} else {
-				 //easy to check when using t parameter
-				if (t>1) { p=v2; t-=1; continue; }
-				tt=t;
-			}
+			if (t>1) { p=v2; t-=1; continue; }
+			double tt=t;
 
 			if (point) *point=bez_point(tt, p->p(),c1->p(),c2->p(),v2->p());
 			if (tangent) {
@@ -3561,82 +3858,45 @@ int Path::PointAlongPath(double t, //!< Either visual distance or bezier paramet
 //! Find the point on any of the paths closests to point.
 /*! point is assumed to already be in data coordinates.
  * Returns the distance between those, and the t parameter to that path point.
+ *
+ * Segments are pruned by the distance to their control hull bounds from the arc table,
+ * so only segments that could possibly be closer than the best so far get searched.
  */
 flatpoint Path::ClosestPoint(flatpoint point, double *disttopath, double *distalongpath, double *tdist, int resolution)
 {
 	if (!path) return flatpoint();
-	Coordinate *start=path->firstPoint(1);
-	if (!start) return flatpoint();
-
-
-	// *** note this assumes start and path refer to the same vertex!
+	int n = UpdateArcTable();
 
 	double dd=0, d=10000000; //distance to path
-	double vdd=0, vd=0;  //visual distance: running total, and for found
-	double tt=0, t=0; //t distance: running total, and for found
+	double tt=0, t=0; //t within segment, and path t for found
 	flatpoint found, ff;
-	Coordinate *p=start, *c1, *c2, *v2;
-
-	do { //one iteration for each segment (a vertex to next vertex)
-		c1=c2=v2=NULL;
-		v2=p->next;
-		if (!v2) break;
 
-		if (v2->flags&POINT_TOPREV) {
-			c1=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c1=p;
+	if (n) {
+		 //seed with the segment whose bounds are nearest, so most of the rest can be skipped
+		int first = 0;
+		double bd, bestbd = arc_bounds_distance(arc_segs[0], point);
+		for (int c=1; c<n; c++) {
+			bd = arc_bounds_distance(arc_segs[c], point);
+			if (bd < bestbd) { bestbd = bd; first = c; }
 		}
 
-		if (v2->flags&POINT_TONEXT) {
-			c2=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c2=v2;
-		}
+		d = arc_segment_closest(arc_segs[first], point, 50, &tt, &found);
+		t = first + tt;
 
-		if (c1==p && c2==v2) {
-			 //we have the simpler case of a line segment
-			flatpoint aa=(point-p->p()); //vector from p to point
-			flatpoint bb=(v2->p()-p->p());   //current segment
-			flatpoint vv=-(aa|=bb);         //vector perpendicular to segment starting at point
-			ff=point+vv;
-			dd=norm(vv); //here's a distance, but we are not yet sure if perpendicular actually touches segment
-
-			double ss=bb*bb; //square of the length of the segment
-			double sp=(ss?(aa*bb)/ss:0); //guard against p and v2 being the same point
-
-			if (dd<d && sp>=0 && sp<=1) { //distance is closer AND we are near the segment
-				found=ff;
-				d=dd;            //update distance to path
-				t=tt+sp;         //update tdist for found point
-				vd=vdd+sp*sqrt(ss); //update visual distance for closest
-			}
-			vdd+=sqrt(ss);   //update running visual distance
+		for (int c=0; c<n; c++) {
+			if (c == first || arc_bounds_distance(arc_segs[c], point) >= d) continue;
 
-		} else {
-			 //else need to search bez segment
-			double vddd=0;
-			double ttt=bez_closest_point(point, p->p(),c1->p(),c2->p(),v2->p(), 50, &dd,&vddd,&ff);
-			if (dd<d) {
-				found=ff;
-				d=dd; //update distance to path
-				t=tt+ttt;  //update tdist for found point
-				vd=vdd+vddd; //update visual distance for closest
+			dd = arc_segment_closest(arc_segs[c], point, 50, &tt, &ff);
+			if (dd < d) {
+				found = ff;
+				d = dd;
+				t = c + tt;
 			}
-			vdd+=bez_segment_length(p->p(),c1->p(),c2->p(),v2->p(), resolution);   //update running visual distance
 		}
-
-		p=v2;
-		tt+=1;
-
-	} while (p!=start);
+	}
 
 	if (disttopath) *disttopath=d;
-	if (distalongpath) *distalongpath=vd;
+	if (distalongpath) *distalongpath=(n ? arc_t_to_distance(arc_lengths, arc_samples, n, arc_closed, t, NULL) : 0);
 	if (tdist) *tdist=t;
 	return found;
 }
@@ -3845,199 +4105,114 @@ int Path::Contains(Path *otherpath)
 //! Find the distance along the path between the bounds, or whole length if tend<tstart.
 double Path::Length(double tstart,double tend)
 {
-	if (!path) return 0;
-	Coordinate *start=path->firstPoint(1);
-	if (!start) return 0;
-	Coordinate *p=start, *c1, *c2, *v2;
-	double d=0, t=0;
-
-	if (tend<tstart) {
-		DBG cerr <<" *** need to implement partial path length!!"<<endl;
-	}
-
-	do { //one iteration for each segment (a vertex to next vertex)
-		c1=c2=v2=NULL;
-		v2=p->next;
-		if (!v2) break;
-
-		if (v2->flags&POINT_TOPREV) {
-			c1=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c1=p;
-		}
-
-		if (v2->flags&POINT_TONEXT) {
-			c2=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c2=v2;
-		}
-
-		if (c1==p && c2==v2) {
-			 //we have the simpler case of a line segment
-			d+=norm(v2->p() - p->p());
+	int n = UpdateArcTable();
+	if (!n) return 0;
+	if (tend<tstart) return arc_lengths[n];
 
-		} else {
-			 //else need to search bez segment
-			d += bez_segment_length(p->p(),c1->p(),c2->p(),v2->p(), 30);   //update running visual distance
-		}
-
-		p=v2;
-		t+=1;
-
-	} while (p!=start);
-
-	return d;
+	return arc_t_to_distance(arc_lengths, arc_samples, n, arc_closed, tend,   NULL)
+		 - arc_t_to_distance(arc_lengths, arc_samples, n, arc_closed, tstart, NULL);
 }
 
 /*! If the tt is on the path, set *err=1. else *err=0.
- *
- * \todo If tt<0 this fails... it shouldn't!!
+ * Closed paths wrap around, open paths clamp to the ends.
+ * resolution is ignored, as the arc table (see UpdateArcTable()) sets its own sampling.
  */
 double Path::t_to_distance(double tt, int *err, int resolution)
 {
-	if (!path) {
-		if (err) *err=0;
-		return 0;
-	}
-	Coordinate *start=path->firstPoint(1);
-	if (!start) {
+	int n = UpdateArcTable();
+	if (!n) {
 		if (err) *err=0;
 		return 0;
 	}
-	Coordinate *p=start, *c1, *c2, *v2;
-	double d=0, sd, t=0;
-
-	do { //one iteration for each segment (a vertex to next vertex)
-		c1=c2=v2=NULL;
-		v2=p->next;
-		if (!v2) break;
-
-		if (v2->flags&POINT_TOPREV) {
-			c1=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c1=p;
-		}
-
-		if (v2->flags&POINT_TONEXT) {
-			c2=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c2=v2;
-		}
-
-		if (c1==p && c2==v2) {
-			 //we have the simpler case of a line segment
-			sd=norm(v2->p() - p->p());
-			if (tt>t+1) {
-				d+=sd;
-				p=v2;
-				t++;
-				continue;
-			}
-			d+=sd*(tt-t);
-			if (err) *err=1;
-			return d;
-
-		} else {
-			 //else need to search bez segment
-			sd=bez_segment_length(p->p(),c1->p(),c2->p(),v2->p(), resolution);   //update running visual distance
-			if (tt>t+1) {
-				d+=sd;
-				p=v2;
-				t++;
-				continue;
-			}
-			d+=bez_t_to_distance(tt-t, p->p(),c1->p(),c2->p(),v2->p(), resolution);
-			if (err) *err=1;
-			return d;
-		}
-
-		p=v2;
-		t+=1;
-
-	} while (p!=start);
-
-	return d;
+	return arc_t_to_distance(arc_lengths, arc_samples, n, arc_closed, tt, err);
 }
 
-/*! If the tt is on the path, set *err=1. else *err=0.
+/*! If the distance is on the path, set *err=1. else *err=0.
+ * Closed paths wrap around, open paths clamp to the ends.
+ * resolution is ignored, as the arc table (see UpdateArcTable()) sets its own sampling.
  */
 double Path::distance_to_t(double distance, int *err, int resolution)
 {
-	if (!path) {
+	int n = UpdateArcTable();
+	if (!n) {
 		if (err) *err=0;
 		return 0;
 	}
-	Coordinate *start=path->firstPoint(1);
-	if (!start) {
-		if (err) *err=0;
+	return arc_distance_to_t(arc_lengths, arc_samples, n, arc_closed, distance, NULL, err);
+}
+
+/*! Batched distance_to_t(). Runs of increasing distances reuse the previous segment
+ * instead of searching again. Returns the number of distances that were on the path.
+ */
+int Path::DistancesToT(const double *distances, int n, double *t_ret)
+{
+	int nseg = UpdateArcTable();
+	if (!nseg) {
+		for (int c=0; c<n; c++) t_ret[c] = 0;
 		return 0;
 	}
-	Coordinate *p=start, *c1, *c2, *v2;
-	double d=0, sd, t=0;
 
-	do { //one iteration for each segment (a vertex to next vertex)
-		c1=c2=v2=NULL;
-		v2=p->next;
-		if (!v2) break;
+	int hint = 0, err, num = 0;
+	for (int c=0; c<n; c++) {
+		t_ret[c] = arc_distance_to_t(arc_lengths, arc_samples, nseg, arc_closed, distances[c], &hint, &err);
+		num += err;
+	}
+	return num;
+}
 
-		if (v2->flags&POINT_TOPREV) {
-			c1=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c1=p;
-		}
+/*! Batched t_to_distance(). Returns the number of t values that were on the path.
+ */
+int Path::TToDistances(const double *t, int n, double *distances_ret)
+{
+	int nseg = UpdateArcTable();
+	if (!nseg) {
+		for (int c=0; c<n; c++) distances_ret[c] = 0;
+		return 0;
+	}
 
-		if (v2->flags&POINT_TONEXT) {
-			c2=v2;
-			v2=v2->next;
-			if (!v2) break;
-		} else {
-			c2=v2;
-		}
+	int err, num = 0;
+	for (int c=0; c<n; c++) {
+		distances_ret[c] = arc_t_to_distance(arc_lengths, arc_samples, nseg, arc_closed, t[c], &err);
+		num += err;
+	}
+	return num;
+}
 
-		if (c1==p && c2==v2) {
-			 //we have the simpler case of a line segment
-			sd=norm(v2->p() - p->p());
-			if (distance>sd) { 
-				distance-=sd;
-				p=v2;
-				t++;
-				continue;
-			}
-			t+=distance/sd;
-			if (err) *err=1;
-			return t;
+/*! Batched PointAlongPath(), evaluating straight from the arc table. Values off an open path are clamped
+ * to the ends, and closed paths wrap. Either of points_ret or tangents_ret may be NULL.
+ * Returns the number of values that were on the path.
+ */
+int Path::PointsAlongPath(const double *t, int n, int tisdistance, flatpoint *points_ret, flatpoint *tangents_ret)
+{
+	int nseg = UpdateArcTable();
+	if (!nseg) {
+		flatpoint p = (path ? path->p() : flatpoint());
+		for (int c=0; c<n; c++) {
+			if (points_ret) points_ret[c] = p;
+			if (tangents_ret) tangents_ret[c] = flatpoint();
+		}
+		return 0;
+	}
 
+	int hint = 0, err, num = 0;
+	double tt;
+	for (int c=0; c<n; c++) {
+		if (tisdistance) {
+			tt = arc_distance_to_t(arc_lengths, arc_samples, nseg, arc_closed, t[c], &hint, &err);
 		} else {
-			 //else need to search bez segment
-			sd=bez_segment_length(p->p(),c1->p(),c2->p(),v2->p(), resolution);   //update running visual distance
-			if (distance>sd) { //not terribly efficient here
-				distance-=sd;
-				p=v2;
-				t++;
-				continue;
-			}
-			t+=bez_distance_to_t(distance, p->p(),c1->p(),c2->p(),v2->p(), resolution);
-			if (err) *err=1;
-			return t;
+			tt = t[c];
+			err = 1;
+			if (arc_closed && (tt < 0 || tt > nseg)) {
+				tt = fmod(tt, (double)nseg);
+				if (tt < 0) tt += nseg;
+			} else if (tt < 0) { tt = 0; err = 0; }
+			else if (tt > nseg) { tt = nseg; err = 0; }
 		}
 
-		p=v2;
-		t+=1;
-
-	} while (p!=start);
-
-	if (err) *err=0;
-	return d;
+		arc_point_at(arc_segs, nseg, tt, points_ret ? points_ret+c : NULL, tangents_ret ? tangents_ret+c : NULL);
+		num += err;
+	}
+	return num;
 }
 
 
@@ -8795,6 +8970,21 @@ void PathInterface::hoverMessage()
 	PostMessage(mes);
 }
 
+/*! Damage only the area of a hovered vertex or handle at p, in data coordinates,
+ * rather than redrawing everything. See anInterface::Invalidate().
+ */
+void PathInterface::invalidateHoverPoint(flatpoint p)
+{
+	DoubleBBox box(realtoscreen(transform_point(datam(), p)));
+	Invalidate(box, 8*ScreenLine());
+}
+
+ //hovers that are drawn in Refresh() as just a shape at hoverpoint
+static bool IsPointHover(int hover)
+{
+	return hover==HOVER_Vertex || hover==HOVER_Point || hover==HOVER_Handle;
+}
+
 /*! 
  * \todo
  *   If you click on the middle of a straight line segment, there should be an option
@@ -8814,6 +9004,7 @@ int PathInterface::MouseMove(int x,int y,unsigned int state,const LaxMouse *mous
 		int oldhover=drawhover;
 		int oldpathi=drawhoveri;
 		int oldhoveri=drawhoveri;
+		flatpoint oldhoverpoint=hoverpoint;
 		drawpathi=-1;
 		drawhover=HOVER_None;
 		drawhoveri=-1;
@@ -8861,8 +9052,14 @@ int PathInterface::MouseMove(int x,int y,unsigned int state,const LaxMouse *mous
 				}
 			} else hoverpointtype=BEZ_STIFF_EQUAL;
 
-			if (drawhover!=oldhover) needtodraw|=2;
 			hoverpoint=h->p();
+			if (drawhover!=oldhover || hoverpoint!=oldhoverpoint) {
+				 //only the old and new handle change, unless something bigger was hovered before
+				if (oldhover==HOVER_None || IsPointHover(oldhover)) {
+					if (oldhover!=HOVER_None) invalidateHoverPoint(oldhoverpoint);
+					invalidateHoverPoint(hoverpoint);
+				} else needtodraw|=2;
+			}
 			hoverMessage();
 			return 0;
 		}
@@ -8899,7 +9096,8 @@ int PathInterface::MouseMove(int x,int y,unsigned int state,const LaxMouse *mous
 		 || drawhoveri != oldhoveri
 		 || drawhover == HOVER_AddPointOn
 		 || drawhover == HOVER_AddWeightNode) {
-			needtodraw=1;
+			if (drawhover==HOVER_None && IsPointHover(oldhover)) invalidateHoverPoint(oldhoverpoint);
+			else needtodraw=1;
 			hoverMessage();
 		}
 		return 0;
@@ -10304,6 +10502,7 @@ PathUndo::PathUndo(PathsData *object, int ntype, int nisauto)
 	if (object) object->inc_count();
 
 	type = ntype;
+	path = nullptr;
 }
 
 PathUndo::~PathUndo()
@@ -10311,6 +10510,15 @@ PathUndo::~PathUndo()
 	if (path) path->dec_count();
 }
 
+/*! Counts the stacks, and a rough guess at the held path.
+ */
+int PathUndo::Size()
+{
+	int n = sizeof(PathUndo) + path_indices.n * sizeof(int) + indices.n * sizeof(int) + points.n * sizeof(flatpoint);
+	if (path) n += sizeof(Path) + (path->path ? path->path->NumPoints(0) : 0) * sizeof(Coordinate);
+	return n;
+}
+
 const char *PathUndo::Description()
 {
 	switch (type) {
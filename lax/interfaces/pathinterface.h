@@ -53,6 +53,9 @@ class ShapeBrush;
 #define BEZ_NSTIFF_EQUAL   (1<<22)
 #define BEZ_NSTIFF_NEQUAL  (1<<23)
 
+ //number of t steps per segment in Path's arc length table
+#define PATH_ARC_SAMPLES  16
+
 
 //-------------------- Path ---------------------------
 
@@ -82,6 +85,24 @@ class PathWeightNode
 	double bottomOffset() { return offset-width/2; }
 };
 
+class PathArcSegment
+{
+  public:
+	Laxkit::flatpoint p1, c1, c2, p2; //lines get c1,c2 at thirds, so t is linear along them
+	double minx, maxx, miny, maxy; //bounds of the control hull
+	bool isline;
+};
+
+class PathCacheSegment
+{
+  public:
+	Laxkit::flatpoint p1, c1, c2, p2; //base segment the samples were made from
+	bool isline;
+	int index; //t offset of the segment, which does not count skipped null segments
+	Laxkit::NumStack<Laxkit::flatpoint> top, bottom; //one per sample
+	Laxkit::NumStack<Laxkit::flatpoint> center; //one per sample for offset paths, else the 4 bezier points
+};
+
 class Path : virtual public Laxkit::anObject,
 			 virtual public Laxkit::DoubleBBox,
 			 virtual public Laxkit::DumpUtility
@@ -115,6 +136,21 @@ class Path : virtual public Laxkit::anObject,
 	virtual void UpdateS(bool all, int resolution=30);
 	virtual void UpdateCache();
 	virtual void UpdateWidthCache();
+	virtual void SampleCacheSegment(PathCacheSegment *seg, bool hasangle, bool hasoffset);
+	int cache_generation; //incremented each time UpdateCache() actually rebuilds
+	unsigned long cache_segments_hash; //hash of everything besides segment shape that affects the samples
+	Laxkit::PtrStack<PathCacheSegment> cache_segments; //per segment samples, reused when segments do not change
+
+	//------ arc length table ------
+	int arc_segments;
+	int arc_generation;
+	bool arc_closed;
+	unsigned long arc_hash;
+	PathArcSegment *arc_segs;
+	double *arc_lengths; //arc_segments+1 cumulative lengths, one per vertex
+	double *arc_samples; //PATH_ARC_SAMPLES+1 cumulative lengths per segment, at even t steps
+	virtual int UpdateArcTable();
+	virtual void ClearArcTable();
 
 	Path();
 	Path(Coordinate *np,LineStyle *nls=NULL);
@@ -190,6 +226,9 @@ class Path : virtual public Laxkit::anObject,
 	virtual double Length(double tstart,double tend);
 	virtual double distance_to_t(double distance, int *err, int resolution=50);
 	virtual double t_to_distance(double t, int *err, int resolution=50);
+	virtual int DistancesToT(const double *distances, int n, double *t_ret);
+	virtual int TToDistances(const double *t, int n, double *distances_ret);
+	virtual int PointsAlongPath(const double *t, int n, int tisdistance, Laxkit::flatpoint *points_ret, Laxkit::flatpoint *tangents_ret);
 	virtual int NumVertices(bool *isclosed_ret);
 	virtual bool IsClosed();
 	virtual int GetIndex(Coordinate *p, bool ignore_controls);
@@ -555,6 +594,7 @@ class PathInterface : public anInterface
 	virtual int rotateSelected(Laxkit::flatpoint center,double angle);
 
 	virtual void hoverMessage();
+	virtual void invalidateHoverPoint(Laxkit::flatpoint p);
 	virtual void drawNewPathIndicator(Laxkit::flatpoint p,int which);
 	virtual void drawWeightNode(Path *path, PathWeightNode *weight, int isfornew);
 	virtual void DrawBaselines();
@@ -677,6 +717,7 @@ class PathUndo : public Laxkit::UndoData
 	PathUndo(PathsData *object, int ntype, int nisauto);
 	~PathUndo();
 	virtual const char *Description();
+	virtual int Size();
 };
 
 } // namespace LaxInterfaces
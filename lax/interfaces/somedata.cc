@@ -324,27 +324,19 @@ int SomeData::renderToBufferImage(LaxImage *image)
  *
  *  Subclasses need not redefine this function. They need only redefine renderToBuffer().
  */
-int SomeData::GeneratePreview(int maxdim)
+//! Pixel size of a preview of data, with the aspect of its bounds.
+static void preview_dims(SomeData *data, int maxdim, int &w, int &h)
 {
-	if (maxx <= minx || maxy <= miny) //bad bounds so return
-		return (previewtime >= modtime);
-
-	DBG cerr <<"...SomeData::GeneratePreview()"<<endl;
-
-
 	if (maxdim <= 0) maxdim = 500;
 	InterfaceManager *im = InterfaceManager::GetDefault(true);
 	if (im) maxdim = im->PreviewSize();
 
-	int w = 0;
-	int h = 0;
-
-	if (maxx - minx > maxy - miny) {
+	if (data->maxx - data->minx > data->maxy - data->miny) {
 		w = maxdim;
-		h = (maxy - miny) * w / (maxx - minx);
+		h = (data->maxy - data->miny) * w / (data->maxx - data->minx);
 	} else {
 		h = maxdim;
-		w = (maxx - minx) * h / (maxy - miny);
+		w = (data->maxx - data->minx) * h / (data->maxy - data->miny);
 	}
 
 	if (w <= 0) w = 1;
@@ -363,10 +355,29 @@ int SomeData::GeneratePreview(int maxdim)
 		w = maxdim * aspect;
 		if (w <= 0) w = 1;
 	}
+}
+
+//! True if old preview is more than 5%-ish off from w,h in x or y.
+static bool preview_resize(LaxImage *preview, int w, int h)
+{
+	return (float)w/preview->w()>1.05 || (float)w/preview->w()<.95 ||
+		   (float)h/preview->h()>1.05 || (float)h/preview->h()<.95;
+}
+
+int SomeData::GeneratePreview(int maxdim)
+{
+	if (maxx <= minx || maxy <= miny) //bad bounds so return
+		return (previewtime >= modtime);
+
+	DBG cerr <<"...SomeData::GeneratePreview()"<<endl;
+
+
+	int w = 0;
+	int h = 0;
+	preview_dims(this, maxdim, w, h);
 
 	//if (preview && (w!=preview->w() || h!=preview->h())) {
-	if (preview && ((float)w/preview->w()>1.05 || (float)w/preview->w()<.95 ||
-					(float)h/preview->h()>1.05 || (float)h/preview->h()<.95)) {
+	if (preview && preview_resize(preview, w, h)) {
 		 //delete old preview and make new only when changing size of preview more that 5%-ish in x or y
 		DBG cerr <<"removing old preview..."<<endl;
 		preview->dec_count(); 
@@ -421,10 +432,95 @@ Laxkit::LaxImage *SomeData::GetPreview()
 	// }
 	// return NULL;
 
+	if (preview_job) TakePreview(true);
 	if (previewtime<modtime || !preview) GeneratePreview(0);
 	return preview;
 }
 
+
+//! Renders a snapshot of a SomeData with its own copy of the tool that draws it, and its own Displayer.
+class SomeDataPreviewRender : public PreviewRender
+{
+  public:
+	SomeData *data;
+	anInterface *interf;
+	Displayer *dp;
+
+	SomeDataPreviewRender(LaxImage *nimage, SomeData *ndata, anInterface *ninterf, Displayer *ndp)
+	  : PreviewRender(nimage)
+	{
+		data = ndata;
+		interf = ninterf;
+		dp = ndp;
+	}
+
+	virtual ~SomeDataPreviewRender()
+	{
+		data->dec_count();
+		interf->dec_count();
+		dp->dec_count();
+	}
+
+	 //same as SomeData::renderToBufferImage(). dp was already made current on image in NewPreviewRender(),
+	 //so this does not touch any shared font
+	virtual int Render()
+	{
+		if (dp->MakeCurrent(image) != 0) return 3;
+		dp->ClearTransparent();
+		dp->NewTransform(image->w()/(data->maxx-data->minx), 0, 0, -image->h()/(data->maxy-data->miny),
+						 -data->minx*image->w()/(data->maxx-data->minx), image->h()*(1+data->miny/(data->maxy-data->miny)));
+		interf->DrawDataDp(dp, data, NULL,NULL);
+		return 0;
+	}
+};
+
+/*! Return a duplicate() of this, a duplicate of the tool that draws it, and a new Displayer already
+ * made current on the new image, all for Previewable::GetPreviewAsync() to render with on another thread.
+ * Returns NULL if this has bad bounds, or no tool draws it, or it cannot be duplicated.
+ *
+ * Subclasses with a custom renderToBufferImage() that uses shared things should return NULL here,
+ * or their own PreviewRender. So should data whose duplicate still refers to images or other objects
+ * of the original, since reference counts and the image cache are not thread safe.
+ */
+PreviewRender *SomeData::NewPreviewRender()
+{
+	if (maxx <= minx || maxy <= miny) return NULL;
+
+	InterfaceManager *imanager = InterfaceManager::GetDefault(true);
+	anInterface *drawer = imanager->GetDrawer(this);
+	if (!drawer) return NULL;
+
+	SomeData *snapshot = duplicate(NULL);
+	if (!snapshot) return NULL;
+	anInterface *interf = drawer->duplicate(NULL);
+	if (!interf) {
+		snapshot->dec_count();
+		return NULL;
+	}
+	snapshot->usepreview = 0;
+
+	int w = 0;
+	int h = 0;
+	preview_dims(this, 0, w, h);
+	if (preview && !preview_resize(preview, w, h)) { //keep size of current preview so it does not jump around
+		w = preview->w();
+		h = preview->h();
+	}
+
+	 //MakeCurrent() here, since the first one sets up the displayer's font from the app's shared default font
+	LaxImage *image = ImageLoader::NewImage(w,h);
+	Displayer *ndp = imanager->GetDisplayer(DRAWS_Screen);
+	if (!image || !ndp || ndp->MakeCurrent(image) != 0) {
+		if (image) image->dec_count();
+		if (ndp) ndp->dec_count();
+		snapshot->dec_count();
+		interf->dec_count();
+		return NULL;
+	}
+
+	return new SomeDataPreviewRender(image, snapshot, interf, ndp);
+}
+
 //! Dump in an Attribute, then call dump_in_atts(thatatt,0).
 /*! If Att!=NULL, then return the attribute used to read in the stuff.
  * This allows holding classes to have extra attributes within the spot field to
@@ -847,6 +943,23 @@ const char *SomeDataUndo::Description()
 	// return NULL;
 }
 
+int SomeDataUndo::Size()
+{
+	return sizeof(SomeDataUndo) + msg.Bytes() + (description ? strlen(description) : 0);
+}
+
+/*! Merge a later change of the same type, keeping our original state and taking on newer's final state.
+ */
+int SomeDataUndo::Coalesce(Laxkit::UndoData *newer)
+{
+	SomeDataUndo *u = dynamic_cast<SomeDataUndo*>(newer);
+	if (!u || u->type != type) return 0;
+
+	m = u->m;
+	box.setbounds(&u->box);
+	return 1;
+}
+
 int SomeData::Undo(UndoData *data)
 {
 	SomeDataUndo *u = dynamic_cast<SomeDataUndo*>(data);
@@ -89,6 +89,7 @@ class SomeData :  virtual public Laxkit::Resourceable,
 	virtual Laxkit::LaxImage *GetPreview();
 	virtual int GeneratePreview(int maxdim);
 	virtual int renderToBufferImage(Laxkit::LaxImage *image);
+	virtual Laxkit::PreviewRender *NewPreviewRender();
 	virtual int renderToBuffer(unsigned char *buffer, int bufw, int bufh, int bufstride, int bufdepth, int bufchannels);
 
 	int modified; //hint for what has been modified
@@ -186,6 +187,8 @@ class SomeDataUndo : public Laxkit::UndoData
 			     Laxkit::Affine *nm, Laxkit::DoubleBBox *nbox,
 			     int ntype, int nisauto);
 	virtual const char *Description();
+	virtual int Size();
+	virtual int Coalesce(Laxkit::UndoData *newer);
 };
 
 
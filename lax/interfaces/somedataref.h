@@ -39,6 +39,7 @@ class SomeDataRef : virtual public SomeData
 	virtual const char *whattype() { return "SomeDataRef"; }
 
 	virtual SomeData *duplicate(SomeData *dup);
+	virtual Laxkit::PreviewRender *NewPreviewRender() { return nullptr; } //duplicates share thedata, which is not thread safe
 	virtual void dump_out(FILE *f,int indent,int what,Laxkit::DumpContext *context);
 	virtual void dump_in_atts(Laxkit::Attribute *att,int flag,Laxkit::DumpContext *context);
 	virtual Laxkit::Attribute *dump_out_atts(Laxkit::Attribute *att,int what,Laxkit::DumpContext *context);
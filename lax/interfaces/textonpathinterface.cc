@@ -692,186 +692,12 @@ int TextOnPath::Remap()
 		return 0;
 	}
 
-	 //set up freetype and hb fonts
-	FontManager *fontmanager = InterfaceManager::GetDefault()->GetFontManager();
-
-	FT_Face ft_face;
-	FT_Library *ft_library = fontmanager->GetFreetypeLibrary();
-
-	FT_New_Face (*ft_library, font->FontFile(), 0, &ft_face);
-	FT_Set_Char_Size (ft_face, scale_correction*font->Msize()*64, scale_correction*font->Msize()*64, 0, 0);
-
-	hb_font_t *hb_font;
-	hb_font = hb_ft_font_create (ft_face, NULL);
-
-
-	 //figure out direction, language, and script
-	hb_segment_properties_t seg_properties;
-
-
-	 //Figure out direction, if any
-	hb_direction_t dir = HB_DIRECTION_INVALID;
-	if      (direction == LAX_LRTB || direction == LAX_LRBT) dir = HB_DIRECTION_LTR;
-	else if (direction == LAX_RLTB || direction == LAX_RLBT) dir = HB_DIRECTION_RTL;
-	else if (direction == LAX_BTLR || direction == LAX_BTRL) dir = HB_DIRECTION_BTT;
-	else if (direction == LAX_TBLR || direction == LAX_TBRL) dir = HB_DIRECTION_TTB;
-	// else need to guess direction
-
-
-	 //Figure out language, if any
-	hb_language_t hblang = NULL;
-	//const char *str=fontmanager->LanguageString(language);
-	//if (language>=0 && str) hblang = hb_language_from_string(str, strlen(str));
-	if (language) hblang = hb_language_from_string(language, strlen(language));
-	//hblang = hb_language_get_default;
-
-
-	 //Figure out script, if any
-	hb_script_t hbscript = HB_SCRIPT_UNKNOWN;
-	//str=fontmanager->ScriptString(language);
-	//if (script>=0 && *str) hbscript = hb_script_from_string(str, strlen(str));
-	if (script) hbscript = hb_script_from_string(script, strlen(script));
-
-
-	 //now figure out lines as necessary
-
-
-	 //create buffer and add text
-	hb_buffer_t *hb_buffer;
-	hb_buffer = hb_buffer_create ();
-	hb_buffer_add_utf8 (hb_buffer, text+start, end-start, 0, -1);
-
-
-	 //set direction, language, and script
-	if (dir==HB_DIRECTION_INVALID || hblang==NULL || hbscript==HB_SCRIPT_UNKNOWN) {
-		 //at least one of these things we know, so we have to manually set again
-		hb_buffer_guess_segment_properties (hb_buffer); //guesses direction, script, language
-		hb_buffer_get_segment_properties (hb_buffer, &seg_properties);
-
-		if (dir!=HB_DIRECTION_INVALID)   seg_properties.direction = dir;      else dir      = seg_properties.direction;
-		if (hblang!=NULL)                seg_properties.language  = hblang;   else hblang   = seg_properties.language;
-		if (hbscript!=HB_SCRIPT_UNKNOWN) seg_properties.script    = hbscript; else hbscript = seg_properties.script;
-
-		hb_buffer_set_segment_properties (hb_buffer, &seg_properties);
-
-	} else {
-		 //we know them all so...
-		seg_properties.direction = dir;
-		seg_properties.language  = hblang;
-		seg_properties.script    = hbscript;
-		hb_buffer_set_segment_properties (hb_buffer, &seg_properties);
-	}
-
-
-	 //set features
-	hb_face_t *hb_face;
-	hb_face = hb_ft_face_create_referenced(ft_face);
-
-	//*** foreach (feature in feature_string) set for hb_font
-	//hb_ot_layout_language_get_feature_tags()
-	//
-
-	unsigned int lang_index=0;
-	unsigned int script_index=0;
-
-	//hb_tag_t script_tag1;
-	//hb_tag_t lang_tag;
-	//unsigned int n_script_tags = 1;
-	//unsigned int n_lang_tags = 1;
-	//hb_ot_tags_from_script_and_language(hbscript, hblang, &n_script_tags, &script_tag1, &n_lang_tags, &lang_tag);
-	//hb_ot_layout_table_find_script (hb_face, HB_OT_TAG_GSUB, script_tag1, &script_index);
-	//
-	//hb_ot_layout_script_select_language (hb_face, HB_OT_TAG_GSUB, script_index, 1, &lang_tag, &lang_index);
-
-#ifdef HARFBUZZ_BELOW_2_0
-		hb_tag_t script_tag1, script_tag2;
-		hb_ot_tags_from_script(hbscript, &script_tag1, &script_tag2);
-
-		hb_tag_t lang_tag = hb_ot_tag_from_language (hblang);
-		hb_ot_layout_script_find_language (hb_face, HB_OT_TAG_GSUB, script_index, lang_tag, &lang_index);
-
-#else
-		hb_tag_t lang_tag;
-		hb_tag_t script_tag1;
-		unsigned int n_script_tags = 1;
-		unsigned int n_lang_tags = 1;
-
-		hb_ot_tags_from_script_and_language(hbscript, hblang, &n_script_tags, &script_tag1, &n_lang_tags, &lang_tag);
-
-		hb_ot_layout_table_find_script (hb_face, HB_OT_TAG_GSUB, script_tag1, &script_index);
-
-		hb_ot_layout_script_select_language (hb_face, HB_OT_TAG_GSUB, script_index, 1, &lang_tag, &lang_index);
-#endif
-
-
-	unsigned int count = 80;
-	hb_tag_t myResult[count];
-	//hb_ot_layout_table_get_feature_tags(hb_font_get_face(hb_font), HB_OT_TAG_GSUB, 0, &count, myResult)
-	//hb_ot_layout_table_get_feature_tags(hb_font_get_face(hb_font), HB_OT_TAG_GPOS, 0, &count, myResult)
-	//
-	//
-	//- hb_ot_layout_table_get_script_tags() to get all scripts for this font;
-	//- for each script index get all languages supported for this script with
-	//hb_ot_layout_script_get_language_tags();
-	//- at this point it's two dimensional - (script index, language index),
-	//now get feature set for this pair with:
-
-	hb_ot_layout_language_get_feature_tags(hb_face, HB_OT_TAG_GSUB, script_index, lang_index, 0, &count, myResult);
-	
-	DBG cerr <<"for font :"<<font->FontFile()<<":"<<endl;
-	DBG cerr <<" All the GSUB features for cur lang+script:  ";
-	DBG char tagstr[5]; tagstr[4]='\0';
-	DBG for (int cc=0; cc<(int)count; cc++) {
-	DBG 	hb_tag_to_string(myResult[cc], tagstr);
-	DBG 	cerr <<tagstr<<"  ";
-	DBG }
-	DBG cerr << endl;
-
-	hb_ot_layout_language_get_feature_tags(hb_face, HB_OT_TAG_GPOS, script_index, lang_index, 0, &count, myResult);
-	
-	DBG cerr <<" All the GPOS features for cur lang+script:  ";
-	DBG for (int cc=0; cc<(int)count; cc++) {
-	DBG 	hb_tag_to_string(myResult[cc], tagstr);
-	DBG 	cerr <<tagstr<<"  ";
-	DBG }
-	DBG cerr << endl;
-
-
-	  //Shape it!
-	hb_shape (hb_font, hb_buffer, NULL, 0);
-
-
-	 // get positioning
-	 //
-	//struct hb_glyph_info_t {
-	//  hb_codepoint_t codepoint;
-	//  hb_mask_t      mask;
-	//  uint32_t       cluster;
-	//}
-	//
-	//struct hb_glyph_position_t {
-	//  hb_position_t  x_advance;
-	//  hb_position_t  y_advance;
-	//  hb_position_t  x_offset; //shift from current position based on advances
-	//  hb_position_t  y_offset;
-	//}
-	//
-	//hb_segment_properties_t {
-	//  hb_direction_t  direction;
-	//  hb_script_t     script;
-	//  hb_language_t   language;
-	//}
-	//
-	//cairo_glyph_t {
-	//  unsigned long        index;
-	//  double               x;
-	//  double               y;
-	//}
-	//
-
-	int nglyphs              = hb_buffer_get_length (hb_buffer); //glyphs wide
-	hb_glyph_info_t *info    = hb_buffer_get_glyph_infos (hb_buffer, NULL);     //points to inside hb_buffer
-	hb_glyph_position_t *pos = hb_buffer_get_glyph_positions (hb_buffer, NULL); //points to inside hb_buffer
+	 //shape at the corrected size, so hinting matches. Unchanged text on a moving path is just a lookup.
+	ShapedGlyph *shaped = nullptr;
+	int numalloc = 0;
+	int nglyphs = TextShaper::Default()->Shape(font->FontFile(), scale_correction*font->Msize(), text+start, end-start,
+												direction, language, script, nullptr, shaped, numalloc);
+	if (nglyphs < 0) nglyphs = 0;
 
 	 //reallocate glyphs, pos, rotation if necessary
 	if (glyphs.Allocated() < nglyphs) {
@@ -890,13 +716,13 @@ int TextOnPath::Remap()
 	for (int i = 0; i < numglyphs; i++) {
 		glyph = glyphs.e[i];
 
-		glyph->index     = info[i].codepoint;
-		glyph->cluster   = info[i].cluster;
-		glyph->x_advance = pos[i].x_advance / 64. / scale_correction;
-		glyph->y_advance = pos[i].y_advance / 64. / scale_correction;
-		glyph->x         =   current_x + pos[i].x_offset / 64. / scale_correction;
-		glyph->y         = -(current_y + pos[i].y_offset / 64. / scale_correction);
-		glyph->numchars  = get_num_chars(text+start, end-start, glyph->cluster, i==numglyphs-1 ? end-start : glyphs.e[i+1]->cluster);
+		glyph->index     = shaped[i].index;
+		glyph->cluster   = shaped[i].cluster;
+		glyph->x_advance = shaped[i].x_advance / scale_correction;
+		glyph->y_advance = shaped[i].y_advance / scale_correction;
+		glyph->x         =   current_x + shaped[i].x_offset / scale_correction;
+		glyph->y         = -(current_y + shaped[i].y_offset / scale_correction);
+		glyph->numchars  = get_num_chars(text+start, end-start, glyph->cluster, i==numglyphs-1 ? end-start : shaped[i+1].cluster);
 
 		width     += glyph->x_advance;
 		widthy    += glyph->y_advance;
@@ -905,18 +731,13 @@ int TextOnPath::Remap()
 		current_y += glyph->y_advance;
 
 		DBG fprintf(stderr, "index: %4d   cluster: %2u   at: %f, %f\n", glyph->index, glyph->cluster, glyph->x, glyph->y);
-		//DBG cerr <<"index: "<<g[i].index<<"  cluster: "<<g[i].cluster<<"  at: "<<g[i].x<<","<<g[i].y<<endl;
 	}
 
 	DBG cerr <<endl;
 
 	textpathlen = width;
-	
+	delete[] shaped;
 
-	 //cleanup hb and freetype stuff
-	hb_buffer_destroy (hb_buffer);
-	hb_font_destroy (hb_font);
-	FT_Done_Face (ft_face);
 
 
 	 //now we have glyphs laid out along a straight line,
@@ -1080,17 +901,11 @@ SomeData *TextOnPath::ConvertToPaths(bool use_clones, Laxkit::RefPtrStack<SomeDa
 	Remap();
 
 
-	FT_Error ft_error;
-	FT_Face ft_faces[font->Layers()];
-	FontManager *fontmanager = GetDefaultFontManager();
-	FT_Library *ft_library = fontmanager->GetFreetypeLibrary();
-
-	LaxFont *ff;
-	for (int c=0; c<font->Layers(); c++) {
-		ff=font->Layer(c);
-		FT_New_Face (*ft_library, ff->FontFile(), 0, &ft_faces[c]);
-		FT_Set_Char_Size (ft_faces[c], font->Msize()*64, font->Msize()*64, 0, 0);
-	}
+	 //glyphs are loaded and decomposed only once per font file and size, and kept for next time
+	int ft_error;
+	TextShaper *shaper = TextShaper::Default();
+	const char *files[font->Layers()];
+	for (int c=0; c<font->Layers(); c++) files[c] = font->Layer(c)->FontFile();
 
 
 	InterfaceManager *imanager = InterfaceManager::GetDefault();
@@ -1131,8 +946,7 @@ SomeData *TextOnPath::ConvertToPaths(bool use_clones, Laxkit::RefPtrStack<SomeDa
 
 		 //assign a glyph name.
 		 //use ONLY face[0] for name in layered fonts. All parts of the glyph ultimately get collapsed to single object.
-		FT_Get_Glyph_Name(ft_faces[0], glyph->index, glyphname, 100);
-		if (glyphname[0]=='\0') sprintf(glyphname,"glyph%d",glyph->index);
+		shaper->GlyphName(files[0], font->Msize(), glyph->index, glyphname, 100);
 
 		for (int layer=0; layer<font->Layers(); layer++) {
 			outline=NULL;
@@ -1145,17 +959,18 @@ SomeData *TextOnPath::ConvertToPaths(bool use_clones, Laxkit::RefPtrStack<SomeDa
 
 			 //make glyph outline if necessary
 			if (!outline) {
-				//ft_error = FT_Load_Glyph(ft_faces[layer], glyph->index, FT_LOAD_NO_SCALE);
-				ft_error = FT_Load_Glyph(ft_faces[layer], glyph->index, FT_LOAD_NO_BITMAP);
-				if (ft_error != 0) continue;
+				PathsData *glypho = dynamic_cast<PathsData*>(imanager->NewDataObject("PathsData"));
+				ft_error = shaper->AppendOutline(files[layer], font->Msize(), glyph->index, glypho);
+				if (ft_error < 0) { glypho->dec_count(); continue; }
 
 				 //so maybe the glyph is a bitmap, maybe it is an svg
 				 //we need to be on watch so that if glyph is COLR-able, we need to get the
 				 //color glyphs, NOT the fallback ones!
 
-				if (ft_faces[layer]->glyph->format != FT_GLYPH_FORMAT_OUTLINE) {
+				if (ft_error != 0) {
 					 //not the simple case where outline is right there!!
 					cerr << " *** Need to implement something meaningful for non-outline glyph to path! "<<endl;
+					glypho->dec_count();
 
 				} else {
 					 //we're in luck! just an ordinary path in one color to parse for this layer...
@@ -1168,28 +983,15 @@ SomeData *TextOnPath::ConvertToPaths(bool use_clones, Laxkit::RefPtrStack<SomeDa
 							palette->colors.e[layer]->color->values[3]);
 					}
 
-					 //has to be first layer, so make new base object
-					PathsData *glypho = dynamic_cast<PathsData*>(imanager->NewDataObject("PathsData"));
+					 //has to be first layer, so glypho is the new base object
 					glypho->Id(glyphname);
 
 					glypho->fill(&color);
 					glypho->line(0);
 					outline=glypho;
-
-					 //set up parsing functions for Path object
-					int pathn = outline->paths.n;
-					FT_Outline_Funcs outline_funcs;
-					outline_funcs.move_to  = pathsdata_ft_move_to;
-					outline_funcs.line_to  = pathsdata_ft_line_to;
-					outline_funcs.conic_to = pathsdata_ft_conic_to;
-					outline_funcs.cubic_to = pathsdata_ft_cubic_to;
-					outline_funcs.shift    = 0;
-					outline_funcs.delta    = 0;
-					 // parse!!
-					ft_error = FT_Outline_Decompose( &ft_faces[layer]->glyph->outline, &outline_funcs, outline );
 					outline->close();
 
-					for (int p=pathn; p<outline->paths.n; p++) {
+					for (int p=0; p<outline->paths.n; p++) {
 						Coordinate *coord = outline->paths.e[p]->path;
 						Coordinate *start = coord;
 
@@ -1303,9 +1105,6 @@ SomeData *TextOnPath::ConvertToPaths(bool use_clones, Laxkit::RefPtrStack<SomeDa
 
 	 //cleanup
 	//if (glyphs != clones_to_add_to) glyphs->dec_count();
-	for (int c=0; c<font->Layers(); c++) {
-		FT_Done_Face (ft_faces[c]);
-	}
 
 	//if (is_all_paths) *** CollapsePaths(object);
 
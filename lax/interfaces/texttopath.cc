@@ -23,6 +23,13 @@
 
 #include <lax/interfaces/texttopath.h>
 #include <lax/interfaces/pathinterface.h>
+#include <lax/laxdefs.h>
+#include <lax/strmanip.h>
+
+#include <lax/lists.cc>
+
+#include <cstring>
+#include <cstdio>
 
 
 using namespace Laxkit;
@@ -67,6 +74,622 @@ int pathsdata_ft_cubic_to(const FT_Vector* control1, const FT_Vector* control2,
 }
 
 
+//--------------------------- TextShaper -------------------------------
+
+//! Common part of what a TextShapeCache holds.
+class TextShapeEntry
+{
+  public:
+	TextShapeEntry *next_in_bucket;
+	TextShapeEntry *prev, *next; //older and newer
+	unsigned int hash;
+
+	TextShapeEntry(unsigned int nhash) { next_in_bucket = prev = next = nullptr; hash = nhash; }
+	virtual ~TextShapeEntry() {}
+};
+
+//! Least recently used hash of TextShapeEntry objects. TextShaper does all the locking.
+class TextShapeCache
+{
+  public:
+	TextShapeEntry **buckets;
+	int numbuckets;
+	TextShapeEntry *oldest, *newest;
+	int num, max;
+
+	TextShapeCache(int nmax);
+	~TextShapeCache();
+	TextShapeEntry *First(unsigned int hash) { return buckets[hash & (numbuckets-1)]; }
+	void Touch(TextShapeEntry *entry);
+	void Add(TextShapeEntry *entry);
+	void Remove(TextShapeEntry *entry);
+	void Trim() { while (num > max && oldest != newest) Remove(oldest); }
+	void Clear() { while (oldest) Remove(oldest); }
+};
+
+TextShapeCache::TextShapeCache(int nmax)
+{
+	max = nmax;
+	num = 0;
+	oldest = newest = nullptr;
+
+	 //keep buckets about half full when full
+	numbuckets = 64;
+	while (numbuckets < 2*max) numbuckets *= 2;
+	buckets = new TextShapeEntry*[numbuckets];
+	memset(buckets, 0, numbuckets*sizeof(TextShapeEntry*));
+}
+
+TextShapeCache::~TextShapeCache()
+{
+	Clear();
+	delete[] buckets;
+}
+
+//! Make entry the newest.
+void TextShapeCache::Touch(TextShapeEntry *entry)
+{
+	if (entry == newest) return;
+
+	 //unlink
+	if (entry->prev) entry->prev->next = entry->next;
+	if (entry->next) entry->next->prev = entry->prev;
+	if (oldest == entry) oldest = entry->next;
+
+	 //add as newest
+	entry->prev = newest;
+	entry->next = nullptr;
+	if (newest) newest->next = entry;
+	newest = entry;
+	if (!oldest) oldest = entry;
+}
+
+//! Add a new entry as the newest. Call Trim() after to keep within max.
+void TextShapeCache::Add(TextShapeEntry *entry)
+{
+	TextShapeEntry **bucket = &buckets[entry->hash & (numbuckets-1)];
+	entry->next_in_bucket = *bucket;
+	*bucket = entry;
+	num++;
+	Touch(entry);
+}
+
+//! Unlink and delete entry.
+void TextShapeCache::Remove(TextShapeEntry *entry)
+{
+	TextShapeEntry **e = &buckets[entry->hash & (numbuckets-1)];
+	while (*e != entry) e = &(*e)->next_in_bucket;
+	*e = entry->next_in_bucket;
+
+	if (entry->prev) entry->prev->next = entry->next;
+	else oldest = entry->next;
+	if (entry->next) entry->next->prev = entry->prev;
+	else newest = entry->prev;
+
+	delete entry;
+	num--;
+}
+
+
+//! FNV-1a, continuing from h.
+static unsigned int hash_bytes(unsigned int h, const void *data, int len)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	for (int c=0; c<len; c++) h = (h ^ p[c]) * 16777619u;
+	return h;
+}
+
+static unsigned int hash_str(unsigned int h, const char *str)
+{
+	if (!str) return h * 16777619u;
+	return hash_bytes(h, str, strlen(str) + 1);
+}
+
+static bool same_str(const char *a, const char *b)
+{
+	if (!a || !b) return a == b;
+	return !strcmp(a, b);
+}
+
+
+//! An open freetype face at one size, and its harfbuzz font.
+class TextShapeFace
+{
+  public:
+	char *file;
+	long size; //26.6
+	FT_Face ft_face;
+	hb_font_t *hb_font;
+
+	TextShapeFace(const char *nfile, long nsize, FT_Face face) {
+		file = newstr(nfile);
+		size = nsize;
+		ft_face = face;
+		hb_font = hb_ft_font_create(ft_face, NULL);
+	}
+	~TextShapeFace() {
+		if (hb_font) hb_font_destroy(hb_font);
+		FT_Done_Face(ft_face);
+		delete[] file;
+	}
+};
+
+
+//! One shaped string.
+class TextShapeRun : public TextShapeEntry
+{
+  public:
+	char *file;
+	long size; //26.6
+	int direction;
+	char *language, *script, *features;
+	char *text;
+	int len;
+
+	ShapedGlyph *glyphs;
+	int numglyphs;
+
+	TextShapeRun(unsigned int nhash, const char *nfile, long nsize, int ndirection,
+				 const char *nlanguage, const char *nscript, const char *nfeatures, const char *ntext, int nlen)
+	  : TextShapeEntry(nhash)
+	{
+		file      = newstr(nfile);
+		size      = nsize;
+		direction = ndirection;
+		language  = newstr(nlanguage);
+		script    = newstr(nscript);
+		features  = newstr(nfeatures);
+		text      = newnstr(ntext, nlen);
+		len       = nlen;
+		glyphs    = nullptr;
+		numglyphs = 0;
+	}
+	virtual ~TextShapeRun() {
+		delete[] file;
+		delete[] language;
+		delete[] script;
+		delete[] features;
+		delete[] text;
+		delete[] glyphs;
+	}
+	bool Matches(unsigned int nhash, const char *nfile, long nsize, int ndirection,
+				 const char *nlanguage, const char *nscript, const char *nfeatures, const char *ntext, int nlen) {
+		return hash == nhash && len == nlen && size == nsize && direction == ndirection
+			&& !memcmp(text, ntext, len) && !strcmp(file, nfile)
+			&& same_str(language, nlanguage) && same_str(script, nscript) && same_str(features, nfeatures);
+	}
+};
+
+
+//! The decomposed outline of one glyph, kept as the freetype points, to replay into PathsData objects.
+class GlyphOutline : public TextShapeEntry
+{
+  public:
+	char *file;
+	long size; //26.6
+	unsigned int glyph;
+
+	char *name;
+	int status; //0 for outline, 1 for a glyph that is not an outline, -1 for could not load
+	char *ops; //'m', 'l', 'q', or 'c', using 1, 1, 2, or 3 points
+	FT_Vector *points;
+	int numops, numpoints;
+	int maxops, maxpoints;
+
+	GlyphOutline(unsigned int nhash, const char *nfile, long nsize, unsigned int nglyph) : TextShapeEntry(nhash) {
+		file   = newstr(nfile);
+		size   = nsize;
+		glyph  = nglyph;
+		name   = nullptr;
+		status = -1;
+		ops    = nullptr;
+		points = nullptr;
+		numops = numpoints = maxops = maxpoints = 0;
+	}
+	virtual ~GlyphOutline() {
+		delete[] file;
+		delete[] name;
+		delete[] ops;
+		delete[] points;
+	}
+	bool Matches(unsigned int nhash, const char *nfile, long nsize, unsigned int nglyph) {
+		return hash == nhash && glyph == nglyph && size == nsize && !strcmp(file, nfile);
+	}
+	void Add(char op, const FT_Vector *p1, const FT_Vector *p2, const FT_Vector *p3);
+	void AppendTo(PathsData *paths);
+};
+
+void GlyphOutline::Add(char op, const FT_Vector *p1, const FT_Vector *p2, const FT_Vector *p3)
+{
+	if (numops == maxops) {
+		maxops = (maxops ? 2*maxops : 16);
+		char *nops = new char[maxops];
+		if (numops) memcpy(nops, ops, numops);
+		delete[] ops;
+		ops = nops;
+	}
+	if (numpoints + 3 > maxpoints) {
+		maxpoints = (maxpoints ? 2*maxpoints : 48);
+		FT_Vector *npoints = new FT_Vector[maxpoints];
+		if (numpoints) memcpy(npoints, points, numpoints*sizeof(FT_Vector));
+		delete[] points;
+		points = npoints;
+	}
+
+	ops[numops++] = op;
+	points[numpoints++] = *p1;
+	if (p2) points[numpoints++] = *p2;
+	if (p3) points[numpoints++] = *p3;
+}
+
+//! Same as decomposing the freetype outline again with the pathsdata_ft_* functions.
+void GlyphOutline::AppendTo(PathsData *paths)
+{
+	FT_Vector *p = points;
+	for (int c=0; c<numops; c++) {
+		if      (ops[c] == 'm') { pathsdata_ft_move_to (p, paths);             p += 1; }
+		else if (ops[c] == 'l') { pathsdata_ft_line_to (p, paths);             p += 1; }
+		else if (ops[c] == 'q') { pathsdata_ft_conic_to(p, p+1, paths);        p += 2; }
+		else                    { pathsdata_ft_cubic_to(p, p+1, p+2, paths);   p += 3; }
+	}
+}
+
+static int record_move_to(const FT_Vector* to, void* user)
+{
+	((GlyphOutline*)user)->Add('m', to, nullptr, nullptr);
+	return 0;
+}
+
+static int record_line_to(const FT_Vector* to, void* user)
+{
+	((GlyphOutline*)user)->Add('l', to, nullptr, nullptr);
+	return 0;
+}
+
+static int record_conic_to(const FT_Vector* control, const FT_Vector* to, void* user)
+{
+	((GlyphOutline*)user)->Add('q', control, to, nullptr);
+	return 0;
+}
+
+static int record_cubic_to(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector*  to, void* user)
+{
+	((GlyphOutline*)user)->Add('c', control1, control2, to);
+	return 0;
+}
+
+
+/*! \class TextShaper
+ * \brief Shapes text with harfbuzz, and keeps shaped runs and glyph outlines around for next time.
+ *
+ * CaptionData and TextOnPath shape their text with Shape(), so recaching an unchanged line,
+ * or laying out the same text again while its path is dragged around, is only a lookup.
+ * Runs are found by font file, size, direction, language, script, features, and text.
+ *
+ * Their ConvertToPaths() get glyphs with AppendOutline(), which loads and decomposes each glyph
+ * of a font file at a size only once, keeping the freetype points to replay into each new PathsData.
+ *
+ * Freetype faces and harfbuzz fonts are kept open for the few most recently used files and sizes,
+ * with their own FT_Library, so nothing depends on the lifetime of a FontManager. Both caches drop
+ * their least recently used entries when full.
+ *
+ * Default() is shared by everything, and is safe to use from any thread.
+ */
+
+TextShaper::TextShaper(int nruns, int noutlines)
+  : faces(LISTS_DELETE_Single)
+{
+	have_library = false;
+	hb_buffer = nullptr;
+	max_faces = TEXT_SHAPER_FACES;
+	runs     = new TextShapeCache(nruns     > 0 ? nruns     : TEXT_SHAPER_RUNS);
+	outlines = new TextShapeCache(noutlines > 0 ? noutlines : TEXT_SHAPER_OUTLINES);
+	run_hits = run_misses = outline_hits = outline_misses = 0;
+}
+
+TextShaper::~TextShaper()
+{
+	delete runs;
+	delete outlines;
+	faces.flush();
+	if (hb_buffer) hb_buffer_destroy(hb_buffer);
+	if (have_library) FT_Done_FreeType(ft_library);
+}
+
+//! Return the open face for file at size, opening it if necessary. Must have the mutex.
+TextShapeFace *TextShaper::face(const char *file, long size)
+{
+	for (int c=faces.n-1; c>=0; c--) {
+		if (faces.e[c]->size != size || strcmp(faces.e[c]->file, file)) continue;
+		TextShapeFace *f = faces.e[c];
+		if (c != faces.n-1) {
+			faces.pop(c);
+			faces.push(f, 1);
+		}
+		return f;
+	}
+
+	if (!have_library) {
+		if (FT_Init_FreeType(&ft_library)) return nullptr;
+		have_library = true;
+	}
+
+	FT_Face ft_face;
+	if (FT_New_Face(ft_library, file, 0, &ft_face)) return nullptr;
+	FT_Set_Char_Size(ft_face, size, size, 0, 0);
+
+	TextShapeFace *f = new TextShapeFace(file, size, ft_face);
+	faces.push(f, 1);
+	while (faces.n > max_faces) faces.remove(0);
+	return f;
+}
+
+/*! Shape len bytes of utf8 text (or all of it if len<0) in the font at file, at size in pixels.
+ * direction is LAX_LRTB and the like, and language and script are strings harfbuzz understands, such as
+ * "en" and "Latn". Any of them that are unknown (0 or NULL) are guessed from the text.
+ * features is a comma separated list like "liga=0,smcp", as in hb_feature_from_string(), or NULL.
+ *
+ * The glyphs are copied to glyphs, reallocating if numalloc is not enough. Returns the number
+ * of glyphs, or -1 if the font could not be opened.
+ */
+int TextShaper::Shape(const char *file, double size, const char *text, int len,
+					  int direction, const char *language, const char *script, const char *features,
+					  ShapedGlyph *&glyphs, int &numalloc)
+{
+	if (!file || !text) return -1;
+	if (len < 0) len = strlen(text);
+	long size64 = size*64;
+
+	unsigned int hash = hash_bytes(2166136261u, text, len);
+	hash = hash_str(hash, file);
+	hash = hash_bytes(hash, &size64, sizeof(size64));
+	hash = hash_bytes(hash, &direction, sizeof(direction));
+	hash = hash_str(hash, language);
+	hash = hash_str(hash, script);
+	hash = hash_str(hash, features);
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	TextShapeRun *run = nullptr;
+	for (TextShapeEntry *e = runs->First(hash); e; e = e->next_in_bucket) {
+		TextShapeRun *r = static_cast<TextShapeRun*>(e);
+		if (r->Matches(hash, file, size64, direction, language, script, features, text, len)) { run = r; break; }
+	}
+
+	if (run) {
+		run_hits++;
+		runs->Touch(run);
+
+	} else {
+		run_misses++;
+		TextShapeFace *f = face(file, size64);
+		if (!f) return -1;
+
+		 //create buffer and add text
+		if (!hb_buffer) hb_buffer = hb_buffer_create();
+		else hb_buffer_reset(hb_buffer);
+		hb_buffer_add_utf8(hb_buffer, text, len, 0, -1);
+
+		hb_direction_t dir = HB_DIRECTION_INVALID;
+		if      (direction == LAX_LRTB || direction == LAX_LRBT) dir = HB_DIRECTION_LTR;
+		else if (direction == LAX_RLTB || direction == LAX_RLBT) dir = HB_DIRECTION_RTL;
+		else if (direction == LAX_BTLR || direction == LAX_BTRL) dir = HB_DIRECTION_BTT;
+		else if (direction == LAX_TBLR || direction == LAX_TBRL) dir = HB_DIRECTION_TTB;
+
+		hb_language_t hblang = NULL;
+		if (language) hblang = hb_language_from_string(language, strlen(language));
+
+		hb_script_t hbscript = HB_SCRIPT_UNKNOWN;
+		if (script) hbscript = hb_script_from_string(script, strlen(script));
+
+		 //set direction, language, and script
+		hb_segment_properties_t seg_properties;
+		if (dir == HB_DIRECTION_INVALID || hblang == NULL || hbscript == HB_SCRIPT_UNKNOWN) {
+			 //guess what we don't know
+			hb_buffer_guess_segment_properties(hb_buffer);
+			hb_buffer_get_segment_properties(hb_buffer, &seg_properties);
+
+			if (dir != HB_DIRECTION_INVALID)   seg_properties.direction = dir;
+			if (hblang != NULL)                seg_properties.language  = hblang;
+			if (hbscript != HB_SCRIPT_UNKNOWN) seg_properties.script    = hbscript;
+
+		} else {
+			memset(&seg_properties, 0, sizeof(seg_properties));
+			seg_properties.direction = dir;
+			seg_properties.language  = hblang;
+			seg_properties.script    = hbscript;
+		}
+		hb_buffer_set_segment_properties(hb_buffer, &seg_properties);
+
+		 //set features
+		hb_feature_t *hbfeatures = nullptr;
+		int numfeatures = 0;
+		if (features && *features) {
+			int max = 1;
+			for (const char *s = features; *s; s++) if (*s == ',') max++;
+			hbfeatures = new hb_feature_t[max];
+
+			const char *s = features, *e;
+			while (*s) {
+				e = strchr(s, ',');
+				if (!e) e = s + strlen(s);
+				if (e > s && hb_feature_from_string(s, e-s, &hbfeatures[numfeatures])) numfeatures++;
+				s = (*e ? e+1 : e);
+			}
+		}
+
+		 //Shape it!
+		hb_shape(f->hb_font, hb_buffer, hbfeatures, numfeatures);
+		delete[] hbfeatures;
+
+		unsigned int n           = hb_buffer_get_length(hb_buffer);
+		hb_glyph_info_t *info    = hb_buffer_get_glyph_infos(hb_buffer, NULL);     //points to inside hb_buffer
+		hb_glyph_position_t *pos = hb_buffer_get_glyph_positions(hb_buffer, NULL); //points to inside hb_buffer
+
+		run = new TextShapeRun(hash, file, size64, direction, language, script, features, text, len);
+		run->numglyphs = n;
+		run->glyphs = new ShapedGlyph[n > 0 ? n : 1];
+		for (unsigned int i = 0; i < n; i++) {
+			run->glyphs[i].index     = info[i].codepoint;
+			run->glyphs[i].cluster   = info[i].cluster;
+			run->glyphs[i].x_advance = pos[i].x_advance / 64.;
+			run->glyphs[i].y_advance = pos[i].y_advance / 64.;
+			run->glyphs[i].x_offset  = pos[i].x_offset  / 64.;
+			run->glyphs[i].y_offset  = pos[i].y_offset  / 64.;
+		}
+
+		runs->Add(run);
+		runs->Trim();
+	}
+
+	if (run->numglyphs > numalloc) {
+		delete[] glyphs;
+		numalloc = run->numglyphs;
+		glyphs = new ShapedGlyph[numalloc];
+	}
+	if (run->numglyphs) memcpy(glyphs, run->glyphs, run->numglyphs * sizeof(ShapedGlyph));
+	return run->numglyphs;
+}
+
+//! Return the outline of glyph, loading it if necessary, or nullptr if the font could not be opened. Must have the mutex.
+GlyphOutline *TextShaper::outline(const char *file, long size, unsigned int glyph)
+{
+	unsigned int hash = hash_str(2166136261u, file);
+	hash = hash_bytes(hash, &size, sizeof(size));
+	hash = hash_bytes(hash, &glyph, sizeof(glyph));
+
+	for (TextShapeEntry *e = outlines->First(hash); e; e = e->next_in_bucket) {
+		GlyphOutline *o = static_cast<GlyphOutline*>(e);
+		if (o->Matches(hash, file, size, glyph)) {
+			outline_hits++;
+			outlines->Touch(o);
+			return o;
+		}
+	}
+
+	outline_misses++;
+	TextShapeFace *f = face(file, size);
+	if (!f) return nullptr;
+
+	GlyphOutline *o = new GlyphOutline(hash, file, size, glyph);
+
+	char glyphname[100];
+	glyphname[0] = '\0';
+	FT_Get_Glyph_Name(f->ft_face, glyph, glyphname, 100);
+	if (glyphname[0] == '\0') sprintf(glyphname, "glyph%u", glyph);
+	o->name = newstr(glyphname);
+
+	if (FT_Load_Glyph(f->ft_face, glyph, FT_LOAD_NO_BITMAP) != 0) {
+		o->status = -1;
+
+	} else if (f->ft_face->glyph->format != FT_GLYPH_FORMAT_OUTLINE) {
+		 //maybe the glyph is a bitmap, maybe it is an svg
+		o->status = 1;
+
+	} else {
+		FT_Outline_Funcs outline_funcs;
+		outline_funcs.move_to  = record_move_to;
+		outline_funcs.line_to  = record_line_to;
+		outline_funcs.conic_to = record_conic_to;
+		outline_funcs.cubic_to = record_cubic_to;
+		outline_funcs.shift    = 0;
+		outline_funcs.delta    = 0;
+		FT_Outline_Decompose(&f->ft_face->glyph->outline, &outline_funcs, o);
+		o->status = 0;
+	}
+
+	outlines->Add(o);
+	outlines->Trim();
+	return o;
+}
+
+/*! Put the postscript name of glyph in name, or "glyph123" if the font has no names for its glyphs.
+ * Returns 0, or 1 if the font could not be opened, in which case name is still "glyph123".
+ */
+int TextShaper::GlyphName(const char *file, double size, unsigned int glyph, char *name, int namelen)
+{
+	if (!name || namelen <= 0) return 1;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	GlyphOutline *o = (file ? outline(file, size*64, glyph) : nullptr);
+	if (!o) {
+		snprintf(name, namelen, "glyph%u", glyph);
+		return 1;
+	}
+	strncpy(name, o->name, namelen);
+	name[namelen-1] = '\0';
+	return 0;
+}
+
+/*! Add the outline of glyph at size to paths, as pathsdata_ft_move_to() and friends would from
+ * FT_Outline_Decompose(). The glyph is only loaded from the font the first time.
+ *
+ * Returns 0 for success, 1 if the glyph is not an outline, such as a bitmap, or -1
+ * if the font or glyph could not be loaded. paths is not touched unless 0 is returned.
+ */
+int TextShaper::AppendOutline(const char *file, double size, unsigned int glyph, PathsData *paths)
+{
+	if (!file || !paths) return -1;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	GlyphOutline *o = outline(file, size*64, glyph);
+	if (!o) return -1;
+	if (o->status != 0) return o->status;
+	o->AppendTo(paths);
+	return 0;
+}
+
+//! Forget all runs and outlines, and close all faces.
+void TextShaper::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	runs->Clear();
+	outlines->Clear();
+	faces.flush();
+}
+
+//! Set how many runs and outlines to keep, removing the oldest if there are more already. Values <= 0 mean the default.
+void TextShaper::SetMax(int nruns, int noutlines)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	runs->max     = (nruns     > 0 ? nruns     : TEXT_SHAPER_RUNS);
+	outlines->max = (noutlines > 0 ? noutlines : TEXT_SHAPER_OUTLINES);
+	runs->Trim();
+	outlines->Trim();
+}
+
+int TextShaper::NumRuns()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return runs->num;
+}
+
+int TextShaper::NumOutlines()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return outlines->num;
+}
+
+//! Lookups that found something and that did not, since the shaper was created.
+void TextShaper::Stats(long *nrun_hits, long *nrun_misses, long *noutline_hits, long *noutline_misses)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (nrun_hits)       *nrun_hits       = run_hits;
+	if (nrun_misses)     *nrun_misses     = run_misses;
+	if (noutline_hits)   *noutline_hits   = outline_hits;
+	if (noutline_misses) *noutline_misses = outline_misses;
+}
+
+/*! The shaper used by CaptionData and TextOnPath. It is never deleted, since objects
+ * might still be recaching during static destruction.
+ */
+TextShaper *TextShaper::Default()
+{
+	static TextShaper *shaper = new TextShaper();
+	return shaper;
+}
+
+
 } // namespace LaxInterfaces
 
 
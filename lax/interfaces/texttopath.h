@@ -26,13 +26,74 @@
 #include <harfbuzz/hb-ft.h>
 #include FT_OUTLINE_H
 
+#include <mutex>
+#include <lax/lists.h>
+
 namespace LaxInterfaces {
 
+class PathsData;
+
 int pathsdata_ft_move_to(const FT_Vector* to, void* user);
 int pathsdata_ft_line_to(const FT_Vector* to, void* user);
 int pathsdata_ft_conic_to(const FT_Vector* control, const FT_Vector* to, void* user);
 int pathsdata_ft_cubic_to(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector*  to, void* user);
 
+
+//--------------------------- TextShaper -------------------------------
+
+#define TEXT_SHAPER_RUNS     1024 //default number of shaped runs to keep
+#define TEXT_SHAPER_OUTLINES 4096 //default number of glyph outlines to keep
+#define TEXT_SHAPER_FACES    8    //default number of freetype faces to keep open
+
+class ShapedGlyph
+{
+  public:
+	unsigned int index;   //glyph index in the font
+	unsigned int cluster; //byte offset in the text of the first character of the glyph
+	double x_advance, y_advance; //in pixels at the shaped size
+	double x_offset,  y_offset;
+};
+
+class TextShapeFace;
+class TextShapeCache;
+class TextShapeRun;
+class GlyphOutline;
+
+class TextShaper
+{
+  protected:
+	std::mutex mutex;
+	FT_Library ft_library;
+	bool have_library;
+	hb_buffer_t *hb_buffer;
+	Laxkit::PtrStack<TextShapeFace> faces; //most recently used last
+	int max_faces;
+	TextShapeCache *runs;
+	TextShapeCache *outlines;
+	long run_hits, run_misses, outline_hits, outline_misses;
+
+	TextShapeFace *face(const char *file, long size);
+	GlyphOutline *outline(const char *file, long size, unsigned int glyph);
+
+  public:
+	TextShaper(int nruns = TEXT_SHAPER_RUNS, int noutlines = TEXT_SHAPER_OUTLINES);
+	virtual ~TextShaper();
+
+	virtual int Shape(const char *file, double size, const char *text, int len,
+					  int direction, const char *language, const char *script, const char *features,
+					  ShapedGlyph *&glyphs, int &numalloc);
+	virtual int GlyphName(const char *file, double size, unsigned int glyph, char *name, int namelen);
+	virtual int AppendOutline(const char *file, double size, unsigned int glyph, PathsData *paths);
+
+	virtual void Clear();
+	virtual void SetMax(int nruns, int noutlines);
+	virtual int NumRuns();
+	virtual int NumOutlines();
+	virtual void Stats(long *nrun_hits, long *nrun_misses, long *noutline_hits, long *noutline_misses);
+
+	static TextShaper *Default();
+};
+
 } // namespace LaxInterfaces
 
 
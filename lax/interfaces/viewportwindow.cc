@@ -215,7 +215,7 @@ ObjectContext *ObjectContext::duplicate()
 ViewportWindow::ViewportWindow(Laxkit::anXWindow *parnt,const char *nname,const char *ntitle,unsigned long nstyle,
 		int xx,int yy,int ww,int hh,int brder, Laxkit::Displayer *ndp)
 		: PanUser(NULL),
-		  anXWindow(parnt,nname,ntitle,nstyle|ANXWIN_DOUBLEBUFFER,xx,yy,ww,hh,brder, NULL,0,NULL)
+		  anXWindow(parnt,nname,ntitle,nstyle|ANXWIN_DOUBLEBUFFER|ANXWIN_DAMAGE_REFRESH,xx,yy,ww,hh,brder, NULL,0,NULL)
 		  
 {
 	 //make our own local copy of colors
@@ -912,7 +912,7 @@ void ViewportWindow::RefreshOver()
  *   //ensure drawing if an interface needs to draw
  *  for (int c=0; c<interfaces.n; c++) interfaces.e[c]->needtodraw=1;
  *  
- *  if (needtodraw) {
+ *  if (needtodraw || DamageRect(nullptr)) {
  *    dp->StartDrawing(this);
  *    
  *    --- draw all the stuff ---
@@ -937,8 +937,8 @@ void ViewportWindow::Refresh()
 	int c;
 	for (c=0; c<interfaces.n; c++) interfaces.e[c]->needtodraw=1;//***
 	
-	
-	if (needtodraw) {
+	 //when only Invalidate() was called, dp is clipped to DamageRect(), so draw as usual
+	if (needtodraw || DamageRect(nullptr)) {
 		 // Refresh interfaces, should draw whatever SomeData they have
 		//DBG cerr <<"  drawing interface..";
 
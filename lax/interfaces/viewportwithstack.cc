@@ -31,6 +31,7 @@
 #include <lax/colorbox.h>
 
 #include <lax/refptrstack.cc>
+#include <lax/lists.cc>
 
 #include <iostream>
 using namespace std;
@@ -51,6 +52,12 @@ namespace LaxInterfaces {
  *
  * It uses plain old ObjectContext objects, which store an index and the object.
  *
+ * The transformed bounds of each object are kept in a Laxkit::BoundsTree, so FindObject() and
+ * FindObjects() only need to test objects near the search point or box. Objects added with
+ * NewData() or DropObject() are added to the tree, and ObjectMoved() updates an object right away.
+ * Code that changes objects some other way, such as through touchContents(), should call InvalidateBounds()
+ * for them, so the next search updates just those. The tree is rebuilt if datastack was resized directly.
+ *
  * \todo *** occasionally might be useful to have the list of objects be external..
  */
 
@@ -64,6 +71,7 @@ ViewportWithStack::ViewportWithStack(Laxkit::anXWindow *parnt,const char *nname,
 
 	draw_axes = true;
 	draw_bounding_boxes = false;
+	allbounds_dirty = false;
 
 	foundtypeobj=new ObjectContext;
 	foundobj=new ObjectContext;
@@ -90,6 +98,55 @@ ViewportWithStack::~ViewportWithStack()
 	if (foundtypeobj) delete foundtypeobj;
 }
 
+//! Set box to the bounds of d in viewport real coordinates.
+void ViewportWithStack::ObjectBounds(SomeData *d, Laxkit::DoubleBBox &box)
+{
+	box.ClearBBox();
+	d->ComputeAABB(d->m(), box);
+}
+
+//! Bring objectbounds up to date with datastack.
+/*! If the number of objects differs, or InvalidateBounds(NULL) was called, the whole tree is rebuilt.
+ * Otherwise only objects passed to InvalidateBounds() since the last sync, and curobj, which the
+ * current tool might be editing, are updated, so each search costs no more than the tree lookup.
+ */
+void ViewportWithStack::SyncBounds()
+{
+	DoubleBBox box;
+
+	if (allbounds_dirty || objectbounds.NumItems() != datastack.n) {
+		objectbounds.Flush();
+		for (int c=0; c<datastack.n; c++) {
+			ObjectBounds(datastack.e[c], box);
+			objectbounds.Insert(c, box);
+		}
+		allbounds_dirty = false;
+		dirtybounds.flush();
+		return;
+	}
+
+	if (curobj->obj) dirtybounds.pushnodup(curobj->obj);
+	for (int c=0; c<dirtybounds.n; c++) {
+		SomeData *d = dirtybounds.e[c];
+		int i = (d == curobj->obj ? curobj->i : -1);
+		if (i<0 || i>=datastack.n || datastack.e[i]!=d) i = datastack.findindex(d);
+		if (i<0) continue;
+		ObjectBounds(datastack.e[i], box);
+		objectbounds.Update(i, box);
+	}
+	dirtybounds.flush();
+}
+
+/*! Mark d's bounds as out of date, so the next search updates them. Call this after changing an
+ * object without ObjectMoved(), for instance after its touchContents(). If d is NULL, all bounds are
+ * recomputed on the next search.
+ */
+void ViewportWithStack::InvalidateBounds(SomeData *d)
+{
+	if (!d) allbounds_dirty = true;
+	else dirtybounds.pushnodup(d);
+}
+
 void ViewportWithStack::ClearSearch()
 {
 	firstobj->clear();
@@ -244,8 +301,16 @@ int ViewportWithStack::FindObject(int x,int y, const char *dtype,
 	if (nextindex<0) nextindex=firstobj->i;
 	if (start==0) if (++nextindex>n) nextindex=0;
 	flatpoint p=dp->screentoreal(x,y);
-	for (c=nextindex; c>=0; c--) {
-		if (c==firstobj->i && start==0) break;
+
+	 //only objects whose bounds contain p need pointin() checks, candidates is in stack order
+	SyncBounds();
+	objectbounds.FindPoint(p, candidates);
+	int k=candidates.n-1;
+	while (k>=0 && candidates.e[k]>nextindex) k--;
+
+	for (c=-1; k>=0; k--) {
+		c=candidates.e[k];
+		if (c<=firstobj->i && start==0) { c=firstobj->i; break; }
 		maybe=datastack.e[c];
 		if (maybe==exclude) continue;
 		if (maybe->pointin(p)) {
@@ -253,9 +318,17 @@ int ViewportWithStack::FindObject(int x,int y, const char *dtype,
 			if (!foundobj->obj) foundobj->set(c,maybe);
 		}
 	}
+	if (k<0) {
+		 //ran out of candidates, which might be before reaching firstobj
+		if (start==0 && firstobj->i>=0 && firstobj->i<=nextindex) c=firstobj->i;
+		else c=-1;
+	}
+
 	 // if item not found, then continue search from top of datastack.
 	if (c==-1) {
-		for (c=datastack.n-1; c>firstobj->i; c--) {
+		for (k=candidates.n-1; k>=0; k--) {
+			c=candidates.e[k];
+			if (c<=firstobj->i) break;
 			maybe=datastack.e[c];
 			if (maybe==exclude) continue;
 			if (maybe->pointin(p)) {
@@ -263,6 +336,7 @@ int ViewportWithStack::FindObject(int x,int y, const char *dtype,
 				if (!foundobj->obj) foundobj->set(c,maybe);
 			}
 		}
+		if (k<0 || c<=firstobj->i) c=firstobj->i;
 		if (c==firstobj->i) { // no more to search for.
 			firstobj->clear();
 			if (foundobj->obj) { 
@@ -295,10 +369,15 @@ int ViewportWithStack::FindObject(int x,int y, const char *dtype,
 int ViewportWithStack::DropObject(SomeData *d, double x,double y)
 {
 	d->origin(flatpoint(x,y));
+	SyncBounds();
 	datastack.push(d);
 	int c=datastack.n-1;
 	curobj->i=c;
 	curobj->SetObject(d);
+
+	DoubleBBox box;
+	ObjectBounds(d, box);
+	objectbounds.Insert(c, box);
 	return c;
 }
 
@@ -313,16 +392,75 @@ int ViewportWithStack::NewData(SomeData *d,ObjectContext **oc_ret, bool clear_se
 
 	if (clear_selection) SetSelection(NULL);
 
+	SyncBounds();
 	curobj->SetObject(d);
 	datastack.push(d);
 	c=datastack.n-1; 
 	curobj->i=c;
 
+	DoubleBBox box;
+	ObjectBounds(d, box);
+	objectbounds.Insert(c, box);
+
 	if (oc_ret) *oc_ret=curobj;
 	
 	return curobj->i;
 }
 
+/*! Update the bounds of oc's object in objectbounds. The context never changes here,
+ * so always returns NULL.
+ */
+ObjectContext *ViewportWithStack::ObjectMoved(ObjectContext *oc, int modifyoc)
+{
+	if (!oc || !oc->obj) return NULL;
+	if (allbounds_dirty || objectbounds.NumItems()!=datastack.n) return NULL; //will be rebuilt on next search anyway
+
+	int i=oc->i;
+	if (i<0 || i>=datastack.n || datastack.e[i]!=oc->obj) i=datastack.findindex(oc->obj);
+	if (i<0) return NULL;
+
+	DoubleBBox box;
+	ObjectBounds(oc->obj, box);
+	objectbounds.Update(i, box);
+	return NULL;
+}
+
+/*! Return objects touching box, in stacking order, bottom first. See ViewportWindow::FindObjects().
+ * There are no nested contexts here, so ascurobj is ignored.
+ */
+int ViewportWithStack::FindObjects(Laxkit::DoubleBBox *box, char real, char ascurobj,
+								   SomeData ***data_ret, ObjectContext ***c_ret)
+{
+	if (data_ret) *data_ret=NULL;
+	if (c_ret) *c_ret=NULL;
+	if (!box || !box->validbounds()) return 0;
+
+	DoubleBBox rbox;
+	if (real) rbox.setbounds(box);
+	else {
+		rbox.addtobounds(dp->screentoreal(flatpoint(box->minx,box->miny)));
+		rbox.addtobounds(dp->screentoreal(flatpoint(box->maxx,box->miny)));
+		rbox.addtobounds(dp->screentoreal(flatpoint(box->maxx,box->maxy)));
+		rbox.addtobounds(dp->screentoreal(flatpoint(box->minx,box->maxy)));
+	}
+
+	SyncBounds();
+	int n=objectbounds.FindBox(rbox, candidates);
+	if (!n) return 0;
+
+	if (data_ret) {
+		*data_ret=new SomeData*[n+1];
+		for (int c=0; c<n; c++) (*data_ret)[c]=datastack.e[candidates.e[c]];
+		(*data_ret)[n]=NULL;
+	}
+	if (c_ret) {
+		*c_ret=new ObjectContext*[n+1];
+		for (int c=0; c<n; c++) (*c_ret)[c]=new ObjectContext(candidates.e[c], datastack.e[candidates.e[c]]);
+		(*c_ret)[n]=NULL;
+	}
+	return n;
+}
+
 //! Delete the current object by decrementing its count and removing it from datastack.
 /*! Also clears any interface in the stack whose data is 
  * is curobj->obj.
@@ -334,7 +472,10 @@ int ViewportWithStack::DeleteObject()
 	SomeData *todel=curobj->obj;
 	if (!todel) return -1;
 	for (int c=0; c<interfaces.n; c++) interfaces.e[c]->Clear(todel);
-	datastack.remove(datastack.findindex(todel));
+	int i=datastack.findindex(todel);
+	if (objectbounds.NumItems()==datastack.n) objectbounds.Remove(i);
+	dirtybounds.remove(dirtybounds.findindex(todel));
+	datastack.remove(i);
 	curobj->clear();
 	
 	//ClearSearch();
@@ -382,7 +523,7 @@ void ViewportWithStack::Refresh()
 	if (draw_axes) dp->drawaxes(10);
 
 	
-	if (needtodraw) {
+	if (needtodraw || DamageRect(NULL)) {
 		int c2;
 		anInterface *ifc=NULL;
 		ViewerWindow *viewer=dynamic_cast<ViewerWindow *>(win_parent);
@@ -23,6 +23,7 @@
 #define _LAX_VIEWPORTWITHSTACK_H
 
 #include <lax/interfaces/viewportwindow.h>
+#include <lax/boundstree.h>
 
 namespace LaxInterfaces {
 
@@ -38,6 +39,13 @@ class ViewportWithStack : public ViewportWindow
 	ObjectContext *curobj;
 	virtual void ClearSearch();
 
+	Laxkit::BoundsTree objectbounds; //transformed bounds of datastack, in the same order
+	Laxkit::NumStack<SomeData*> dirtybounds; //objects whose objectbounds entry needs updating, see InvalidateBounds()
+	bool allbounds_dirty;
+	Laxkit::NumStack<int> candidates;
+	virtual void ObjectBounds(SomeData *d, Laxkit::DoubleBBox &box);
+	virtual void SyncBounds();
+
  public:
 	bool draw_axes;
 	bool draw_bounding_boxes;
@@ -53,10 +61,14 @@ class ViewportWithStack : public ViewportWindow
 	virtual int NewData(SomeData *d,ObjectContext **oc_ret, bool clear_selection=true);
 	virtual int DropObject(SomeData *d, double x,double y);
 	virtual int DeleteObject();
+	virtual ObjectContext *ObjectMoved(ObjectContext *oc, int modifyoc);
+	virtual void InvalidateBounds(SomeData *d);
 	
 	virtual int FindObject(int x,int y, const char *dtype, 
 						   SomeData *exclude, int start,
 						   ObjectContext **oc, int searcharea);
+	virtual int FindObjects(Laxkit::DoubleBBox *box, char real, char ascurobj,
+							SomeData ***data_ret, ObjectContext ***c_ret);
 	virtual int ChangeObject(ObjectContext *oc, int switchtool);
 	virtual int ChangeContext(int x,int y,ObjectContext **oc);
 	virtual int SelectObject(int i);
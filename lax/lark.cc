@@ -24,47 +24,120 @@
 #include <lax/lists.cc>
 #include <lax/strmanip.h>
 
+#include <atomic>
+#include <mutex>
+#include <cstring>
+
 
 
 namespace Laxkit {
 
-	
-static PtrStack<char> lax_larks(2);
-/*! lark_alpha_sorted[0] is index in lax_larks of lowest string.
- *  lark_alpha_sorted[lark_alpha_sorted.n-1] is index in lax_larks of highest string.
- */
-static NumStack<int> lark_alpha_sorted;
-	
-//! Find the index in the lark_alpha_sorted stack that str would be found.
-/*! If str is not there, then c is filled with that position in lark_alpha_sorted
- * that the id of the lark must be pushed into.
- *
- * \todo make this faster via binary search 
- */
-static int lark_position(const char *str,int *c)
+
+//! Number of lark strings in each block of the id to string directory.
+#define LARK_BLOCK_SIZE 1024
+//! Maximum number of directory blocks, so at most LARK_BLOCK_SIZE*LARK_MAX_BLOCKS larks.
+#define LARK_MAX_BLOCKS 4096
+//! Size of the chunks lark strings are copied into.
+#define LARK_CHUNK_SIZE 8192
+
+
+//! One slot of the lark hash table. id is 0 for empty. hash is set before id is published.
+struct LarkSlot
 {
-	int p,i;
-	for (i=0; i<lark_alpha_sorted.n; i++) {
-		p=strcmp(str,lax_larks.e[lark_alpha_sorted.e[i]]);
-		if (p==0) { *c=i; return 1; }
-		if (p>0) { *c=i; return 0; }
+	std::atomic<int> id;
+	unsigned int hash;
+};
+
+//! Open addressing hash table of lark ids. Tables are never changed once full, only replaced by bigger ones.
+struct LarkTable
+{
+	unsigned int size; //always a power of 2
+	LarkSlot *slots;
+	LarkTable *prev; //old tables are kept for any readers still using them
+};
+
+static std::atomic<LarkTable*> lark_table(nullptr);
+static std::atomic<const char**> lark_blocks[LARK_MAX_BLOCKS];
+static std::atomic<int> lark_count(0);
+static std::mutex lark_mutex; //guards adding larks
+
+ //stable storage for lark strings, only touched with lark_mutex held
+static char *lark_chunk = nullptr;
+static int lark_chunk_used = LARK_CHUNK_SIZE;
+
+
+//! FNV-1a hash of len bytes of str.
+static unsigned int lark_hash(const char *str, int len)
+{
+	unsigned int h = 2166136261u;
+	for (int c=0; c<len; c++) {
+		h ^= (unsigned char)str[c];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+//! Find the id of len chars of str in table t, or 0. Safe without the lock.
+static int lark_find(LarkTable *t, const char *str, int len, unsigned int hash)
+{
+	if (!t) return 0;
+	unsigned int mask = t->size-1;
+	for (unsigned int i = hash & mask; ; i = (i+1) & mask) {
+		int id = t->slots[i].id.load(std::memory_order_acquire);
+		if (!id) return 0;
+		if (t->slots[i].hash != hash) continue;
+		const char *s = lark_str_from_id(id);
+		if (!strncmp(s, str, len) && s[len] == '\0') return id;
 	}
-	*c=i;
-	return 0;
-//	----------broken:
-//	if (lark_alpha_sorted.n==0) return 0;
-//	int cmp, d=0, s=0, e=lark_alpha_sorted.n-1, l=e/2;
-//	do {
-//		if (strcmp(lark_alpha_sorted.e[s],str)<=0) return s;
-//		if (strcmp(lark_alpha_sorted.e[e],str)>=0) return e+1;
-//		if (l==s || l==e) return e;
-//		cmp=strcmp(lark_alpha_sorted.e[l],str);
-//		if (cmp==0) return l;
-//		if (cmp<0) e=l;
-//			else   s=l;
-//		l=(s+e)/2;
-//	} while (s!=e)
-//	return s;
+}
+
+//! Put id in t. The lock must be held, and t must have room.
+static void lark_insert(LarkTable *t, int id, unsigned int hash)
+{
+	unsigned int mask = t->size-1;
+	unsigned int i = hash & mask;
+	while (t->slots[i].id.load(std::memory_order_relaxed)) i = (i+1) & mask;
+	t->slots[i].hash = hash;
+	t->slots[i].id.store(id, std::memory_order_release);
+}
+
+//! Make a bigger table with everything in old, or a first table if old is null. The lock must be held.
+static LarkTable *lark_grow(LarkTable *old)
+{
+	LarkTable *t = new LarkTable;
+	t->size = (old ? 2*old->size : 256);
+	t->slots = new LarkSlot[t->size];
+	for (unsigned int c=0; c<t->size; c++) {
+		t->slots[c].id.store(0, std::memory_order_relaxed);
+		t->slots[c].hash = 0;
+	}
+	t->prev = old;
+
+	if (old) {
+		for (unsigned int c=0; c<old->size; c++) {
+			int id = old->slots[c].id.load(std::memory_order_relaxed);
+			if (id) lark_insert(t, id, old->slots[c].hash);
+		}
+	}
+	return t;
+}
+
+//! Copy len chars of str to storage that lasts for the life of the program. The lock must be held.
+static const char *lark_store(const char *str, int len)
+{
+	char *s;
+	if (len+1 > LARK_CHUNK_SIZE/4) s = new char[len+1];
+	else {
+		if (lark_chunk_used + len+1 > LARK_CHUNK_SIZE) {
+			lark_chunk = new char[LARK_CHUNK_SIZE];
+			lark_chunk_used = 0;
+		}
+		s = lark_chunk + lark_chunk_used;
+		lark_chunk_used += len+1;
+	}
+	memcpy(s, str, len);
+	s[len] = '\0';
+	return s;
 }
 
 //! Return pointer to string associated with id, or NULL if none.
@@ -74,12 +147,15 @@ static int lark_position(const char *str,int *c)
  * as a shortcut for checking string equality for commonly used strings, namely
  * event names. These are a replacement for X Atoms, so that Laxkit events do not
  * clutter up the X server.
- * 
- * \todo *** make threadsafe
+ *
+ * Lark strings are never moved or freed, so the returned pointer is good for the life
+ * of the program. This is threadsafe, and never blocks.
  */
 const char *lark_str_from_id(int id)
 {
-	return (id>0 && id<=lax_larks.n ? lax_larks.e[id-1] : NULL);
+	if (id <= 0 || id > lark_count.load(std::memory_order_acquire)) return NULL;
+	id--;
+	return lark_blocks[id / LARK_BLOCK_SIZE].load(std::memory_order_acquire)[id % LARK_BLOCK_SIZE];
 }
 
 //! Return the id associated with str.
@@ -88,27 +164,60 @@ const char *lark_str_from_id(int id)
  *
  * If createifabsent==0 and the string is not known, then 0 is returned. No string
  * can have 0 associated with it.
- * 
- * \todo *** make threadsafe
+ *
+ * This is threadsafe. Looking up known strings never blocks. Adding new ones takes a lock.
  */
 int lark_id_from_str(const char *str, char createifabsent)
 {
-	int c;
+	if (!str) return 0;
+	return lark_id_from_strn(str, strlen(str), createifabsent);
+}
+
+//! Like lark_id_from_str(), but for only the first len chars of str.
+int lark_id_from_strn(const char *str, int len, char createifabsent)
+{
+	if (!str) return 0;
+	if (len < 0) len = strlen(str);
 
-	 // find lark
-	if (lark_position(str,&c)) return lark_alpha_sorted.e[c]+1;
+	unsigned int hash = lark_hash(str, len);
+	int id = lark_find(lark_table.load(std::memory_order_acquire), str, len, hash);
+	if (id || !createifabsent) return id;
 
-	 // create new lark
-	if (createifabsent==0) return 0;
-	lax_larks.push(newstr(str));
-	lark_alpha_sorted.push(lax_larks.n,c);
-	
-	return lax_larks.n;
+	std::lock_guard<std::mutex> lock(lark_mutex);
+
+	 //someone might have added it while we waited
+	LarkTable *t = lark_table.load(std::memory_order_relaxed);
+	id = lark_find(t, str, len, hash);
+	if (id) return id;
+
+	int n = lark_count.load(std::memory_order_relaxed);
+	if (n >= LARK_BLOCK_SIZE * LARK_MAX_BLOCKS) return 0;
+
+	 //add string to the id directory
+	const char **block = lark_blocks[n / LARK_BLOCK_SIZE].load(std::memory_order_relaxed);
+	if (!block) {
+		block = new const char*[LARK_BLOCK_SIZE];
+		lark_blocks[n / LARK_BLOCK_SIZE].store(block, std::memory_order_release);
+	}
+	block[n % LARK_BLOCK_SIZE] = lark_store(str, len);
+	id = n+1;
+	lark_count.store(id, std::memory_order_release);
+
+	 //add id to the hash, keeping it at most half full
+	if (!t || 2*(unsigned int)id > t->size) {
+		t = lark_grow(t);
+		lark_table.store(t, std::memory_order_release);
+	}
+	lark_insert(t, id, hash);
+
+	return id;
 }
 
 
 //-------------------------- IdSet ----------------------------
 /*! \class IdSet
+ * Set of strings with an id for each. Strings are kept sorted, and there is also an index sorted
+ * by id, so lookups both ways are binary searches.
  */
 
 
@@ -141,83 +250,95 @@ int IdSet::NumIds()
 	return strs.n;
 }
 
-int IdSet::FindIndex(const char *str)
+/*! Return the index in strs that str is at, or -1. If not found and insert_ret, set it
+ * to the index str would be inserted at.
+ */
+int IdSet::FindIndex(const char *str, int *insert_ret)
 {
-	for (int c=0; c<strs.n; c++) {
-		if (!strcmp(str,strs.e[c])) return c;
+	int s = 0, e = strs.n-1, m, cmp;
+	while (s <= e) {
+		m = (s+e)/2;
+		cmp = strcmp(str, strs.e[m]);
+		if (cmp == 0) return m;
+		if (cmp < 0) e = m-1;
+		else s = m+1;
 	}
-
+	if (insert_ret) *insert_ret = s;
 	return -1;
 }
 
-int IdSet::FindIndex(int id)
+/*! Return the position in by_id that id is at, or would be inserted at.
+ */
+int IdSet::IdPosition(int id)
 {
-	for (int c=0; c<ids.n; c++) {
-		if (id==ids.e[c]) return c;
+	int s = 0, e = by_id.n-1, m;
+	while (s <= e) {
+		m = (s+e)/2;
+		if (ids.e[by_id.e[m]] < id) s = m+1;
+		else e = m-1;
 	}
+	return s;
+}
 
+int IdSet::FindIndex(int id)
+{
+	int p = IdPosition(id);
+	if (p < by_id.n && ids.e[by_id.e[p]] == id) return by_id.e[p];
 	return -1;
 }
 
-/*! \todo speed this up with binary search.
- */
 int IdSet::FindId(const char *str)
 {
-	for (int c=0; c<strs.n; c++) {
-		if (!strcmp(str,strs.e[c])) return ids.e[c];
-	}
-
-	return -1;
+	int index = FindIndex(str);
+	if (index<0) return -1;
+	return ids.e[index];
 }
 
-/*! \todo speed this up with binary search.
- */
 const char *IdSet::FindStr(int id)
 {
-	for (int c=0; c<ids.n; c++) {
-		if (ids.e[c]==id) return strs.e[c];
-	}
-
-	return NULL;
+	return StrFromId(id);
 }
 
 /*! Return 0 for added, nonzero for already there.
  */
 int IdSet::Add(const char *str, int id)
 {
-	int index=FindIndex(str);
-	if (index>=0) return 1;
-
-	for (index=0; index<strs.n; index++) {
-		if (strcmp(str,strs.e[index])<0) break;
-	}
+	int index;
+	if (FindIndex(str, &index) >= 0) return 1;
 
 	strs.push(newstr(str),LISTS_DELETE_Array,index);
 	ids.push(id, index);
 
+	for (int c=0; c<by_id.n; c++) if (by_id.e[c] >= index) by_id.e[c]++;
+	by_id.push(index, IdPosition(id));
+
 	return 0;
 }
 
 int IdSet::Remove(const char *str)
 {
-	int index=FindIndex(str);
-	if (index>=0) {
-		strs.remove(index);
-		ids.remove(index);
-		return 0;
-	}
-	return 1;
+	return RemoveIndex(FindIndex(str));
 }
 
 int IdSet::Remove(int id)
 {
-	int index=FindIndex(id);
-	if (index>=0) {
-		strs.remove(index);
-		ids.remove(index);
-		return 0;
+	return RemoveIndex(FindIndex(id));
+}
+
+/*! Return 0 for removed, or 1 for bad index.
+ */
+int IdSet::RemoveIndex(int index)
+{
+	if (index < 0 || index >= strs.n) return 1;
+
+	for (int c=0; c<by_id.n; c++) {
+		if (by_id.e[c] == index) { by_id.remove(c); break; }
 	}
-	return 1;
+	for (int c=0; c<by_id.n; c++) if (by_id.e[c] > index) by_id.e[c]--;
+
+	strs.remove(index);
+	ids.remove(index);
+	return 0;
 }
 
 
@@ -31,6 +31,10 @@ namespace Laxkit {
 
 const char *lark_str_from_id(int id);
 int lark_id_from_str(const char *str, char createifabsent=0);
+int lark_id_from_strn(const char *str, int len, char createifabsent=0);
+
+//! Lark id of a string literal, looked up only the first time this line runs.
+#define LARK(str) ([]() { static const int lark_id = Laxkit::lark_id_from_str(str, 1); return lark_id; }())
 
 
 //-------------------------- IdSet ----------------------------
@@ -39,6 +43,10 @@ class IdSet
   protected:
 	PtrStack<char> strs;
 	NumStack<int> ids;
+	NumStack<int> by_id; //indices into ids, sorted by id
+
+	virtual int IdPosition(int id);
+	virtual int RemoveIndex(int index);
 	
   public:
 	IdSet();
@@ -47,7 +55,7 @@ class IdSet
 	virtual int NumIds();
 	virtual const char *StrFromId(int id);
 	virtual int IdFromStr(const char *str);
-	virtual int FindIndex(const char *str);
+	virtual int FindIndex(const char *str, int *insert_ret = nullptr);
 	virtual int FindIndex(int id);
 	virtual int FindId(const char *str);
 	virtual const char *FindStr(int id);
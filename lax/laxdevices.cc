@@ -217,6 +217,12 @@ int LaxDevice::selectForWindow(anXWindow *win,unsigned long)
 /*! \var clock_t LaxMouse::ttthreshhold
  * \brief Clock time after entering to allow movement, before considering tooltips.
  */
+/*! \var const MouseEventData *LaxMouse::current_motion
+ * \brief The LAX_onMouseMove event currently being delivered for this mouse, if any.
+ *
+ * anXApp sets this just before sending a motion event, and clears it right after.
+ * See MotionHistory().
+ */
 
 LaxMouse::LaxMouse()
   :	buttoncount(0),
@@ -228,7 +234,8 @@ LaxMouse::LaxMouse()
 	ttthreshhold(0),
 	ttwindow(NULL),
 	last_tt(0),
-	paired_keyboard(NULL)
+	paired_keyboard(NULL),
+	current_motion(NULL)
 {}
 
 LaxMouse::~LaxMouse()
@@ -256,6 +263,24 @@ void LaxMouse::buttonReleased(int button,anXWindow *ww)
 	if (!ww || (ww && buttonwindow!=ww->object_id) || button != button_for_count) buttoncount=0;
 }
 
+//! Return samples of motion events that were merged into the one currently being delivered.
+/*! anXApp coalesces queued motion events for the same device and window, so a window's
+ * MouseMove() might be called once for many actual device events. Tools that want every
+ * sample, like freehand drawing, can call this from within MouseMove() to get the skipped
+ * ones, oldest first. The current position is not included.
+ *
+ * Returns NULL and sets n_ret to 0 if there is no history.
+ */
+const MotionSample *LaxMouse::MotionHistory(int *n_ret) const
+{
+	if (!current_motion || !current_motion->history_n) {
+		if (n_ret) *n_ret = 0;
+		return NULL;
+	}
+	if (n_ret) *n_ret = current_motion->history_n;
+	return current_motion->history;
+}
+
 //! Update buttoncount, which helps keep track of double, triple, etc clicks.
 void LaxMouse::buttonPressed(Time time, int button,unsigned long windowid)
 {
@@ -712,6 +737,7 @@ int CoreXlibPointer::eventFilter(EventData **events_ret,
 		b->x		=xev->xmotion.x;
 		b->y		=xev->xmotion.y;
 		b->modifiers=xev->xmotion.state;
+		b->xlib_time=xev->xmotion.time;
 
 		isinput=1;
 		*events_ret=b;
@@ -1121,6 +1147,48 @@ XInput2Pointer::XInput2Pointer(XIDeviceInfo *d)
 	Name(d->name);
 	xid=d->deviceid;
 	use=d->use;
+	valuator_source=-1;
+	for (int c=0; c<5; c++) valuator_min[c]=valuator_max[c]=valuator_last[c]=0;
+	valuator_last[2]=1; //full pressure
+}
+
+//! Fill in pressure and tilt of a motion event from the valuators sent with it.
+/*! Valuator ranges are queried from the source (slave) device only when the source changes,
+ * so this does not make a round trip to the X server for each event like getInfo() does.
+ * This lets coalesced motion keep accurate per sample pressure.
+ */
+void XInput2Pointer::motionValuators(XIDeviceEvent *dev, MouseEventData *b)
+{
+	if (dev->sourceid != valuator_source) {
+		valuator_source = dev->sourceid;
+		for (int c=0; c<5; c++) valuator_min[c]=valuator_max[c]=0;
+
+		int n=0;
+		XIDeviceInfo *devinfo=XIQueryDevice(anXApp::app->dpy, dev->sourceid, &n);
+		if (devinfo) {
+			for (int c=0; c<devinfo->num_classes; c++) {
+				if (devinfo->classes[c]->type!=XIValuatorClass) continue;
+				XIValuatorClassInfo *val=(XIValuatorClassInfo*)(devinfo->classes[c]);
+				if (val->number<0 || val->number>=5) continue;
+				valuator_min[val->number]=val->min;
+				valuator_max[val->number]=val->max;
+			}
+			XIFreeDeviceInfo(devinfo);
+		}
+	}
+
+	 //values only holds valuators whose bit is set in mask, in order
+	double *values=dev->valuators.values;
+	for (int c=0, i=0; c<5 && c<dev->valuators.mask_len*8; c++) {
+		if (!XIMaskIsSet(dev->valuators.mask, c)) continue;
+		double v=values[i++];
+		if (valuator_min[c]>=valuator_max[c]) continue;
+		valuator_last[c]=(v-valuator_min[c])/(valuator_max[c]-valuator_min[c]);
+	}
+
+	b->pressure=valuator_last[2];
+	b->tilt    =valuator_last[3];
+	b->tilty   =valuator_last[4];
 }
 
 /*! Return 0 for success, nonzero for error.
@@ -1513,6 +1581,8 @@ int XInput2Pointer::eventFilter(EventData **events_ret, XEvent *xev, anXWindow *
 		b->x		=dev->event_x;
 		b->y		=dev->event_y;
 		b->modifiers=dev->mods.effective;//***is this right???
+		b->xlib_time=dev->time;
+		motionValuators(dev, b);
 
 		isinput=1;
 		*events_ret=b;
@@ -42,6 +42,8 @@ namespace Laxkit {
 
 class anXWindow;
 class EventData;
+class MouseEventData;
+struct MotionSample;
 class EventReceiver;
 
 
@@ -110,6 +112,8 @@ class LaxMouse : public LaxDevice
 	unsigned long last_tt;
 
 	LaxKeyboard *paired_keyboard;
+	const MouseEventData *current_motion; //set by anXApp while a motion event is being delivered
+
 	LaxMouse();
 	virtual ~LaxMouse();
 	virtual int clearReceiver(EventReceiver *receiver);
@@ -129,6 +133,7 @@ class LaxMouse : public LaxDevice
 	virtual double TiltX() const;
 	virtual double TiltY() const;
 	virtual void Tilt(double *x, double *y) const;
+	virtual const MotionSample *MotionHistory(int *n_ret) const;
 };
 
 
@@ -224,7 +229,11 @@ class XInput2Pointer : public LaxMouse
 {
  public:
 	int use;
+	int valuator_source; //device whose valuator ranges are cached
+	double valuator_min[5], valuator_max[5];
+	double valuator_last[5]; //normalized, since motion events only carry valuators that changed
 	XInput2Pointer(XIDeviceInfo *d);
+	virtual void motionValuators(XIDeviceEvent *dev, MouseEventData *b);
 	virtual int usesX() { return 1; }
 	virtual int eventFilter(EventData **events_ret,XEvent *xev,anXWindow *target,int &isinput);
 	virtual int selectForWindow(anXWindow *win,unsigned long);
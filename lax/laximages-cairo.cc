@@ -25,6 +25,7 @@
 
 #include <cstdio>
 #include <errno.h>
+#include <unistd.h>
 
 #include <lax/laximages-cairo.h>
 #include <lax/strmanip.h>
@@ -33,6 +34,12 @@
 #include <lax/anxapp.h>
 #include <lax/laxutils.h>
 #include <lax/fileutils.h>
+#include <lax/workerpool.h>
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <condition_variable>
 
 
 #include <iostream>
@@ -273,15 +280,117 @@ int save_image_cairo(LaxImage *image, const char *filename, const char *format)
 /*! \var int LaxCairoImage::height
  * \brief The actual height of the full image.
  */
+/*! \var bool LaxCairoImage::load_in_background
+ * \brief If true, DisplayImage() loads png files on TaskQueue::Default() instead of waiting for them.
+ */
+/*! \var int LaxCairoImage::proxy_size
+ * \brief When the cache frees an image bigger than this, keep a copy scaled to fit in this many pixels. 0 for none.
+ */
+
+bool LaxCairoImage::load_in_background = true;
+int LaxCairoImage::proxy_size = 256;
+
+
+//! A png load on TaskQueue::Default(), shared by the image and the queue.
+class CairoLoadJob
+{
+  public:
+	std::atomic<int> refs;
+	unsigned long task; //id in TaskQueue::Default()
+	clock_t wanted; //when DisplayImage() last asked for it, only used in the main thread
+	char *filename;
+	cairo_surface_t *surface; //the result, or NULL if the load failed
+	bool done;
+	NumStack<unsigned long> notify; //windows to send "imageloaded" to when done
+
+	std::mutex mutex;
+	std::condition_variable done_cond;
+
+	CairoLoadJob(const char *file) { refs = 2; task = 0; wanted = times(NULL); filename = newstr(file); surface = NULL; done = false; }
+	~CairoLoadJob() { delete[] filename; if (surface) cairo_surface_destroy(surface); }
+	void Release() { if (--refs == 0) delete this; }
+	void Run();
+	bool Watch(unsigned long window);
+};
+
+//! Runs on a queue thread.
+void CairoLoadJob::Run()
+{
+	cairo_surface_t *s = NULL;
+	if (file_exists(filename, 1, NULL) == S_IFREG) {
+		s = cairo_image_surface_create_from_png(filename);
+		if (cairo_surface_status(s) != CAIRO_STATUS_SUCCESS) {
+			cairo_surface_destroy(s);
+			s = NULL;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	surface = s;
+	done = true;
+	done_cond.notify_all();
+	if (anXApp::app) {
+		for (int c=0; c<notify.n; c++) anXApp::app->SendMessage(new EventData("imageloaded"), notify.e[c]);
+	}
+}
+
+//! Send window "imageloaded" when done. Returns false if already done, so nothing will be sent.
+bool CairoLoadJob::Watch(unsigned long window)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (done) return false;
+	if (notify.findindex(window) < 0) notify.push(window);
+	return true;
+}
+
+//! Images with a background load going, so loads can finish even if the image is not drawn again.
+static PtrStack<LaxCairoImage> loading_images(LISTS_DELETE_None);
+
+//! Newer requests load first, since older ones have more likely scrolled out of view.
+static int load_priority = 0;
+
+/*! loading_images, the cache counts, and CacheManager::GetDefault() are not locked, so images must
+ * only be fetched and released from the main thread. Only the file reads in CairoLoadJob happen elsewhere.
+ */
+static bool in_main_thread()
+{
+	return !anXApp::app || anXApp::app->IsMainThread();
+}
+
+//! Return a copy of image scaled to fit in maxsize, or NULL if it already fits.
+static cairo_surface_t *make_proxy(cairo_surface_t *image, int maxsize)
+{
+	int w = cairo_image_surface_get_width(image);
+	int h = cairo_image_surface_get_height(image);
+	if (w <= maxsize && h <= maxsize) return NULL;
+
+	double scale = (w > h ? double(maxsize)/w : double(maxsize)/h);
+	int pw = w*scale, ph = h*scale;
+	if (pw < 1) pw = 1;
+	if (ph < 1) ph = 1;
+
+	cairo_surface_t *proxy = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, pw,ph);
+	cairo_t *cr = cairo_create(proxy);
+	cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+	cairo_scale(cr, double(pw)/w, double(ph)/h);
+	cairo_set_source_surface(cr, image, 0,0);
+	cairo_paint(cr);
+	cairo_destroy(cr);
+	return proxy;
+}
+
 
 
 LaxCairoImage::LaxCairoImage()
   : LaxImage(NULL)
 { 
 	flag=0;
-	display_count=0;
+	modified = false;
+	load_failed = false;
+	load_job = NULL;
 
 	image=NULL;
+	proxy=NULL;
 	width=height=0;
 
 	cache_buffer = nullptr;
@@ -309,9 +418,12 @@ LaxCairoImage::LaxCairoImage(int w, int h)
 LaxCairoImage::LaxCairoImage(const char *fname, cairo_surface_t *img)
 	: LaxImage(fname)
 {
-	display_count = 0; 
 	flag = 0;
+	modified = false;
+	load_failed = false;
+	load_job = nullptr;
 	image = nullptr;
+	proxy = nullptr;
 	cache_buffer = nullptr;
 	cache_buffer_size = 0;
 
@@ -347,9 +459,12 @@ LaxCairoImage::LaxCairoImage(const char *fname, cairo_surface_t *img)
 LaxCairoImage::LaxCairoImage(const char *original, const char *fname, int maxw, int maxh)
 	: LaxImage(fname)
 {
-	display_count = 0;
 	flag = 0;
+	modified = false;
+	load_failed = false;
+	load_job = nullptr;
 	image = nullptr;
+	proxy = nullptr;
 	cache_buffer = nullptr;
 	cache_buffer_size = 0;
 
@@ -407,6 +522,7 @@ LaxCairoImage::LaxCairoImage(const char *original, const char *fname, int maxw,
 
 			//generate_preview_image(filename,previewfile,"jpg",dwidth,dheight,0);
 			image = nimage;
+			modified = true;
 
 		} else {
 			cairo_surface_destroy(pimage);
@@ -417,10 +533,12 @@ LaxCairoImage::LaxCairoImage(const char *original, const char *fname, int maxw,
 //! Free image if it happens to exist.
 LaxCairoImage::~LaxCairoImage()
 {
+	DropLoad();
 	if (image) {
 		cairo_surface_destroy(image);
 		image=NULL;
 	}
+	if (proxy) cairo_surface_destroy(proxy);
 
 	delete[] cache_buffer;
 }
@@ -450,6 +568,7 @@ LaxImage *LaxCairoImage::Crop(int x, int y, int width, int height, bool return_n
 	image = cimage;
 	this->width = width;
 	this->height = height;
+	Modified();
 	return this;
 }
 
@@ -538,6 +657,7 @@ int LaxCairoImage::doneWithBuffer(unsigned char *bbuffer)
 		//delete[] bbuffer;
 	}
 	cairo_surface_mark_dirty (image);
+	Modified();
 
 	return 0;
 }
@@ -607,6 +727,7 @@ int LaxCairoImage::createFromData_ARGB8(int nwidth, int nheight, int stride, con
 	cairo_surface_destroy(image);
 	cairo_destroy(cr);
 	if (premultiplied) delete[] premultiplied;
+	Modified();
 
 
 	 //---alternate method: keep external buffer around:
@@ -639,18 +760,32 @@ int LaxCairoImage::createFromData_ARGB8(int nwidth, int nheight, int stride, con
  */
 void LaxCairoImage::clear()
 {	
+	if (InCache()) InCache()->Remove(this);
+	DropLoad();
+	load_failed = false;
+	modified = false;
+
 	 //free any image data
 	if (filename) { delete[] filename; filename=NULL; }
 	width=height=0;
 
 	cairo_surface_destroy(image);
 	image=NULL;
+	if (proxy) { cairo_surface_destroy(proxy); proxy = NULL; }
+}
+
+//! Pixels no longer match filename, so the image must stay in memory.
+void LaxCairoImage::Modified()
+{
+	modified = true;
+	if (InCache()) InCache()->Remove(this);
 }
 
 unsigned int LaxCairoImage::imagestate()
 {
 	return (filename ? LAX_IMAGE_HAS_FILE : 0) |
 		   (width>0 ? LAX_IMAGE_METRICS : 0) |
+		   (proxy!=NULL ? LAX_IMAGE_PREVIEW : 0) |
 		   (image!=NULL ? LAX_IMAGE_WHOLE : 0);
 }
 
@@ -658,12 +793,94 @@ unsigned int LaxCairoImage::imagestate()
 /*! Calling this is supposed to make it easier on the memory cache, by allowing
  * other code to free the cairo_surface from memory. Calling Image() will place
  * it back in memory.
+ *
+ * Each Image() or non-NULL DisplayImage() should be followed by one of these.
+ * Once nothing is using the image, the default CacheManager may free it if over budget.
  */
 void LaxCairoImage::doneForNow()
 {
-	if (!image || flag) return;
+	if (flag) return;
+	assert(in_main_thread());
+
+	if (dec_cache() == 0 && InCache()) InCache()->Trim();
+}
+
+//! Start loading filename on TaskQueue::Default().
+void LaxCairoImage::StartLoad()
+{
+	CairoLoadJob *job = load_job = new CairoLoadJob(filename);
+	loading_images.push(this);
+	job->task = TaskQueue::Default()->Add([job]() { job->Run(); job->Release(); }, ++load_priority);
+}
+
+//! Take a background load back out of the queue if it has not started. Returns true if it was.
+bool LaxCairoImage::CancelLoad()
+{
+	if (!load_job || !TaskQueue::Default()->Cancel(load_job->task)) return false;
+	load_job->Release(); //the queue's reference
+	load_job->Release();
+	load_job = NULL;
+	loading_images.remove(this);
+	return true;
+}
+
+//! Forget any background load, whether or not it is running.
+void LaxCairoImage::DropLoad()
+{
+	if (!load_job || CancelLoad()) return;
+	load_job->Release();
+	load_job = NULL;
+	loading_images.remove(this);
+}
+
+/*! Take finished background loads from DisplayImage() and touch them in the default CacheManager,
+ * so they count against its budget even if not drawn again. Loads not started yet that were
+ * not asked for in the last stale_ms milliseconds are canceled, as they have probably scrolled
+ * out of view. DisplayImage() calls this. Returns the number of loads still going.
+ */
+int LaxCairoImage::CheckLoads(int stale_ms)
+{
+	clock_t now = times(NULL);
+	clock_t stale = stale_ms * sysconf(_SC_CLK_TCK) / 1000;
+
+	for (int c = loading_images.n-1; c >= 0; c--) {
+		LaxCairoImage *img = loading_images.e[c];
+		if (img->AdoptLoaded(false)) {
+			if (img->image && img->AbleToRegenerate()) CacheManager::GetDefault()->Touch(img);
+		} else if (now - img->load_job->wanted > stale) img->CancelLoad();
+	}
+	return loading_images.n;
+}
 
-	if (display_count>0) display_count--;
+/*! Take the result of a background load if it is done. If wait, first wait for it to be done.
+ * Returns 1 if a load was finished, whether or not it succeeded, else 0.
+ */
+int LaxCairoImage::AdoptLoaded(bool wait)
+{
+	if (!load_job) return 0;
+
+	cairo_surface_t *s = NULL;
+	{
+		std::unique_lock<std::mutex> lock(load_job->mutex);
+		if (wait) while (!load_job->done) load_job->done_cond.wait(lock);
+		if (!load_job->done) return 0;
+		s = load_job->surface;
+		load_job->surface = NULL;
+	}
+	load_job->Release();
+	load_job = NULL;
+	loading_images.remove(this);
+
+	load_failed = (s == NULL);
+	if (s) {
+		if (image) cairo_surface_destroy(image);
+		image = s;
+		if (width<=0 || height<=0) {
+			width = cairo_image_surface_get_width(image);
+			height= cairo_image_surface_get_height(image);
+		}
+	}
+	return 1;
 }
 
 //! Return the image. Loads from filename if !image.
@@ -675,11 +892,21 @@ void LaxCairoImage::doneForNow()
  * If 1 and main is unavailable, or 2 and the preview is unavailable, then NULL is
  * returned.
  *
+ * If a background load from DisplayImage() is under way, this waits for it instead of loading again.
+ * Images that can be reloaded from filename are touched in CacheManager::GetDefault().
+ * Follow with doneForNow() when done with the image.
+ * This must only be called from the main thread, as the cache and loads are not locked.
+ *
  * \todo note that if image is already loaded, this function does not yet switch to
  *   the proper one..
  */
 cairo_surface_t *LaxCairoImage::Image()
 {
+	assert(in_main_thread());
+
+	 //a background load not started yet is canceled to just load here, else waited for
+	if (!image && load_job && !CancelLoad()) AdoptLoaded(true);
+
 	if (!image) {
 		if (importer) {
 			importer->LoadToMemory(this);
@@ -691,6 +918,7 @@ cairo_surface_t *LaxCairoImage::Image()
 				image=NULL;
 
 			} else { //success loading
+				load_failed = false;
 				if (width<=0 || height<=0) {
 					width= cairo_image_surface_get_width(image),	
 					height=cairo_image_surface_get_height(image);
@@ -700,10 +928,44 @@ cairo_surface_t *LaxCairoImage::Image()
 	} 
 
 	if (!image) return nullptr;
-	display_count++;
+	inc_cache();
+	if (AbleToRegenerate()) CacheManager::GetDefault()->Touch(this);
 	return image;
 }
 
+/*! For drawing. If the full image is in memory, or cannot be loaded in the background, this is
+ * the same as Image(), with *scale_ret set to 1.
+ *
+ * Otherwise, when load_in_background, a png load is started on TaskQueue::Default() rather
+ * than waiting for it. Meanwhile, if there is a proxy, it is returned, with *scale_ret set to how
+ * much to scale it up by to match the full image. When the load is done, notify_window, if nonzero,
+ * is sent an "imageloaded" message, which makes an anXWindow redraw.
+ * Returns NULL when there is nothing to draw yet.
+ *
+ * Like Image(), a non-NULL return must be followed by doneForNow(), and this must only be called
+ * from the main thread.
+ */
+cairo_surface_t *LaxCairoImage::DisplayImage(double *scale_ret, unsigned long notify_window)
+{
+	assert(in_main_thread());
+	if (scale_ret) *scale_ret = 1;
+	if (loading_images.n) CheckLoads();
+	if (image || !load_in_background || importer || !filename || modified) return Image();
+
+	if (!load_job && !load_failed) StartLoad();
+	if (load_job) load_job->wanted = times(NULL);
+	if (load_job && notify_window && !load_job->Watch(notify_window)) {
+		 //finished in the meantime
+		AdoptLoaded(false);
+		if (image) return Image();
+	}
+
+	if (!proxy) return nullptr;
+	inc_cache();
+	if (scale_ret) *scale_ret = double(width) / cairo_image_surface_get_width(proxy);
+	return proxy;
+}
+
 /*! format==null guess from extension
  * Return 0 for success or nonzero for failure and not saved.
  * Warning: does no clobber check.
@@ -723,6 +985,49 @@ void LaxCairoImage::Set(double r, double g, double b, double a)
 	cairo_set_source_rgba(cr, r,g,b,a);
 	cairo_paint(cr);
 	cairo_destroy(cr);
+	Modified();
+}
+
+//! Bytes held by the full image and any getImageBuffer() buffer. Proxies are not counted.
+long LaxCairoImage::CacheMemoryNeeded()
+{
+	if (!image) return cache_buffer_size;
+	return (long)cairo_image_surface_get_stride(image) * cairo_image_surface_get_height(image) + cache_buffer_size;
+}
+
+//! Images can be reloaded if they have a filename, and have not been changed since loading.
+int LaxCairoImage::AbleToRegenerate()
+{
+	return filename && !modified;
+}
+
+//! Load the image if necessary. Returns 0 for success, or 1 for could not load.
+int LaxCairoImage::CacheRegenerate()
+{
+	if (!Image()) return 1;
+	dec_cache();
+	return 0;
+}
+
+/*! Free the full image, first keeping a proxy of it if it is bigger than proxy_size.
+ * Returns 0 for freed, or 1 for not freed because it is in use or cannot be reloaded.
+ */
+int LaxCairoImage::CacheFree()
+{
+	if (!image || CacheCount() > 0 || !AbleToRegenerate()) return 1;
+
+	if (!proxy && proxy_size > 0) proxy = make_proxy(image, proxy_size);
+	cairo_surface_destroy(image);
+	image = NULL;
+	delete[] cache_buffer;
+	cache_buffer = nullptr;
+	cache_buffer_size = 0;
+	return 0;
+}
+
+int LaxCairoImage::CacheState()
+{
+	return imagestate();
 }
 
 
@@ -37,14 +37,29 @@ namespace Laxkit {
 
 
 //--------------------------- LaxCairoImage --------------------------------------
-class LaxCairoImage : public LaxImage
+
+class CairoLoadJob;
+
+class LaxCairoImage : public LaxImage, public MemCachedObject
 {
  protected:
 	char flag;
-	int display_count;
+	bool modified; //pixels differ from filename, so image cannot be freed and reloaded
+	bool load_failed; //last background load failed, so do not keep retrying it
+	CairoLoadJob *load_job; //background load in progress, or NULL
+
+	virtual void StartLoad();
+	virtual bool CancelLoad();
+	virtual void DropLoad();
+	virtual int AdoptLoaded(bool wait);
 
  public:
+	static bool load_in_background;
+	static int proxy_size;
+	static int CheckLoads(int stale_ms = 500);
+
 	cairo_surface_t *image;
+	cairo_surface_t *proxy; //small version kept when the cache frees image, or NULL
 	int width,height;
 
 	unsigned char *cache_buffer;
@@ -56,7 +71,9 @@ class LaxCairoImage : public LaxImage
 	LaxCairoImage(const char *original, const char *fname, int maxw, int maxh);
 	virtual ~LaxCairoImage();
 	virtual cairo_surface_t *Image();
+	virtual cairo_surface_t *DisplayImage(double *scale_ret, unsigned long notify_window = 0);
 	virtual void doneForNow();
+	virtual void Modified();
 	virtual unsigned int imagestate();
 	virtual int imagetype() { return LAX_IMAGE_CAIRO; }
 	virtual int w() { return width; }
@@ -70,6 +87,13 @@ class LaxCairoImage : public LaxImage
 
 	virtual void Set(double r, double g, double b, double a);
 	virtual int Save(const char *tofile = nullptr, const char *format = nullptr); //format==null guess from extension
+
+	 //MemCachedObject
+	virtual long CacheMemoryNeeded();
+	virtual int AbleToRegenerate();
+	virtual int CacheRegenerate();
+	virtual int CacheFree();
+	virtual int CacheState();
 };
 
 
@@ -627,7 +627,7 @@ int ImlibLoader::LoadToMemory(LaxImage *img)
 		cimg->createFromData_ARGB8(cimg->width, cimg->height, 4*cimg->width, data, true);
 		imlib_image_put_back_data((DATA32 *)data);
 
-		cimg->Image(); //incs cimg->display_count++;
+		cimg->Image(); //incs the cache count
 		return 0;
 	}
 #endif
@@ -69,63 +69,45 @@ namespace Laxkit {
 
 
 //----------------------------Memory Cache------------------------
-/*! **********hmmmmm THIS IS A WORK IN PROGRESS!!!
+/*! \class MemCachedObject
+ * \brief Something whose data can be freed when memory is tight, and regenerated when needed again.
  *
- * image data can be: 
- *    1. in memory and needed
- *    2. in memory and not needed,     needtoregenerate==0
- *    3. not in memory and needed.     needtoregenerate==1
- *    4. not in memory and not needed. needtoregenerate==1
- * doneForNow() will put it in 2 if it was in 1, and do nothing if it was in 3
- * getImageData() will put it in 1 from any other state
+ * Object data can be:
+ *    1. in memory and needed,          cache_count>0
+ *    2. in memory and not needed,      cache_count==0
+ *    3. not in memory and needed
+ *    4. not in memory and not needed
  *
- * when it is in 2, there needs to be background cache management to free
- * the data if memory is low and it has the oldest access time, putting it into 3.
+ * inc_cache() marks the data as needed, and dec_cache() as not needed any more.
+ * A CacheManager keeps objects in least recently used order, and when over its budget,
+ * calls CacheFree() on the oldest objects in state 2, putting them in state 4.
  *
- * in states 1 and 3, it is not managed by any cache manager
- *
- * In order for cache manager to accept an object, is must have able_to_regenerate==1
- * 
- * \todo ***** think about this!! Imlib2 does memory caching already... how I wonder?
+ * In order for a cache manager to free an object, it must have AbleToRegenerate() true.
+ */
+/*! \var int MemCachedObject::cache_count
+ * \brief How many users currently need the data. Only objects with 0 can be freed.
  */
-class MemCachedObject
-{
- friend class CacheManager;
- private:
-	int incache;
-	unsigned int cache_count;
-	MemCachedObject *prev_cache, *next_cache;
-
- public:
-	int cachegroup; //images | fonts | object groups...
-	clock_t lastaccesstime;
-	int id;
-
-	MemCachedObject();
-	virtual ~MemCachedObject();
-
-	virtual int CacheMemoryNeeded()=0;
-	virtual int AbleToRegenerate()=0;
-	virtual int CacheRegenerate()=0;
-	virtual int CacheFree()=0; //return 0 for success, or nonzero can't free, like for in memory buffer with no regenerate available
-	virtual int CacheState()=0;
 
-	virtual int inc_cache();
-	virtual int dec_cache();
-};
 
 /*! Default is to start with the object data not being needed, so the count is 0.
  */
 MemCachedObject::MemCachedObject()
 {
-	prev_cache=next_cache=NULL;
+	cache_manager = NULL;
+	cache_bytes = 0;
+	prev_cache = next_cache = NULL;
 
-	cache_count=0;
-	lastaccesstime=0;
+	cache_count = 0;
+	cachegroup = 0;
+	lastaccesstime = 0;
+	id = 0;
 }
 
+//! Removes this from any CacheManager.
 MemCachedObject::~MemCachedObject()
-{}
+{
+	if (cache_manager) cache_manager->Remove(this);
+}
 
 //! Increment the cache count, returning the new current count.
 int MemCachedObject::inc_cache()
@@ -146,40 +128,156 @@ int MemCachedObject::dec_cache()
 
 
 //--------------------------- CacheManager --------------------------------------
-class CacheManager
-{
-  protected:
-	MemCachedObject *top, *bottom; //each mod touch moves object to bottom
+/*! \class CacheManager
+ * \brief Keep MemCachedObject data within a memory budget, freeing least recently used first.
+ *
+ * Objects are kept in a list, oldest at top. Touch() moves an object to the bottom, and
+ * recounts its CacheMemoryNeeded(). When Bytes() goes over Budget(), Trim() walks from
+ * the top, calling CacheFree() on objects with a 0 cache count that are able to regenerate,
+ * until enough is freed. Objects in use are skipped, so Bytes() can stay over the budget
+ * while they are in use.
+ *
+ * The manager does not own the objects. They remove themselves when destroyed.
+ * This is not thread safe, and should only be used from the main thread.
+ */
 
-  public:
-	static CacheManager *GetDefault();
-	static CacheManager *SetDefault(CacheManager *newmanager);
 
-	CacheManager();
-	virtual ~CacheManager();
-	virtual int Add(MemCachedObject *obj);
-	virtual int Remove(MemCachedObject *obj);
-};
+static SingletonKeeper cacheKeeper;
 
-CacheManager::CacheManager()
+//! Return the default manager, creating one if necessary.
+CacheManager *CacheManager::GetDefault()
 {
-	top=bottom=NULL;
+	CacheManager *manager = dynamic_cast<CacheManager*>(cacheKeeper.GetObject());
+	if (!manager) {
+		manager = new CacheManager();
+		cacheKeeper.SetObject(manager, true);
+	}
+	return manager;
 }
 
+//! Set the default manager, which gets a new reference. Returns newmanager.
+/*! Objects in the old default stay there until they are touched again.
+ */
+CacheManager *CacheManager::SetDefault(CacheManager *newmanager)
+{
+	if (cacheKeeper.GetObject() != newmanager) cacheKeeper.SetObject(newmanager, false);
+	return newmanager;
+}
+
+CacheManager::CacheManager(long budget)
+{
+	top = bottom = NULL;
+	num_objects = 0;
+	max_bytes = budget;
+	bytes = 0;
+	num_freed = 0;
+	bytes_freed = 0;
+}
+
+//! Detaches any remaining objects, but does not free their data.
 CacheManager::~CacheManager()
 {
+	while (top) Remove(top);
 }
 
+void CacheManager::Unlink(MemCachedObject *obj)
+{
+	if (obj->prev_cache) obj->prev_cache->next_cache = obj->next_cache;
+	else top = obj->next_cache;
+	if (obj->next_cache) obj->next_cache->prev_cache = obj->prev_cache;
+	else bottom = obj->prev_cache;
+	obj->prev_cache = obj->next_cache = NULL;
+}
+
+//! Add obj as most recently used, removing it from any other manager, then Trim() if over budget.
+/*! If obj is already here, this is the same as Touch(). Returns 0.
+ */
 int CacheManager::Add(MemCachedObject *obj)
 {
-	// ***
-	return 1;
+	if (!obj) return 1;
+	if (obj->cache_manager == this) return Touch(obj);
+	if (obj->cache_manager) obj->cache_manager->Remove(obj);
+
+	obj->cache_manager = this;
+	obj->prev_cache = bottom;
+	obj->next_cache = NULL;
+	if (bottom) bottom->next_cache = obj;
+	else top = obj;
+	bottom = obj;
+	num_objects++;
+
+	obj->lastaccesstime = times(NULL);
+	obj->cache_bytes = obj->CacheMemoryNeeded();
+	bytes += obj->cache_bytes;
+	if (max_bytes > 0 && bytes > max_bytes) Trim();
+	return 0;
 }
 
+//! Take obj out of the list, without freeing its data. Return 0 for removed, or 1 for not here.
 int CacheManager::Remove(MemCachedObject *obj)
 {
-	// ***
-	return 1;
+	if (!obj || obj->cache_manager != this) return 1;
+
+	Unlink(obj);
+	bytes -= obj->cache_bytes;
+	obj->cache_bytes = 0;
+	obj->cache_manager = NULL;
+	num_objects--;
+	return 0;
+}
+
+//! Mark obj as most recently used, and recount its memory. Adds obj if it is not here.
+int CacheManager::Touch(MemCachedObject *obj)
+{
+	if (!obj) return 1;
+	if (obj->cache_manager != this) return Add(obj);
+
+	if (obj != bottom) {
+		Unlink(obj);
+		obj->prev_cache = bottom;
+		bottom->next_cache = obj;
+		bottom = obj;
+	}
+
+	obj->lastaccesstime = times(NULL);
+	long newbytes = obj->CacheMemoryNeeded();
+	bytes += newbytes - obj->cache_bytes;
+	obj->cache_bytes = newbytes;
+	if (max_bytes > 0 && bytes > max_bytes) Trim();
+	return 0;
+}
+
+//! Free least recently used objects until Bytes() <= target. target<0 means use Budget().
+/*! Freed objects are removed from the list. Returns the number of bytes freed.
+ */
+long CacheManager::Trim(long target)
+{
+	if (target < 0) {
+		if (max_bytes <= 0) return 0;
+		target = max_bytes;
+	}
+
+	long freed = 0;
+	MemCachedObject *obj = top, *next;
+	while (obj && bytes > target) {
+		next = obj->next_cache;
+		long objbytes = obj->cache_bytes;
+		if (obj->cache_count == 0 && obj->AbleToRegenerate() && obj->CacheFree() == 0) {
+			Remove(obj);
+			freed += objbytes;
+			num_freed++;
+			bytes_freed += objbytes;
+		}
+		obj = next;
+	}
+	return freed;
+}
+
+//! Set the budget in bytes, trimming right away if now over. max<=0 means no limit.
+void CacheManager::SetBudget(long max)
+{
+	max_bytes = max;
+	if (max_bytes > 0 && bytes > max_bytes) Trim();
 }
 
 
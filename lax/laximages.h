@@ -58,6 +58,78 @@ enum LaxImageState {
 
 class ImageLoader;
 
+
+//--------------------------- MemCachedObject --------------------------------------
+
+//! Default CacheManager::Budget(), in bytes.
+#define CACHE_DEFAULT_MAX_BYTES (256*1024*1024)
+
+class CacheManager;
+
+class MemCachedObject
+{
+ friend class CacheManager;
+ private:
+	CacheManager *cache_manager; //the manager this is in, or NULL
+	long cache_bytes; //CacheMemoryNeeded() when last counted by cache_manager
+	unsigned int cache_count;
+	MemCachedObject *prev_cache, *next_cache;
+
+ public:
+	int cachegroup; //images | fonts | object groups...
+	clock_t lastaccesstime;
+	int id;
+
+	MemCachedObject();
+	virtual ~MemCachedObject();
+
+	virtual long CacheMemoryNeeded()=0;
+	virtual int AbleToRegenerate()=0;
+	virtual int CacheRegenerate()=0;
+	virtual int CacheFree()=0; //return 0 for success, or nonzero can't free, like for in memory buffer with no regenerate available
+	virtual int CacheState()=0;
+
+	virtual int inc_cache();
+	virtual int dec_cache();
+	virtual int CacheCount() { return cache_count; }
+	CacheManager *InCache() { return cache_manager; }
+};
+
+
+//--------------------------- CacheManager --------------------------------------
+
+class CacheManager : public anObject
+{
+  protected:
+	MemCachedObject *top, *bottom; //each touch moves object to bottom, so top is least recently used
+	int num_objects;
+	long max_bytes;
+	long bytes;
+	long num_freed, bytes_freed;
+
+	void Unlink(MemCachedObject *obj);
+
+  public:
+	static CacheManager *GetDefault();
+	static CacheManager *SetDefault(CacheManager *newmanager);
+
+	CacheManager(long budget = CACHE_DEFAULT_MAX_BYTES);
+	virtual ~CacheManager();
+	virtual const char *whattype() { return "CacheManager"; }
+
+	virtual int Add(MemCachedObject *obj);
+	virtual int Remove(MemCachedObject *obj);
+	virtual int Touch(MemCachedObject *obj);
+	virtual long Trim(long target = -1);
+
+	virtual void SetBudget(long max);
+	virtual long Budget() { return max_bytes; }
+	virtual long Bytes() { return bytes; }
+	virtual int NumObjects() { return num_objects; }
+	virtual long NumFreed() { return num_freed; }
+	virtual long BytesFreed() { return bytes_freed; }
+};
+
 class LaxImage : public anObject
 {
   public:
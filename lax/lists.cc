@@ -538,7 +538,7 @@ T **PtrStack<T>::extractArrays(char **local,int *nn)//local=nullptr, nn=nullptr
 template <class T>
 void PtrStack<T>::flush()
 {
-	if (n == 0) return;
+	 //note: arrays can still be allocated when n==0, after popping everything
 	for (int c=0; c<n; c++)
 		if (e[c]) {
 			if (islocal[c] == LISTS_DELETE_Array) delete[] e[c];
@@ -788,7 +788,7 @@ int PtrStack<T>::Allocate(int newmax)
 	delete[] e; e = nullptr;
 	e = newt;
 
-	char *templ = new char[max];
+	char *templ = new char[newmax];
 	if (n) memcpy(templ,islocal,n*sizeof(char));
 	delete[] islocal;
 	islocal = templ;
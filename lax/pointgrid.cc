@@ -0,0 +1,201 @@
+//
+//
+//    The Laxkit, a windowing toolkit
+//    Please consult https://github.com/Laidout/laxkit about where to send any
+//    correspondence about this software.
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 3 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; If not, see <http://www.gnu.org/licenses/>.
+//
+//    Copyright (C) 2024 by Tom Lechner
+//
+
+#include <lax/pointgrid.h>
+
+#include <cmath>
+#include <cstring>
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+namespace Laxkit {
+
+
+//---------------------------------- PointGrid ---------------------------------
+
+/*! \class PointGrid
+ * \brief Uniform grid of points, for fast nearest point and radius searches.
+ *
+ * Build() bins a snapshot of points into square cells with a counting sort, so cell contents
+ * are contiguous in cell_points and cell_pos. The grid does not track later changes to the
+ * points. Rebuild it when they move.
+ *
+ * Searches return indices into the array passed to Build().
+ */
+
+
+PointGrid::PointGrid()
+{
+	minx = miny = 0;
+	cellsize    = 1;
+	xcells      = ycells = 0;
+	numpoints   = 0;
+	cell_start  = nullptr;
+	cell_points = nullptr;
+	cell_pos    = nullptr;
+}
+
+PointGrid::~PointGrid()
+{
+	Flush();
+}
+
+void PointGrid::Flush()
+{
+	delete[] cell_start;
+	delete[] cell_points;
+	delete[] cell_pos;
+	cell_start  = nullptr;
+	cell_points = nullptr;
+	cell_pos    = nullptr;
+	xcells = ycells = 0;
+	numpoints = 0;
+}
+
+/*! Bin n points into cells ncellsize wide. If ncellsize<=0, pick a size that puts about 2 points in each cell.
+ * Cell count is limited to about 4*n, so very small cells on a sparse set are enlarged.
+ */
+void PointGrid::Build(const flatpoint *points, int n, double ncellsize)
+{
+	Flush();
+	if (n <= 0) return;
+
+	double maxx, maxy;
+	minx = maxx = points[0].x;
+	miny = maxy = points[0].y;
+	for (int c=1; c<n; c++) {
+		if (points[c].x < minx) minx = points[c].x; else if (points[c].x > maxx) maxx = points[c].x;
+		if (points[c].y < miny) miny = points[c].y; else if (points[c].y > maxy) maxy = points[c].y;
+	}
+
+	double w = maxx-minx, h = maxy-miny;
+	if (ncellsize <= 0) ncellsize = sqrt(2 * (w > 0 ? w : 1) * (h > 0 ? h : 1) / n);
+	if ((w/ncellsize + 1) * (h/ncellsize + 1) > 4.*n + 16) ncellsize = sqrt((w+ncellsize) * (h+ncellsize) / (4.*n + 16));
+	if (!(ncellsize > 0)) ncellsize = 1;
+
+	cellsize  = ncellsize;
+	xcells    = (int)(w/cellsize) + 1;
+	ycells    = (int)(h/cellsize) + 1;
+	numpoints = n;
+
+	int ncells  = xcells*ycells;
+	cell_start  = new int[ncells+1];
+	cell_points = new int[n];
+	cell_pos    = new flatpoint[n];
+	int *cell_of = new int[n];
+
+	 //counting sort by cell
+	memset(cell_start, 0, (ncells+1)*sizeof(int));
+	for (int c=0; c<n; c++) {
+		cell_of[c] = CellY(points[c].y)*xcells + CellX(points[c].x);
+		cell_start[cell_of[c]+1]++;
+	}
+	for (int c=0; c<ncells; c++) cell_start[c+1] += cell_start[c];
+
+	int *fill = new int[ncells];
+	memcpy(fill, cell_start, ncells*sizeof(int));
+	for (int c=0; c<n; c++) {
+		int i = fill[cell_of[c]]++;
+		cell_points[i] = c;
+		cell_pos[i] = points[c];
+	}
+
+	delete[] fill;
+	delete[] cell_of;
+}
+
+/*! Return index of the point closest to p, or -1 if the grid is empty.
+ * Searches rings of cells around p until no closer point can be in the next ring.
+ */
+int PointGrid::Closest(flatpoint p, double *dist2_ret)
+{
+	if (numpoints == 0) return -1;
+
+	int cx = CellX(p.x), cy = CellY(p.y);
+	int best = -1;
+	double bestd = HUGE_VAL;
+
+	int maxring = (xcells > ycells ? xcells : ycells);
+	for (int r = 0; r <= maxring; r++) {
+		 //any point in ring r is at least (r-1)*cellsize away, even when p is off the grid
+		if (best >= 0 && r > 1) {
+			double d = (r-1)*cellsize;
+			if (d*d > bestd) break;
+		}
+
+		for (int y = cy-r; y <= cy+r; y++) {
+			if (y < 0 || y >= ycells) continue;
+			int step = (y == cy-r || y == cy+r) ? 1 : 2*r; //only the ring's edge cells
+			if (step == 0) step = 1;
+
+			for (int x = cx-r; x <= cx+r; x += step) {
+				if (x < 0 || x >= xcells) continue;
+
+				int cell = y*xcells + x;
+				for (int i = cell_start[cell]; i < cell_start[cell+1]; i++) {
+					double d = (cell_pos[i] - p).norm2();
+					if (d < bestd) {
+						bestd = d;
+						best = cell_points[i];
+					}
+				}
+			}
+		}
+	}
+
+	if (dist2_ret) *dist2_ret = bestd;
+	return best;
+}
+
+/*! Append to index_ret the indices of all points within radius of p.
+ * Returns the number of points found.
+ */
+int PointGrid::FindWithin(flatpoint p, double radius, NumStack<int> &index_ret)
+{
+	if (numpoints == 0) return 0;
+
+	int x1 = CellX(p.x - radius), x2 = CellX(p.x + radius);
+	int y1 = CellY(p.y - radius), y2 = CellY(p.y + radius);
+	double r2 = radius*radius;
+	int n = 0;
+
+	for (int y = y1; y <= y2; y++) {
+		for (int x = x1; x <= x2; x++) {
+			int cell = y*xcells + x;
+			for (int i = cell_start[cell]; i < cell_start[cell+1]; i++) {
+				if ((cell_pos[i] - p).norm2() <= r2) {
+					index_ret.push(cell_points[i]);
+					n++;
+				}
+			}
+		}
+	}
+
+	return n;
+}
+
+
+} //namespace Laxkit
+
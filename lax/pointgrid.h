@@ -0,0 +1,62 @@
+//
+//
+//    The Laxkit, a windowing toolkit
+//    Please consult https://github.com/Laidout/laxkit about where to send any
+//    correspondence about this software.
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 3 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; If not, see <http://www.gnu.org/licenses/>.
+//
+//    Copyright (C) 2024 by Tom Lechner
+//
+#ifndef _LAX_POINTGRID_H
+#define _LAX_POINTGRID_H
+
+#include <lax/lists.h>
+#include <lax/vectors.h>
+
+
+namespace Laxkit {
+
+
+//---------------------------------- PointGrid ---------------------------------
+
+class PointGrid
+{
+  public:
+	double minx, miny;
+	double cellsize;
+	int xcells, ycells;
+
+	int numpoints;
+	int *cell_start;      //xcells*ycells+1, cell i has cell_points[cell_start[i]..cell_start[i+1]-1]
+	int *cell_points;     //point indices grouped by cell
+	flatpoint *cell_pos;  //positions of cell_points, in the same order
+
+	PointGrid();
+	virtual ~PointGrid();
+	virtual void Flush();
+	virtual void Build(const flatpoint *points, int n, double ncellsize = 0);
+
+	int CellX(double x) { int i = (x-minx)/cellsize; return i<0 ? 0 : (i>=xcells ? xcells-1 : i); }
+	int CellY(double y) { int i = (y-miny)/cellsize; return i<0 ? 0 : (i>=ycells ? ycells-1 : i); }
+
+	virtual int Closest(flatpoint p, double *dist2_ret = nullptr);
+	virtual int FindWithin(flatpoint p, double radius, NumStack<int> &index_ret);
+};
+
+
+} //namespace Laxkit
+
+#endif
+
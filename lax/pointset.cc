@@ -21,7 +21,9 @@
 //
 
 #include <lax/pointset.h>
+#include <lax/workerpool.h>
 
+#include <atomic>
 
 #include <iostream>
 using namespace std;
@@ -40,10 +42,12 @@ namespace Laxkit {
 
 PointSet::PointSet()
 {
+	grid = nullptr;
 }
 
 PointSet::~PointSet()
 {
+	delete grid;
 }
 
 anObject *PointSet::duplicate(anObject *ref)
@@ -92,6 +96,7 @@ int PointSet::CopyFrom(PointSet *set, int with_info, int copy_method)
 		while (points.n > set->points.n) points.remove(points.n-1);
 	}
 
+	InvalidateIndex();
 	return n;
 }
 
@@ -150,11 +155,13 @@ static int cmp_YDescending(const void *v1,const void *v2)
 void PointSet::SortX(bool ascending)
 {
 	qsort(points.e, points.n, sizeof(PointSet::PointObj*), ascending ? cmp_XAscending : cmp_XDescending);
+	InvalidateIndex();
 }
 
 void PointSet::SortY(bool ascending)
 {
 	qsort(points.e, points.n, sizeof(PointSet::PointObj*), ascending ? cmp_YAscending : cmp_YDescending);
+	InvalidateIndex();
 }
 
 void PointSet::CreateRandomPoints(int num, int seed, double minx, double maxx, double miny, double maxy)
@@ -311,6 +318,7 @@ flatpoint PointSet::Point(flatpoint newPos, int index, ...)
 {
 	if (index < 0 || index >= points.n) return flatpoint();
 	points.e[index]->p = newPos;
+	InvalidateIndex();
 	return newPos;
 }
 
@@ -328,6 +336,7 @@ int PointSet::Map(std::function<int(const flatpoint &p, flatpoint &newp)> adjust
 			n++;
 		}
 	}
+	if (n) InvalidateIndex();
 	return n;
 }
 
@@ -336,16 +345,19 @@ int PointSet::Map(std::function<int(const flatpoint &p, flatpoint &newp)> adjust
 
 int PointSet::Insert(int where, flatpoint p, anObject *data, bool absorb, double weight, double radius)
 {
+	InvalidateIndex();
 	return points.push(newPointObj(p,data,absorb,weight,radius), -1, where);
 }
 
 int PointSet::AddPoint(flatpoint p, anObject *data, bool absorb, double weight, double radius)
 {
+	InvalidateIndex();
 	return points.push(newPointObj(p,data,absorb,weight,radius));
 }
 
 int PointSet::Remove(int index)
 {
+	InvalidateIndex();
 	return points.remove(index);
 }
 
@@ -417,6 +429,7 @@ flatpoint PointSet::Pop(int which, anObject **data_ret)
 		*data_ret = points.e[which]->info;
 		if (*data_ret) (*data_ret)->inc_count();
 		points.remove(which);
+		InvalidateIndex();
 	}
 
 	return p;
@@ -426,6 +439,7 @@ int PointSet::Swap(int index1, int index2)
 {
 	if (index1<0 || index1 >= points.n || index2 < 0 || index2 >= points.n) return 1;
 	points.swap(index1, index2);
+	InvalidateIndex();
 	return 0;
 }
 
@@ -433,29 +447,62 @@ int PointSet::Slide(int index1, int index2)
 {
 	if (index1<0 || index1 >= points.n || index2 < 0 || index2 >= points.n) return 1;
 	points.slide(index1, index2);
+	InvalidateIndex();
 	return 0;
 }
 
 void PointSet::Flush()
 {
 	points.flush();
+	InvalidateIndex();
 }
 
 //--------------------------- Info ---------------------
 
+#define CLOSEST_MIN_GRID     64   //Closest() builds a PointGrid for sets at least this big
+#define RELAX_POINTS_PER_JOB 256  //points per ParallelFor() index in Relax() and RelaxWeighted()
+
+/*! Return the index of the point closest to to_this, or -1 if there are no points.
+ *
+ * For larger sets, this builds a PointGrid on first use, and reuses it until points change through
+ * PointSet functions. If you change points.e directly, call InvalidateIndex().
+ */
 int PointSet::Closest(flatpoint to_this)
 {
-	double d=1e+100;
-	double dd;
-	int i = -1;
-	for (int c=0; c<points.n; c++) {
-		dd = norm2(points.e[c]->p - to_this);
-		if (dd < d) {
-			d = dd;
-			i = c;
+	if (points.n < CLOSEST_MIN_GRID) {
+		double d=1e+100;
+		double dd;
+		int i = -1;
+		for (int c=0; c<points.n; c++) {
+			dd = norm2(points.e[c]->p - to_this);
+			if (dd < d) {
+				d = dd;
+				i = c;
+			}
 		}
+		return i;
+	}
+
+	if (!grid) {
+		flatpoint *pos = new flatpoint[points.n];
+		for (int c=0; c<points.n; c++) pos[c] = points.e[c]->p;
+		grid = new PointGrid;
+		grid->Build(pos, points.n);
+		delete[] pos;
+	}
+
+	return grid->Closest(to_this);
+}
+
+/*! Throw away the spatial index used by Closest(). PointSet functions that change points call this
+ * already, so you only need to call it when changing points.e directly.
+ */
+void PointSet::InvalidateIndex()
+{
+	if (grid) {
+		delete grid;
+		grid = nullptr;
 	}
-	return i;
 }
 
 /*! Return evenly weighted average of all the points.
@@ -482,104 +529,183 @@ void PointSet::GetBBox(DoubleBBox &box)
 
 /*! Relax trying to maintain at least mindist between points, but also try to
  * stay contained within original bounding box.
+ *
+ * Points closer than mindist push apart strongly, and further points push with a weaker inverse square force.
+ * Only neighbors within a cutoff are considered, which is the larger of 4*mindist and 3 times the average
+ * point spacing. Neighbors are found with a PointGrid rebuilt each iteration, and forces on each point are
+ * summed in parallel on WorkerPool::Default().
  */
 void PointSet::Relax(int maxiterations, double mindist, double damp, DoubleBBox box)
 {
 	if (points.n < 1) return;
 
-	flatpoint p1,p2, v, force;
-	double dd;
-
-	// double ff=1; //force multiplier
-	
-	// DoubleBBox box;
-	// GetBBox(box);
-	// flatpoint pts[4];
-	// pts[0] = flatpoint(box.minx, box.miny);
-	// pts[1] = flatpoint(box.maxx, box.miny);
-	// pts[2] = flatpoint(box.maxx, box.maxy);
-	// pts[3] = flatpoint(box.minx, box.maxy);
-
-	flatpoint cc1,cc2;
-	flatpoint d;
-	// double w,h; //, w2,h2;
-	flatpoint dims[points.n];
-	// flatpoint centers[points.n];
-	flatpoint forces[points.n];
-	// double distbtwn;
+	int n = points.n;
+	flatpoint *pos    = new flatpoint[n];
+	flatpoint *forces = new flatpoint[n];
+	PointGrid pgrid;
+	WorkerPool *pool = WorkerPool::Default();
 
-	for (int c=0; c<points.n; c++) {
-		dims[c].x = dims[c].y = 0;
-		// centers[c] = points.e[c]->p;
-	}
-	
 	for (int iterations=0; iterations<maxiterations; iterations++) {
-		for (int c=0; c<points.n; c++) forces[c].set(0,0);
+		DoubleBBox bounds;
+		for (int c=0; c<n; c++) {
+			pos[c] = points.e[c]->p;
+			bounds.addtobounds(pos[c]);
+		}
 
-		for (int c=0; c<points.n; c++) {
-			cc1 = points.e[c]->p;
-			// w   = dims[c].x;
-			// h   = dims[c].y;
-			d.x = d.y = 0;
-
-			force = flatpoint(0, 0);
-			// p1    = cc1 - flatpoint(w / 2, h / 2);
-			// p2    = cc1 + flatpoint(w / 2, h / 2);
-
-
-			for (int c2 = c+1; c2<points.n; c2++) {
-				force.set(0,0);
-
-				// WidthHeight(selection->e(c2), flatpoint(1, 0), flatpoint(0, 1), &w2, &h2, &cc2);
-				cc2 = points.e[c2]->p;
-				v   = cc1 - cc2;
-				dd  = norm(v);
-				v.normalize();
-				if (dd < 1e-7) { dd = 1e-7; v.set(1,0); }
-
-				// distbtwn = rect_radius(cc1, w, h, dist) + rect_radius(cc2, w2, h2, dist);
-				// distbtwn = dd;
-				// if (dd < 2 * (mindist + distbtwn)) force -= ff * v / (dd * dd);
-				// if (dd < (mindist + distbtwn)) force -= 3 * (ff * v / (dd * dd));
-				
-				// apply strong force
-				if (dd < mindist) force += (mindist - dd) * damp * v;
-
-				// apply "gravity" force: G m1 m2 / r^2
-				if (dd > mindist/2) force += damp * mindist*mindist*mindist *1. / (dd*dd) * v;
-				//----
-				// double fd = (2 * mindist - dd) * damp;
-				// if (fd > 0) force += fd * v;
-				
-				forces[c]  += force;
-				forces[c2] -= force;
-			}
+		double w = bounds.maxx - bounds.minx, h = bounds.maxy - bounds.miny;
+		double spacing = (w > 0 && h > 0) ? sqrt(w*h/n) : (w+h)/n;
+		double cutoff = 3*spacing;
+		if (cutoff < 4*mindist) cutoff = 4*mindist;
+		if (!(cutoff > 0)) break; //all points in the same place
 
-			// // go toward original bounding box if outside
-			//  *** this sucks because bounding box changes each time this func called
-			// if (!point_is_in(cc1, pts,4)) {
-			// 	// if (cc1.x < box.minx) force += flatpoint(box.minx - cc1.x, 0);
-			// 	// else if (cc1.x > box.maxx) force += flatpoint(box.maxx - cc1.x, 0);
-			// 	// if (cc1.y < box.miny) force += flatpoint(0, box.miny - cc1.y);
-			// 	// else if (cc1.y > box.maxy) force += flatpoint(0, box.maxy - cc1.y);
-			// 	//------
-			// 	v = datac - cc1;
-			// 	forces[c] += v / norm(v) * damp;
-			// }
+		pgrid.Build(pos, n, cutoff);
 
-		}
+		pool->ParallelFor((n + RELAX_POINTS_PER_JOB-1) / RELAX_POINTS_PER_JOB, [&](int index, int thread) {
+			flatpoint v;
+			double dd;
 
-		for (int c=0; c<points.n; c++) {
+			for (int c = index*RELAX_POINTS_PER_JOB; c < (index+1)*RELAX_POINTS_PER_JOB && c < n; c++) {
+				flatpoint cc1 = pos[c];
+				flatpoint force;
+
+				int x1 = pgrid.CellX(cc1.x - cutoff), x2 = pgrid.CellX(cc1.x + cutoff);
+				int y1 = pgrid.CellY(cc1.y - cutoff), y2 = pgrid.CellY(cc1.y + cutoff);
+
+				for (int y = y1; y <= y2; y++) {
+					for (int x = x1; x <= x2; x++) {
+						int cell = y*pgrid.xcells + x;
+
+						for (int i = pgrid.cell_start[cell]; i < pgrid.cell_start[cell+1]; i++) {
+							int c2 = pgrid.cell_points[i];
+							if (c2 == c) continue;
+
+							v  = cc1 - pgrid.cell_pos[i];
+							dd = norm(v);
+							if (dd > cutoff) continue;
+							if (dd < 1e-7) { dd = 1e-7; v.set(c < c2 ? 1 : -1, 0); }
+							else v /= dd;
+
+							 // apply strong force
+							if (dd < mindist) force += (mindist - dd) * damp * v;
+
+							 // apply "gravity" force: G m1 m2 / r^2
+							if (dd > mindist/2) force += damp * mindist*mindist*mindist *1. / (dd*dd) * v;
+						}
+					}
+				}
+
+				forces[c] = force;
+			}
+		});
+
+		for (int c=0; c<n; c++) {
 			points.e[c]->p += forces[c];
 		}
 	}
+
+	delete[] pos;
+	delete[] forces;
+	InvalidateIndex();
 }
 
 /*! Make points be point->weight radius away from each other. Optional boundary.
+ *
+ * Two points closer than weightscale*(weight1+weight2)/2 are pushed apart by damp times their overlap.
+ * If nboundary > 2, points that end up outside the boundary polygon are moved to the closest point on it.
+ * Stops early when no points overlap. Neighbors are found with a PointGrid, and forces are summed in parallel.
  */
 void PointSet::RelaxWeighted(int maxiterations, double weightscale, double damp, flatpoint *boundary, int nboundary)
 {
-	cerr << " *** IMPLEMENT PointSet::RelaxWeighted()!!!"<<endl;
+	if (points.n < 2) return;
+
+	int n = points.n;
+	double maxweight = 0;
+	for (int c=0; c<n; c++) if (points.e[c]->weight > maxweight) maxweight = points.e[c]->weight;
+	double reach = weightscale * maxweight; //no pair of points can want to be further apart than this
+	if (!(reach > 0)) return;
+
+	flatpoint *pos    = new flatpoint[n];
+	flatpoint *forces = new flatpoint[n];
+	double *radii     = new double[n];
+	PointGrid pgrid;
+	WorkerPool *pool = WorkerPool::Default();
+	std::atomic<int> overlaps;
+
+	for (int c=0; c<n; c++) radii[c] = weightscale * points.e[c]->weight / 2;
+
+	for (int iterations=0; iterations<maxiterations; iterations++) {
+		for (int c=0; c<n; c++) pos[c] = points.e[c]->p;
+		pgrid.Build(pos, n, reach);
+		overlaps = 0;
+
+		pool->ParallelFor((n + RELAX_POINTS_PER_JOB-1) / RELAX_POINTS_PER_JOB, [&](int index, int thread) {
+			flatpoint v;
+			double dd, target;
+			int found = 0;
+
+			for (int c = index*RELAX_POINTS_PER_JOB; c < (index+1)*RELAX_POINTS_PER_JOB && c < n; c++) {
+				flatpoint cc1 = pos[c];
+				flatpoint force;
+
+				int x1 = pgrid.CellX(cc1.x - reach), x2 = pgrid.CellX(cc1.x + reach);
+				int y1 = pgrid.CellY(cc1.y - reach), y2 = pgrid.CellY(cc1.y + reach);
+
+				for (int y = y1; y <= y2; y++) {
+					for (int x = x1; x <= x2; x++) {
+						int cell = y*pgrid.xcells + x;
+
+						for (int i = pgrid.cell_start[cell]; i < pgrid.cell_start[cell+1]; i++) {
+							int c2 = pgrid.cell_points[i];
+							if (c2 == c) continue;
+
+							target = radii[c] + radii[c2];
+							v  = cc1 - pgrid.cell_pos[i];
+							dd = norm(v);
+							if (dd >= target) continue;
+							if (dd < 1e-7) { dd = 1e-7; v.set(c < c2 ? 1 : -1, 0); }
+							else v /= dd;
+
+							force += (target - dd) / 2 * damp * v;
+							found++;
+						}
+					}
+				}
+
+				forces[c] = force;
+			}
+
+			if (found) overlaps += found;
+		});
+
+		if (overlaps == 0) break;
+
+		for (int c=0; c<n; c++) {
+			flatpoint p = points.e[c]->p + forces[c];
+
+			if (nboundary > 2 && !point_is_in(p, boundary, nboundary)) {
+				 //move to closest point on boundary
+				double best = 1e+100;
+				flatpoint closest = p;
+				for (int b=0; b<nboundary; b++) {
+					flatpoint a = boundary[b], e = boundary[(b+1) % nboundary];
+					flatpoint ae = e - a;
+					double t = ae.norm2() > 0 ? ((p - a) * ae) / ae.norm2() : 0;
+					if (t < 0) t = 0; else if (t > 1) t = 1;
+					flatpoint on = a + t * ae;
+					double d = norm2(on - p);
+					if (d < best) { best = d; closest = on; }
+				}
+				p = closest;
+			}
+
+			points.e[c]->p = p;
+		}
+	}
+
+	delete[] pos;
+	delete[] forces;
+	delete[] radii;
+	InvalidateIndex();
 }
 
 void PointSet::MovePoints(double dx, double dy)
@@ -594,6 +720,7 @@ void PointSet::Shuffle()
 		i = c * (double)random()/RAND_MAX;
 		points.swap(c,i);
 	}
+	InvalidateIndex();
 }
 
 /*! For each point p, set p->info to the index of next hull point, or -1 if not a hull point.
@@ -604,10 +731,125 @@ PointSet *PointSet::ConvexHull(PointSet *add_to_this)
 	return nullptr;
 }
 
+/*! \class PointSetCSVEvents
+ * Internal AttributeEvents for PointSet::LoadCSV(), that add a point for each row as it is read.
+ */
+class PointSetCSVEvents : public AttributeEvents
+{
+  public:
+	PointSet *set;
+	const char *xcolumn, *ycolumn;
+	bool has_headers;
+	int xi, yi, wi; //column indices, or -1
+	int depth, column, found;
+	long row;
+	double x, y, w;
+	bool bad;
+
+	PointSetCSVEvents(PointSet *nset, bool headers, const char *xcol, const char *ycol);
+	virtual bool BeginNode();
+	virtual bool Name(const char *str, int len);
+	virtual bool Value(const char *str, int len) { return true; }
+	virtual bool EndNode();
+};
+
+PointSetCSVEvents::PointSetCSVEvents(PointSet *nset, bool headers, const char *xcol, const char *ycol)
+{
+	set = nset;
+	has_headers = headers;
+	xcolumn = xcol;
+	ycolumn = ycol;
+	depth = column = found = 0;
+	row = 0;
+	x = y = 0;
+	w = 1;
+	bad = false;
+
+	if (has_headers) xi = yi = wi = -1;
+	else {
+		char *end = nullptr;
+		xi = (xcolumn ? strtol(xcolumn, &end, 10) : 0);
+		if (!xcolumn || end == xcolumn) xi = 0;
+		yi = (ycolumn ? strtol(ycolumn, &end, 10) : 1);
+		if (!ycolumn || end == ycolumn) yi = 1;
+		wi = (xi == 0 && yi == 1 ? 2 : -1);
+	}
+}
+
+bool PointSetCSVEvents::BeginNode()
+{
+	depth++;
+	if (depth == 1) {
+		column = -1;
+		found = 0;
+		x = y = 0;
+		w = 1;
+	} else if (depth == 2) column++;
+	return true;
+}
+
+bool PointSetCSVEvents::Name(const char *str, int len)
+{
+	if (depth != 2) return true;
+
+	while (len > 0 && isspace(*str))  { str++; len--; }
+	while (len > 0 && isspace(str[len-1])) len--;
+
+	if (row == 0 && has_headers) {
+		if      (xi < 0 && (int)strlen(xcolumn) == len && !strncmp(str, xcolumn, len)) xi = column;
+		else if (yi < 0 && (int)strlen(ycolumn) == len && !strncmp(str, ycolumn, len)) yi = column;
+		else if (wi < 0 && len == 6 && !strncmp(str, "weight", 6)) wi = column;
+		return true;
+	}
+
+	double *v = (column == xi ? &x : column == yi ? &y : column == wi ? &w : nullptr);
+	if (!v) return true;
+
+	char num[64];
+	char *end = nullptr;
+	if (len <= 0 || len >= 64) { bad = true; return false; }
+	memcpy(num, str, len);
+	num[len] = '\0';
+	*v = strtod(num, &end);
+	if (end != num + len) { bad = true; return false; }
+	if (v == &x) found |= 1;
+	else if (v == &y) found |= 2;
+	return true;
+}
+
+bool PointSetCSVEvents::EndNode()
+{
+	depth--;
+	if (depth > 0) return true;
+
+	if (row == 0 && has_headers) {
+		if (xi < 0 || yi < 0) { bad = true; return false; }
+	} else {
+		if (found != 3) { bad = true; return false; }
+		if (set->points.n == set->points.Allocated()) set->points.Allocate(2*set->points.n + 10);
+		set->AddPoint(flatpoint(x,y), nullptr, false, w);
+	}
+	row++;
+	return true;
+}
+
+/*! Append points from a csv file. The file is streamed one row at a time, so it can be much bigger than memory.
+ *
+ * If has_headers, the first row names the columns, and xcolumn and ycolumn are the header names
+ * to use for x and y. A column named "weight" is used for point weight. Otherwise, xcolumn and ycolumn
+ * are column numbers starting at 0, defaulting to 0 and 1, in which case column 2, if any, is the weight.
+ *
+ * Return 0 for success, or nonzero for error. On error, rows read before the error are kept.
+ */
 int PointSet::LoadCSV(const char *file, bool has_headers, const char *xcolumn, const char *ycolumn)
 {
-	cerr << " *** IMPLEMENT PointSet::LoadCSV()!!!"<<endl;
-	return 1;
+	IOBuffer f;
+	if (f.OpenFile(file, "r") != 0) return 1;
+
+	PointSetCSVEvents events(this, has_headers, xcolumn ? xcolumn : "x", ycolumn ? ycolumn : "y");
+	int status = ParseCSVEvents(f, ",", &events);
+	if (status || events.bad) return 1;
+	return 0;
 }
 
 #define SAVE_List_XYW 0
@@ -618,7 +860,7 @@ int PointSet::Save(const char *file, int format) //0=lines of x,y
 	if (!f) return 1;
 
 	if (format == SAVE_CSV) { //write header
-		fwrite("x, y, weight\n", 1,11, f);
+		fwrite("x, y, weight\n", 1,13, f);
 	}
 	for (int c=0; c<points.n; c++) {
 		fprintf(f, "%.10g, %.10g, %.10g\n", points.e[c]->p.x, points.e[c]->p.y, points.e[c]->weight);
@@ -27,6 +27,7 @@
 #include <lax/anobject.h>
 #include <lax/dump.h>
 #include <lax/doublebbox.h>
+#include <lax/pointgrid.h>
 #include <lax/utf8string.h>
 #include <lax/laximages.h>
 #include <lax/colors.h>
@@ -107,6 +108,9 @@ class PointCollection
 
 class PointSet : public PointCollection, virtual public anObject, virtual public DumpUtility
 {
+  protected:
+	PointGrid *grid; //built on demand by Closest(), removed by InvalidateIndex()
+
   public:
  	class PointObj
  	{
@@ -150,6 +154,7 @@ class PointSet : public PointCollection, virtual public anObject, virtual public
 
 	// info
 	virtual int Closest(flatpoint to_this);
+	virtual void InvalidateIndex();
 	virtual flatpoint Barycenter();
 	virtual void GetBBox(DoubleBBox &box);
 
@@ -21,6 +21,11 @@
 //
 
 #include <lax/previewable.h>
+#include <lax/workerpool.h>
+#include <lax/anxapp.h>
+
+#include <mutex>
+#include <condition_variable>
 
 #include <iostream>
 using namespace std;
@@ -30,22 +35,119 @@ using namespace std;
 
 namespace Laxkit {
 
+//--------------------------------- PreviewRender ----------------------------
+
+/*! \class PreviewRender
+ * \brief What a Previewable needs to render a preview on another thread.
+ *
+ * Previewable::NewPreviewRender() makes these in the main thread, with a copy of whatever
+ * the object needs to draw itself, and a new image. Render() is then called on a TaskQueue thread,
+ * and must not touch anything the main thread might be using.
+ * The object is destroyed back in the main thread.
+ *
+ * Note that anObject reference counts are not atomic, and the LaxImage cache is not locked. So Render()
+ * must not inc_count() or dec_count() anything the main thread can also see, and must not draw
+ * images that are shared with the main thread. Objects that refer to such images should return NULL
+ * from NewPreviewRender(), so their previews are rendered synchronously instead.
+ */
+
+//! Takes the reference to nimage.
+PreviewRender::PreviewRender(LaxImage *nimage)
+{
+	image = nimage;
+}
+
+PreviewRender::~PreviewRender()
+{
+	if (image) image->dec_count();
+}
+
+
+//--------------------------------- PreviewJob ----------------------------
+
+//! A PreviewRender on TaskQueue::Default(). Only created, checked, and deleted in the main thread.
+class PreviewJob
+{
+  public:
+	Previewable *owner; //NULL once the owner is gone
+	PreviewRender *render;
+	unsigned long task; //id in TaskQueue::Default()
+	bool stale; //owner changed after render was made
+
+	int status; //-1 for not done, 0 for rendered, else render failed
+	NumStack<unsigned long> notify; //windows to send "previewready" to when done
+	std::mutex mutex;
+	std::condition_variable done_cond;
+
+	PreviewJob(Previewable *nowner, PreviewRender *nrender) {
+		owner = nowner;
+		render = nrender;
+		task = 0;
+		stale = false;
+		status = -1;
+	}
+	~PreviewJob() { render->dec_count(); }
+	void Run();
+	bool Watch(unsigned long window);
+	int Done(bool wait);
+};
+
+//! Runs on a queue thread.
+void PreviewJob::Run()
+{
+	int s = render->Render();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	status = s;
+	done_cond.notify_all();
+	if (anXApp::app) {
+		for (int c=0; c<notify.n; c++) anXApp::app->SendMessage(new EventData("previewready"), notify.e[c]);
+	}
+}
+
+//! Send window "previewready" when done. Returns false if already done, so nothing will be sent.
+bool PreviewJob::Watch(unsigned long window)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (status >= 0) return false;
+	if (notify.findindex(window) < 0) notify.push(window);
+	return true;
+}
+
+//! Return status, first waiting for it to be done if wait.
+int PreviewJob::Done(bool wait)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (wait) while (status < 0) done_cond.wait(lock);
+	return status;
+}
+
+//! All jobs not yet taken by their owners, including ones whose owners are gone.
+static PtrStack<PreviewJob> preview_jobs(LISTS_DELETE_None);
+
+
 //--------------------------------- Previewable ----------------------------
 
 /*! \class Previewable
  *
  * Standardizes getting little preview images from various kinds of objects.
+ *
+ * GetPreview() renders an old preview right away. GetPreviewAsync() instead renders in the background
+ * when NewPreviewRender() can provide a thread safe way to do so, and keeps returning the old preview
+ * until the new one is ready.
  */
 
 Previewable::Previewable()
 {
 	preview    = NULL;
+	preview_job= NULL;
 	previewtime= 0; //times() at which preview was last rendered
     modtime    = 0; //times() of most recent modification that should trigger a preview rerender
 }
 
 Previewable::~Previewable()
 {
+	CancelPreview();
 	if (preview) preview->dec_count();
 }
 
@@ -54,17 +156,115 @@ Previewable::~Previewable()
  */
 void Previewable::touchContents()
 {
+	if (preview_job) preview_job->stale = true;
     previewtime = 0;
     tms tms_;
     modtime     = times(&tms_);
 }
 
+/*! Return the preview, first rendering it here if it is old.
+ * Any background render from GetPreviewAsync() is finished first.
+ */
 LaxImage *Previewable::GetPreview()
 {
+	if (preview_job) TakePreview(true);
 	if (previewtime < modtime || !preview) GeneratePreview(-1,-1);
     return preview;
 }
 
+/*! Like GetPreview(), but when the preview is old, render it on TaskQueue::Default() instead of waiting,
+ * and return the old preview meanwhile, which might be NULL. When done, notify_window, if nonzero,
+ * is sent a "previewready" message, which makes an anXWindow redraw, and the next call returns the new
+ * preview. Higher priority renders start sooner.
+ *
+ * There is only ever one render per object. Any number of changes while it is queued or running
+ * just make one more render after it is done, so a long edit does not pile up renders.
+ *
+ * If NewPreviewRender() returns NULL, this is the same as GetPreview(). See PreviewRender for what
+ * a render on another thread may touch.
+ * This must only be called from the main thread.
+ */
+LaxImage *Previewable::GetPreviewAsync(unsigned long notify_window, int priority)
+{
+	if (preview_jobs.n) CheckPreviews();
+
+	 //previewtime is only 0 with no preview before first render, or after touchContents()
+	if (!preview_job && (previewtime < modtime || (!preview && previewtime == 0))) {
+		PreviewRender *render = NewPreviewRender();
+		if (!render) return GetPreview();
+
+		PreviewJob *job = preview_job = new PreviewJob(this, render);
+		preview_jobs.push(job);
+		job->task = TaskQueue::Default()->Add([job]() { job->Run(); }, priority);
+	}
+
+	if (preview_job && notify_window && !preview_job->Watch(notify_window)) TakePreview(false);
+	return preview;
+}
+
+/*! Swap in a finished background render. If wait, first take the render out of the queue if it
+ * has not started, or wait for it if it has. Returns 1 if there is a new preview, else 0.
+ *
+ * A render that fails still updates previewtime, so it is not retried until the next change.
+ */
+int Previewable::TakePreview(bool wait)
+{
+	if (!preview_job) return 0;
+	PreviewJob *job = preview_job;
+
+	if (wait && TaskQueue::Default()->Cancel(job->task)) {
+		preview_job = nullptr;
+		preview_jobs.remove(job);
+		delete job;
+		return 0;
+	}
+
+	int status = job->Done(wait);
+	if (status < 0) return 0;
+
+	preview_job = nullptr;
+	preview_jobs.remove(job);
+	if (status == 0) {
+		 //anything drawing the old preview has its own reference
+		if (preview) preview->dec_count();
+		preview = job->render->image;
+		preview->inc_count();
+	}
+	tms tms_;
+	previewtime = (job->stale ? 0 : times(&tms_));
+	delete job;
+	return status == 0;
+}
+
+//! Stop any background render, discarding its result.
+void Previewable::CancelPreview()
+{
+	if (!preview_job) return;
+	PreviewJob *job = preview_job;
+	preview_job = nullptr;
+
+	if (TaskQueue::Default()->Cancel(job->task)) {
+		preview_jobs.remove(job);
+		delete job;
+	} else job->owner = nullptr; //still running, CheckPreviews() deletes it when done
+}
+
+/*! Swap in all finished background renders, and clean up after any whose owners are gone.
+ * GetPreviewAsync() calls this. Returns the number of renders still going.
+ */
+int Previewable::CheckPreviews()
+{
+	for (int c = preview_jobs.n-1; c >= 0; c--) {
+		PreviewJob *job = preview_jobs.e[c];
+		if (job->owner) job->owner->TakePreview(false);
+		else if (job->Done(false) >= 0) {
+			preview_jobs.remove(c);
+			delete job;
+		}
+	}
+	return preview_jobs.n;
+}
+
 int Previewable::maxPreviewSize()
 {
 	return 200;
@@ -30,10 +30,31 @@
 
 namespace Laxkit {
 
+//--------------------------------- PreviewRender ----------------------------
+
+class PreviewRender : public anObject
+{
+  public:
+	LaxImage *image; //what to render to
+
+	PreviewRender(LaxImage *nimage);
+	virtual ~PreviewRender();
+	virtual const char *whattype() { return "PreviewRender"; }
+	virtual int Render() = 0; //return 0 for success
+};
+
+
 //--------------------------------- Previewable ----------------------------
 
+class PreviewJob;
+
 class Previewable : virtual public anObject, virtual public DoubleBBox
 {
+  protected:
+	PreviewJob *preview_job; //background render in progress, or NULL
+
+	virtual int TakePreview(bool wait);
+
   public:
 	Previewable();
 	virtual ~Previewable();
@@ -45,10 +66,16 @@ class Previewable : virtual public anObject, virtual public DoubleBBox
 	virtual bool HasOldPreview() { return modtime > previewtime; }
 	virtual bool CanRenderPreview() { return false; }
 	virtual LaxImage *GetPreview();
+	virtual LaxImage *GetPreviewAsync(unsigned long notify_window = 0, int priority = 0);
+	virtual bool PreviewPending() { return preview_job != nullptr; }
+	virtual void CancelPreview();
 	virtual int GeneratePreview(int width, int height);
+	virtual PreviewRender *NewPreviewRender() { return nullptr; }
 
 	virtual int renderToBufferImage(LaxImage *image) = 0; //return 0 for success
 	virtual int maxPreviewSize();
+
+	static int CheckPreviews();
 };
 
 
@@ -24,6 +24,7 @@
 
 #include <lax/resources.h>
 #include <lax/strmanip.h>
+#include <lax/lark.h>
 #include <lax/fileutils.h>
 #include <lax/misc.h>
 #include <lax/language.h>
@@ -367,6 +368,7 @@ ResourceType::ResourceType()
 {
 	default_icon=nullptr;
 	creation_func=nullptr;
+	name_id=lark_id_from_str(name, 1);
 }
 
 ResourceType::ResourceType(const char *nname, const char *nName, const char *ndesc, LaxImage *nicon)
@@ -374,6 +376,7 @@ ResourceType::ResourceType(const char *nname, const char *nName, const char *nde
 {
 	default_icon=nullptr;
 	creation_func=nullptr;
+	name_id=lark_id_from_str(nname, 1);
 }
 
 ResourceType::~ResourceType()
@@ -381,6 +384,14 @@ ResourceType::~ResourceType()
 	if (default_icon) default_icon->dec_count();
 }
 
+/*! Change name, and name_id with it. Types are found by name_id, so always rename through here.
+ */
+void ResourceType::Rename(const char *nname)
+{
+	makestr(name, nname);
+	name_id = lark_id_from_str(name, 1);
+}
+
 /*! Return the number of actual resources, excluding folders.
  */
 int ResourceType::NumResources()
@@ -868,10 +879,11 @@ int ResourceManager::RemoveResource(anObject *obj, const char *type)
 
 ResourceType *ResourceManager::FindType(const char *name)
 {
-	if (!name) return nullptr;
+	int id = lark_id_from_str(name, 0);
+	if (!id) return nullptr;
 
 	for (int c=0; c<types.n; c++) {
-		if (!strcmp(name,types.e[c]->name)) return types.e[c];
+		if (types.e[c]->name_id == id) return types.e[c];
 	}
 	return nullptr;
 }
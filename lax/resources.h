@@ -155,11 +155,13 @@ class ResourceType : public Resource
 	ResourceFromFileFunc from_file_func = nullptr;
 
 	LaxImage *default_icon;
+	int name_id; //lark id of name, for FindType(). Use Rename() to change name, so this stays current
 
 	ResourceType();
 	ResourceType(const char *nname, const char *nName, const char *ndesc, LaxImage *nicon);
 	virtual ~ResourceType();
 	virtual const char *whattype() { return "ResourceType"; }
+	virtual void Rename(const char *nname);
 
 	virtual int AddDir(const char *dir, int where);
 	virtual int RemoveDir(const char *dir);
@@ -22,6 +22,7 @@
 
 #include <lax/shortcuts.h>
 #include <lax/strmanip.h>
+#include <lax/lark.h>
 #include <lax/language.h>
 #include <lax/singletonkeeper.h>
 
@@ -187,6 +188,7 @@ WindowAction::WindowAction(int nid, const char *nname, const char *desc, const c
 {
 	id          = nid;
 	name        = newstr(nname);
+	name_id     = lark_id_from_str(nname, 1);
 	description = newstr(desc);
 	iconname    = newstr(icon);
 	mode        = nmode;
@@ -301,6 +303,7 @@ ShortcutHandler::ShortcutHandler(const char *areaname,ShortcutDefs *cuts, Window
 	deviceid(0)
 {
 	area=newstr(areaname);
+	area_id=lark_id_from_str(areaname, 1);
 	shortcuts=cuts;   if (cuts)    cuts->inc_count();
 	actions=wactions; if (actions) actions->inc_count();
 }
@@ -320,10 +323,17 @@ ShortcutHandler *ShortcutHandler::duplicate()
 	if (shortcuts) shortcuts->inc_count();
 	h->actions=actions;
 	if (actions) actions->inc_count();
-	makestr(h->area,area);
+	h->SetArea(area);
 	return h;
 }
 
+//! Set area, and area_id to match.
+void ShortcutHandler::SetArea(const char *narea)
+{
+	makestr(area, narea);
+	area_id = lark_id_from_str(narea, 1);
+}
+
 
 //----------action stack functions:
 
@@ -366,9 +376,10 @@ WindowAction *ShortcutHandler::FindAction(unsigned int key, unsigned int state,
 int ShortcutHandler::FindActionNumber(const char *actionname,int len)
 {
 	if (!actions) return -1;
-	if (len<0) len=strlen(actionname);
+	int nameid = lark_id_from_strn(actionname, len, 0);
+	if (!nameid) return -1;
 	for (int c=0; c<actions->n; c++) {
-		if (len==(int)strlen(actions->e[c]->name) && !strncmp(actionname,actions->e[c]->name,len)) return actions->e[c]->id;
+		if (actions->e[c]->name_id == nameid) return actions->e[c]->id;
 	}
 	return -1;
 }
@@ -612,7 +623,7 @@ int ShortcutManager::AddArea(const char *area, ShortcutDefs *cuts, WindowActions
 int ShortcutManager::AddArea(const char *area, ShortcutHandler *handler)
 {
 	if (!area) area = handler->area;
-	else if (!handler->area || strcmp(area, handler->area)) makestr(handler->area, area);
+	else if (!handler->area || strcmp(area, handler->area)) handler->SetArea(area);
 	shortcuts.push(handler);
 	return 0;
 }
@@ -646,9 +657,8 @@ int ShortcutManager::AreaParent(const char *area, const char *parent)
 //! Return a duplicate of an existing handler for area. The action and shortcut lists are refcounted, not duplicated.
 ShortcutHandler *ShortcutManager::NewHandler(const char *area)
 {
-	for (int c=0; c<shortcuts.n; c++) {
-		if (!strcmp(shortcuts.e[c]->area, area)) return shortcuts.e[c]->duplicate();
-	}
+	ShortcutHandler *handler = FindHandler(area);
+	if (handler) return handler->duplicate();
 
 	return NULL;
 }
@@ -1055,8 +1065,12 @@ char *ShortcutManager::ShortcutString(unsigned int key, unsigned long state, cha
  */
 ShortcutHandler *ShortcutManager::FindHandler(const char *area)
 {
+	 //areas are compared by lark id, so an unknown string can't match any
+	int id = lark_id_from_str(area, 0);
+	if (!id) return NULL;
+
 	for (int c=0; c<shortcuts.n; c++) {
-		if (!strcmp(area,shortcuts.e[c]->area)) return shortcuts.e[c];
+		if (shortcuts.e[c]->area_id == id) return shortcuts.e[c];
 	}
 	return NULL;
 }
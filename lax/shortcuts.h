@@ -88,6 +88,7 @@ class WindowAction : public Tagged
   public:
 	int id; // <- corresponds to shortcut->action
 	char *name; //such as for a menu line
+	int name_id; //lark id of name
 	char *description; //short description
 	char *iconname;
 	int mode; //win_mode window must be in for action to be acted on
@@ -141,11 +142,13 @@ class ShortcutHandler : public Laxkit::anObject
 	int deviceid; //id of the active keyboard
   public:
 	char *area;
+	int area_id; //lark id of area, use SetArea() to keep them matched
 
 	ShortcutHandler(const char *areaname=NULL, ShortcutDefs *cuts=NULL, WindowActions *wactions=NULL);
 	virtual ~ShortcutHandler(); 
 	virtual ShortcutHandler *duplicate();
 	virtual const char *whattype() { return "ShortcutHandler"; }
+	virtual void SetArea(const char *narea);
 
 	virtual int NumActions();
 	virtual WindowAction *Action(int i);
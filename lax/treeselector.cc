@@ -91,6 +91,13 @@ TreeSelector::ColumnInfo::~ColumnInfo()
  * the panner wholebox (min and max) is the bounding box of all the items,
  * and the selbox (start and end) is inrect minus the pads. However, any shifting changes 
  * the panner's selbox, but this does not trigger any change in inrect.
+ *
+ * For very big trees, use TREESEL_VIRTUAL. Then all rows are assumed to be the same height, so
+ * visibleitems is just a list of pointers, and rows are only measured with getitemextent() when
+ * item() is first asked for them, which is normally when they scroll near the viewport. Only rows
+ * in view plus TREESEL_VIRTUAL_OVERSCAN above and below are laid out and drawn, the total height
+ * is just the number of rows times rowstep, and the width is the widest row measured so far.
+ * Expand() and Collapse() splice rows in and out of visibleitems instead of rebuilding it.
  */
 /*! \var MenuInfo *TreeSelector::menu
  * \brief Stores the actual menu items.
@@ -200,6 +207,8 @@ void TreeSelector::base_init()
 	leading      = 1;
 	menustyle    = 0;
 	needtobuildcache = 1;
+	rowstep      = 0;
+	maxrowwidth  = 0;
 	iwidth       = 10;
 	iconwidth    = 0; //default width of icon, even if icon missing, as fraction of textheight, so 1 == textheight
 	firsttime    = 1;
@@ -235,6 +244,7 @@ bool TreeSelector::SetStyle(unsigned long long style, int newvalue)
 {
 	if (newvalue) menustyle |= style;
 	else menustyle &= ~style;
+	if (style & TREESEL_VIRTUAL) needtobuildcache = 1;
 	return menustyle & style;
 }
 
@@ -426,7 +436,29 @@ int TreeSelector::numItems()
 MenuItem *TreeSelector::item(int i,char skipcache)
 {
 	if (i<0 || i>=visibleitems.menuitems.n) return NULL;
-	return visibleitems.menuitems.e[i];
+	MenuItem *mitem = visibleitems.menuitems.e[i];
+
+	if (menustyle & TREESEL_VIRTUAL) {
+		 //rows move around when things are expanded or collapsed, so always place,
+		 //but only measure the first time the row is needed
+		mitem->x = 0;
+		mitem->y = i * rowstep;
+		mitem->h = rowstep - 1;
+
+		if (mitem->w < 0) {
+			double ww, hh;
+			for (MenuItem *ii = mitem; ii; ii = ii->nextdetail) {
+				getitemextent(ii, &ww,&hh, NULL,NULL);
+				ii->x = 0;
+				ii->y = mitem->y;
+				ii->w = ww;
+				ii->h = mitem->h;
+			}
+			if (mitem->w > maxrowwidth) maxrowwidth = mitem->w;
+		}
+	}
+
+	return mitem;
 }
 
 //! Programs call this to select index which of visible items.
@@ -523,8 +555,17 @@ int TreeSelector::DeselectAll()
 int TreeSelector::Expand(int which)
 {
 	if (which<0 || which>=visibleitems.how_many(0)) return 0;
-	visibleitems.menuitems.e[which]->state|=MENU_OPEN;
-	needtobuildcache=1;
+
+	MenuItem *mitem = visibleitems.menuitems.e[which];
+	if ((menustyle & TREESEL_VIRTUAL) && !needtobuildcache) {
+		if (!mitem->isOpen()) {
+			mitem->state |= MENU_OPEN;
+			if (mitem->hasSub() && mitem->GetSubmenu()) insertRows(which+1, mitem->GetSubmenu());
+		}
+	} else {
+		mitem->state |= MENU_OPEN;
+		needtobuildcache = 1;
+	}
 	needtodraw=1;
 	return 1;
 }
@@ -545,7 +586,8 @@ int TreeSelector::Collapse(int which)
 	}
 
 	parent->state &= ~MENU_OPEN;
-	needtobuildcache = 1;
+	if ((menustyle & TREESEL_VIRTUAL) && !needtobuildcache) removeRows(which+1, parent);
+	else needtobuildcache = 1;
 	needtodraw = 1;
 	return 1;
 }
@@ -836,6 +878,9 @@ double TreeSelector::getgraphicextent(MenuItem *mitem, double *w, double *h)
  * set in menustyle, then that width is not included.
  *
  * Return the maximum height in h_ret.
+ *
+ * In TREESEL_VIRTUAL mode, only rows near the viewport are measured, and the width
+ * returned is for the widest row measured so far.
  */
 int TreeSelector::findmaxwidth(int s,int e, int *h_ret)
 {
@@ -854,6 +899,20 @@ int TreeSelector::findmaxwidth(int s,int e, int *h_ret)
 	if (pad < 0)  pad  = textheight * .3;
 	if (padg < 0) padg = textheight * .2;
 
+	if (menustyle & TREESEL_VIRTUAL) {
+		int first, last;
+		visibleRange(&first, &last);
+		if (s < first) s = first;
+		if (e > last) e = last;
+		for (int c = s; c <= e; c++) {
+			mitem = item(c); //measures if necessary
+			getgraphicextent(mitem, &ww, &hh);
+			if (hh > h) h = hh;
+		}
+		if (h_ret) *h_ret = h;
+		return maxrowwidth + 2*pad + iwidth;
+	}
+
 	for (int c = s; c <= e; c++) {
 		mitem = item(c);
 		getgraphicextent(mitem, &ww, &hh);
@@ -883,6 +942,7 @@ int TreeSelector::findColumnWidth(int which)
 {
 	int s = 0;
 	int e = numItems()-1;
+	if (menustyle & TREESEL_VIRTUAL) visibleRange(&s, &e); //don't measure the whole tree
 	if (s<0 || e<0) return 0;
 
 	double w=0,h=0,ww=0,hh=0,t;
@@ -915,18 +975,30 @@ int TreeSelector::findColumnWidth(int which)
 }
 
 //! Basically RebuildCache(), then update the panner.
+/*! In TREESEL_VIRTUAL mode, Expand() and Collapse() keep visibleitems up to date,
+ * so the cache is only rebuilt when needtobuildcache is set.
+ */
 void TreeSelector::arrangeItems()
 {
-	RebuildCache();
+	if (needtobuildcache || !(menustyle & TREESEL_VIRTUAL)) RebuildCache();
+	arrangePanner();
+}
 
+//! Set the panner wholebox to the extent of visibleitems, and the selbox to inrect at its top left.
+void TreeSelector::arrangePanner()
+{
 	IntRectangle wholerect; //rectangle around all items. 0,0 is 0,0 for first item
 	wholerect.x = wholerect.y = 0;
 	wholerect.width = findmaxwidth(0,-1,NULL);
 
 	if (visibleitems.menuitems.n == 0) return;
 
-	MenuItem *item = visibleitems.menuitems.e[visibleitems.menuitems.n-1];
-	wholerect.height = item->y + item->h;
+	if (menustyle & TREESEL_VIRTUAL) {
+		wholerect.height = visibleitems.menuitems.n * rowstep - 1;
+	} else {
+		MenuItem *item = visibleitems.menuitems.e[visibleitems.menuitems.n-1];
+		wholerect.height = item->y + item->h;
+	}
 	IntRectangle selbox = inrect; //inrect has window coordinates. selbox is screen area mapped to wholerect space
 	selbox.x -= inrect.x;     //selbox width and height should be same w and h as inrect
 	selbox.y -= inrect.y;
@@ -952,7 +1024,17 @@ void TreeSelector::arrangeItems()
 int TreeSelector::RebuildCache()
 {
 	visibleitems.Flush();
-	addToCache(0, menu, 0);
+
+	if (menustyle & TREESEL_VIRTUAL) {
+		 //all rows get the height of text or icon, whichever is bigger, like in getitemextent()
+		double gw, gh;
+		getgraphicextent(NULL, &gw, &gh);
+		int th = UIScale() * win_themestyle->normal->textheight();
+		rowstep = (gh > th ? gh : th) + 1;
+		maxrowwidth = 0;
+		insertRows(0, menu);
+
+	} else addToCache(0, menu, 0);
 	needtobuildcache = 0;
 
 	if (ccuritem >= numItems()) {
@@ -1011,6 +1093,99 @@ int TreeSelector::addToCache(int indent,MenuInfo *mmenu, int cury)
 	return cury;
 }
 
+//! Count the shown items of mmenu and of its open submenus.
+static int countShown(MenuInfo *mmenu)
+{
+	int n = 0;
+	MenuItem *i;
+	for (int c=0; c<mmenu->n(); c++) {
+		i = mmenu->e(c);
+		if (i->hidden() == 1) continue;
+		n++;
+		if (i->hasSub() && i->isOpen() && i->GetSubmenu()) n += countShown(i->GetSubmenu());
+	}
+	return n;
+}
+
+//! Put the shown items of mmenu and of its open submenus in rows, in display order, marked as not measured.
+static int fillShown(MenuInfo *mmenu, MenuItem **rows)
+{
+	int n = 0;
+	MenuItem *i;
+	for (int c=0; c<mmenu->n(); c++) {
+		i = mmenu->e(c);
+		if (i->hidden() == 1) continue;
+		i->w = -1;
+		rows[n++] = i;
+		if (i->hasSub() && i->isOpen() && i->GetSubmenu()) n += fillShown(i->GetSubmenu(), rows+n);
+	}
+	return n;
+}
+
+//! Insert the shown items of mmenu and its open submenus into visibleitems at index where, for TREESEL_VIRTUAL.
+/*! Only pointers are moved around here, in one go. The rows are measured later by item().
+ * Returns the number of rows added.
+ */
+int TreeSelector::insertRows(int where, MenuInfo *mmenu)
+{
+	if (!mmenu) return 0;
+	int num = countShown(mmenu);
+	if (!num) return 0;
+
+	PtrStack<MenuItem> &rows = visibleitems.menuitems;
+	if (where < 0 || where > rows.n) where = rows.n;
+	if (rows.n + num > rows.Allocated()) rows.Allocate(rows.n + num + rows.n/4);
+
+	memmove(rows.e       + where + num, rows.e       + where, (rows.n - where) * sizeof(MenuItem*));
+	memmove(rows.islocal + where + num, rows.islocal + where, (rows.n - where) * sizeof(char));
+	fillShown(mmenu, rows.e + where);
+	memset(rows.islocal + where, 0, num); //same as AddItemAsIs(i,0)
+	rows.n += num;
+
+	return num;
+}
+
+//! Remove rows starting at index where that are under parent, for TREESEL_VIRTUAL.
+/*! Returns the number of rows removed.
+ */
+int TreeSelector::removeRows(int where, MenuItem *parent)
+{
+	PtrStack<MenuItem> &rows = visibleitems.menuitems;
+	if (where < 0) where = 0;
+
+	int end = where;
+	while (end < rows.n && rows.e[end]->hasParent(parent)) end++;
+	int num = end - where;
+	if (!num) return 0;
+
+	memmove(rows.e       + where, rows.e       + end, (rows.n - end) * sizeof(MenuItem*));
+	memmove(rows.islocal + where, rows.islocal + end, (rows.n - end) * sizeof(char));
+	rows.n -= num;
+
+	if (ccuritem >= numItems()) {
+		ccuritem    = curitem  = numItems()-1;
+		ccurdetail  = ccurflag = -1;
+		curmenuitem = item(ccuritem);
+	}
+
+	return num;
+}
+
+//! Find the rows in view, plus TREESEL_VIRTUAL_OVERSCAN above and below.
+/*! This is only meaningful for TREESEL_VIRTUAL, where all rows are rowstep high.
+ * Returns the number of rows in the range, which might be 0.
+ */
+int TreeSelector::visibleRange(int *first, int *last)
+{
+	int step = (rowstep > 0 ? rowstep : 1);
+	*first = -offsety / step - TREESEL_VIRTUAL_OVERSCAN;
+	*last  = (inrect.height - offsety) / step + TREESEL_VIRTUAL_OVERSCAN;
+	if (*first < 0) *first = 0;
+	if (*last >= numItems()) *last = numItems()-1;
+	if (*last < *first) return 0;
+	return *last - *first + 1;
+}
+
 //! Find extent of text+graphic+(pad between graphic and text).
 /*! If the graphic extent is 0, then the pad is not included.
  * w and h must not be NULL! Note that the y extent is the actual
@@ -1106,8 +1281,20 @@ void TreeSelector::Refresh()
 	double th = textheight;
 	int indent = 0;
 	flatpoint offset(offsetx + inrect.x, offsety + inrect.y); //from window 0,0
-	int n = 0;
-	DrawItems(indent,menu,n,offset);
+	if (menustyle & TREESEL_VIRTUAL) {
+		int first, last;
+		int oldwidth = maxrowwidth;
+		if (visibleRange(&first, &last)) DrawRows(first, last, offset);
+		if (maxrowwidth > oldwidth) {
+			 //rows just scrolled into view were wider, so widen the panner without moving it
+			int w = findmaxwidth(0,-1,NULL);
+			panner->SetSize(1, 0, w-1, (w < inrect.width ? w : inrect.width) - 1);
+			offsetx = -panner->GetCurPos(1);
+		}
+	} else {
+		int n = 0;
+		DrawItems(indent,menu,n,offset);
+	}
 
 
 	 // Draw title if necessary
@@ -1244,6 +1431,98 @@ int TreeSelector::DrawItems(int indent, MenuInfo *mmenu, int &n, flatpoint offse
 	return yy;
 }
 
+//! Whether i is the last item in its menu that is not hidden.
+static bool lastShown(MenuItem *i)
+{
+	MenuInfo *m = i->parent;
+	if (!m) return true;
+	for (int c = m->menuitems.n-1; c >= 0; c--) {
+		if (m->menuitems.e[c]->hidden() == 1) continue;
+		return m->menuitems.e[c] == i;
+	}
+	return true;
+}
+
+/*! Draw rows first to last of visibleitems, for TREESEL_VIRTUAL. This looks the same
+ * as DrawItems(), but instead of recursing through the whole menu, the indent and the tree
+ * lines that pass through each row are figured out from the item's parents.
+ *
+ * offset is screen offset.
+ */
+void TreeSelector::DrawRows(int first, int last, flatpoint offset)
+{
+	Displayer *dp = GetDisplayer();
+
+	MenuItem *i, *ii;
+	MenuItem *focused = item(ccuritem);
+	int yy, indent;
+	double x;
+	unsigned long oddcolor = coloravg(win_themestyle->bg,win_themestyle->fg, .05);
+	unsigned long linecolor = win_themestyle->fg.Pixel();
+	unsigned long col;
+
+	int tree_offset=0; //offset of tree lines due to being in a particular column
+	if (columns.n && tree_column!=0 && tree_column<columns.n) {
+		tree_offset = columns.e[tree_column]->pos;
+	}
+
+	for (int r = first; r <= last; r++) {
+		i = item(r);
+		yy = i->y + i->h/2; //so yy in center of row
+
+		indent = 0;
+		for (ii = i; ii->parent && ii->parent->parent; ii = ii->parent->parent) indent++;
+
+		 //draw background, odd and even as counted from 1 like DrawItems()
+		if (i->isSelected()) {
+			col = win_themestyle->bghl.Pixel();
+			if (r%2 == 1) col = coloravg(col, win_themestyle->fg, .05);
+
+		} else {
+			if (r%2 == 1 && !HasStyle(TREESEL_FLAT_COLOR)) col = oddcolor;
+			else col = win_themestyle->bg.Pixel();
+		}
+		if (i == focused) col = coloravg(col,win_themestyle->fg,.1);
+		dp->NewFG(col);
+		dp->drawrectangle(offset.x+0,offset.y+i->y, win_w,i->h, 1);
+
+		dp->NewFG(linecolor);
+		if (!HasStyle(TREESEL_NO_LINES)) {
+			 //vertical lines of this and any parent levels that continue below this row
+			ii = i;
+			for (int level = indent-1; level >= 0; level--) {
+				x = tree_offset+offset.x+(.5+level)*iwidth;
+				if (!lastShown(ii)) dp->drawline(x,offset.y+i->y, x,offset.y+i->y+i->h+1);
+				else if (ii == i) dp->drawline(x,offset.y+i->y, x,offset.y+yy);
+				ii = ii->parent->parent;
+			}
+
+			 //small horizontal dash for current item
+			if (indent > 0) {
+				dp->drawline(tree_offset+offset.x+(indent-.5)*iwidth,offset.y+yy, tree_offset+offset.x+indent*iwidth,offset.y+yy);
+			}
+
+			 //start of the line down to the first child
+			if (i->hasSub() && i->isOpen() && r < numItems()-1 && visibleitems.menuitems.e[r+1]->parent == i->GetSubmenu()) {
+				x = tree_offset+offset.x+(.5+indent)*iwidth;
+				dp->drawline(x,offset.y+yy, x,offset.y+i->y+i->h+1);
+			}
+		}
+
+		double suboffset = iwidth;
+		if (i->hasSub()) {
+			if (HasStyle(TREESEL_SUB_ON_RIGHT)) {
+				suboffset = 0;
+				drawSubIndicator(i, offset.x+inrect.width - iwidth,offset.y+yy, i->isSelected());
+			} else {
+				drawSubIndicator(i, tree_offset+offset.x+indent*iwidth,offset.y+yy, i->isSelected());
+			}
+		}
+
+		drawItemContents(i, offset.x,suboffset,offset.y, 0, (indent+(HasStyle(TREESEL_NO_LINES) ? 0 : 1))*iwidth);
+	}
+}
+
 //! Draws a submenu indicator centered on x,y, and width=iwidth, height=textheight+leading.
 void TreeSelector::drawSubIndicator(MenuItem *mitem,int x,int y, int selected)
 {
@@ -1744,6 +2023,7 @@ int TreeSelector::CharInput(unsigned int ch,const char *buffer,int len,unsigned
 
 	} else if (ch == LAX_Left || (ch=='-' && !HasStyle(TREESEL_LIVE_SEARCH))) {  // Collapse current item, or all if control
 		if (state&ControlMask) {
+			needtobuildcache = 1; //one rebuild, rather than splicing for each
 			for (int c=visibleitems.n()-1; c>=0; c--) {
 				if (c>=visibleitems.n()) continue;
 				if (visibleitems.e(c)->isOpen()) Collapse(c);
@@ -1761,6 +2041,7 @@ int TreeSelector::CharInput(unsigned int ch,const char *buffer,int len,unsigned
 
 	} else if (ch == LAX_Right || ((ch=='=' || ch=='+') && !HasStyle(TREESEL_LIVE_SEARCH))) {  // Expand current item, or all if control
 		if (state&ControlMask) {
+			needtobuildcache = 1; //one rebuild, rather than splicing for each
 			for (int c=0; c<visibleitems.n(); c++) {
 				if (visibleitems.e(c)->hasSub()) Expand(c);
 			}
@@ -1791,9 +2072,9 @@ int TreeSelector::CharInput(unsigned int ch,const char *buffer,int len,unsigned
 		} else {
 			 //select all
 			for (int c=0; c<numItems(); c++) {
-				selection.push(item(c),0);
-				item(c)->state&=~(LAX_ON|LAX_OFF|MENU_SELECTED); 
-				item(c)->state|=LAX_ON|MENU_SELECTED;
+				selection.push(visibleitems.e(c),0);
+				visibleitems.e(c)->state&=~(LAX_ON|LAX_OFF|MENU_SELECTED); 
+				visibleitems.e(c)->state|=LAX_ON|MENU_SELECTED;
 			}
 			if (menustyle&(TREESEL_ONE_ONLY|TREESEL_ZERO_OR_ONE)) addselect(ccuritem,0);
 		}
@@ -2139,6 +2420,13 @@ int TreeSelector::findItem(int x,int y, int *onsub, int *ondetail, int *onflag)
 	MenuItem *i;
 	int which = -1;
 	int itemgap = 1;
+	if (menustyle & TREESEL_VIRTUAL) {
+		 //all rows are the same height
+		if (y < 0 || e < 0 || rowstep <= 0) return -1;
+		which = y / rowstep;
+		if (which > e) return e+1;
+		s = e+1; //skip the search
+	}
 	while (e >= s) {
 		i = item(s);
 
@@ -2424,7 +2712,18 @@ int TreeSelector::movescreen(int dx,int dy)
 
 	 // find an item that is on screen
 	MenuItem *i=NULL;
-	if (itemrect.y<inrect.y) { 
+	if ((menustyle & TREESEL_VIRTUAL) && rowstep > 0) {
+		 //rows are all the same height, so no need to search
+		if (itemrect.y<inrect.y) {
+			int r = (-offsety + rowstep-1) / rowstep;
+			if (r > ccuritem) ccuritem = r;
+		} else if (itemrect.y+itemrect.height>inrect.y+inrect.height) {
+			int r = (inrect.height - offsety + 1) / rowstep - 1;
+			if (r < ccuritem) ccuritem = (r < 0 ? 0 : r);
+		}
+		if (ccuritem >= numItems()) ccuritem = numItems()-1;
+
+	} else if (itemrect.y<inrect.y) { 
 		 //search below
 		for (int ii=ccuritem; ii<numItems(); ii++) {
 			i=item(ii);
@@ -2509,6 +2808,7 @@ void TreeSelector::SetLineHeight(int ntotalheight,int newleading, char forcearra
 	 if (ntotalheight <= 0 || newleading < 0) return;
 	 textheight = ntotalheight - newleading;
 	 iwidth     = textheight;
+	 if (menustyle & TREESEL_VIRTUAL) needtobuildcache = 1; //rows need remeasuring
 	 leading    = newleading;
 	 padg       = textheight / 2;
 	 if (forcearrange == 1) syncWindows();  // syncwindows calls arrangeItems...
@@ -2568,6 +2868,7 @@ void TreeSelector::adjustinrect()
 //! This is meant to be called when the window is going, but you just added or removed a bunch of stuff.
 void TreeSelector::Sync()
 {
+	needtobuildcache = 1;
 	arrangeItems();
 	needtodraw=1;
 }
@@ -2631,6 +2932,8 @@ int TreeSelector::WrapToPosition(int screen_x, int screen_y, int screen, anXWind
 
 	if (columns.n) {
 		for (int c=0; c<columns.n; c++) ew += columns.e[c]->width;
+	} else if (menustyle & TREESEL_VIRTUAL) {
+		ew = maxrowwidth; //of the rows that fit on screen, which arrangeItems() just measured
 	} else {
 		for (int c=0; c<visibleitems.menuitems.n; c++) {
 			MenuItem *im = visibleitems.menuitems.e[c];
@@ -2640,7 +2943,9 @@ int TreeSelector::WrapToPosition(int screen_x, int screen_y, int screen, anXWind
 	}
 
 	double fullheight = 0;
-	for (int c=0; c<visibleitems.menuitems.n; c++) {
+	if (menustyle & TREESEL_VIRTUAL) {
+		if (numItems()) fullheight = numItems() * rowstep - 1;
+	} else for (int c=0; c<visibleitems.menuitems.n; c++) {
 		MenuItem *im = visibleitems.menuitems.e[c];
 		if (im->hidden() == 1) continue;
 		fullheight = im->y + im->h; //full height is just bottom edge of last visible item
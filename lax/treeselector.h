@@ -83,9 +83,13 @@ namespace Laxkit {
 
 #define TREESEL_SUB_FOLDER           (1LL<<39) //arrow graphic is a little folder
 #define TREESEL_SUB_ON_RIGHT         (1LL<<40) //draw the submenu indicator on far right side
+#define TREESEL_VIRTUAL              (1LL<<41) //all rows same height, only lay out rows near the viewport
 
 //... remember that the buck stops with (1<<63)
 
+ //how many rows above and below the viewport to lay out in TREESEL_VIRTUAL mode
+#define TREESEL_VIRTUAL_OVERSCAN     8
+
 
 
 
@@ -120,6 +124,8 @@ class TreeSelector : public ScrolledWindow
 
 	int needtobuildcache;
 	MenuInfo visibleitems;
+	int rowstep; //row height + gap, for TREESEL_VIRTUAL
+	int maxrowwidth; //widest row measured so far, for TREESEL_VIRTUAL
 
 	virtual void adjustinrect();
 	virtual void findoutrect();
@@ -141,6 +147,7 @@ class TreeSelector : public ScrolledWindow
 	virtual int findColumn(int x);
 	virtual int findRect(int c,IntRectangle *itemspot);
 	virtual void arrangeItems();
+	virtual void arrangePanner();
 	virtual void syncWindows();
 	virtual int makeinwindow();
 	virtual int numItems();
@@ -150,7 +157,11 @@ class TreeSelector : public ScrolledWindow
 	virtual char ToggleChar(char current);
 
 	virtual int addToCache(int indent,MenuInfo *menu, int cury);
+	virtual int insertRows(int where, MenuInfo *mmenu);
+	virtual int removeRows(int where, MenuItem *parent);
+	virtual int visibleRange(int *first, int *last);
 	virtual int DrawItems(int indent, MenuInfo *item, int &n, flatpoint offset);
+	virtual void DrawRows(int first, int last, flatpoint offset);
 	virtual void drawItemContents(MenuItem *i,int offset_x,int suboffset,int offset_y, int fill, int indent);
 	virtual void drawarrow(int x,int y,int r,int type);
 
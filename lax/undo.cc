@@ -26,6 +26,8 @@
 #include <lax/language.h>
 
 #include <sys/times.h>
+#include <unistd.h>
+#include <zlib.h>
 
 
 #include <iostream>
@@ -84,6 +86,12 @@ UndoData::UndoData(int nisauto)
     context     = NULL;
     direction   = UNDOABLE;
     prev = next = NULL;
+
+	coalesce_key = 0;
+	compressed   = 0;
+	undo_size    = 0;
+	packed       = NULL;
+	packed_len   = unpacked_len = 0;
 }
 
 /*! If prev==NULL, then delete next, else just remove *this from chain.
@@ -108,6 +116,7 @@ UndoData::~UndoData()
 
 	if (dynamic_cast<anObject*>(context)) dynamic_cast<anObject*>(context)->dec_count();
 	delete[] description;
+	delete[] packed;
 }
 
 int UndoData::isUndoable()
@@ -123,7 +132,70 @@ int UndoData::isRedoable()
  */
 int UndoData::Size()
 {
-	return 4*sizeof(Undoable*) + 2*sizeof(int) + 2*sizeof(long) + (description ? strlen(description) : 0);
+	return 4*sizeof(Undoable*) + 2*sizeof(int) + 2*sizeof(long) + (description ? strlen(description) : 0) + packed_len;
+}
+
+/*! \fn int UndoData::Coalesce(UndoData *newer)
+ * Called from UndoManager::AddUndo() when newer has the same nonzero coalesce_key and context
+ * as this, and was added soon enough after. If this can absorb newer, so that undoing this goes back
+ * to before this, and redoing goes to after newer, then do so and return 1, and newer will be deleted.
+ * Otherwise return 0 and newer is added as usual. Default is return 0.
+ */
+
+/*! \fn int UndoData::Compress()
+ * Called by UndoManager for undos that are far enough back that they are unlikely to be needed soon.
+ * Subclasses can pack away their bulky data, usually with PackBytes(), and return 1.
+ * Return 0 to leave things as they are. Decompress() is called before the undo is used again.
+ * Default is return 0.
+ */
+
+/*! \fn int UndoData::Decompress()
+ * Restore whatever Compress() packed away. Return 0 for success, nonzero for error.
+ */
+
+/*! Compress len bytes with zlib into packed, for use in Compress().
+ * Returns 1 for packed, or 0 if it would not save anything, in which case nothing is changed.
+ */
+int UndoData::PackBytes(const char *bytes, long len)
+{
+	if (!bytes || len <= 0) return 0;
+
+	uLongf size = compressBound(len);
+	Bytef *buffer = new Bytef[size];
+	if (compress2(buffer, &size, (const Bytef*)bytes, len, Z_BEST_SPEED) != Z_OK || (long)size >= len) {
+		delete[] buffer;
+		return 0;
+	}
+
+	 //compressBound() is bigger than len, so copy down to what is actually used
+	delete[] packed;
+	packed = new char[size];
+	memcpy(packed, buffer, size);
+	delete[] buffer;
+	packed_len   = size;
+	unpacked_len = len;
+	return 1;
+}
+
+/*! Uncompress and free what PackBytes() made. Returns a new[] char array that calling code
+ * must delete[], or NULL if there was nothing packed, or on error.
+ */
+char *UndoData::UnpackBytes(long *len_ret)
+{
+	if (!packed) return NULL;
+
+	uLongf size = unpacked_len;
+	char *bytes = new char[unpacked_len];
+	if (uncompress((Bytef*)bytes, &size, (const Bytef*)packed, packed_len) != Z_OK || (long)size != unpacked_len) {
+		delete[] bytes;
+		return NULL;
+	}
+
+	delete[] packed;
+	packed = NULL;
+	packed_len = unpacked_len = 0;
+	if (len_ret) *len_ret = size;
+	return bytes;
 }
 
 /*! Return which UndoData we are on by counting self and all self->prev.
@@ -159,7 +231,6 @@ MetaUndoData::MetaUndoData(Undoable *context, int ntype, int nisauto, const char
 
 MetaUndoData::~MetaUndoData()
 {
-	delete[] description;
 }
 
 const char *MetaUndoData::Description()
@@ -167,16 +238,50 @@ const char *MetaUndoData::Description()
 	return description;
 }
 
+//! Rough bytes used by att and all its subattributes.
+static int meta_size(Attribute *att)
+{
+	//note this is a naive approximation.. checks only stringlen, not allocated.
+	int n = sizeof(Attribute) + (att->name ? strlen(att->name) : 0) + (att->value ? strlen(att->value) : 0)
+		  + (att->comment ? strlen(att->comment) : 0) + att->attributes.n * (sizeof(Attribute*) + 1);
+	for (int c=0; c<att->attributes.n; c++) n += meta_size(att->attributes.e[c]);
+	return n;
+}
+
 int MetaUndoData::Size() //in bytes of this whole undo instanc
 {
-	int n = (description ? strlen(description) : 0) + 4*meta.attributes.n;
+	return sizeof(MetaUndoData) + (description ? strlen(description) : 0) + meta_size(&meta) + packed_len;
+}
 
-	//note this is a very naive approximation.. checks only stringlen, not allocated.
-	for (int c=0; c<meta.attributes.n; c++) {
-		Attribute *att = meta.attributes.e[c];
-		n += (att->name ? strlen(att->name) : 0) + (att->value ? strlen(att->value) : 0) + (att->comment ? strlen(att->comment) : 0);
-	}
-	return n;
+/*! Pack meta away in the binary attribute format.
+ */
+int MetaUndoData::Compress()
+{
+	if (!meta.attributes.n) return 0;
+
+	char *buffer = NULL;
+	size_t len = 0;
+	FILE *f = open_memstream(&buffer, &len);
+	if (!f) return 0;
+	int status = DumpAttributeToBinary(f, &meta);
+	fclose(f);
+
+	if (status == 0 && PackBytes(buffer, len)) meta.clear();
+	else status = 1;
+	free(buffer);
+	return status == 0;
+}
+
+int MetaUndoData::Decompress()
+{
+	long len = 0;
+	char *buffer = UnpackBytes(&len);
+	if (!buffer) return 1;
+
+	int error = 0;
+	BinaryToAttribute(buffer, len, NULL, &meta, &error);
+	delete[] buffer;
+	return error;
 }
 
 
@@ -185,12 +290,26 @@ int MetaUndoData::Size() //in bytes of this whole undo instanc
 //--------------------------------------------- UndoManager ------------------------------------------
 /*! \class UndoManager
  * \brief Simple class to keep track of undoes.
+ *
+ * History is kept within a budget, see SetLimits(). By default there is no limit on
+ * the number of undos, and UNDO_DEFAULT_MAX_BYTES on their total UndoData::Size().
+ * Oldest undos are removed first, whole auto groups at a time, and the current one is always kept.
+ *
+ * Older undos can also be compressed, see SetCompression(), and a stream of similar undos
+ * can be merged into one, see SetCoalesceTime(). Stats() tells how it is all going.
  */
 
 	
 UndoManager::UndoManager()
 {
-	head=current=NULL;
+	head = current = last_added = NULL;
+
+	max_count      = 0;
+	max_bytes      = UNDO_DEFAULT_MAX_BYTES;
+	compress_after = 0;
+	coalesce_time  = 0;
+	num_entries    = 0;
+	memset(&stats, 0, sizeof(stats));
 }
 
 UndoManager::~UndoManager()
@@ -198,7 +317,141 @@ UndoManager::~UndoManager()
 	if (head) delete head;
 }
 
+/*! Keep at most max_undos undos, and at most max_size bytes of them, as reported
+ * by UndoData::Size(). Use 0 for no limit. Older undos are removed right away if necessary.
+ */
+void UndoManager::SetLimits(int max_undos, long max_size)
+{
+	max_count = (max_undos > 0 ? max_undos : 0);
+	max_bytes = (max_size > 0 ? max_size : 0);
+	Evict();
+}
+
+/*! Call UndoData::Compress() on undos that are more than after_steps back from the current one.
+ * 0 means never compress.
+ */
+void UndoManager::SetCompression(int after_steps)
+{
+	compress_after = (after_steps > 0 ? after_steps : 0);
+	CompressCold();
+	Evict();
+}
+
+/*! Undos added within ms milliseconds of the last one with the same nonzero
+ * UndoData::coalesce_key and context may be merged with UndoData::Coalesce().
+ * This is good for things like a series of nudges or drags of the same object.
+ * 0 means never coalesce, which is the default.
+ */
+void UndoManager::SetCoalesceTime(int ms)
+{
+	coalesce_time = (ms > 0 ? ms : 0);
+}
+
+//! Return current statistics about how many undos there are, and how much memory they use.
+const UndoStats &UndoManager::Stats()
+{
+	stats.num_undoable = stats.num_redoable = stats.num_compressed = 0;
+	stats.compressed_bytes = stats.bytes_saved = 0;
+
+	for (UndoData *data = head; data; data = data->next) {
+		if (data->isUndoable()) stats.num_undoable++;
+		else stats.num_redoable++;
+
+		if (data->compressed > 0) {
+			stats.num_compressed++;
+			stats.compressed_bytes += data->undo_size;
+			stats.bytes_saved += data->unpacked_len - data->packed_len;
+		}
+	}
+	return stats;
+}
+
+//! Update the cached size of data, and the running total.
+void UndoManager::Account(UndoData *data)
+{
+	stats.bytes -= data->undo_size;
+	data->undo_size = data->Size();
+	stats.bytes += data->undo_size;
+}
+
+//! Remove data from running totals, just before it is deleted.
+void UndoManager::Forget(UndoData *data)
+{
+	stats.bytes -= data->undo_size;
+	num_entries--;
+	if (data == last_added) last_added = NULL;
+}
+
+/*! Remove the oldest undos until there are no more than max_count, totalling no more than max_bytes.
+ * Undos are removed with any auto undos that follow them, and the current undo is never removed.
+ *
+ * Returns the number of undos removed.
+ */
+int UndoManager::Evict()
+{
+	int n = 0;
+
+	while (head && current && head != current
+			&& ((max_count > 0 && num_entries > max_count) || (max_bytes > 0 && stats.bytes > max_bytes))) {
+		 //auto undos must go with the one before them
+		UndoData *last = head;
+		while (last->next && last->next->isauto && last != current) last = last->next;
+		if (last == current) break;
+
+		UndoData *newhead = last->next;
+		last->next = NULL;
+		newhead->prev = NULL;
+
+		for (UndoData *data = head; data; data = data->next) {
+			stats.num_evicted++;
+			stats.bytes_evicted += data->undo_size;
+			Forget(data);
+			n++;
+		}
+		delete head; //deletes the whole detached chain
+		head = newhead;
+	}
+
+	return n;
+}
+
+//! Compress data if it has not been tried yet. Returns 1 if it was already tried, else 0.
+static int undo_freeze(UndoData *data)
+{
+	if (data->compressed) return 1;
+	data->compressed = (data->Compress() ? 1 : -1);
+	return 0;
+}
+
+/*! Compress undos more than compress_after steps back from current, and redos
+ * more than compress_after steps ahead. Ones further away are done before nearer ones, so this
+ * stops at the first one that has already been tried. Returns the number compressed.
+ */
+int UndoManager::CompressCold()
+{
+	if (compress_after <= 0) return 0;
+
+	int n = 0, steps = 0;
+	for (UndoData *data = current; data; data = data->prev, steps++) {
+		if (steps < compress_after) continue;
+		if (undo_freeze(data)) break;
+		Account(data);
+		if (data->compressed > 0) n++;
+	}
+
+	steps = 0;
+	for (UndoData *data = (current ? current->next : head); data; data = data->next, steps++) {
+		if (steps < compress_after) continue;
+		if (undo_freeze(data)) break;
+		Account(data);
+		if (data->compressed > 0) n++;
+	}
+	return n;
+}
+
 /*! Takes possession of data, and will delete it when done.
+ *
+ * Returns 0 for added, or 1 for data was merged into the previous undo and deleted, see SetCoalesceTime().
  */
 int UndoManager::AddUndo(UndoData *data)
 {
@@ -208,12 +461,30 @@ int UndoManager::AddUndo(UndoData *data)
 	tms tms_;
 	data->time=times(&tms_);
 
+	 //merge with the previous undo when allowed
+	if (coalesce_time > 0 && data->coalesce_key && current && current == last_added
+			&& !current->isauto && !data->isauto && current->compressed <= 0
+			&& current->coalesce_key == data->coalesce_key && current->context == data->context
+			&& (data->time - current->time) * 1000 <= (clock_t)coalesce_time * sysconf(_SC_CLK_TCK)
+			&& current->Coalesce(data)) {
+		current->time = data->time;
+		Account(current);
+		stats.num_coalesced++;
+		delete data;
+		return 1;
+	}
+
      //if any after current, remove them
 	if (current) {
 		while (current->next && current->next->isRedoable()) {
+			Forget(current->next);
 			delete current->next;
 		}
-	} else if (head) { delete head; head=NULL; }
+	} else if (head) {
+		for (UndoData *d = head; d; d = d->next) Forget(d);
+		delete head;
+		head=NULL;
+	}
 
     if (current) {
 		current->next=data;
@@ -228,6 +499,21 @@ int UndoManager::AddUndo(UndoData *data)
 		} else head=current=data;
     }
 
+	num_entries++;
+	Account(data);
+	last_added = data;
+
+	CompressCold();
+	Evict();
+	return 0;
+}
+
+//! Decompress data if needed before it is used. Returns 0 for ok, nonzero for error.
+static int undo_thaw(UndoData *data)
+{
+	if (data->compressed <= 0) return 0;
+	if (data->Decompress() != 0) return 1;
+	data->compressed = 0;
 	return 0;
 }
 
@@ -245,9 +531,16 @@ int UndoManager::Undo()
 	unsigned long msg_id = 0;
 	int msg_pos = 0;
 
+	last_added = NULL;
+
 	do {
 		isauto = current->isauto;
+		if (undo_thaw(current) != 0) {
+			cerr <<" *** could not decompress undo! "<<current->Description()<<endl;
+			return 3;
+		}
 		if (current->context->Undo(current)==0) {
+			Account(current);
 			msg = current->Description();
 			msg_id = current->undo_id;
 			msg_pos = current->GetUndoPosition();
@@ -258,6 +551,7 @@ int UndoManager::Undo()
 		}
 	} while (isauto);
 
+	CompressCold();
 	if (msg && anXApp::app) anXApp::app->PostMessage2(_("Undo (%d:%d): %s"), msg_pos, msg_id, msg);
 	return 0;
 }
@@ -279,23 +573,28 @@ int UndoManager::Redo()
 	const char *msg = nullptr;
 	unsigned long msg_id = 0;
 	int msg_pos = 0;
+	last_added = NULL;
 
-	if (current->context->Redo(current)==0) {
+	if (undo_thaw(current) == 0 && current->context->Redo(current)==0) {
 		current->direction = UNDOABLE;
+		Account(current);
 		msg = current->Description();
 		msg_id = current->undo_id;
 		msg_pos = current->GetUndoPosition();
 
 		while (current->next && current->next->isauto) {
 			current = current->next;
-			if (current->context->Redo(current)==0) {
+			if (undo_thaw(current) == 0 && current->context->Redo(current)==0) {
 				current->direction = UNDOABLE;
+				Account(current);
 			} else {
 				// *** uh oh! broken mid undo stream, a tragedy!
 				return 5;
 			}
 		}
 
+		CompressCold();
+		Evict();
 		if (msg && anXApp::app) anXApp::app->PostMessage2(_("Redo (%d:%d): %s"), msg_pos, msg_id, msg);
 		return 0;
 	}
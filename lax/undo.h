@@ -29,6 +29,8 @@
 
 namespace Laxkit {
 
+#define UNDO_DEFAULT_MAX_BYTES (256*1024*1024)
+
 class UndoData;
 
 //--------------------------------------------- Undoable ------------------------------------------
@@ -55,6 +57,11 @@ class UndoData
 
 	anObject *data;
 
+	unsigned long coalesce_key; //nonzero undos with the same key and context may merge, see UndoManager::SetCoalesceTime()
+	int compressed; //1 if Compress() packed this away, -1 if it declined, else 0
+	long undo_size; //cached Size(), maintained by UndoManager
+	long packed_len, unpacked_len; //sizes of packed, when used
+
     UndoData(int nisauto=0);
     virtual ~UndoData();
     virtual int isUndoable();
@@ -63,6 +70,15 @@ class UndoData
 	virtual const char *Script() { return NULL; }
 	virtual int GetUndoPosition();
 	virtual int Size(); //in bytes of this whole undo instance
+
+	virtual int Coalesce(UndoData *newer) { return 0; } //return 1 if newer was merged into this
+	virtual int Compress() { return 0; } //return 1 if compressed
+	virtual int Decompress() { return 0; } //return 0 for success
+
+  protected:
+	char *packed; //zlib compressed bytes from PackBytes()
+	virtual int PackBytes(const char *bytes, long len);
+	virtual char *UnpackBytes(long *len_ret);
 };
 
 
@@ -72,21 +88,48 @@ class MetaUndoData : public UndoData
   public:
     int type;
     Attribute meta;
-    char *description;
 
     MetaUndoData(Undoable *context, int ntype, int nisauto, const char *desc);
     virtual ~MetaUndoData();
     virtual const char *Description();
     virtual int Size(); //in bytes of this whole undo instance
+	virtual int Compress();
+	virtual int Decompress();
 };
 
 
 //--------------------------------------------- UndoManager ------------------------------------------
+class UndoStats
+{
+  public:
+	int num_undoable, num_redoable;
+	int num_compressed;
+	long bytes;            //current total of UndoData::Size()
+	long compressed_bytes; //how much of bytes is in compressed entries
+	long bytes_saved;      //how much smaller compressed entries are than they were
+	long num_evicted, bytes_evicted;
+	long num_coalesced;
+};
+
 class UndoManager : public anObject
 {
   protected:
     UndoData *head;
     UndoData *current; //points to either the current undoable, or NULL. There may be redoable ones in head!
+	UndoData *last_added; //only this may coalesce with new undos, cleared by Undo() and Redo()
+
+	int max_count;      //0 for no limit
+	long max_bytes;     //0 for no limit
+	int compress_after; //compress undos more than this many steps from current, 0 for never
+	int coalesce_time;  //in ms, 0 for never coalesce
+	int num_entries;
+	UndoStats stats;
+
+	virtual void Account(UndoData *data);
+	virtual void Forget(UndoData *data);
+	virtual int Evict();
+	virtual int CompressCold();
+
   public:
 	UndoManager();
 	virtual ~UndoManager();
@@ -95,6 +138,11 @@ class UndoManager : public anObject
 
 	virtual int Undo();
 	virtual int Redo();
+
+	virtual void SetLimits(int max_undos, long max_size);
+	virtual void SetCompression(int after_steps);
+	virtual void SetCoalesceTime(int ms);
+	virtual const UndoStats &Stats();
 };
 
 
@@ -0,0 +1,342 @@
+//
+//    The Laxkit, a windowing toolkit
+//    Please consult https://github.com/Laidout/laxkit about where to send any
+//    correspondence about this software.
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 3 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; If not, see <http://www.gnu.org/licenses/>.
+//
+//    Copyright (C) 2024 by Tom Lechner
+//
+
+#include <lax/workerpool.h>
+
+#include <unistd.h>
+
+#include <iostream>
+using namespace std;
+#define DBG
+
+
+namespace Laxkit {
+
+
+//---------------------------------- WorkerPool ---------------------------------
+
+/*! \class WorkerPool
+ * \brief A fixed set of threads to split up big loops with.
+ *
+ * ParallelFor(n, func) calls func(index, thread) for each index in [0..n), spread out over
+ * the pool's threads and the calling thread, and returns when all are done. Indices are handed
+ * out one at a time, so uneven work per index balances itself. thread is in [0..NumThreads()),
+ * and can be used to pick per thread scratch space. The calling thread is always thread 0.
+ *
+ * If ParallelFor() is called from inside func, the inner loop just runs on the current thread.
+ */
+
+static thread_local bool in_worker = false;
+
+
+/*! nthreads is the number of extra threads, not counting the thread that calls ParallelFor().
+ * If nthreads<0, use one less than the number of processors.
+ */
+WorkerPool::WorkerPool(int nthreads)
+{
+	if (nthreads < 0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = (n > 1 ? n-1 : 0);
+	}
+
+	pthread_mutex_init(&mutex, nullptr);
+	pthread_mutex_init(&run_mutex, nullptr);
+	pthread_cond_init(&work_cond, nullptr);
+	pthread_cond_init(&done_cond, nullptr);
+	quitting   = false;
+	batch_func = nullptr;
+	batch_n    = 0;
+	batch_next = 0;
+	batch_busy = 0;
+	batch_id   = 0;
+
+	 //threads wait on mutex until threads[] is filled in, so they can find their index
+	pthread_mutex_lock(&mutex);
+	num_threads = 0;
+	threads = (nthreads > 0 ? new pthread_t[nthreads] : nullptr);
+	for (int c=0; c<nthreads; c++) {
+		if (pthread_create(&threads[num_threads], nullptr, ThreadMain, this) != 0) {
+			cerr << " *** WorkerPool could only start "<<num_threads<<" threads!"<<endl;
+			break;
+		}
+		num_threads++;
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+WorkerPool::~WorkerPool()
+{
+	pthread_mutex_lock(&mutex);
+	quitting = true;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&mutex);
+
+	for (int c=0; c<num_threads; c++) pthread_join(threads[c], nullptr);
+	delete[] threads;
+
+	pthread_mutex_destroy(&mutex);
+	pthread_mutex_destroy(&run_mutex);
+	pthread_cond_destroy(&work_cond);
+	pthread_cond_destroy(&done_cond);
+}
+
+//! A shared pool with one thread per processor, created on first use.
+WorkerPool *WorkerPool::Default()
+{
+	static WorkerPool *pool = new WorkerPool(-1);
+	return pool;
+}
+
+void *WorkerPool::ThreadMain(void *data)
+{
+	WorkerPool *pool = (WorkerPool*)data;
+	in_worker = true;
+
+	int thread = 0;
+	pthread_mutex_lock(&pool->mutex);
+	for (int c=0; c<pool->num_threads; c++) if (pthread_equal(pool->threads[c], pthread_self())) thread = c+1;
+	unsigned int seen = 0; //batch_id starts at 0, so the first batch is never missed
+
+	while (true) {
+		while (!pool->quitting && pool->batch_id == seen) pthread_cond_wait(&pool->work_cond, &pool->mutex);
+		if (pool->quitting) break;
+		seen = pool->batch_id;
+
+		pthread_mutex_unlock(&pool->mutex);
+		pool->WorkBatch(thread);
+		pthread_mutex_lock(&pool->mutex);
+
+		if (--pool->batch_busy == 0) pthread_cond_signal(&pool->done_cond);
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+	return nullptr;
+}
+
+//! Keep grabbing indices of the current batch until there are none left.
+void WorkerPool::WorkBatch(int thread)
+{
+	int i;
+	while ((i = batch_next.fetch_add(1)) < batch_n) (*batch_func)(i, thread);
+}
+
+/*! Call func(index, thread) for each index in [0..n), and return when all calls are done.
+ */
+void WorkerPool::ParallelFor(int n, std::function<void(int index, int thread)> func)
+{
+	if (n <= 0) return;
+	if (num_threads == 0 || n == 1 || in_worker) {
+		for (int c=0; c<n; c++) func(c, 0);
+		return;
+	}
+
+	pthread_mutex_lock(&run_mutex);
+
+	pthread_mutex_lock(&mutex);
+	batch_func = &func;
+	batch_n    = n;
+	batch_next = 0;
+	batch_busy = num_threads;
+	batch_id++;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&mutex);
+
+	in_worker = true;
+	WorkBatch(0);
+	in_worker = false;
+
+	pthread_mutex_lock(&mutex);
+	while (batch_busy > 0) pthread_cond_wait(&done_cond, &mutex);
+	batch_func = nullptr;
+	pthread_mutex_unlock(&mutex);
+
+	pthread_mutex_unlock(&run_mutex);
+}
+
+
+//---------------------------------- TaskQueue ---------------------------------
+
+/*! \class TaskQueue
+ * \brief Background threads that run queued tasks, highest priority first.
+ *
+ * Unlike WorkerPool, Add() returns right away. Tasks of the same priority run in the order added.
+ * Tasks that have not started yet can be taken back out with Cancel(). Tasks must arrange
+ * their own way of getting results back, such as with anXApp::SendMessage(), which is thread safe.
+ */
+
+
+/*! If nthreads<0, use one less than the number of processors, but at least 1.
+ * If nthreads==0, Add() just runs tasks right away on the calling thread.
+ */
+TaskQueue::TaskQueue(int nthreads)
+{
+	if (nthreads < 0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = (n > 2 ? n-1 : 1);
+	}
+
+	pthread_mutex_init(&mutex, nullptr);
+	pthread_cond_init(&work_cond, nullptr);
+	pthread_cond_init(&idle_cond, nullptr);
+	quitting    = false;
+	tasks       = nullptr;
+	num_waiting = 0;
+	num_running = 0;
+	last_id     = 0;
+
+	num_threads = 0;
+	threads = (nthreads > 0 ? new pthread_t[nthreads] : nullptr);
+	for (int c=0; c<nthreads; c++) {
+		if (pthread_create(&threads[num_threads], nullptr, ThreadMain, this) != 0) {
+			cerr << " *** TaskQueue could only start "<<num_threads<<" threads!"<<endl;
+			break;
+		}
+		num_threads++;
+	}
+}
+
+/*! Tasks that are running are finished first. Tasks still waiting are discarded without running.
+ */
+TaskQueue::~TaskQueue()
+{
+	pthread_mutex_lock(&mutex);
+	quitting = true;
+	pthread_cond_broadcast(&work_cond);
+	pthread_mutex_unlock(&mutex);
+
+	for (int c=0; c<num_threads; c++) pthread_join(threads[c], nullptr);
+	delete[] threads;
+
+	while (tasks) {
+		Task *task = tasks;
+		tasks = task->next;
+		delete task;
+	}
+
+	pthread_mutex_destroy(&mutex);
+	pthread_cond_destroy(&work_cond);
+	pthread_cond_destroy(&idle_cond);
+}
+
+//! A shared queue, created on first use.
+TaskQueue *TaskQueue::Default()
+{
+	static TaskQueue *queue = new TaskQueue(-1);
+	return queue;
+}
+
+void *TaskQueue::ThreadMain(void *data)
+{
+	TaskQueue *queue = (TaskQueue*)data;
+
+	pthread_mutex_lock(&queue->mutex);
+	while (true) {
+		while (!queue->quitting && !queue->tasks) pthread_cond_wait(&queue->work_cond, &queue->mutex);
+		if (queue->quitting) break;
+
+		Task *task = queue->tasks;
+		queue->tasks = task->next;
+		queue->num_waiting--;
+		queue->num_running++;
+
+		pthread_mutex_unlock(&queue->mutex);
+		task->func();
+		delete task;
+		pthread_mutex_lock(&queue->mutex);
+
+		queue->num_running--;
+		if (queue->num_running == 0 && !queue->tasks) pthread_cond_broadcast(&queue->idle_cond);
+	}
+
+	pthread_mutex_unlock(&queue->mutex);
+	return nullptr;
+}
+
+//! Return how many tasks have not started yet.
+int TaskQueue::NumWaiting()
+{
+	pthread_mutex_lock(&mutex);
+	int n = num_waiting;
+	pthread_mutex_unlock(&mutex);
+	return n;
+}
+
+//! Queue up func to run on a background thread. Higher priority runs sooner.
+/*! Returns an id that can be used with Cancel(). Ids are never 0.
+ */
+unsigned long TaskQueue::Add(std::function<void()> func, int priority)
+{
+	pthread_mutex_lock(&mutex);
+	unsigned long id = ++last_id;
+	if (num_threads == 0) {
+		pthread_mutex_unlock(&mutex);
+		func();
+		return id;
+	}
+
+	Task *task = new Task;
+	task->id       = id;
+	task->priority = priority;
+	task->func     = func;
+
+	 //after any of same or higher priority
+	Task **pos = &tasks;
+	while (*pos && (*pos)->priority >= priority) pos = &(*pos)->next;
+	task->next = *pos;
+	*pos = task;
+	num_waiting++;
+
+	pthread_cond_signal(&work_cond);
+	pthread_mutex_unlock(&mutex);
+	return id;
+}
+
+//! Remove a task that has not started yet. Returns true if it was removed, or false if it already started or is unknown.
+bool TaskQueue::Cancel(unsigned long id)
+{
+	bool found = false;
+	pthread_mutex_lock(&mutex);
+	for (Task **pos = &tasks; *pos; pos = &(*pos)->next) {
+		if ((*pos)->id == id) {
+			Task *task = *pos;
+			*pos = task->next;
+			delete task;
+			num_waiting--;
+			found = true;
+			break;
+		}
+	}
+	if (found && num_running == 0 && !tasks) pthread_cond_broadcast(&idle_cond);
+	pthread_mutex_unlock(&mutex);
+	return found;
+}
+
+//! Return when there are no tasks waiting or running.
+void TaskQueue::Wait()
+{
+	pthread_mutex_lock(&mutex);
+	while (tasks || num_running > 0) pthread_cond_wait(&idle_cond, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+
+} //namespace Laxkit
+
@@ -0,0 +1,112 @@
+//
+//    The Laxkit, a windowing toolkit
+//    Please consult https://github.com/Laidout/laxkit about where to send any
+//    correspondence about this software.
+//
+//    This library is free software; you can redistribute it and/or
+//    modify it under the terms of the GNU Library General Public
+//    License as published by the Free Software Foundation; either
+//    version 3 of the License, or (at your option) any later version.
+//
+//    This library is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//    Library General Public License for more details.
+//
+//    You should have received a copy of the GNU Library General Public
+//    License along with this library; If not, see <http://www.gnu.org/licenses/>.
+//
+//    Copyright (C) 2024 by Tom Lechner
+//
+#ifndef _LAX_WORKERPOOL_H
+#define _LAX_WORKERPOOL_H
+
+
+#include <pthread.h>
+#include <atomic>
+#include <functional>
+
+
+namespace Laxkit {
+
+
+//---------------------------------- WorkerPool ---------------------------------
+
+class WorkerPool
+{
+  protected:
+	pthread_t *threads;
+	int num_threads;
+
+	pthread_mutex_t mutex;
+	pthread_mutex_t run_mutex; //only one ParallelFor() at a time
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	bool quitting;
+
+	 //current batch
+	std::function<void(int,int)> *batch_func;
+	int batch_n;
+	std::atomic<int> batch_next;
+	int batch_busy; //workers not yet done with the current batch
+	unsigned int batch_id;
+
+	static void *ThreadMain(void *data);
+	void WorkBatch(int thread);
+
+  public:
+	WorkerPool(int nthreads = -1);
+	virtual ~WorkerPool();
+	virtual int NumThreads() { return num_threads+1; }
+	virtual void ParallelFor(int n, std::function<void(int index, int thread)> func);
+
+	static WorkerPool *Default();
+};
+
+
+//---------------------------------- TaskQueue ---------------------------------
+
+class TaskQueue
+{
+  protected:
+	class Task
+	{
+	  public:
+		unsigned long id;
+		int priority;
+		std::function<void()> func;
+		Task *next;
+	};
+
+	pthread_t *threads;
+	int num_threads;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t work_cond;
+	pthread_cond_t idle_cond;
+	bool quitting;
+
+	Task *tasks; //waiting tasks, highest priority first
+	int num_waiting;
+	int num_running;
+	unsigned long last_id;
+
+	static void *ThreadMain(void *data);
+
+  public:
+	TaskQueue(int nthreads = -1);
+	virtual ~TaskQueue();
+	virtual int NumThreads() { return num_threads; }
+	virtual int NumWaiting();
+	virtual unsigned long Add(std::function<void()> func, int priority = 0);
+	virtual bool Cancel(unsigned long id);
+	virtual void Wait();
+
+	static TaskQueue *Default();
+};
+
+
+} //namespace Laxkit
+
+#endif
+